@@ -1,6 +1,7 @@
 import 'dart:io';
 import 'package:dio/dio.dart';
 import 'package:dio/io.dart';
+import 'package:flutter/services.dart';
 
 /// Certificate pinning configuration for secure API connections.
 ///
@@ -11,6 +12,9 @@ import 'package:dio/io.dart';
 /// - In production, replace placeholder fingerprints with actual certificate SHA-256 fingerprints
 /// - Fingerprints can be obtained using: openssl s_client -connect host:port | openssl x509 -pubkey -noout | openssl sha256
 class CertificatePinner {
+  static const MethodChannel _nativeChannel =
+      MethodChannel('com.tamshai.ai/certificate_pins');
+
   /// SHA-256 fingerprints of pinned certificates.
   /// Add production certificate fingerprints here.
   static const List<String> pinnedCertificates = [
@@ -77,6 +81,28 @@ class CertificatePinner {
     }
   }
 
+  /// Hands the pins to the Windows runner, which checks them for its own
+  /// WinHTTP connections, the native SSE transport's among them. The runner
+  /// hashes each server's chain once during the TLS handshake and keeps the
+  /// result for the session, rather than calling back into Dart.
+  ///
+  /// The runner refuses every connection of its own until this has
+  /// completed, so await it at startup, before the first request.
+  static Future<void> configureNative() async {
+    if (!Platform.isWindows) return;
+    try {
+      await _nativeChannel.invokeMethod<void>('configure', {
+        'pins': pinnedCertificates,
+        'exemptHosts': exemptHosts,
+      });
+    } on MissingPluginException {
+      // An older runner; the native transport is not pinned.
+    } on PlatformException {
+      // Pins the runner can't parse. It keeps refusing connections rather
+      // than making them unpinned, and the app still starts.
+    }
+  }
+
   /// Extracts the SHA-256 fingerprint from an X509 certificate.
   static String _getCertificateFingerprint(X509Certificate cert) {
     // Note: In a production app, you would use a proper SHA-256 implementation
@@ -5,6 +5,7 @@ import '../auth/providers/auth_provider.dart';
 import 'package:flutter_riverpod/flutter_riverpod.dart';
 import 'certificate_pinner.dart';
 import '../config/environment_config.dart';
+import '../native/native_json_transformer.dart';
 
 /// Dio interceptor for automatic token injection and refresh
 ///
@@ -35,24 +36,32 @@ class AuthTokenInterceptor extends Interceptor {
   /// Set the parent Dio instance. Must be called after adding to Dio.
   void setDio(Dio dio) => _dio = dio;
 
+  /// Returns a current access token, refreshing it first if it has expired.
+  ///
+  /// Also used by transports that bypass Dio, such as the native SSE
+  /// transport on Windows.
+  Future<String?> resolveAccessToken() async {
+    // Check if token is expired
+    final isExpired = await _storage.isTokenExpired();
+
+    if (isExpired) {
+      _logger.i('Token expired, refreshing before request');
+
+      // Trigger refresh
+      await _ref.read(authNotifierProvider.notifier).refreshToken();
+    }
+
+    // Get current access token
+    return _storage.getAccessToken();
+  }
+
   @override
   Future<void> onRequest(
     RequestOptions options,
     RequestInterceptorHandler handler,
   ) async {
     try {
-      // Check if token is expired
-      final isExpired = await _storage.isTokenExpired();
-      
-      if (isExpired) {
-        _logger.i('Token expired, refreshing before request');
-        
-        // Trigger refresh
-        await _ref.read(authNotifierProvider.notifier).refreshToken();
-      }
-
-      // Get current access token
-      final accessToken = await _storage.getAccessToken();
+      final accessToken = await resolveAccessToken();
 
       if (accessToken != null) {
         // Add authorization header
@@ -172,6 +181,11 @@ final dioProvider = Provider<Dio>((ref) {
     ),
   );
 
+  // Parse large responses in the Windows runner rather than on the UI isolate
+  if (NativeJsonTransformer.isSupported) {
+    dio.transformer = NativeJsonTransformer();
+  }
+
   // Configure certificate pinning for production security
   // Note: Pinning is disabled when no certificates are configured (dev mode)
   CertificatePinner.configure(dio);
@@ -9,6 +9,7 @@ import '../services/keycloak_auth_service.dart';
 import '../services/desktop_oauth_service.dart';
 import '../services/direct_grant_auth_service.dart';
 import '../services/biometric_service.dart';
+import '../../native/native_response_cache.dart';
 import '../../storage/secure_storage_service.dart';
 
 // Re-export exceptions for convenience
@@ -261,6 +262,11 @@ class AuthNotifier extends Notifier<AuthState> {
 
       await _authService.logout(endKeycloakSession: endKeycloakSession);
 
+      // Cached components hold the user's business data
+      if (NativeResponseCache.isSupported) {
+        await NativeResponseCache().clear();
+      }
+
       state = const AuthState.unauthenticated();
       _logger.i('Logout successful');
     } catch (e, stackTrace) {
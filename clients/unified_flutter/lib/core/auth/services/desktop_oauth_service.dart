@@ -12,6 +12,7 @@ import '../models/keycloak_config.dart';
 import '../../storage/secure_storage_service.dart';
 import '../../utils/jwt_utils.dart';
 import 'auth_service.dart';
+import 'native_oauth_callback_listener.dart';
 
 /// Desktop OAuth service using browser + local HTTP server callback
 ///
@@ -19,7 +20,8 @@ import 'auth_service.dart';
 /// Uses OAuth 2.0 Authorization Code Flow with PKCE.
 ///
 /// Flow:
-/// 1. Start local HTTP server on preferred fixed port (fallback to dynamic)
+/// 1. Start local HTTP server on preferred fixed port (fallback to dynamic);
+///    on Windows the runner's listener is already bound and is used instead
 /// 2. Generate PKCE code verifier and challenge
 /// 3. Open browser to Keycloak authorization endpoint
 /// 4. User authenticates (including TOTP if required)
@@ -38,13 +40,22 @@ class DesktopOAuthService implements AuthService {
   HttpServer? _server;
   Completer<String>? _authCodeCompleter;
 
+  /// Runner-side callback listener, where the platform provides one.
+  final NativeOAuthCallbackListener? _nativeListener;
+  bool _awaitingNativeCallback = false;
+
   DesktopOAuthService({
     required KeycloakConfig config,
     required SecureStorageService storage,
     Logger? logger,
+    NativeOAuthCallbackListener? nativeListener,
   })  : _config = config,
         _storage = storage,
-        _logger = logger ?? Logger();
+        _logger = logger ?? Logger(),
+        _nativeListener = nativeListener ??
+            (NativeOAuthCallbackListener.isSupported
+                ? NativeOAuthCallbackListener()
+                : null);
 
   @override
   Future<AuthUser> login() async {
@@ -56,12 +67,24 @@ class DesktopOAuthService implements AuthService {
       final codeChallenge = _generateCodeChallenge(codeVerifier);
       final state = _generateState();
 
-      // Start local server for callback
-      final server = await _startLocalServer();
+      // Prefer the runner's listener, which is bound before login starts;
+      // otherwise start a local server for the callback
+      final nativePort = await _nativeListener?.getPort();
+      final Future<String> authCodeFuture;
+      final int port;
+      if (nativePort != null) {
+        port = nativePort;
+        authCodeFuture = _waitForNativeCallback(state);
+        _logger.i('Using runner callback listener on port $port');
+      } else {
+        final server = await _startLocalServer();
+        port = server.port;
+        _authCodeCompleter = Completer<String>();
+        authCodeFuture = _authCodeCompleter!.future;
+        _logger.i('Local callback server started on port $port');
+      }
       // Use 127.0.0.1 instead of localhost for Windows compatibility
-      final redirectUri = 'http://127.0.0.1:${server.port}/callback';
-
-      _logger.i('Local callback server started on port ${server.port}');
+      final redirectUri = 'http://127.0.0.1:$port/callback';
 
       // Build authorization URL
       final authUrl = _buildAuthorizationUrl(
@@ -81,8 +104,7 @@ class DesktopOAuthService implements AuthService {
       }
 
       // Wait for authorization code
-      _authCodeCompleter = Completer<String>();
-      final authCode = await _authCodeCompleter!.future.timeout(
+      final authCode = await authCodeFuture.timeout(
         const Duration(minutes: 5),
         onTimeout: () {
           _stopServer();
@@ -411,7 +433,40 @@ class DesktopOAuthService implements AuthService {
     return _server!;
   }
 
+  /// Waits for the runner's listener to receive the redirect.
+  ///
+  /// Any local process can request the callback URL, so requests without
+  /// this login's state, errors included, are logged and ignored rather than
+  /// failing the login; the wait goes on until the real redirect arrives or
+  /// the caller's timeout cancels it.
+  ///
+  /// Returns an empty code if the login was cancelled or failed.
+  Future<String> _waitForNativeCallback(String expectedState) async {
+    _awaitingNativeCallback = true;
+    try {
+      for (;;) {
+        final callback = await _nativeListener!.waitForCallback();
+        if (callback == null) return '';
+        if (callback.state != expectedState) {
+          _logger.w('Ignoring OAuth callback with a mismatched state');
+          continue;
+        }
+        if (callback.error != null) {
+          _logger.w('OAuth callback error: ${callback.error} '
+              '${callback.errorDescription ?? ''}');
+          return '';
+        }
+        return callback.code ?? '';
+      }
+    } finally {
+      _awaitingNativeCallback = false;
+    }
+  }
+
   Future<void> _stopServer() async {
+    if (_awaitingNativeCallback) {
+      await _nativeListener!.cancel();
+    }
     if (_server != null) {
       await _server!.close(force: true);
       _server = null;
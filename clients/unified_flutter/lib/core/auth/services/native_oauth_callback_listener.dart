@@ -0,0 +1,62 @@
+import 'dart:io' show Platform;
+
+import 'package:flutter/services.dart';
+
+/// Query parameters of the OAuth redirect received by the runner.
+class OAuthCallbackResult {
+  final String? code;
+  final String? state;
+  final String? error;
+  final String? errorDescription;
+
+  const OAuthCallbackResult({
+    this.code,
+    this.state,
+    this.error,
+    this.errorDescription,
+  });
+}
+
+/// OAuth redirect listener backed by the Windows runner
+/// (`OAuthCallbackPlugin`).
+///
+/// The runner binds one of the preferred callback ports when the window is
+/// created and parses the `/callback` request on a background thread, so a
+/// login neither waits for a Dart `HttpServer` to start nor handles the
+/// redirect on the UI isolate.
+class NativeOAuthCallbackListener {
+  static const MethodChannel _channel =
+      MethodChannel('com.tamshai.ai/oauth_callback');
+
+  /// Whether the current platform provides the native listener.
+  static bool get isSupported => Platform.isWindows;
+
+  /// The port the runner is listening on, or null if it could not bind one
+  /// or does not provide the listener.
+  Future<int?> getPort() async {
+    try {
+      return await _channel.invokeMethod<int>('getPort');
+    } on MissingPluginException {
+      return null;
+    }
+  }
+
+  /// Waits for the browser to be redirected to `/callback`.
+  ///
+  /// Completes with null if the wait is cancelled or superseded by a newer
+  /// one.
+  Future<OAuthCallbackResult?> waitForCallback() async {
+    final result =
+        await _channel.invokeMapMethod<String, String?>('awaitCallback');
+    if (result == null) return null;
+    return OAuthCallbackResult(
+      code: result['code'],
+      state: result['state'],
+      error: result['error'],
+      errorDescription: result['errorDescription'],
+    );
+  }
+
+  /// Completes a pending [waitForCallback] with null.
+  Future<void> cancel() => _channel.invokeMethod<void>('cancel');
+}
@@ -4,17 +4,88 @@ import 'package:logger/logger.dart';
 import 'package:uuid/uuid.dart';
 import '../../api/token_interceptor.dart';
 import '../../auth/providers/auth_provider.dart';
+import '../../native/frame_telemetry.dart';
 import '../models/chat_state.dart';
 import '../services/chat_service.dart';
+import '../services/native_document_ingest.dart';
+import '../services/native_sse_transport.dart';
 
 /// Chat service provider
 final chatServiceProvider = Provider<ChatService>((ref) {
+  final dio = ref.watch(dioProvider);
   return ChatService(
-    dio: ref.watch(dioProvider),
+    dio: dio,
     logger: ref.watch(loggerProvider),
+    // Windows streams through the runner so the UI isolate never sees raw
+    // SSE bytes
+    nativeTransport:
+        NativeSseTransport.isSupported ? NativeSseTransport() : null,
+    accessTokenResolver: dio.interceptors
+        .whereType<AuthTokenInterceptor>()
+        .firstOrNull
+        ?.resolveAccessToken,
   );
 });
 
+/// Native document ingestion, or null where the runner does not provide it
+final documentIngestProvider = Provider<NativeDocumentIngest?>((ref) {
+  return NativeDocumentIngest.isSupported ? NativeDocumentIngest() : null;
+});
+
+/// Documents attached to the next message (Riverpod 3.x NotifierProvider)
+final chatAttachmentsProvider =
+    NotifierProvider<ChatAttachmentsNotifier, List<IngestedDocument>>(() {
+  return ChatAttachmentsNotifier();
+});
+
+/// Tracks documents dropped onto the window until a message takes them
+class ChatAttachmentsNotifier extends Notifier<List<IngestedDocument>> {
+  NativeDocumentIngest? _ingest;
+
+  @override
+  List<IngestedDocument> build() {
+    _ingest = ref.watch(documentIngestProvider);
+    final subscription = _ingest?.documents.listen(_update);
+    ref.onDispose(() => subscription?.cancel());
+    return const [];
+  }
+
+  void _update(IngestedDocument document) {
+    final index = state.indexWhere((d) => d.handle == document.handle);
+    state = index < 0
+        ? [...state, document]
+        : [...state]..[index] = document;
+  }
+
+  /// Attach the file at [path]
+  Future<void> open(String path) async {
+    final document = await _ingest?.open(path);
+    if (document != null) _update(document);
+  }
+
+  /// Detach document [handle] and release it
+  void remove(int handle) {
+    state = state.where((d) => d.handle != handle).toList();
+    _ingest?.close(handle);
+  }
+
+  /// Detach the ready documents, for a message to send; the caller closes
+  /// them with [release]. Documents still being read stay attached.
+  List<IngestedDocument> takeReady() {
+    final ready =
+        state.where((d) => d.state == IngestState.ready).toList();
+    state = state.where((d) => d.state != IngestState.ready).toList();
+    return ready;
+  }
+
+  /// Release documents taken with [takeReady]
+  void release(List<IngestedDocument> documents) {
+    for (final document in documents) {
+      _ingest?.close(document.handle);
+    }
+  }
+}
+
 /// Chat state provider (Riverpod 3.x NotifierProvider)
 final chatNotifierProvider = NotifierProvider<ChatNotifier, ChatState>(() {
   return ChatNotifier();
@@ -28,6 +99,12 @@ class ChatNotifier extends Notifier<ChatState> {
 
   StreamSubscription<SSEChunk>? _currentStream;
 
+  /// Closes the documents the current stream was sent with
+  void Function()? _releaseDocuments;
+
+  static const _streamingPhase = 'chat_streaming';
+  bool _inStreamingPhase = false;
+
   @override
   ChatState build() {
     _chatService = ref.watch(chatServiceProvider);
@@ -36,20 +113,43 @@ class ChatNotifier extends Notifier<ChatState> {
     // Cleanup on dispose
     ref.onDispose(() {
       _currentStream?.cancel();
+      _setStreamingPhase(false);
     });
 
+    // Tag the frames drawn while a reply streams in
+    listenSelf((_, next) => _setStreamingPhase(next.isStreaming));
+
     return const ChatState();
   }
 
+  void _setStreamingPhase(bool streaming) {
+    if (streaming == _inStreamingPhase) return;
+    _inStreamingPhase = streaming;
+    if (streaming) {
+      FrameTelemetry.enterPhase(_streamingPhase);
+    } else {
+      FrameTelemetry.exitPhase(_streamingPhase);
+    }
+  }
+
   /// Send a message and stream the response
   Future<void> sendMessage(String content) async {
     if (content.trim().isEmpty) return;
     if (state.isLoading || state.isStreaming) return;
 
+    // The runner sends their text along with the query
+    final attachments = ref.read(chatAttachmentsProvider.notifier);
+    final documents = attachments.takeReady();
+    void releaseDocuments() => attachments.release(documents);
+    _releaseDocuments = releaseDocuments;
+
     // Add user message
     final userMessage = ChatMessage(
       id: _uuid.v4(),
-      content: content,
+      content: [
+        content,
+        for (final document in documents) '📎 ${document.name}',
+      ].join('\n'),
       role: MessageRole.user,
       timestamp: DateTime.now(),
     );
@@ -79,9 +179,15 @@ class ChatNotifier extends Notifier<ChatState> {
 
     // Start streaming response
     try {
-      _currentStream = _chatService.sendQuery(content).listen(
+      _currentStream = _chatService
+          .sendQuery(
+            content,
+            documents: [for (final document in documents) document.handle],
+          )
+          .listen(
         (chunk) => _handleSSEChunk(chunk, assistantMessageId),
         onError: (error) {
+          releaseDocuments();
           _logger.e('Stream error', error: error);
           _updateMessage(assistantMessageId, (msg) => msg.copyWith(
             isStreaming: false,
@@ -96,6 +202,7 @@ class ChatNotifier extends Notifier<ChatState> {
           );
         },
         onDone: () {
+          releaseDocuments();
           _updateMessage(assistantMessageId, (msg) => msg.copyWith(
             isStreaming: false,
           ));
@@ -106,6 +213,7 @@ class ChatNotifier extends Notifier<ChatState> {
         },
       );
     } catch (e, stackTrace) {
+      releaseDocuments();
       _logger.e('Failed to start stream', error: e, stackTrace: stackTrace);
       _updateMessage(assistantMessageId, (msg) => msg.copyWith(
         isStreaming: false,
@@ -229,6 +337,8 @@ class ChatNotifier extends Notifier<ChatState> {
   void cancelStream() {
     _currentStream?.cancel();
     _currentStream = null;
+    _releaseDocuments?.call();
+    _releaseDocuments = null;
 
     if (state.currentStreamingMessageId != null) {
       _updateMessage(state.currentStreamingMessageId!, (msg) => msg.copyWith(
@@ -1,8 +1,10 @@
 import 'dart:async';
 import 'dart:convert';
 import 'package:dio/dio.dart';
+import 'package:flutter/services.dart' show MissingPluginException;
 import 'package:logger/logger.dart';
 import '../models/chat_state.dart';
+import 'native_sse_transport.dart';
 
 /// Chat service for interacting with MCP Gateway
 ///
@@ -10,21 +12,96 @@ import '../models/chat_state.dart';
 /// - SSE streaming for AI responses (v1.4 requirement)
 /// - Truncation warning detection (v1.4 requirement)
 /// - Pending confirmation handling (v1.4 requirement)
+///
+/// When a [NativeSseTransport] is provided (Windows), the stream is fetched
+/// and parsed by the runner and only decoded events reach this isolate.
 class ChatService {
   final Dio _dio;
   final Logger _logger;
+  final NativeSseTransport? _nativeTransport;
+  final Future<String?> Function()? _accessTokenResolver;
 
   ChatService({
     required Dio dio,
     Logger? logger,
+    NativeSseTransport? nativeTransport,
+    Future<String?> Function()? accessTokenResolver,
   })  : _dio = dio,
-        _logger = logger ?? Logger();
+        _logger = logger ?? Logger(),
+        _nativeTransport = nativeTransport,
+        _accessTokenResolver = accessTokenResolver;
 
   /// Send a query to the MCP Gateway and stream the response
   ///
   /// Returns a stream of SSE chunks that can be used to build
-  /// the response incrementally in the UI.
-  Stream<SSEChunk> sendQuery(String query) async* {
+  /// the response incrementally in the UI. The text of the native
+  /// [documents] is sent with the query; only the native transport can, so
+  /// without it a query with documents fails with an error chunk.
+  Stream<SSEChunk> sendQuery(
+    String query, {
+    List<int> documents = const [],
+  }) async* {
+    if (_nativeTransport != null) {
+      try {
+        yield* _sendQueryNative(_nativeTransport, query, documents);
+        return;
+      } on MissingPluginException {
+        _logger.w('Native SSE transport unavailable, falling back to Dio');
+      }
+    }
+    if (documents.isNotEmpty) {
+      _logger.w('Cannot send ${documents.length} attached documents without the native transport');
+      yield const SSEChunk(
+        type: SSEEventType.error,
+        error: 'Attached documents cannot be sent on this connection. '
+            'Remove them and try again.',
+      );
+      return;
+    }
+    yield* _sendQueryDio(query);
+  }
+
+  /// Stream the query through the runner's native SSE transport
+  Stream<SSEChunk> _sendQueryNative(
+    NativeSseTransport transport,
+    String query,
+    List<int> documents,
+  ) async* {
+    _logger.i('Sending query to MCP Gateway (native): ${query.substring(0, query.length.clamp(0, 50))}...');
+
+    final accessToken = await _accessTokenResolver?.call();
+    final chunks = transport.open(
+      url: '${_dio.options.baseUrl}/api/query',
+      headers: {
+        'Content-Type': 'application/json',
+        'Accept': 'text/event-stream',
+        'Cache-Control': 'no-cache',
+        if (accessToken != null) 'Authorization': 'Bearer $accessToken',
+      },
+      query: query,
+      documents: documents,
+    );
+
+    try {
+      await for (final chunk in chunks) {
+        yield chunk;
+
+        // Check for done signal
+        if (chunk.type == SSEEventType.done) {
+          return;
+        }
+      }
+    } on NativeSseException catch (e, stackTrace) {
+      _logger.e('Native SSE error in sendQuery', error: e, stackTrace: stackTrace);
+      yield SSEChunk(
+        type: SSEEventType.error,
+        error: _formatNativeError(e),
+      );
+    }
+  }
+
+  /// Stream the query through Dio, parsing SSE on this isolate
+  Stream<SSEChunk> _sendQueryDio(String query) async* {
     try {
       _logger.i('Sending query to MCP Gateway: ${query.substring(0, query.length.clamp(0, 50))}...');
 
@@ -242,20 +319,40 @@ class ChatService {
       case DioExceptionType.connectionError:
         return 'Cannot connect to server. Is the MCP Gateway running?';
       case DioExceptionType.badResponse:
-        final statusCode = e.response?.statusCode;
         // Handle both Map responses (JSON) and ResponseBody (SSE stream)
         final data = e.response?.data;
         final message = (data is Map<String, dynamic> ? data['error'] : null) ?? e.message;
-        if (statusCode == 401) {
-          return 'Session expired. Please log in again.';
-        } else if (statusCode == 403) {
-          return 'Access denied. You don\'t have permission for this action.';
-        } else if (statusCode == 404) {
-          return 'Confirmation expired or not found.';
-        }
-        return 'Server error ($statusCode): $message';
+        return _formatStatusError(e.response?.statusCode, message);
       default:
         return 'Network error: ${e.message}';
     }
   }
+
+  /// Format NativeSseException for user display
+  String _formatNativeError(NativeSseException e) {
+    switch (e.kind) {
+      case 'timeout':
+        return 'Connection timeout. Please check your network.';
+      case 'connection':
+        return 'Cannot connect to server. Is the MCP Gateway running?';
+      case 'http':
+        return _formatStatusError(e.statusCode, e.message);
+      case 'certificate':
+        return 'Secure connection failed: the server could not be verified.';
+      default:
+        return 'Network error: ${e.message}';
+    }
+  }
+
+  /// Format an HTTP error status for user display
+  String _formatStatusError(int? statusCode, Object? message) {
+    if (statusCode == 401) {
+      return 'Session expired. Please log in again.';
+    } else if (statusCode == 403) {
+      return 'Access denied. You don\'t have permission for this action.';
+    } else if (statusCode == 404) {
+      return 'Confirmation expired or not found.';
+    }
+    return 'Server error ($statusCode): $message';
+  }
 }
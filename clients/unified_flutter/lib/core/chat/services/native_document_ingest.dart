@@ -0,0 +1,153 @@
+import 'dart:async';
+import 'dart:io' show Platform;
+
+import 'package:flutter/services.dart';
+
+/// Where an attached document is in the runner's ingestion.
+enum IngestState { ingesting, ready, failed }
+
+/// A document attached to the next chat message, as reported by the runner.
+///
+/// Only the document's handle and progress live on this side; its text stays
+/// in the runner until the query that carries it is sent.
+class IngestedDocument {
+  final int handle;
+  final String name;
+  final int sizeBytes;
+  final int processedBytes;
+  final IngestState state;
+  final String? sha256;
+
+  /// One of `unavailable`, `too_large` or `unsupported_format` once
+  /// [state] is [IngestState.failed].
+  final String? error;
+  final String? errorMessage;
+
+  const IngestedDocument({
+    required this.handle,
+    required this.name,
+    this.sizeBytes = 0,
+    this.processedBytes = 0,
+    this.state = IngestState.ingesting,
+    this.sha256,
+    this.error,
+    this.errorMessage,
+  });
+
+  /// Fraction of the file read so far, between 0 and 1.
+  double get progress {
+    if (sizeBytes == 0) return state == IngestState.ingesting ? 0 : 1;
+    return processedBytes / sizeBytes;
+  }
+
+  IngestedDocument copyWith({
+    int? sizeBytes,
+    int? processedBytes,
+    IngestState? state,
+    String? sha256,
+    String? error,
+    String? errorMessage,
+  }) {
+    return IngestedDocument(
+      handle: handle,
+      name: name,
+      sizeBytes: sizeBytes ?? this.sizeBytes,
+      processedBytes: processedBytes ?? this.processedBytes,
+      state: state ?? this.state,
+      sha256: sha256 ?? this.sha256,
+      error: error ?? this.error,
+      errorMessage: errorMessage ?? this.errorMessage,
+    );
+  }
+}
+
+/// Document ingestion backed by the Windows runner (`DocumentIngestPlugin`).
+///
+/// Files opened here or dropped onto the main window are read, hashed and
+/// checked natively. Pass the handles of ready documents to
+/// [NativeSseTransport.open] to send their text with a query, and [close]
+/// them once it no longer needs them.
+class NativeDocumentIngest {
+  static const MethodChannel _methodChannel =
+      MethodChannel('com.tamshai.ai/document_ingest');
+  static const EventChannel _eventChannel =
+      EventChannel('com.tamshai.ai/document_ingest/events');
+
+  final Map<int, IngestedDocument> _documents = {};
+  final StreamController<IngestedDocument> _updates =
+      StreamController<IngestedDocument>.broadcast();
+  StreamSubscription<dynamic>? _eventSubscription;
+
+  /// Whether the current platform provides native ingestion.
+  static bool get isSupported => Platform.isWindows;
+
+  /// Every change to an attached document, including the arrival of files
+  /// dropped onto the window.
+  Stream<IngestedDocument> get documents {
+    _ensureListening();
+    return _updates.stream;
+  }
+
+  /// Start reading the file at [path].
+  Future<IngestedDocument> open(String path) async {
+    _ensureListening();
+    final reply = await _methodChannel
+        .invokeMapMethod<String, dynamic>('open', {'path': path});
+    final handle = reply!['handle'] as int;
+    // The reply is sent before any event about the document.
+    final document =
+        IngestedDocument(handle: handle, name: reply['name'] as String);
+    _documents[handle] = document;
+    return document;
+  }
+
+  /// Release document [handle] in the runner.
+  Future<void> close(int handle) async {
+    _documents.remove(handle);
+    try {
+      await _methodChannel.invokeMethod<void>('close', {'handle': handle});
+    } on MissingPluginException {
+      // Nothing native to release.
+    }
+  }
+
+  void _ensureListening() {
+    _eventSubscription ??=
+        _eventChannel.receiveBroadcastStream().listen(_handleEvent);
+  }
+
+  void _handleEvent(dynamic event) {
+    final map = event as Map<dynamic, dynamic>;
+    final handle = map['handle'] as int;
+    final type = map['type'] as String;
+    final current = _documents[handle];
+    final IngestedDocument updated;
+    if (type == 'added') {
+      updated = IngestedDocument(handle: handle, name: map['name'] as String);
+    } else if (current == null) {
+      // Closed since.
+      return;
+    } else if (type == 'progress') {
+      updated = current.copyWith(
+        sizeBytes: map['size'] as int,
+        processedBytes: map['processed'] as int,
+      );
+    } else if (type == 'ready') {
+      updated = current.copyWith(
+        processedBytes: current.sizeBytes,
+        state: IngestState.ready,
+        sha256: map['sha256'] as String?,
+      );
+    } else if (type == 'failed') {
+      updated = current.copyWith(
+        state: IngestState.failed,
+        error: map['error'] as String?,
+        errorMessage: map['message'] as String?,
+      );
+    } else {
+      return;
+    }
+    _documents[handle] = updated;
+    _updates.add(updated);
+  }
+}
@@ -0,0 +1,141 @@
+import 'dart:async';
+import 'dart:io' show Platform;
+
+import 'package:flutter/services.dart';
+import '../models/chat_state.dart';
+
+/// Error raised by the native transport before or during a stream.
+///
+/// [kind] is one of `timeout`, `connection`, `http` or `network`;
+/// [statusCode] is set for `http` errors.
+class NativeSseException implements Exception {
+  final String kind;
+  final String message;
+  final int? statusCode;
+
+  const NativeSseException(this.kind, this.message, {this.statusCode});
+
+  @override
+  String toString() => 'NativeSseException($kind): $message';
+}
+
+/// SSE transport backed by the Windows runner (`SseStreamPlugin`).
+///
+/// The runner performs the HTTP request, frames the event stream and decodes
+/// each event's JSON on a worker thread, so the UI isolate only receives
+/// typed events - already batched, with consecutive text deltas merged.
+class NativeSseTransport {
+  static const MethodChannel _methodChannel =
+      MethodChannel('com.tamshai.ai/sse');
+  static const EventChannel _eventChannel =
+      EventChannel('com.tamshai.ai/sse/events');
+
+  /// Error kinds that end the stream, as opposed to error events sent by the
+  /// gateway, which are delivered as [SSEEventType.error] chunks.
+  static const _transportErrorKinds = {
+    'timeout',
+    'connection',
+    'http',
+    'network',
+    'certificate',
+  };
+
+  final Map<int, StreamController<SSEChunk>> _streams = {};
+  StreamSubscription<dynamic>? _eventSubscription;
+  int _nextStreamId = 1;
+
+  /// Whether the current platform provides the native transport.
+  static bool get isSupported => Platform.isWindows;
+
+  /// POST [query] to [url] and stream the decoded response events.
+  ///
+  /// The runner writes the JSON body, `{"query": ...}`, appending the text of
+  /// each ready [NativeDocumentIngest] handle in [documents] to the query.
+  /// Cancelling the subscription aborts the native request.
+  Stream<SSEChunk> open({
+    required String url,
+    required Map<String, String> headers,
+    required String query,
+    List<int> documents = const [],
+  }) {
+    final streamId = _nextStreamId++;
+    late final StreamController<SSEChunk> controller;
+    controller = StreamController<SSEChunk>(
+      onListen: () async {
+        _ensureListening();
+        _streams[streamId] = controller;
+        try {
+          await _methodChannel.invokeMethod<void>('start', {
+            'streamId': streamId,
+            'url': url,
+            'headers': headers,
+            'query': query,
+            if (documents.isNotEmpty) 'documents': documents,
+          });
+        } catch (e, stackTrace) {
+          _streams.remove(streamId);
+          controller.addError(e, stackTrace);
+          await controller.close();
+        }
+      },
+      onCancel: () async {
+        if (_streams.remove(streamId) != null) {
+          await _methodChannel.invokeMethod<void>('cancel', {
+            'streamId': streamId,
+          });
+        }
+      },
+    );
+    return controller.stream;
+  }
+
+  void _ensureListening() {
+    _eventSubscription ??=
+        _eventChannel.receiveBroadcastStream().listen(_handleBatch);
+  }
+
+  void _handleBatch(dynamic batch) {
+    for (final event in batch as List<dynamic>) {
+      final map = event as Map<dynamic, dynamic>;
+      final controller = _streams[map['streamId'] as int];
+      if (controller == null) continue;
+
+      final type = map['type'] as String;
+      if (type == 'streamEnd') {
+        _streams.remove(map['streamId']);
+        controller.close();
+      } else if (type == 'error' &&
+          _transportErrorKinds.contains(map['errorKind'])) {
+        controller.addError(NativeSseException(
+          map['errorKind'] as String,
+          map['error'] as String? ?? 'Unknown error',
+          statusCode: map['statusCode'] as int?,
+        ));
+      } else {
+        controller.add(_toChunk(type, map));
+      }
+    }
+  }
+
+  SSEChunk _toChunk(String type, Map<dynamic, dynamic> map) {
+    final metadata = map['metadata'];
+    return SSEChunk(
+      type: SSEEventType.values.byName(type),
+      text: map['text'] as String?,
+      error: map['error'] as String?,
+      metadata: metadata is Map ? _toJsonMap(metadata) : null,
+    );
+  }
+
+  /// StandardMessageCodec maps arrive as `Map<Object?, Object?>`; convert
+  /// them to the JSON-style maps the rest of the app expects.
+  static Map<String, dynamic> _toJsonMap(Map<dynamic, dynamic> map) {
+    return map.map((key, value) => MapEntry(key as String, _toJson(value)));
+  }
+
+  static dynamic _toJson(dynamic value) {
+    if (value is Map) return _toJsonMap(value);
+    if (value is List) return value.map(_toJson).toList();
+    return value;
+  }
+}
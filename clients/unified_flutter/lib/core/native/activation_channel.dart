@@ -0,0 +1,17 @@
+import 'package:flutter/services.dart';
+
+/// Command lines forwarded by later launches of the app (Windows).
+///
+/// The Windows runner keeps a single instance per session: a second launch,
+/// e.g. from a desktop shortcut, sends its arguments to the running instance
+/// over a named pipe, brings the existing window to the front and exits.
+/// Those arguments are delivered here.
+class ActivationChannel {
+  static const EventChannel _channel =
+      EventChannel('com.tamshai.ai/activation');
+
+  /// Arguments of each forwarded launch, excluding the executable path.
+  static Stream<List<String>> get activations => _channel
+      .receiveBroadcastStream()
+      .map((event) => (event as List<dynamic>).cast<String>());
+}
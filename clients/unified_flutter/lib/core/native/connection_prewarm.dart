@@ -0,0 +1,31 @@
+import 'dart:io' show Platform;
+
+import 'package:flutter/services.dart';
+
+import '../config/environment_config.dart';
+
+/// Tells the Windows runner which endpoints to warm up on the next launch.
+///
+/// The environment config is compiled into the app, so the runner can't read
+/// it before the engine has started. It warms up the endpoints recorded here
+/// instead, while the engine boots: it connects to the gateway on the session
+/// its native SSE transport uses, and only resolves Keycloak, whose requests
+/// dio makes over connections of its own.
+class ConnectionPrewarm {
+  static const MethodChannel _channel = MethodChannel('com.tamshai.ai/prewarm');
+
+  /// Whether the current platform warms up connections.
+  static bool get isSupported => Platform.isWindows;
+
+  /// Records the endpoints of [config].
+  static Future<void> record(EnvironmentConfig config) async {
+    try {
+      await _channel.invokeMethod<void>('record', {
+        'connect': [config.apiBaseUrl],
+        'resolve': [config.keycloakIssuer],
+      });
+    } on MissingPluginException {
+      // Nothing on the other end to warm up connections.
+    }
+  }
+}
@@ -0,0 +1,58 @@
+import 'package:flutter/services.dart';
+
+/// Resends plugin messages on behalf of the Windows runner's plugin loader.
+///
+/// The runner registers plugins that are not needed for the first frame on
+/// first use. Messages sent before a registration reach a stub rather than
+/// the plugin, so the runner hands them back here; sending them again
+/// delivers them to the now-registered plugin, and the plugin's replies are
+/// passed back to the original callers.
+///
+/// The plugin is registered by a `register` call sent right before the
+/// messages, with no chance for other code to send in between, so the
+/// messages reach the plugin in the order they were first sent. If more
+/// reached the stubs in the meantime, the runner answers with the whole
+/// queue instead, drops the messages just sent, and the batch is sent again.
+class DeferredPluginReplay {
+  static const MethodChannel _channel = MethodChannel('com.tamshai.ai/plugins');
+
+  /// Starts handling replay requests from the runner.
+  static void install() {
+    _channel.setMethodCallHandler(_handleCall);
+  }
+
+  static Future<List<Uint8List?>> _handleCall(MethodCall call) async {
+    if (call.method != 'replay') {
+      throw MissingPluginException('Unknown method ${call.method}');
+    }
+    final arguments = call.arguments as Map<dynamic, dynamic>;
+    final plugin = arguments['plugin'] as String;
+    var messages = arguments['messages'] as List<dynamic>;
+    final messenger = ServicesBinding.instance.defaultBinaryMessenger;
+    for (;;) {
+      // Both are sent before the first await.
+      final registered = _channel.invokeMethod<Object?>('register', {
+        'plugin': plugin,
+        'count': messages.length,
+      });
+      final replies = [
+        for (final message in messages.cast<Map<dynamic, dynamic>>())
+          messenger.send(
+            message['channel'] as String,
+            ByteData.sublistView(message['message'] as Uint8List),
+          ),
+      ];
+      final outcome = await registered;
+      if (outcome is List) {
+        // The stubs answer the dropped replays themselves.
+        await Future.wait(replies);
+        messages = outcome;
+        continue;
+      }
+      return [
+        for (final reply in await Future.wait(replies))
+          reply?.buffer.asUint8List(reply.offsetInBytes, reply.lengthInBytes),
+      ];
+    }
+  }
+}
@@ -0,0 +1,146 @@
+import 'dart:io' show Platform;
+import 'dart:typed_data';
+import 'dart:ui' show FramePhase, FrameTiming;
+
+import 'package:flutter/scheduler.dart';
+import 'package:flutter/services.dart';
+import 'package:flutter/widgets.dart';
+
+/// Frame pacing telemetry for the Windows runner.
+///
+/// Once [start]ed, the engine's [FrameTiming] batches are forwarded to the
+/// runner's `FrameTelemetryPlugin`, which joins them with the compositor's
+/// clock and keeps build, raster and present latency histograms. They are
+/// written to ETW alongside the runner's other trace events, and [summary]
+/// returns them to Dart.
+///
+/// Frames are tagged with the innermost phase entered with [enterPhase], such
+/// as a streaming reply or a generative component on screen, so jank can be
+/// traced to what the app was doing. [FrameTelemetryScope] does this for a
+/// widget's lifetime.
+class FrameTelemetry {
+  static const MethodChannel _channel =
+      MethodChannel('com.tamshai.ai/frame_telemetry');
+
+  /// Whether the current platform collects frame telemetry.
+  static bool get isSupported => Platform.isWindows;
+
+  static bool _started = false;
+
+  /// Phases entered and not yet exited, innermost last.
+  static final List<String> _phases = [];
+
+  /// The phase the runner was last told about.
+  static String? _sentPhase;
+
+  /// Starts forwarding frame timings to the runner.
+  static void start() {
+    if (_started) return;
+    _started = true;
+    SchedulerBinding.instance.addTimingsCallback(_reportTimings);
+    _syncPhase();
+  }
+
+  /// Stops forwarding frame timings.
+  static void stop() {
+    if (!_started) return;
+    _started = false;
+    _sentPhase = null;
+    SchedulerBinding.instance.removeTimingsCallback(_reportTimings);
+  }
+
+  /// Tags the frames that follow with [phase] until it is exited.
+  static void enterPhase(String phase) {
+    _phases.add(phase);
+    _syncPhase();
+  }
+
+  /// Exits the innermost [phase] entered with [enterPhase].
+  static void exitPhase(String phase) {
+    final index = _phases.lastIndexOf(phase);
+    if (index < 0) return;
+    _phases.removeAt(index);
+    _syncPhase();
+  }
+
+  /// The runner's percentiles and histograms for the frames it kept, or null
+  /// if the runner does not collect them.
+  static Future<Map<String, dynamic>?> summary() async {
+    try {
+      return await _channel.invokeMapMethod<String, dynamic>('summary');
+    } on MissingPluginException {
+      return null;
+    }
+  }
+
+  static void _reportTimings(List<FrameTiming> timings) {
+    final data = Int64List(timings.length * 3);
+    for (var i = 0; i < timings.length; i++) {
+      final timing = timings[i];
+      data[i * 3] = timing.buildDuration.inMicroseconds;
+      data[i * 3 + 1] = timing.rasterDuration.inMicroseconds;
+      data[i * 3 + 2] = timing.timestampInMicroseconds(FramePhase.rasterFinish);
+    }
+    _invoke('report', data);
+  }
+
+  static void _syncPhase() {
+    if (!_started) return;
+    final phase = _phases.isEmpty ? null : _phases.last;
+    if (phase == _sentPhase) return;
+    _sentPhase = phase;
+    _invoke('setPhase', {'phase': phase});
+  }
+
+  static Future<void> _invoke(String method, Object? arguments) async {
+    try {
+      await _channel.invokeMethod<void>(method, arguments);
+    } on MissingPluginException {
+      // Nothing on the other end; stop sending.
+      stop();
+    }
+  }
+}
+
+/// Tags the frames drawn while this widget is mounted with [phase].
+class FrameTelemetryScope extends StatefulWidget {
+  /// Name of the phase, such as `component:OrgChartComponent`.
+  final String phase;
+
+  final Widget child;
+
+  const FrameTelemetryScope({
+    super.key,
+    required this.phase,
+    required this.child,
+  });
+
+  @override
+  State<FrameTelemetryScope> createState() => _FrameTelemetryScopeState();
+}
+
+class _FrameTelemetryScopeState extends State<FrameTelemetryScope> {
+  @override
+  void initState() {
+    super.initState();
+    FrameTelemetry.enterPhase(widget.phase);
+  }
+
+  @override
+  void didUpdateWidget(FrameTelemetryScope oldWidget) {
+    super.didUpdateWidget(oldWidget);
+    if (oldWidget.phase != widget.phase) {
+      FrameTelemetry.exitPhase(oldWidget.phase);
+      FrameTelemetry.enterPhase(widget.phase);
+    }
+  }
+
+  @override
+  void dispose() {
+    FrameTelemetry.exitPhase(widget.phase);
+    super.dispose();
+  }
+
+  @override
+  Widget build(BuildContext context) => widget.child;
+}
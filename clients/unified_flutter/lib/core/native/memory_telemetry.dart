@@ -0,0 +1,162 @@
+import 'dart:io' show Platform;
+
+import 'package:flutter/services.dart';
+
+/// GPU memory the app uses on one adapter.
+class GpuMemoryUse {
+  final String adapter;
+
+  /// Dedicated video memory in use, and how much the OS lets the app use.
+  final int localBytes;
+  final int localBudgetBytes;
+
+  /// System memory the adapter uses on the app's behalf.
+  final int nonLocalBytes;
+
+  const GpuMemoryUse({
+    required this.adapter,
+    required this.localBytes,
+    required this.localBudgetBytes,
+    required this.nonLocalBytes,
+  });
+
+  factory GpuMemoryUse.fromMap(Map<Object?, Object?> map) => GpuMemoryUse(
+        adapter: map['adapter'] as String,
+        localBytes: map['localBytes'] as int,
+        localBudgetBytes: map['localBudgetBytes'] as int,
+        nonLocalBytes: map['nonLocalBytes'] as int,
+      );
+}
+
+/// The process's memory use at one point in time.
+class MemorySample {
+  final DateTime time;
+
+  /// The commit charge, and its peak since the process started.
+  final int privateBytes;
+  final int peakPrivateBytes;
+
+  final int workingSet;
+  final int peakWorkingSet;
+
+  final int handles;
+  final int gdiObjects;
+  final int userObjects;
+
+  /// One entry per hardware adapter.
+  final List<GpuMemoryUse> gpu;
+
+  const MemorySample({
+    required this.time,
+    required this.privateBytes,
+    required this.peakPrivateBytes,
+    required this.workingSet,
+    required this.peakWorkingSet,
+    required this.handles,
+    required this.gdiObjects,
+    required this.userObjects,
+    required this.gpu,
+  });
+
+  factory MemorySample.fromMap(Map<Object?, Object?> map) => MemorySample(
+        time: DateTime.fromMillisecondsSinceEpoch(map['timeMs'] as int),
+        privateBytes: map['privateBytes'] as int,
+        peakPrivateBytes: map['peakPrivateBytes'] as int,
+        workingSet: map['workingSet'] as int,
+        peakWorkingSet: map['peakWorkingSet'] as int,
+        handles: map['handles'] as int,
+        gdiObjects: map['gdiObjects'] as int,
+        userObjects: map['userObjects'] as int,
+        gpu: [
+          for (final use in map['gpu'] as List)
+            GpuMemoryUse.fromMap(use as Map<Object?, Object?>),
+        ],
+      );
+}
+
+/// Something that happened that may explain a change in memory use.
+class MemoryMarker {
+  final DateTime time;
+
+  /// `resize` or `dpi` for a window surface, `trim` or `restore` for the
+  /// runner's memory trimming, or `hidden` or `shown` for the app.
+  final String kind;
+
+  /// For surfaces, the new size in physical pixels and the DPI.
+  final int? width;
+  final int? height;
+  final int? dpi;
+
+  const MemoryMarker({
+    required this.time,
+    required this.kind,
+    this.width,
+    this.height,
+    this.dpi,
+  });
+
+  factory MemoryMarker.fromMap(Map<Object?, Object?> map) => MemoryMarker(
+        time: DateTime.fromMillisecondsSinceEpoch(map['timeMs'] as int),
+        kind: map['kind'] as String,
+        width: map['width'] as int?,
+        height: map['height'] as int?,
+        dpi: map['dpi'] as int?,
+      );
+}
+
+/// The runner's recent samples and markers, oldest first.
+class MemoryHistory {
+  final List<MemorySample> samples;
+  final List<MemoryMarker> markers;
+
+  const MemoryHistory({required this.samples, required this.markers});
+}
+
+/// Dart side of the Windows runner's `MemoryTelemetry`.
+///
+/// The runner samples process and GPU memory every thirty seconds and after
+/// window resizes, trims and visibility changes, which it also notes as
+/// markers. Everything is written to ETW as well; these calls read the
+/// samples it kept, so support tooling can tell leaks from oversized
+/// surfaces.
+class MemoryTelemetry {
+  static const MethodChannel _channel =
+      MethodChannel('com.tamshai.ai/memory_telemetry');
+
+  /// Whether the current platform samples memory.
+  static bool get isSupported => Platform.isWindows;
+
+  /// The samples and markers the runner kept, or null without the runner.
+  static Future<MemoryHistory?> history() async {
+    try {
+      final history = await _channel.invokeMapMethod<String, dynamic>(
+        'history',
+      );
+      if (history == null) return null;
+      return MemoryHistory(
+        samples: [
+          for (final sample in history['samples'] as List)
+            MemorySample.fromMap(sample as Map<Object?, Object?>),
+        ],
+        markers: [
+          for (final marker in history['markers'] as List)
+            MemoryMarker.fromMap(marker as Map<Object?, Object?>),
+        ],
+      );
+    } on MissingPluginException {
+      return null;
+    }
+  }
+
+  /// A sample taken now, or null without the runner.
+  static Future<MemorySample?> sample() async {
+    try {
+      final sample = await _channel.invokeMapMethod<Object?, Object?>(
+        'sample',
+      );
+      return sample == null ? null : MemorySample.fromMap(sample);
+    } on MissingPluginException {
+      return null;
+    }
+  }
+}
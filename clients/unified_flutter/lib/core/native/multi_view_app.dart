@@ -0,0 +1,87 @@
+import 'package:flutter/widgets.dart';
+
+import 'window_channel.dart';
+
+/// Root widget that renders into every view of the engine (Windows).
+///
+/// [mainView] fills the implicit view of the main window. Views opened with
+/// [WindowChannel.open] are built with [buildWindow] for the route they were
+/// opened with; until that route is known they stay empty.
+///
+/// Must be passed to `runWidget` rather than `runApp`, which only renders
+/// into the implicit view.
+class MultiViewApp extends StatefulWidget {
+  final Widget mainView;
+  final Widget Function(String route) buildWindow;
+
+  const MultiViewApp({
+    super.key,
+    required this.mainView,
+    required this.buildWindow,
+  });
+
+  @override
+  State<MultiViewApp> createState() => _MultiViewAppState();
+}
+
+class _MultiViewAppState extends State<MultiViewApp>
+    with WidgetsBindingObserver {
+  /// Ids of the extra views seen so far, to tell when one has gone.
+  final Set<int> _seenViewIds = {};
+
+  @override
+  void initState() {
+    super.initState();
+    WidgetsBinding.instance.addObserver(this);
+    WindowChannel.routes.addListener(_onRoutesChanged);
+  }
+
+  @override
+  void dispose() {
+    WindowChannel.routes.removeListener(_onRoutesChanged);
+    WidgetsBinding.instance.removeObserver(this);
+    super.dispose();
+  }
+
+  @override
+  void didChangeMetrics() {
+    // Called when views are added or removed, among other changes.
+    final viewIds = _extraViews().map((view) => view.viewId).toSet();
+    for (final viewId in _seenViewIds.difference(viewIds)) {
+      WindowChannel.forget(viewId);
+    }
+    _seenViewIds
+      ..clear()
+      ..addAll(viewIds);
+    setState(() {});
+  }
+
+  void _onRoutesChanged() => setState(() {});
+
+  Iterable<FlutterView> _extraViews() {
+    final dispatcher = WidgetsBinding.instance.platformDispatcher;
+    final implicitView = dispatcher.implicitView;
+    return dispatcher.views.where((view) => view != implicitView);
+  }
+
+  @override
+  Widget build(BuildContext context) {
+    final implicitView =
+        WidgetsBinding.instance.platformDispatcher.implicitView;
+    final routes = WindowChannel.routes.value;
+    return ViewCollection(
+      views: [
+        if (implicitView != null)
+          View(view: implicitView, child: widget.mainView),
+        for (final view in _extraViews())
+          View(
+            key: ValueKey(view.viewId),
+            view: view,
+            child: routes.containsKey(view.viewId)
+                ? widget.buildWindow(routes[view.viewId]!)
+                : const SizedBox.shrink(),
+          ),
+      ],
+    );
+  }
+}
@@ -0,0 +1,179 @@
+import 'dart:io' show Platform;
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+
+/// A condition rows must meet in a [NativeDataTable] query.
+class DataTableFilter {
+  /// One of `equals`, `atLeast`, `atMost` or `contains`.
+  final String op;
+
+  /// The columns the condition applies to; `contains` matches if any of them
+  /// does.
+  final List<String> columns;
+
+  final Object value;
+
+  const DataTableFilter._(this.op, this.columns, this.value);
+
+  /// Rows whose string [column] is exactly [value].
+  factory DataTableFilter.equals(String column, String value) =>
+      DataTableFilter._('equals', [column], value);
+
+  /// Rows whose number [column] is at least [value]; rows without one fail.
+  factory DataTableFilter.atLeast(String column, num value) =>
+      DataTableFilter._('atLeast', [column], value);
+
+  /// Rows whose number [column] is at most [value]; rows without one fail.
+  factory DataTableFilter.atMost(String column, num value) =>
+      DataTableFilter._('atMost', [column], value);
+
+  /// Rows where any of the string [columns] contains [text], ignoring case.
+  factory DataTableFilter.contains(List<String> columns, String text) =>
+      DataTableFilter._('contains', columns, text);
+
+  Map<String, Object?> toMap() => {
+        'op': op,
+        'columns': columns,
+        'value': value,
+      };
+}
+
+/// The order of a [NativeDataTable] query. Rows without a value come last
+/// either way.
+class DataTableSort {
+  final String column;
+  final bool ascending;
+
+  const DataTableSort(this.column, {this.ascending = true});
+
+  Map<String, Object?> toMap() => {'column': column, 'ascending': ascending};
+}
+
+/// One page of a [NativeDataTable] query.
+class DataTablePage {
+  /// How many rows matched in all.
+  final int total;
+
+  /// The indices, into the lists the table was loaded from, of the rows on
+  /// this page, in order.
+  final List<int> rows;
+
+  const DataTablePage({required this.total, required this.rows});
+}
+
+/// Dart side of the Windows runner's `DataTablePlugin`.
+///
+/// Large lists are loaded into the runner once, column by column; filtering
+/// and sorting then run there on every query, and only the indices of one
+/// page of rows come back, so the UI builds widgets for that page alone.
+class NativeDataTable {
+  static const MethodChannel _channel =
+      MethodChannel('com.tamshai.ai/data_table');
+
+  /// Whether the current platform provides the tables.
+  static bool get isSupported => Platform.isWindows;
+
+  final int _handle;
+
+  NativeDataTable._(this._handle);
+
+  /// Loads a table of the given [strings] and [numbers] columns, by name,
+  /// which must all be as long as each other.
+  ///
+  /// Returns null if the runner is missing or rejects the columns.
+  static Future<NativeDataTable?> load({
+    Map<String, List<String?>> strings = const {},
+    Map<String, List<double?>> numbers = const {},
+  }) async {
+    final columns = [
+      for (final entry in strings.entries)
+        {'name': entry.key, 'strings': entry.value},
+      for (final entry in numbers.entries)
+        {
+          'name': entry.key,
+          'numbers': Float64List.fromList(
+            [for (final value in entry.value) value ?? double.nan],
+          ),
+        },
+    ];
+    try {
+      final handle = await _channel.invokeMethod<int>(
+        'load',
+        {'columns': columns},
+      );
+      return handle == null ? null : NativeDataTable._(handle);
+    } on MissingPluginException {
+      return null;
+    } on PlatformException {
+      return null;
+    }
+  }
+
+  /// The rows that pass every filter in [filters], sorted by [sort], from
+  /// [offset] up to [limit] of them.
+  ///
+  /// Returns null if a later query of this table replaced this one before it
+  /// finished, or the query failed.
+  Future<DataTablePage?> query({
+    List<DataTableFilter> filters = const [],
+    DataTableSort? sort,
+    int offset = 0,
+    int limit = 100,
+  }) async {
+    try {
+      final page = await _channel.invokeMapMethod<String, dynamic>('query', {
+        'handle': _handle,
+        'filters': [for (final filter in filters) filter.toMap()],
+        'sort': sort?.toMap(),
+        'offset': offset,
+        'limit': limit,
+      });
+      if (page == null) return null;
+      return DataTablePage(
+        total: page['total'] as int,
+        rows: page['rows'] as Int32List,
+      );
+    } on MissingPluginException {
+      return null;
+    } on PlatformException {
+      return null;
+    }
+  }
+
+  /// How many of the rows that pass [filters] have each value of the string
+  /// [column], in sort order of the values. Empty if the count failed.
+  Future<Map<String, int>> group(
+    String column, {
+    List<DataTableFilter> filters = const [],
+  }) async {
+    try {
+      final reply = await _channel.invokeMapMethod<String, dynamic>('group', {
+        'handle': _handle,
+        'column': column,
+        'filters': [for (final filter in filters) filter.toMap()],
+      });
+      if (reply == null) return const {};
+      final values = (reply['values'] as List).cast<String>();
+      final counts = reply['counts'] as Int32List;
+      return {
+        for (var i = 0; i < values.length; i++) values[i]: counts[i],
+      };
+    } on MissingPluginException {
+      return const {};
+    } on PlatformException {
+      return const {};
+    }
+  }
+
+  /// Frees the table in the runner. The table can't be queried afterwards.
+  Future<void> dispose() async {
+    try {
+      await _channel.invokeMethod<void>('release', {'handle': _handle});
+    } on MissingPluginException {
+      // Nothing was loaded.
+    } on PlatformException {
+      // Already gone.
+    }
+  }
+}
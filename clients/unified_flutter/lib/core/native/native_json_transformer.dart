@@ -0,0 +1,147 @@
+import 'dart:io' show Platform;
+import 'dart:isolate';
+import 'dart:typed_data';
+
+import 'package:dio/dio.dart';
+import 'package:flutter/services.dart';
+
+/// Dio transformer that parses large JSON responses in the Windows runner.
+///
+/// Generated components such as org charts and lead tables can be several
+/// megabytes. Responses at least [nativeThreshold] bytes long are handed to
+/// the runner's `JsonDecoderPlugin`, which parses them on a native thread and
+/// replies in the channel's binary codec. The call is made from a background
+/// isolate, which unpacks the reply with [JsonMessageCodec] straight into the
+/// types `jsonDecode` uses, so the UI isolate only receives the finished
+/// document, handed over without a copy. Smaller responses, those the plugin
+/// can't parse, and everything when the plugin is missing take the usual
+/// [BackgroundTransformer] path, which parses anything over 50 KB in a
+/// background isolate too.
+class NativeJsonTransformer extends BackgroundTransformer {
+  static const MethodChannel _channel = MethodChannel(
+    'com.tamshai.ai/json',
+    StandardMethodCodec(JsonMessageCodec()),
+  );
+
+  /// Whether the current platform provides the native parser.
+  static bool get isSupported => Platform.isWindows;
+
+  /// Responses shorter than this are not worth a channel round trip.
+  final int nativeThreshold;
+
+  bool _pluginMissing = false;
+
+  NativeJsonTransformer({this.nativeThreshold = 64 * 1024});
+
+  @override
+  Future<dynamic> transformResponse(
+    RequestOptions options,
+    ResponseBody responseBody,
+  ) async {
+    if (_pluginMissing ||
+        options.responseType != ResponseType.json ||
+        options.responseDecoder != null ||
+        !Transformer.isJsonMimeType(
+          responseBody.headers[Headers.contentTypeHeader]?.first,
+        )) {
+      return super.transformResponse(options, responseBody);
+    }
+
+    final builder = BytesBuilder(copy: false);
+    await for (final chunk in responseBody.stream) {
+      builder.add(chunk);
+    }
+    final bytes = builder.takeBytes();
+
+    // Background isolates can only reach the runner with the root isolate's
+    // token, which is missing where there is no engine, as in tests.
+    final token = RootIsolateToken.instance;
+    if (bytes.length >= nativeThreshold && token != null) {
+      final result = await _decodeOffUiIsolate(token, bytes);
+      if (result.decoded) {
+        return result.document;
+      }
+      _pluginMissing = result.pluginMissing;
+    }
+    return super.transformResponse(
+      options,
+      ResponseBody.fromBytes(
+        bytes,
+        responseBody.statusCode,
+        statusMessage: responseBody.statusMessage,
+        isRedirect: responseBody.isRedirect,
+        redirects: responseBody.redirects,
+        headers: responseBody.headers,
+      ),
+    );
+  }
+
+  /// Decodes [bytes] with the runner's plugin in a new isolate.
+  ///
+  /// Static, so that the closure sent to the isolate holds only its
+  /// arguments.
+  static Future<_NativeResult> _decodeOffUiIsolate(
+    RootIsolateToken token,
+    Uint8List bytes,
+  ) {
+    return Isolate.run(() async {
+      BackgroundIsolateBinaryMessenger.ensureInitialized(token);
+      try {
+        final value = await _channel.invokeMethod<Object?>('decode', bytes);
+        return (decoded: true, pluginMissing: false, document: value);
+      } on MissingPluginException {
+        return (decoded: false, pluginMissing: true, document: null);
+      } catch (_) {
+        // A document the plugin rejects, or a reply the codec can't read,
+        // such as a string that isn't valid UTF-8. The usual path deals with
+        // the response as it would have without the plugin.
+        return (decoded: false, pluginMissing: false, document: null);
+      }
+    });
+  }
+
+  /// Retypes a decoded channel value the way `jsonDecode` types documents,
+  /// so that generated `fromJson` factories can cast maps to
+  /// `Map<String, dynamic>`.
+  static dynamic asJson(Object? value) {
+    if (value is Map) {
+      return <String, dynamic>{
+        for (final entry in value.entries)
+          entry.key as String: asJson(entry.value),
+      };
+    }
+    if (value is List) {
+      return <dynamic>[for (final element in value) asJson(element)];
+    }
+    return value;
+  }
+}
+
+/// Reads channel values the way `jsonDecode` types documents.
+///
+/// [StandardMessageCodec] reads maps as `Map<Object?, Object?>`, which
+/// generated `fromJson` factories can't cast to `Map<String, dynamic>`; this
+/// reads them as the latter to begin with, rather than retyping the tree
+/// afterwards with [NativeJsonTransformer.asJson].
+class JsonMessageCodec extends StandardMessageCodec {
+  const JsonMessageCodec();
+
+  /// The standard codec's type byte for maps.
+  static const int _valueMap = 13;
+
+  @override
+  Object? readValueOfType(int type, ReadBuffer buffer) {
+    if (type != _valueMap) {
+      return super.readValueOfType(type, buffer);
+    }
+    final length = readSize(buffer);
+    final map = <String, dynamic>{};
+    for (var i = 0; i < length; i++) {
+      map[readValue(buffer)! as String] = readValue(buffer);
+    }
+    return map;
+  }
+}
+
+/// What [NativeJsonTransformer._decodeOffUiIsolate] got from the plugin.
+typedef _NativeResult = ({bool decoded, bool pluginMissing, Object? document});
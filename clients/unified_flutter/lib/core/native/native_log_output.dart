@@ -0,0 +1,84 @@
+import 'dart:async';
+import 'dart:convert';
+import 'dart:io' show Platform;
+import 'dart:typed_data';
+
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+import 'package:logger/logger.dart';
+
+/// Log output for the Windows runner's `LogSink`.
+///
+/// Records are batched and sent to the runner as one binary message every
+/// [flushInterval], or sooner once a batch grows large or an error is logged.
+/// The runner writes them to its log file, ETW and any console from a thread
+/// of its own, so logging never waits on console output.
+class NativeLogOutput extends LogOutput {
+  static const String _channel = 'com.tamshai.ai/log';
+
+  /// Batched bytes that are sent without waiting for the timer.
+  static const int _maxBatchBytes = 16 * 1024;
+
+  /// Whether the current platform provides the native log.
+  static bool get isSupported => Platform.isWindows;
+
+  /// Routes the app's logging to the runner: [Logger]s created from now on,
+  /// and [debugPrint], which the framework reports errors through.
+  static void install() {
+    final output = NativeLogOutput();
+    Logger.defaultOutput = () => output;
+    debugPrint = (String? message, {int? wrapWidth}) {
+      if (message != null) output.write(Level.info, message);
+    };
+  }
+
+  final Duration flushInterval;
+  final BytesBuilder _batch = BytesBuilder(copy: false);
+  Timer? _timer;
+
+  NativeLogOutput({this.flushInterval = const Duration(milliseconds: 100)});
+
+  @override
+  void output(OutputEvent event) {
+    write(event.level, event.lines.join('\n'));
+  }
+
+  /// Queues [message] at [level] for the next batch.
+  void write(Level level, String message) {
+    final bytes = utf8.encode(message);
+    _batch
+      ..addByte(_wireLevel(level))
+      ..add((ByteData(4)..setUint32(0, bytes.length, Endian.little))
+          .buffer
+          .asUint8List())
+      ..add(bytes);
+    if (_batch.length >= _maxBatchBytes || level.value >= Level.error.value) {
+      flush();
+    } else {
+      _timer ??= Timer(flushInterval, flush);
+    }
+  }
+
+  /// Sends the records batched so far.
+  void flush() {
+    _timer?.cancel();
+    _timer = null;
+    if (_batch.isEmpty) return;
+    final bytes = _batch.takeBytes();
+    ServicesBinding.instance.defaultBinaryMessenger
+        .send(_channel, ByteData.sublistView(bytes));
+  }
+
+  @override
+  Future<void> destroy() async => flush();
+
+  /// The runner's level numbers, 0 for trace to 5 for fatal.
+  static int _wireLevel(Level level) {
+    if (level.value >= Level.fatal.value) return 5;
+    if (level.value >= Level.error.value) return 4;
+    if (level.value >= Level.warning.value) return 3;
+    if (level.value >= Level.info.value) return 2;
+    if (level.value >= Level.debug.value) return 1;
+    return 0;
+  }
+}
@@ -0,0 +1,118 @@
+import 'dart:io' show Platform;
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+
+import 'native_json_transformer.dart';
+
+/// A response held by the Windows runner's response cache.
+class CachedResponse {
+  /// The decoded JSON body.
+  final dynamic value;
+
+  /// The ETag it was served with, or null.
+  final String? etag;
+
+  /// Whether it is within its max-age; stale responses should be shown while
+  /// they are revalidated.
+  final bool fresh;
+
+  /// How long ago it was fetched or last revalidated.
+  final Duration age;
+
+  const CachedResponse({
+    required this.value,
+    this.etag,
+    required this.fresh,
+    required this.age,
+  });
+}
+
+/// Dart side of the Windows runner's `ResponseCachePlugin`.
+///
+/// The runner keeps responses in an encrypted, memory-mapped file shared by
+/// every window and kept across launches, checks their freshness against the
+/// Cache-Control they arrived with, and decodes them on its own thread, so a
+/// hit is a ready JSON value. Without the runner every lookup misses.
+class NativeResponseCache {
+  static const MethodChannel _channel =
+      MethodChannel('com.tamshai.ai/response_cache');
+
+  /// Whether the current platform provides the cache.
+  static bool get isSupported => Platform.isWindows;
+
+  /// The key for [request] made by [user] of [tenant], so that users and
+  /// deployments never see each other's responses.
+  static String keyFor({
+    required String tenant,
+    required String user,
+    required String request,
+  }) =>
+      '$tenant\n$user\n$request';
+
+  /// The response cached under [key], or null.
+  Future<CachedResponse?> get(String key) async {
+    try {
+      final hit = await _channel.invokeMapMethod<String, dynamic>(
+        'get',
+        {'key': key},
+      );
+      if (hit == null) return null;
+      return CachedResponse(
+        value: NativeJsonTransformer.asJson(hit['value']),
+        etag: hit['etag'] as String?,
+        fresh: hit['fresh'] as bool,
+        age: Duration(milliseconds: hit['ageMs'] as int),
+      );
+    } on MissingPluginException {
+      return null;
+    } on PlatformException {
+      return null;
+    }
+  }
+
+  /// Caches the JSON [body] under [key] as its [cacheControl] allows, and
+  /// returns it decoded. A body with the cached [etag] only renews the cached
+  /// response.
+  ///
+  /// Returns null if the body is not JSON or the runner is missing, in which
+  /// case nothing is cached.
+  Future<dynamic> put(
+    String key,
+    Uint8List body, {
+    String? etag,
+    String? cacheControl,
+  }) async {
+    try {
+      final value = await _channel.invokeMethod<Object?>('put', {
+        'key': key,
+        'body': body,
+        'etag': etag,
+        'cacheControl': cacheControl,
+      });
+      return NativeJsonTransformer.asJson(value);
+    } on MissingPluginException {
+      return null;
+    } on PlatformException {
+      return null;
+    }
+  }
+
+  /// Renews the response cached under [key], after the server answered a
+  /// revalidation with 304 Not Modified.
+  Future<void> touch(String key, {String? cacheControl}) =>
+      _invoke('touch', {'key': key, 'cacheControl': cacheControl});
+
+  /// Forgets every cached response, as when the user signs out.
+  Future<void> clear() => _invoke('clear', null);
+
+  Future<void> _invoke(String method, Object? arguments) async {
+    try {
+      await _channel.invokeMethod<void>(method, arguments);
+    } on MissingPluginException {
+      // Nothing cached to renew or forget.
+    } on PlatformException {
+      // The cache could not be opened.
+    }
+  }
+}
@@ -0,0 +1,63 @@
+import 'dart:io' show Platform;
+import 'dart:ui' show Size;
+
+import 'package:flutter/foundation.dart';
+import 'package:flutter/services.dart';
+
+/// Extra top-level windows on the app's engine (Windows).
+///
+/// The runner's `MultiWindowPlugin` opens each window as another view of the
+/// running engine, so it shares the isolate and Riverpod state with the main
+/// window. `MultiViewApp` builds the content of each view from the route it
+/// was opened with.
+class WindowChannel {
+  static const MethodChannel _channel = MethodChannel('com.tamshai.ai/windows');
+
+  /// Whether the current platform can open extra windows.
+  static bool get isSupported => Platform.isWindows;
+
+  /// The route each open extra window shows, by view id.
+  static final ValueNotifier<Map<int, String>> routes =
+      ValueNotifier<Map<int, String>>(const {});
+
+  /// Opens the window called [name] showing [route], or brings it to the
+  /// front if it is already open. [size] is in logical pixels.
+  ///
+  /// Returns the window's view id, or null if windows are not supported.
+  static Future<int?> open({
+    required String name,
+    required String route,
+    String? title,
+    Size? size,
+  }) async {
+    final int? viewId;
+    try {
+      viewId = await _channel.invokeMethod<int>('open', {
+        'name': name,
+        if (title != null) 'title': title,
+        if (size != null) 'width': size.width.round(),
+        if (size != null) 'height': size.height.round(),
+      });
+    } on MissingPluginException {
+      return null;
+    }
+    if (viewId != null && routes.value[viewId] != route) {
+      routes.value = {...routes.value, viewId: route};
+    }
+    return viewId;
+  }
+
+  /// Closes the window showing the view [viewId].
+  static Future<void> close(int viewId) async {
+    await _channel.invokeMethod<void>('close', {'viewId': viewId});
+    forget(viewId);
+  }
+
+  /// Drops the route of a view that has gone, e.g. because the user closed
+  /// its window.
+  static void forget(int viewId) {
+    if (routes.value.containsKey(viewId)) {
+      routes.value = Map.of(routes.value)..remove(viewId);
+    }
+  }
+}
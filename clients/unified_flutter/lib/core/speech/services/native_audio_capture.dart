@@ -0,0 +1,150 @@
+import 'dart:async';
+import 'dart:io' show Platform;
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+
+/// Error raised when the microphone cannot be opened or stops working.
+///
+/// [code] is `permission_denied` when the Windows privacy settings block the
+/// microphone, and `unavailable` when there is none or it went away.
+class NativeAudioCaptureException implements Exception {
+  final String code;
+  final String message;
+
+  const NativeAudioCaptureException(this.code, this.message);
+
+  @override
+  String toString() => 'NativeAudioCaptureException($code): $message';
+}
+
+/// Format of the frames delivered by [NativeAudioCapture].
+class AudioCaptureFormat {
+  final int sampleRate;
+  final int channels;
+
+  /// Samples per channel in each frame.
+  final int frameSamples;
+
+  const AudioCaptureFormat({
+    required this.sampleRate,
+    required this.channels,
+    required this.frameSamples,
+  });
+
+  /// Bytes in each frame of 16-bit samples.
+  int get frameBytes => frameSamples * channels * 2;
+
+  Duration get frameDuration =>
+      Duration(microseconds: frameSamples * 1000000 ~/ sampleRate);
+}
+
+/// Microphone capture backed by the Windows runner (`AudioCapturePlugin`).
+///
+/// The runner reads the default communications microphone with WASAPI on a
+/// real-time thread and hands over whole frames of 16-bit little-endian mono
+/// PCM, each [AudioCaptureFormat.frameBytes] long, about one frame period
+/// after their last sample was recorded.
+class NativeAudioCapture {
+  static const MethodChannel _methodChannel =
+      MethodChannel('com.tamshai.ai/audio_capture');
+  static const EventChannel _eventChannel =
+      EventChannel('com.tamshai.ai/audio_capture/frames');
+
+  /// Whether the current platform provides native capture.
+  static bool get isSupported => Platform.isWindows;
+
+  final StreamController<Uint8List> _frames =
+      StreamController<Uint8List>.broadcast();
+  StreamSubscription<dynamic>? _subscription;
+  AudioCaptureFormat? _format;
+
+  /// Captured frames, oldest first; views into the runner's batches, so
+  /// copy them to keep them beyond the listener.
+  Stream<Uint8List> get frames => _frames.stream;
+
+  /// Format of the running capture, or null when stopped.
+  AudioCaptureFormat? get format => _format;
+
+  /// Opens the microphone at [sampleRate] with frames of [frameMs].
+  ///
+  /// Throws [NativeAudioCaptureException] if it cannot be opened.
+  Future<AudioCaptureFormat> start({
+    int sampleRate = 16000,
+    int frameMs = 10,
+  }) async {
+    final running = _format;
+    if (running != null) return running;
+
+    // Listen first: the runner does not keep frames for a missing listener.
+    _subscription ??= _eventChannel.receiveBroadcastStream().listen(
+          _onFrames,
+          onError: _onError,
+        );
+    final Map<String, dynamic>? reply;
+    try {
+      reply = await _methodChannel.invokeMapMethod<String, dynamic>('start', {
+        'sampleRate': sampleRate,
+        'frameMs': frameMs,
+      });
+    } on PlatformException catch (e) {
+      await _cancelSubscription();
+      throw NativeAudioCaptureException(
+        e.code,
+        e.message ?? 'Audio capture failed',
+      );
+    }
+    final format = AudioCaptureFormat(
+      sampleRate: reply!['sampleRate'] as int,
+      channels: reply['channels'] as int,
+      frameSamples: reply['frameSamples'] as int,
+    );
+    _format = format;
+    return format;
+  }
+
+  /// Closes the microphone once the frames already captured are delivered.
+  Future<void> stop() async {
+    if (_subscription == null) return;
+    await _methodChannel.invokeMethod<void>('stop');
+    _format = null;
+    await _cancelSubscription();
+  }
+
+  /// Stops capturing and closes [frames].
+  Future<void> dispose() async {
+    await stop();
+    await _frames.close();
+  }
+
+  void _onFrames(dynamic data) {
+    final format = _format;
+    if (format == null) return;
+    final bytes = data as Uint8List;
+    final frameBytes = format.frameBytes;
+    for (var offset = 0;
+        offset + frameBytes <= bytes.length;
+        offset += frameBytes) {
+      _frames.add(Uint8List.sublistView(bytes, offset, offset + frameBytes));
+    }
+  }
+
+  void _onError(Object error) {
+    _format = null;
+    _cancelSubscription();
+    _frames.addError(
+      error is PlatformException
+          ? NativeAudioCaptureException(
+              error.code,
+              error.message ?? 'Audio capture failed',
+            )
+          : error,
+    );
+  }
+
+  Future<void> _cancelSubscription() async {
+    final subscription = _subscription;
+    _subscription = null;
+    await subscription?.cancel();
+  }
+}
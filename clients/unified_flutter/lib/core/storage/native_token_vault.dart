@@ -0,0 +1,56 @@
+import 'dart:io' show Platform;
+
+import 'package:flutter/services.dart';
+
+/// Token store backed by the Windows runner (`TokenVaultPlugin`).
+///
+/// The runner keeps all entries in one DPAPI-encrypted bundle, so storing a
+/// refreshed set of tokens is one channel call, one encryption and one
+/// atomic write. Entries are read in one call as well, and kept here after
+/// that, so later reads need no channel call at all.
+class NativeTokenVault {
+  static const MethodChannel _channel =
+      MethodChannel('com.tamshai.ai/token_vault');
+
+  /// Whether the current platform provides the native vault.
+  static bool get isSupported => Platform.isWindows;
+
+  Future<Map<String, String>>? _entries;
+
+  /// Every stored entry.
+  Future<Map<String, String>> readAll() {
+    return _entries ??= _load();
+  }
+
+  Future<Map<String, String>> _load() async {
+    try {
+      final entries = await _channel.invokeMapMethod<String, String>('getAll');
+      return entries ?? {};
+    } catch (_) {
+      // Let the next read try again.
+      _entries = null;
+      rethrow;
+    }
+  }
+
+  /// Sets every entry in [values] in one write; entries whose value is null
+  /// are removed.
+  Future<void> writeAll(Map<String, String?> values) async {
+    await _channel.invokeMethod<void>('putAll', {'values': values});
+    final entries = Map.of(await readAll());
+    values.forEach((key, value) {
+      if (value == null) {
+        entries.remove(key);
+      } else {
+        entries[key] = value;
+      }
+    });
+    _entries = Future.value(entries);
+  }
+
+  /// Removes every entry.
+  Future<void> clear() async {
+    await _channel.invokeMethod<void>('clear');
+    _entries = Future.value({});
+  }
+}
@@ -4,6 +4,7 @@ import 'package:flutter_secure_storage/flutter_secure_storage.dart';
 import 'package:logger/logger.dart';
 import '../auth/models/auth_state.dart';
 import '../config/environment_config.dart';
+import 'native_token_vault.dart';
 
 /// Secure storage service for authentication tokens and user data
 ///
@@ -12,12 +13,19 @@ import '../config/environment_config.dart';
 /// - iOS: Uses Keychain with biometric access control
 /// - Android: Uses KeyStore with biometric authentication
 ///
+/// On Windows the tokens, profile and flags live in the runner's
+/// [NativeTokenVault] instead, which reads and writes them all in one call.
+/// Entries left in Credential Manager by older versions move there on first
+/// use.
+///
 /// The refresh token is stored with biometric protection enabled,
 /// requiring Face ID, Touch ID, or Windows Hello to access.
 class SecureStorageService {
   final FlutterSecureStorage _storage;
   final FlutterSecureStorage _biometricStorage;
+  final NativeTokenVault? _vault;
   final Logger _logger;
+  Future<void>? _vaultMigration;
 
   // Storage keys
   static const _accessTokenKey = 'access_token';
@@ -28,12 +36,26 @@ class SecureStorageService {
   static const _biometricEnabledKey = 'biometric_enabled';
   static const _tokenIssuerKey = 'token_issuer';
 
+  /// Keys kept in the native vault where there is one
+  static const _vaultKeys = [
+    _accessTokenKey,
+    _refreshTokenKey,
+    _idTokenKey,
+    _tokenExpiryKey,
+    _userProfileKey,
+    _biometricEnabledKey,
+    _tokenIssuerKey,
+  ];
+
   SecureStorageService({
     FlutterSecureStorage? storage,
     FlutterSecureStorage? biometricStorage,
+    NativeTokenVault? vault,
     Logger? logger,
   })  : _storage = storage ?? const FlutterSecureStorage(),
         _biometricStorage = biometricStorage ?? _createBiometricStorage(),
+        _vault =
+            vault ?? (NativeTokenVault.isSupported ? NativeTokenVault() : null),
         _logger = logger ?? Logger();
 
   /// Create storage with biometric protection enabled
@@ -58,12 +80,61 @@ class SecureStorageService {
     }
   }
 
+  /// Read one entry, from the vault where there is one
+  Future<String?> _read(String key) async {
+    final vault = _vault;
+    if (vault == null) return _storage.read(key: key);
+    await _migrateToVault(vault);
+    return (await vault.readAll())[key];
+  }
+
+  /// Write several entries at once; null values delete their entry
+  Future<void> _writeAll(Map<String, String?> values) async {
+    final vault = _vault;
+    if (vault == null) {
+      // Store sequentially to ensure all writes complete
+      for (final entry in values.entries) {
+        if (entry.value == null) {
+          await _storage.delete(key: entry.key);
+        } else {
+          await _storage.write(key: entry.key, value: entry.value);
+        }
+      }
+      return;
+    }
+    await _migrateToVault(vault);
+    await vault.writeAll(values);
+  }
+
+  /// Move entries stored by versions without the vault into it, once
+  Future<void> _migrateToVault(NativeTokenVault vault) {
+    return _vaultMigration ??= () async {
+      try {
+        if ((await vault.readAll()).isNotEmpty) return;
+        final legacy = await _storage.readAll();
+        final values = {
+          for (final key in _vaultKeys)
+            if (legacy[key] != null) key: legacy[key],
+        };
+        if (values.isEmpty) return;
+        _logger.i('Moving ${values.length} entries to the token vault');
+        await vault.writeAll(values);
+        await Future.wait(values.keys.map((key) => _storage.delete(key: key)));
+      } catch (e, stackTrace) {
+        _vaultMigration = null;
+        _logger.e('Failed to migrate to the token vault',
+            error: e, stackTrace: stackTrace);
+        rethrow;
+      }
+    }();
+  }
+
   /// Validate that stored tokens match current environment issuer.
   /// Clears all tokens if issuer has changed (e.g., switching from vps to www).
   /// Returns true if tokens are valid for current environment, false if cleared.
   Future<bool> validateStoredIssuer() async {
     try {
-      final storedIssuer = await _storage.read(key: _tokenIssuerKey);
+      final storedIssuer = await _read(_tokenIssuerKey);
       final currentIssuer = EnvironmentConfig.current.keycloakIssuer;
 
       if (storedIssuer == null) {
@@ -108,14 +179,15 @@ class SecureStorageService {
       _logger.i('  - expiry: $expiryString');
       _logger.i('  - issuer: $currentIssuer');
 
-      // Store tokens sequentially to ensure all writes complete
-      await _storage.write(key: _accessTokenKey, value: tokens.accessToken);
-      await _storage.write(key: _idTokenKey, value: tokens.idToken);
-      await _storage.write(key: _tokenExpiryKey, value: expiryString);
-      await _storage.write(key: _tokenIssuerKey, value: currentIssuer);
+      await _writeAll({
+        _accessTokenKey: tokens.accessToken,
+        _idTokenKey: tokens.idToken,
+        _tokenExpiryKey: expiryString,
+        _tokenIssuerKey: currentIssuer,
+        if (tokens.refreshToken != null) _refreshTokenKey: tokens.refreshToken,
+      });
 
       if (tokens.refreshToken != null) {
-        await _storage.write(key: _refreshTokenKey, value: tokens.refreshToken);
         _logger.i('  - refresh_token stored');
       } else {
         _logger.w('  - NO refresh_token to store!');
@@ -131,7 +203,7 @@ class SecureStorageService {
   /// Retrieve access token
   Future<String?> getAccessToken() async {
     try {
-      return await _storage.read(key: _accessTokenKey);
+      return await _read(_accessTokenKey);
     } catch (e, stackTrace) {
       _logger.e('Failed to read access token', error: e, stackTrace: stackTrace);
       return null;
@@ -141,7 +213,7 @@ class SecureStorageService {
   /// Retrieve refresh token
   Future<String?> getRefreshToken() async {
     try {
-      return await _storage.read(key: _refreshTokenKey);
+      return await _read(_refreshTokenKey);
     } catch (e, stackTrace) {
       _logger.e('Failed to read refresh token', error: e, stackTrace: stackTrace);
       return null;
@@ -151,7 +223,7 @@ class SecureStorageService {
   /// Retrieve ID token
   Future<String?> getIdToken() async {
     try {
-      return await _storage.read(key: _idTokenKey);
+      return await _read(_idTokenKey);
     } catch (e, stackTrace) {
       _logger.e('Failed to read ID token', error: e, stackTrace: stackTrace);
       return null;
@@ -161,7 +233,7 @@ class SecureStorageService {
   /// Check if access token is expired
   Future<bool> isTokenExpired() async {
     try {
-      final expiryString = await _storage.read(key: _tokenExpiryKey);
+      final expiryString = await _read(_tokenExpiryKey);
       if (expiryString == null) {
         _logger.w('isTokenExpired: No expiry stored, treating as expired');
         return true;
@@ -191,7 +263,7 @@ class SecureStorageService {
   Future<void> storeUserProfile(AuthUser user) async {
     try {
       final jsonString = jsonEncode(user.toJson());
-      await _storage.write(key: _userProfileKey, value: jsonString);
+      await _writeAll({_userProfileKey: jsonString});
       _logger.d('User profile stored');
     } catch (e, stackTrace) {
       _logger.e('Failed to store user profile', error: e, stackTrace: stackTrace);
@@ -202,7 +274,7 @@ class SecureStorageService {
   /// Retrieve user profile
   Future<AuthUser?> getUserProfile() async {
     try {
-      final jsonString = await _storage.read(key: _userProfileKey);
+      final jsonString = await _read(_userProfileKey);
       if (jsonString == null) return null;
 
       final json = jsonDecode(jsonString) as Map<String, dynamic>;
@@ -234,14 +306,12 @@ class SecureStorageService {
   /// Clear all stored authentication data
   Future<void> clearAll() async {
     try {
+      final vault = _vault;
       await Future.wait([
-        _storage.delete(key: _accessTokenKey),
-        _storage.delete(key: _refreshTokenKey),
-        _storage.delete(key: _idTokenKey),
-        _storage.delete(key: _tokenExpiryKey),
-        _storage.delete(key: _userProfileKey),
-        _storage.delete(key: _biometricEnabledKey),
-        _storage.delete(key: _tokenIssuerKey),
+        if (vault != null)
+          vault.writeAll({for (final key in _vaultKeys) key: null})
+        else
+          for (final key in _vaultKeys) _storage.delete(key: key),
         _biometricStorage.delete(key: _refreshTokenKey),
       ]);
       _logger.d('All auth data cleared');
@@ -257,6 +327,7 @@ class SecureStorageService {
       await Future.wait([
         _storage.deleteAll(),
         _biometricStorage.deleteAll(),
+        if (_vault != null) _vault.clear(),
       ]);
       _logger.w('All secure storage data deleted');
     } catch (e, stackTrace) {
@@ -272,7 +343,7 @@ class SecureStorageService {
   /// Check if biometric unlock is enabled
   Future<bool> isBiometricUnlockEnabled() async {
     try {
-      final value = await _storage.read(key: _biometricEnabledKey);
+      final value = await _read(_biometricEnabledKey);
       return value == 'true';
     } catch (e) {
       _logger.e('Failed to check biometric status', error: e);
@@ -292,7 +363,7 @@ class SecureStorageService {
       );
 
       // Mark biometric as enabled
-      await _storage.write(key: _biometricEnabledKey, value: 'true');
+      await _writeAll({_biometricEnabledKey: 'true'});
 
       _logger.i('Biometric unlock enabled');
     } catch (e, stackTrace) {
@@ -308,7 +379,7 @@ class SecureStorageService {
 
       await Future.wait([
         _biometricStorage.delete(key: _refreshTokenKey),
-        _storage.delete(key: _biometricEnabledKey),
+        _writeAll({_biometricEnabledKey: null}),
       ]);
 
       _logger.i('Biometric unlock disabled');
@@ -4,6 +4,7 @@ import 'package:flutter_riverpod/flutter_riverpod.dart';
 import 'package:go_router/go_router.dart';
 import '../../core/chat/models/chat_state.dart';
 import '../../core/chat/providers/chat_provider.dart';
+import '../../core/chat/services/native_document_ingest.dart';
 import '../../core/widgets/dialogs.dart';
 import 'widgets/message_bubble.dart';
 import 'widgets/chat_input.dart';
@@ -63,6 +64,7 @@ class _ChatScreenState extends ConsumerState<ChatScreen> {
   @override
   Widget build(BuildContext context) {
     final chatState = ref.watch(chatNotifierProvider);
+    final attachments = ref.watch(chatAttachmentsProvider);
     final theme = Theme.of(context);
 
     // Auto-scroll when new messages arrive
@@ -187,6 +189,9 @@ class _ChatScreenState extends ConsumerState<ChatScreen> {
                   ),
           ),
 
+          // Documents dropped onto the window, sent with the next message
+          if (attachments.isNotEmpty) _buildAttachments(attachments, theme),
+
           // Input area
           ChatInput(
             controller: _textController,
@@ -243,6 +248,42 @@ class _ChatScreenState extends ConsumerState<ChatScreen> {
     );
   }
 
+  Widget _buildAttachments(List<IngestedDocument> attachments, ThemeData theme) {
+    return Padding(
+      padding: const EdgeInsets.fromLTRB(16, 8, 16, 0),
+      child: Wrap(
+        spacing: 8,
+        runSpacing: 8,
+        children: [
+          for (final document in attachments)
+            Tooltip(
+              message: document.errorMessage ?? document.name,
+              child: InputChip(
+                avatar: switch (document.state) {
+                  IngestState.ingesting => SizedBox.square(
+                      dimension: 16,
+                      child: CircularProgressIndicator(
+                        strokeWidth: 2,
+                        value: document.progress,
+                      ),
+                    ),
+                  IngestState.ready => const Icon(Icons.description_outlined),
+                  IngestState.failed => Icon(
+                      Icons.error_outline,
+                      color: theme.colorScheme.error,
+                    ),
+                },
+                label: Text(document.name),
+                onDeleted: () => ref
+                    .read(chatAttachmentsProvider.notifier)
+                    .remove(document.handle),
+              ),
+            ),
+        ],
+      ),
+    );
+  }
+
   Widget _buildSuggestionChip(String text, ThemeData theme) {
     return ActionChip(
       label: Text(text),
@@ -1,5 +1,9 @@
+import 'dart:convert';
+import 'dart:typed_data';
+
 import 'package:dio/dio.dart';
 import 'package:logger/logger.dart';
+import '../../../core/native/native_response_cache.dart';
 import '../models/component_response.dart';
 
 /// User context containing user ID and roles for API requests
@@ -47,9 +51,11 @@ class DisplayException implements Exception {
 /// - X-User-ID and X-User-Roles headers for RBAC
 /// - 30-second default timeout for AI processing
 /// - Comprehensive error handling with DisplayException
+/// - Stale-while-revalidate loading through the runner's response cache
 class DisplayService {
   final Dio _dio;
   final Logger _logger;
+  final NativeResponseCache? _cache;
 
   /// Default timeout for API requests (AI processing can take time)
   static const Duration defaultTimeout = Duration(seconds: 30);
@@ -57,8 +63,10 @@ class DisplayService {
   DisplayService({
     required Dio dio,
     Logger? logger,
+    NativeResponseCache? cache,
   })  : _dio = dio,
-        _logger = logger ?? Logger();
+        _logger = logger ?? Logger(),
+        _cache = cache;
 
   /// Fetch a UI component based on a display directive
   ///
@@ -117,6 +125,133 @@ class DisplayService {
     }
   }
 
+  /// Load a UI component like [fetchComponent], through the response cache
+  ///
+  /// A cached component is emitted straight away. Unless it is still fresh,
+  /// it is then revalidated, and the new component emitted if it changed; if
+  /// revalidation fails, the stale one stays. Without a cache this emits
+  /// the result of [fetchComponent].
+  ///
+  /// Emits [DisplayException] errors as [fetchComponent] throws them, unless
+  /// a cached component was emitted.
+  Stream<ComponentResponse> watchComponent(
+    String directive,
+    UserContext userContext, {
+    Duration? timeout,
+  }) async* {
+    final cache = _cache;
+    if (cache == null) {
+      yield await fetchComponent(directive, userContext, timeout: timeout);
+      return;
+    }
+
+    final key = NativeResponseCache.keyFor(
+      tenant: _dio.options.baseUrl,
+      user: userContext.userId,
+      request: '${userContext.rolesAsString}\n$directive',
+    );
+    final cached = await cache.get(key);
+    final cachedData = cached?.value;
+    final hasCached = cachedData is Map<String, dynamic>;
+    if (hasCached) {
+      _logger.d('Serving cached component: ${cachedData['type']}');
+      yield ComponentResponse.fromJson(cachedData);
+      if (cached!.fresh) return;
+    }
+
+    try {
+      final component = await _fetchIntoCache(
+        cache,
+        key,
+        directive,
+        userContext,
+        etag: hasCached ? cached!.etag : null,
+        timeout: timeout,
+      );
+      if (component != null) yield component;
+    } on DisplayException catch (e) {
+      if (!hasCached) rethrow;
+      _logger.w('Keeping stale component: ${e.message}');
+    }
+  }
+
+  /// Fetch a component and store it in [cache] under [key]
+  ///
+  /// Returns null if the server reports that the component cached with
+  /// [etag] has not changed.
+  Future<ComponentResponse?> _fetchIntoCache(
+    NativeResponseCache cache,
+    String key,
+    String directive,
+    UserContext userContext, {
+    String? etag,
+    Duration? timeout,
+  }) async {
+    try {
+      final response = await _dio.post<List<int>>(
+        '/api/display',
+        data: {'directive': directive},
+        options: Options(
+          headers: {
+            'X-User-ID': userContext.userId,
+            'X-User-Roles': userContext.rolesAsString,
+            if (etag != null) 'If-None-Match': etag,
+          },
+          receiveTimeout: timeout ?? defaultTimeout,
+          responseType: ResponseType.bytes,
+          validateStatus: (status) =>
+              status != null &&
+              ((status >= 200 && status < 300) || status == 304),
+        ),
+      );
+
+      final cacheControl = response.headers.value('cache-control');
+      if (response.statusCode == 304) {
+        await cache.touch(key, cacheControl: cacheControl);
+        return null;
+      }
+      final bytes = response.data;
+      if (bytes == null || bytes.isEmpty) {
+        throw DisplayException(
+          message: 'Server returned empty response',
+          code: 'INVALID_RESPONSE',
+        );
+      }
+
+      final responseEtag = response.headers.value('etag');
+      final body = bytes is Uint8List ? bytes : Uint8List.fromList(bytes);
+      final data = await cache.put(
+            key,
+            body,
+            etag: responseEtag,
+            cacheControl: cacheControl,
+          ) ??
+          _decodeJson(body);
+      if (data is! Map<String, dynamic>) {
+        throw DisplayException(
+          message: 'Server returned an invalid response',
+          code: 'INVALID_RESPONSE',
+        );
+      }
+      if (etag != null && responseEtag == etag) return null;
+
+      _logger.d('Received component response: ${data['type']}');
+      return ComponentResponse.fromJson(data);
+    } on DioException catch (e, stackTrace) {
+      _logger.e('DioException in watchComponent', error: e, stackTrace: stackTrace);
+      throw _mapDioException(e);
+    }
+  }
+
+  /// Decode a body the cache did not, or null if it is not JSON
+  static dynamic _decodeJson(Uint8List body) {
+    try {
+      return jsonDecode(utf8.decode(body));
+    } on FormatException {
+      return null;
+    }
+  }
+
   /// Map DioException to DisplayException with appropriate error codes
   DisplayException _mapDioException(DioException e) {
     switch (e.type) {
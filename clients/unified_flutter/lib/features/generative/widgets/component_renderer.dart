@@ -1,4 +1,5 @@
 import 'package:flutter/material.dart';
+import '../../../core/native/frame_telemetry.dart';
 import '../../../core/theme/color_extensions.dart';
 import '../models/component_response.dart';
 import '../models/employee.dart' as emp;
@@ -676,7 +677,10 @@ class ComponentRenderer extends StatelessWidget {
       voiceEnabled: voiceEnabled,
     );
 
-    return builder(ctx);
+    return FrameTelemetryScope(
+      phase: 'component:${component.type}',
+      child: builder(ctx),
+    );
   }
 }
 
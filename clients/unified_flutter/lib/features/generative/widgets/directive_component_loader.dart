@@ -6,6 +6,8 @@ import 'package:logger/logger.dart';
 import '../../../core/auth/models/auth_state.dart';
 import '../../../core/auth/providers/auth_provider.dart';
 import '../../../core/config/environment_config.dart';
+import '../../../core/native/native_json_transformer.dart';
+import '../../../core/native/native_response_cache.dart';
 import '../../../core/utils/directive_parser.dart';
 import '../models/component_response.dart';
 import '../services/display_service.dart';
@@ -18,12 +20,24 @@ final displayServiceProvider = Provider<DisplayService>((ref) {
     connectTimeout: const Duration(seconds: 10),
     receiveTimeout: const Duration(seconds: 30),
   ));
-  return DisplayService(dio: dio, logger: Logger());
+  // Org charts and data tables can be several megabytes of JSON
+  if (NativeJsonTransformer.isSupported) {
+    dio.transformer = NativeJsonTransformer();
+  }
+  return DisplayService(
+    dio: dio,
+    logger: Logger(),
+    // Dashboards reopen from disk while they are revalidated
+    cache: NativeResponseCache.isSupported ? NativeResponseCache() : null,
+  );
 });
 
-/// Provider for fetching component data based on a directive
-final componentDataProvider = FutureProvider.family<ComponentResponse, String>(
-  (ref, directive) async {
+/// Provider for component data based on a directive
+///
+/// Emits a cached component first where there is one, then the revalidated
+/// one if it changed.
+final componentDataProvider = StreamProvider.family<ComponentResponse, String>(
+  (ref, directive) {
     final displayService = ref.watch(displayServiceProvider);
     final authState = ref.watch(authNotifierProvider);
 
@@ -34,10 +48,10 @@ final componentDataProvider = FutureProvider.family<ComponentResponse, String>(
     };
 
     if (user == null) {
-      throw DisplayException(
+      return Stream.error(DisplayException(
         message: 'Not authenticated',
         code: 'UNAUTHORIZED',
-      );
+      ));
     }
 
     final userContext = UserContext(
@@ -45,7 +59,7 @@ final componentDataProvider = FutureProvider.family<ComponentResponse, String>(
       roles: user.roles ?? [],
     );
 
-    return displayService.fetchComponent(directive, userContext);
+    return displayService.watchComponent(directive, userContext);
   },
 );
 
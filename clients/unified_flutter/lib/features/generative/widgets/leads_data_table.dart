@@ -1,5 +1,6 @@
 import 'package:flutter/material.dart';
 import 'package:intl/intl.dart';
+import '../../../core/native/native_data_table.dart';
 import '../models/component_response.dart';
 
 /// Bulk action types for lead management
@@ -30,6 +31,11 @@ enum LeadSortField {
 /// - Bulk action bar when items are selected
 ///
 /// Supports loading, error, and empty states.
+///
+/// On Windows, lists of [nativePagingThreshold] leads or more are loaded into
+/// a [NativeDataTable]: the current filters and sort are applied there and
+/// only one page of rows is built at a time, with controls to turn pages.
+/// The callbacks fire as they do for smaller lists.
 class LeadsDataTable extends StatefulWidget {
   /// List of leads to display
   final List<Lead> leads;
@@ -71,6 +77,12 @@ class LeadsDataTable extends StatefulWidget {
     this.error,
   });
 
+  /// The smallest list that is filtered, sorted and paged natively.
+  static const int nativePagingThreshold = 1000;
+
+  /// Rows on each page of a natively paged list.
+  static const int pageSize = 100;
+
   @override
   State<LeadsDataTable> createState() => _LeadsDataTableState();
 }
@@ -81,6 +93,43 @@ class _LeadsDataTableState extends State<LeadsDataTable> {
   bool _sortAscending = true;
 
   final _dateFormat = DateFormat('MMM d, yyyy');
+  final _countFormat = NumberFormat.decimalPattern();
+
+  // Native paging: the table holding widget.leads, the page on show and how
+  // many leads have each status under the other filters.
+  NativeDataTable? _table;
+  DataTablePage? _page;
+  int _offset = 0;
+  Map<String, int> _statusCounts = const {};
+
+  bool get _pagesNatively =>
+      NativeDataTable.isSupported &&
+      widget.leads.length >= LeadsDataTable.nativePagingThreshold;
+
+  @override
+  void initState() {
+    super.initState();
+    if (_pagesNatively) _loadTable();
+  }
+
+  @override
+  void didUpdateWidget(LeadsDataTable oldWidget) {
+    super.didUpdateWidget(oldWidget);
+    if (widget.leads != oldWidget.leads) {
+      _releaseTable();
+      if (_pagesNatively) _loadTable();
+    } else if (widget.filters != oldWidget.filters && _table != null) {
+      _offset = 0;
+      _queryPage();
+      _countStatuses();
+    }
+  }
+
+  @override
+  void dispose() {
+    _releaseTable();
+    super.dispose();
+  }
 
   @override
   Widget build(BuildContext context) {
@@ -110,6 +159,156 @@ class _LeadsDataTableState extends State<LeadsDataTable> {
               ),
             ),
           ),
+          if (_pagesNatively) _buildPager(context),
+        ],
+      ),
+    );
+  }
+
+  void _releaseTable() {
+    _table?.dispose();
+    _table = null;
+    _page = null;
+    _offset = 0;
+    _statusCounts = const {};
+  }
+
+  Future<void> _loadTable() async {
+    final leads = widget.leads;
+    final table = await NativeDataTable.load(
+      strings: {
+        'name': [for (final lead in leads) lead.name],
+        'company': [for (final lead in leads) lead.company],
+        'email': [for (final lead in leads) lead.email],
+        'status': [for (final lead in leads) lead.status.name],
+        'source': [for (final lead in leads) lead.source],
+        'ownerId': [for (final lead in leads) lead.ownerId],
+      },
+      numbers: {
+        'statusOrder': [
+          for (final lead in leads) lead.status.index.toDouble(),
+        ],
+        'score': [for (final lead in leads) lead.score?.toDouble()],
+        'lastActivity': [
+          for (final lead in leads)
+            lead.createdAt?.millisecondsSinceEpoch.toDouble(),
+        ],
+      },
+    );
+    if (!mounted || !identical(leads, widget.leads)) {
+      table?.dispose();
+      return;
+    }
+    // Without the runner the list is simply shown whole.
+    if (table == null) return;
+    _table = table;
+    _queryPage();
+    _countStatuses();
+  }
+
+  List<DataTableFilter> _nativeFilters({bool withStatus = true}) {
+    final filters = widget.filters;
+    final search = filters.search?.trim() ?? '';
+    return [
+      if (withStatus && filters.status != null)
+        DataTableFilter.equals('status', filters.status!.name),
+      if (filters.source != null)
+        DataTableFilter.equals('source', filters.source!),
+      if (filters.minScore != null)
+        DataTableFilter.atLeast('score', filters.minScore!),
+      if (filters.ownerId != null)
+        DataTableFilter.equals('ownerId', filters.ownerId!),
+      if (search.isNotEmpty)
+        DataTableFilter.contains(['name', 'company', 'email'], search),
+    ];
+  }
+
+  DataTableSort? _nativeSort() {
+    final field = _currentSortField;
+    if (field == null) return null;
+    final column = switch (field) {
+      LeadSortField.name => 'name',
+      LeadSortField.company => 'company',
+      LeadSortField.status => 'statusOrder',
+      LeadSortField.score => 'score',
+      LeadSortField.source => 'source',
+      LeadSortField.lastActivity => 'lastActivity',
+    };
+    return DataTableSort(column, ascending: _sortAscending);
+  }
+
+  Future<void> _queryPage() async {
+    final table = _table;
+    if (table == null) return;
+    final page = await table.query(
+      filters: _nativeFilters(),
+      sort: _nativeSort(),
+      offset: _offset,
+      limit: LeadsDataTable.pageSize,
+    );
+    // Null when a newer query replaced this one.
+    if (!mounted || page == null || !identical(table, _table)) return;
+    setState(() => _page = page);
+  }
+
+  Future<void> _countStatuses() async {
+    final table = _table;
+    if (table == null) return;
+    final counts = await table.group(
+      'status',
+      filters: _nativeFilters(withStatus: false),
+    );
+    if (!mounted || !identical(table, _table)) return;
+    setState(() => _statusCounts = counts);
+  }
+
+  void _turnPage(int offset) {
+    _offset = offset;
+    _queryPage();
+  }
+
+  /// The leads to build rows for: the current page when paging natively,
+  /// otherwise all of them.
+  List<Lead> get _visibleLeads {
+    if (!_pagesNatively) return widget.leads;
+    final page = _page;
+    if (page == null) {
+      return widget.leads.take(LeadsDataTable.pageSize).toList();
+    }
+    return [for (final row in page.rows) widget.leads[row]];
+  }
+
+  Widget _buildPager(BuildContext context) {
+    final theme = Theme.of(context);
+    final total = _page?.total ?? widget.leads.length;
+    final first = total == 0 ? 0 : _offset + 1;
+    final last = (_offset + LeadsDataTable.pageSize).clamp(0, total);
+
+    return Padding(
+      padding: const EdgeInsets.symmetric(horizontal: 16, vertical: 4),
+      child: Row(
+        mainAxisAlignment: MainAxisAlignment.end,
+        children: [
+          Text(
+            '${_countFormat.format(first)}–${_countFormat.format(last)} '
+            'of ${_countFormat.format(total)}',
+            style: theme.textTheme.bodySmall,
+          ),
+          const SizedBox(width: 8),
+          IconButton(
+            icon: const Icon(Icons.chevron_left),
+            tooltip: 'Previous page',
+            onPressed: _page == null || _offset == 0
+                ? null
+                : () => _turnPage(_offset - LeadsDataTable.pageSize),
+          ),
+          IconButton(
+            icon: const Icon(Icons.chevron_right),
+            tooltip: 'Next page',
+            onPressed: _page == null || last >= total
+                ? null
+                : () => _turnPage(_offset + LeadsDataTable.pageSize),
+          ),
         ],
       ),
     );
@@ -225,7 +424,7 @@ class _LeadsDataTableState extends State<LeadsDataTable> {
         ),
         ...LeadStatus.values.map((status) => DropdownMenuItem<LeadStatus?>(
               value: status,
-              child: Text(_getStatusLabel(status)),
+              child: Text(_getStatusItemLabel(status)),
             )),
       ],
       onChanged: (value) {
@@ -388,7 +587,7 @@ class _LeadsDataTableState extends State<LeadsDataTable> {
           onSort: (_, __) => _handleSort(LeadSortField.lastActivity),
         ),
       ],
-      rows: widget.leads.map((lead) => _buildDataRow(context, lead)).toList(),
+      rows: _visibleLeads.map((lead) => _buildDataRow(context, lead)).toList(),
     );
   }
 
@@ -510,6 +709,14 @@ class _LeadsDataTableState extends State<LeadsDataTable> {
     }
   }
 
+  /// The status label, with how many leads have it when paging natively.
+  String _getStatusItemLabel(LeadStatus status) {
+    final label = _getStatusLabel(status);
+    if (_statusCounts.isEmpty) return label;
+    final count = _statusCounts[status.name] ?? 0;
+    return '$label (${_countFormat.format(count)})';
+  }
+
   void _handleSort(LeadSortField field) {
     setState(() {
       if (_currentSortField == field) {
@@ -519,6 +726,10 @@ class _LeadsDataTableState extends State<LeadsDataTable> {
         _sortAscending = true;
       }
     });
+    if (_table != null) {
+      _offset = 0;
+      _queryPage();
+    }
     widget.onSort(field, _sortAscending);
   }
 
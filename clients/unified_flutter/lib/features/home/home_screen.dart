@@ -3,6 +3,7 @@ import 'package:flutter_riverpod/flutter_riverpod.dart';
 import 'package:go_router/go_router.dart';
 import '../../core/auth/providers/auth_provider.dart';
 import '../../core/auth/services/biometric_service.dart';
+import '../../core/native/window_channel.dart';
 import '../../core/widgets/dialogs.dart';
 
 /// Home screen shown after successful authentication
@@ -173,6 +174,21 @@ class HomeScreen extends ConsumerWidget {
                                 ],
                               ),
                             ),
+                            // On Windows the chat can also go in a window of
+                            // its own, next to the rest of the app.
+                            if (WindowChannel.isSupported)
+                              IconButton(
+                                icon: const Icon(
+                                  Icons.open_in_new,
+                                  color: Colors.white,
+                                ),
+                                tooltip: 'Open in new window',
+                                onPressed: () => WindowChannel.open(
+                                  name: 'chat',
+                                  route: '/chat',
+                                  title: 'Tamshai AI Assistant',
+                                ),
+                              ),
                             const Icon(
                               Icons.arrow_forward_ios,
                               color: Colors.white,
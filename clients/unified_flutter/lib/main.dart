@@ -1,10 +1,19 @@
+import 'dart:async';
 import 'dart:io' show Platform;
 
 import 'package:flutter/material.dart';
 import 'package:flutter_riverpod/flutter_riverpod.dart';
 import 'package:go_router/go_router.dart';
+import 'core/api/certificate_pinner.dart';
 import 'core/auth/providers/auth_provider.dart';
 import 'core/auth/models/auth_state.dart';
+import 'core/config/environment_config.dart';
+import 'core/native/activation_channel.dart';
+import 'core/native/connection_prewarm.dart';
+import 'core/native/deferred_plugin_replay.dart';
+import 'core/native/frame_telemetry.dart';
+import 'core/native/multi_view_app.dart';
+import 'core/native/native_log_output.dart';
 import 'features/authentication/login_screen.dart';
 import 'features/authentication/native_login_screen.dart';
 import 'features/authentication/biometric_unlock_screen.dart';
@@ -16,7 +25,28 @@ bool get _isMobilePlatform {
   return Platform.isIOS || Platform.isAndroid;
 }
 
-void main() {
+Future<void> main() async {
+  WidgetsFlutterBinding.ensureInitialized();
+  if (Platform.isWindows) {
+    NativeLogOutput.install();
+    DeferredPluginReplay.install();
+    FrameTelemetry.start();
+    // The runner refuses its own connections until it has the pins, so they
+    // are in place before anything starts one.
+    await CertificatePinner.configureNative();
+    unawaited(ConnectionPrewarm.record(EnvironmentConfig.current));
+    // Extra windows are further views of this engine, sharing its state.
+    runWidget(
+      ProviderScope(
+        child: MultiViewApp(
+          mainView: const TamshaiApp(),
+          buildWindow: (route) =>
+              TamshaiApp(initialLocation: route, isMainWindow: false),
+        ),
+      ),
+    );
+    return;
+  }
   runApp(
     const ProviderScope(
       child: TamshaiApp(),
@@ -25,20 +55,52 @@ void main() {
 }
 
 class TamshaiApp extends ConsumerStatefulWidget {
-  const TamshaiApp({super.key});
+  /// Route the window starts on.
+  final String initialLocation;
+
+  /// Whether this is the main window. Windows opened with
+  /// `WindowChannel.open` skip the app-wide setup.
+  final bool isMainWindow;
+
+  const TamshaiApp({
+    super.key,
+    this.initialLocation = '/',
+    this.isMainWindow = true,
+  });
 
   @override
   ConsumerState<TamshaiApp> createState() => _TamshaiAppState();
 }
 
 class _TamshaiAppState extends ConsumerState<TamshaiApp> {
+  StreamSubscription<List<String>>? _activationSubscription;
+
   @override
   void initState() {
     super.initState();
+    if (!widget.isMainWindow) return;
+
     // Initialize auth state on app start
     WidgetsBinding.instance.addPostFrameCallback((_) {
       ref.read(authNotifierProvider.notifier).initialize();
     });
+
+    // Later launches on Windows hand their arguments to this instance
+    if (Platform.isWindows) {
+      // Only the count: forwarded arguments can carry an OAuth code and
+      // state, and the log is written to disk.
+      _activationSubscription = ActivationChannel.activations.listen(
+        (arguments) => ref
+            .read(loggerProvider)
+            .i('Activated by another launch with ${arguments.length} arguments'),
+      );
+    }
+  }
+
+  @override
+  void dispose() {
+    _activationSubscription?.cancel();
+    super.dispose();
   }
 
   @override
@@ -70,7 +132,7 @@ class _TamshaiAppState extends ConsumerState<TamshaiApp> {
 
   GoRouter _createRouter(WidgetRef ref) {
     return GoRouter(
-      initialLocation: '/',
+      initialLocation: widget.initialLocation,
       debugLogDiagnostics: true,
       redirect: (context, state) async {
         final authState = ref.read(authNotifierProvider);
@@ -0,0 +1,90 @@
+/// Unit tests for NativeOAuthCallbackListener
+///
+/// Tests the Dart side of the Windows runner's OAuth callback listener:
+/// - The bound port is reported, or null without the runner plugin
+/// - Callback parameters are decoded into OAuthCallbackResult
+/// - A cancelled wait completes with null
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:unified_flutter/core/auth/services/native_oauth_callback_listener.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const channel = MethodChannel('com.tamshai.ai/oauth_callback');
+
+  late TestDefaultBinaryMessenger messenger;
+  late List<MethodCall> calls;
+
+  setUp(() {
+    messenger =
+        TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+    calls = [];
+  });
+
+  tearDown(() {
+    messenger.setMockMethodCallHandler(channel, null);
+  });
+
+  group('NativeOAuthCallbackListener', () {
+    test('reports the port bound by the runner', () async {
+      messenger.setMockMethodCallHandler(channel, (call) async {
+        calls.add(call);
+        return 18766;
+      });
+
+      expect(await NativeOAuthCallbackListener().getPort(), 18766);
+      expect(calls.single.method, 'getPort');
+    });
+
+    test('reports no port when the runner has no listener', () async {
+      expect(await NativeOAuthCallbackListener().getPort(), isNull);
+    });
+
+    test('decodes the callback parameters', () async {
+      messenger.setMockMethodCallHandler(channel, (call) async {
+        return {
+          'code': 'auth-code',
+          'state': 'state-123',
+          'error': null,
+          'errorDescription': null,
+        };
+      });
+
+      final result = await NativeOAuthCallbackListener().waitForCallback();
+      expect(result, isNotNull);
+      expect(result!.code, 'auth-code');
+      expect(result.state, 'state-123');
+      expect(result.error, isNull);
+    });
+
+    test('decodes an error redirect', () async {
+      messenger.setMockMethodCallHandler(channel, (call) async {
+        return {
+          'code': null,
+          'state': 'state-123',
+          'error': 'access_denied',
+          'errorDescription': 'User cancelled login',
+        };
+      });
+
+      final result = await NativeOAuthCallbackListener().waitForCallback();
+      expect(result!.code, isNull);
+      expect(result.error, 'access_denied');
+      expect(result.errorDescription, 'User cancelled login');
+    });
+
+    test('a cancelled wait completes with null', () async {
+      messenger.setMockMethodCallHandler(channel, (call) async {
+        calls.add(call);
+        return null;
+      });
+
+      final listener = NativeOAuthCallbackListener();
+      expect(await listener.waitForCallback(), isNull);
+      await listener.cancel();
+      expect(calls.map((c) => c.method), ['awaitCallback', 'cancel']);
+    });
+  });
+}
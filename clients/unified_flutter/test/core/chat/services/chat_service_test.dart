@@ -0,0 +1,34 @@
+/// Unit tests for ChatService
+///
+/// Tests that a query with attached documents fails visibly, rather than
+/// being sent without them, when the native transport is not available.
+
+import 'package:dio/dio.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:logger/logger.dart';
+import 'package:unified_flutter/core/chat/models/chat_state.dart';
+import 'package:unified_flutter/core/chat/services/chat_service.dart';
+
+void main() {
+  group('ChatService', () {
+    test('fails a query with documents without the native transport',
+        () async {
+      var requests = 0;
+      final dio = Dio(BaseOptions(baseUrl: 'http://127.0.0.1:3100'))
+        ..interceptors.add(InterceptorsWrapper(
+          onRequest: (options, handler) {
+            requests++;
+            handler.reject(DioException(requestOptions: options));
+          },
+        ));
+      final service = ChatService(dio: dio, logger: Logger(level: Level.off));
+
+      final chunks =
+          await service.sendQuery('Summarise this', documents: [3]).toList();
+
+      expect(chunks.single.type, SSEEventType.error);
+      expect(chunks.single.error, contains('Attached documents'));
+      expect(requests, 0);
+    });
+  });
+}
@@ -0,0 +1,123 @@
+/// Unit tests for NativeDocumentIngest
+///
+/// Tests the Dart side of the Windows runner's document ingestion:
+/// - Opened and dropped documents are tracked by handle
+/// - Progress, ready and failed events update them
+/// - Closed documents ignore further events
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:unified_flutter/core/chat/services/native_document_ingest.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const methodChannel = MethodChannel('com.tamshai.ai/document_ingest');
+  const eventChannel = EventChannel('com.tamshai.ai/document_ingest/events');
+
+  late TestDefaultBinaryMessenger messenger;
+  late List<MethodCall> calls;
+  MockStreamHandlerEventSink? events;
+
+  setUp(() {
+    messenger =
+        TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+    calls = [];
+    events = null;
+    messenger.setMockMethodCallHandler(methodChannel, (call) async {
+      calls.add(call);
+      if (call.method == 'open') {
+        return {'handle': 7, 'name': 'export.csv'};
+      }
+      return null;
+    });
+    messenger.setMockStreamHandler(
+      eventChannel,
+      MockStreamHandler.inline(
+        onListen: (arguments, sink) => events = sink,
+      ),
+    );
+  });
+
+  tearDown(() {
+    messenger.setMockMethodCallHandler(methodChannel, null);
+    messenger.setMockStreamHandler(eventChannel, null);
+  });
+
+  /// Let mocked channel replies and listen calls complete.
+  Future<void> settle() async {
+    for (var i = 0; i < 3; i++) {
+      await Future<void>.delayed(Duration.zero);
+    }
+  }
+
+  group('NativeDocumentIngest', () {
+    test('opens a file and follows it until it is ready', () async {
+      final ingest = NativeDocumentIngest();
+      final updates = <IngestedDocument>[];
+      final subscription = ingest.documents.listen(updates.add);
+
+      final document = await ingest.open(r'C:\Data\export.csv');
+      expect(calls.single.method, 'open');
+      expect((calls.single.arguments as Map)['path'], r'C:\Data\export.csv');
+      expect(document.handle, 7);
+      expect(document.name, 'export.csv');
+      expect(document.state, IngestState.ingesting);
+
+      events!.success({
+        'type': 'progress',
+        'handle': 7,
+        'processed': 1024,
+        'size': 4096,
+      });
+      events!.success({'type': 'ready', 'handle': 7, 'sha256': 'ab12'});
+      await settle();
+
+      expect(updates.first.progress, 0.25);
+      expect(updates.last.state, IngestState.ready);
+      expect(updates.last.progress, 1.0);
+      expect(updates.last.sha256, 'ab12');
+
+      await subscription.cancel();
+    });
+
+    test('announces dropped files and reports failures', () async {
+      final ingest = NativeDocumentIngest();
+      final updates = <IngestedDocument>[];
+      final subscription = ingest.documents.listen(updates.add);
+      await settle();
+
+      events!.success({'type': 'added', 'handle': 3, 'name': 'report.pdf'});
+      events!.success({
+        'type': 'failed',
+        'handle': 3,
+        'error': 'unsupported_format',
+        'message': 'The file is not UTF-8 or UTF-16 text',
+      });
+      await settle();
+
+      expect(updates.first.name, 'report.pdf');
+      expect(updates.last.state, IngestState.failed);
+      expect(updates.last.error, 'unsupported_format');
+
+      await subscription.cancel();
+    });
+
+    test('ignores events for closed documents', () async {
+      final ingest = NativeDocumentIngest();
+      final updates = <IngestedDocument>[];
+      final subscription = ingest.documents.listen(updates.add);
+
+      await ingest.open(r'C:\Data\export.csv');
+      await ingest.close(7);
+      expect(calls.last.method, 'close');
+      expect((calls.last.arguments as Map)['handle'], 7);
+
+      events!.success({'type': 'ready', 'handle': 7, 'sha256': 'ab12'});
+      await settle();
+      expect(updates, isEmpty);
+
+      await subscription.cancel();
+    });
+  });
+}
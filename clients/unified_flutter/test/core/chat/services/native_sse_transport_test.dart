@@ -0,0 +1,232 @@
+/// Unit tests for NativeSseTransport
+///
+/// Tests the Dart side of the Windows runner's SSE transport:
+/// - Decoded event batches become SSEChunks
+/// - Transport failures surface as NativeSseException
+/// - Cancelling a subscription aborts the native request
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:unified_flutter/core/chat/models/chat_state.dart';
+import 'package:unified_flutter/core/chat/services/native_sse_transport.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const methodChannel = MethodChannel('com.tamshai.ai/sse');
+  const eventChannel = EventChannel('com.tamshai.ai/sse/events');
+
+  late TestDefaultBinaryMessenger messenger;
+  late List<MethodCall> calls;
+  MockStreamHandlerEventSink? events;
+
+  setUp(() {
+    messenger =
+        TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+    calls = [];
+    events = null;
+    messenger.setMockMethodCallHandler(methodChannel, (call) async {
+      calls.add(call);
+      return null;
+    });
+    messenger.setMockStreamHandler(
+      eventChannel,
+      MockStreamHandler.inline(
+        onListen: (arguments, sink) => events = sink,
+      ),
+    );
+  });
+
+  tearDown(() {
+    messenger.setMockMethodCallHandler(methodChannel, null);
+    messenger.setMockStreamHandler(eventChannel, null);
+  });
+
+  /// Let mocked channel replies and listen calls complete.
+  Future<void> settle() async {
+    for (var i = 0; i < 3; i++) {
+      await Future<void>.delayed(Duration.zero);
+    }
+  }
+
+  Stream<SSEChunk> openStream(NativeSseTransport transport) {
+    return transport.open(
+      url: 'http://127.0.0.1:3100/api/query',
+      headers: {'Accept': 'text/event-stream'},
+      query: 'hello',
+    );
+  }
+
+  group('NativeSseTransport', () {
+    test('starts the native request with the stream arguments', () async {
+      final transport = NativeSseTransport();
+      final subscription = openStream(transport).listen((_) {});
+      await settle();
+
+      expect(calls.single.method, 'start');
+      final arguments = calls.single.arguments as Map;
+      expect(arguments['streamId'], 1);
+      expect(arguments['url'], 'http://127.0.0.1:3100/api/query');
+      expect(arguments['query'], 'hello');
+      expect(arguments.containsKey('body'), isFalse);
+
+      await subscription.cancel();
+    });
+
+    test('sends document handles separately from the query', () async {
+      final transport = NativeSseTransport();
+      final subscription = transport.open(
+        url: 'http://127.0.0.1:3100/api/query',
+        headers: {'Accept': 'text/event-stream'},
+        query: 'Summarise this',
+        documents: [3, 4],
+      ).listen((_) {});
+      await settle();
+
+      final arguments = calls.single.arguments as Map;
+      expect(arguments['query'], 'Summarise this');
+      expect(arguments['documents'], [3, 4]);
+
+      await subscription.cancel();
+    });
+
+    test('delivers decoded events and closes on streamEnd', () async {
+      final transport = NativeSseTransport();
+      final chunksFuture = openStream(transport).toList();
+      await settle();
+
+      events!.success([
+        {'streamId': 1, 'type': 'contentBlockDelta', 'text': 'Hello, '},
+        {'streamId': 1, 'type': 'contentBlockDelta', 'text': 'world'},
+        {'streamId': 1, 'type': 'messageStop'},
+        {'streamId': 1, 'type': 'streamEnd'},
+      ]);
+
+      final chunks = await chunksFuture;
+      expect(chunks.map((c) => c.type), [
+        SSEEventType.contentBlockDelta,
+        SSEEventType.contentBlockDelta,
+        SSEEventType.messageStop,
+      ]);
+      expect(chunks.map((c) => c.text).join(), 'Hello, world');
+    });
+
+    test('converts metadata to JSON-style maps', () async {
+      final transport = NativeSseTransport();
+      final chunksFuture = openStream(transport).toList();
+      await settle();
+
+      events!.success([
+        {
+          'streamId': 1,
+          'type': 'pendingConfirmation',
+          'metadata': {
+            'confirmationId': 'abc',
+            'message': 'Delete employee?',
+            'action': 'delete',
+            'confirmationData': {'ids': [1, 2]},
+          },
+        },
+        {'streamId': 1, 'type': 'streamEnd'},
+      ]);
+
+      final chunk = (await chunksFuture).single;
+      expect(chunk.type, SSEEventType.pendingConfirmation);
+      expect(chunk.metadata, isA<Map<String, dynamic>>());
+      expect(chunk.metadata!['confirmationId'], 'abc');
+      expect(chunk.metadata!['confirmationData'], isA<Map<String, dynamic>>());
+    });
+
+    test('ignores events that belong to other streams', () async {
+      final transport = NativeSseTransport();
+      final chunksFuture = openStream(transport).toList();
+      await settle();
+
+      events!.success([
+        {'streamId': 7, 'type': 'contentBlockDelta', 'text': 'stray'},
+        {'streamId': 1, 'type': 'contentBlockDelta', 'text': 'mine'},
+        {'streamId': 1, 'type': 'streamEnd'},
+      ]);
+
+      final chunks = await chunksFuture;
+      expect(chunks.single.text, 'mine');
+    });
+
+    test('surfaces transport failures as NativeSseException', () async {
+      final transport = NativeSseTransport();
+      final chunksFuture = openStream(transport).toList();
+      await settle();
+
+      events!.success([
+        {
+          'streamId': 1,
+          'type': 'error',
+          'errorKind': 'http',
+          'error': 'Unauthorized',
+          'statusCode': 401,
+        },
+        {'streamId': 1, 'type': 'streamEnd'},
+      ]);
+
+      await expectLater(
+        chunksFuture,
+        throwsA(isA<NativeSseException>()
+            .having((e) => e.kind, 'kind', 'http')
+            .having((e) => e.statusCode, 'statusCode', 401)),
+      );
+    });
+
+    test('surfaces pinning failures as NativeSseException', () async {
+      final transport = NativeSseTransport();
+      final chunksFuture = openStream(transport).toList();
+      await settle();
+
+      events!.success([
+        {
+          'streamId': 1,
+          'type': 'error',
+          'errorKind': 'certificate',
+          'error': "The gateway's certificate is not pinned",
+        },
+        {'streamId': 1, 'type': 'streamEnd'},
+      ]);
+
+      await expectLater(
+        chunksFuture,
+        throwsA(isA<NativeSseException>()
+            .having((e) => e.kind, 'kind', 'certificate')),
+      );
+    });
+
+    test('delivers gateway error events as chunks', () async {
+      final transport = NativeSseTransport();
+      final chunksFuture = openStream(transport).toList();
+      await settle();
+
+      events!.success([
+        {
+          'streamId': 1,
+          'type': 'error',
+          'errorKind': 'server',
+          'error': 'Rate limited',
+        },
+        {'streamId': 1, 'type': 'streamEnd'},
+      ]);
+
+      final chunk = (await chunksFuture).single;
+      expect(chunk.type, SSEEventType.error);
+      expect(chunk.error, 'Rate limited');
+    });
+
+    test('cancelling the subscription cancels the native stream', () async {
+      final transport = NativeSseTransport();
+      final subscription = openStream(transport).listen((_) {});
+      await settle();
+
+      await subscription.cancel();
+
+      expect(calls.map((c) => c.method), ['start', 'cancel']);
+      expect((calls.last.arguments as Map)['streamId'], 1);
+    });
+  });
+}
@@ -0,0 +1,53 @@
+/// Unit tests for ConnectionPrewarm
+///
+/// Tests that the environment's endpoints are recorded with the Windows
+/// runner, and that a missing runner is ignored.
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:unified_flutter/core/config/environment_config.dart';
+import 'package:unified_flutter/core/native/connection_prewarm.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const channel = MethodChannel('com.tamshai.ai/prewarm');
+
+  late TestDefaultBinaryMessenger messenger;
+  late List<MethodCall> calls;
+
+  setUp(() {
+    messenger =
+        TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+    calls = [];
+    messenger.setMockMethodCallHandler(channel, (call) async {
+      calls.add(call);
+      return null;
+    });
+  });
+
+  tearDown(() {
+    messenger.setMockMethodCallHandler(channel, null);
+  });
+
+  group('ConnectionPrewarm', () {
+    test('connects to the gateway and resolves Keycloak', () async {
+      await ConnectionPrewarm.record(EnvironmentConfig.stage);
+
+      expect(calls.single.method, 'record');
+      expect(calls.single.arguments, {
+        'connect': ['https://www.tamshai.com'],
+        'resolve': ['https://www.tamshai.com/auth/realms/tamshai-corp'],
+      });
+    });
+
+    test('ignores a missing runner', () async {
+      messenger.setMockMethodCallHandler(channel, null);
+
+      await expectLater(
+        ConnectionPrewarm.record(EnvironmentConfig.prod),
+        completes,
+      );
+    });
+  });
+}
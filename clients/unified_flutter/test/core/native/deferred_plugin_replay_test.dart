@@ -0,0 +1,121 @@
+/// Unit tests for DeferredPluginReplay
+///
+/// Tests that messages handed back by the Windows runner's plugin loader are
+/// resent on the plugin's channel, in order and right behind the register
+/// call, and that the plugin's replies are returned.
+
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:unified_flutter/core/native/deferred_plugin_replay.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const codec = StandardMethodCodec();
+  const replayChannel = MethodChannel('com.tamshai.ai/plugins');
+  const pluginChannel = 'dev.flutter.pigeon.test.Api.call';
+
+  late TestDefaultBinaryMessenger messenger;
+  // What reached the runner, in order: register calls and plugin messages.
+  late List<Object> sent;
+  // Answers to successive register calls; true once the queue is complete.
+  late List<Object> registerReplies;
+
+  setUp(() {
+    messenger =
+        TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+    sent = [];
+    registerReplies = [true];
+    DeferredPluginReplay.install();
+    messenger.setMockMethodCallHandler(replayChannel, (call) async {
+      sent.add('${call.method} ${(call.arguments as Map)['count']}');
+      return registerReplies.removeAt(0);
+    });
+    messenger.setMockMessageHandler(pluginChannel, (data) async {
+      final message = Uint8List.sublistView(data!);
+      sent.add(message.first);
+      return ByteData.sublistView(Uint8List.fromList([message.first * 10]));
+    });
+  });
+
+  tearDown(() {
+    messenger.setMockMethodCallHandler(replayChannel, null);
+    messenger.setMockMessageHandler(pluginChannel, null);
+  });
+
+  /// Sends a method call to Dart as the runner would and decodes the result.
+  Future<Object?> callFromRunner(MethodCall call) async {
+    ByteData? reply;
+    await messenger.handlePlatformMessage(
+      'com.tamshai.ai/plugins',
+      codec.encodeMethodCall(call),
+      (data) => reply = data,
+    );
+    return codec.decodeEnvelope(reply!);
+  }
+
+  Map<String, Object> message(int value) => {
+        'channel': pluginChannel,
+        'message': Uint8List.fromList([value]),
+      };
+
+  group('DeferredPluginReplay', () {
+    test('resends the messages and returns the plugin replies', () async {
+      final result = await callFromRunner(MethodCall('replay', {
+        'plugin': 'TestPlugin',
+        'messages': [message(1)],
+      }));
+
+      expect(sent, ['register 1', 1]);
+      expect(result, [
+        Uint8List.fromList([10]),
+      ]);
+    });
+
+    test('resends the messages in order behind the register call', () async {
+      final result = await callFromRunner(MethodCall('replay', {
+        'plugin': 'TestPlugin',
+        'messages': [message(1), message(2), message(3)],
+      }));
+
+      expect(sent, ['register 3', 1, 2, 3]);
+      expect(result, [
+        Uint8List.fromList([10]),
+        Uint8List.fromList([20]),
+        Uint8List.fromList([30]),
+      ]);
+    });
+
+    test('sends the whole queue again when more was queued', () async {
+      registerReplies = [
+        [message(1), message(2), message(3)],
+        true,
+      ];
+
+      final result = await callFromRunner(MethodCall('replay', {
+        'plugin': 'TestPlugin',
+        'messages': [message(1), message(2)],
+      }));
+
+      expect(sent, ['register 2', 1, 2, 'register 3', 1, 2, 3]);
+      expect(result, [
+        Uint8List.fromList([10]),
+        Uint8List.fromList([20]),
+        Uint8List.fromList([30]),
+      ]);
+    });
+
+    test('returns null replies when nothing handles the channel', () async {
+      messenger.setMockMessageHandler(pluginChannel, null);
+
+      final result = await callFromRunner(MethodCall('replay', {
+        'plugin': 'TestPlugin',
+        'messages': [message(1)],
+      }));
+
+      expect(result, [null]);
+    });
+  });
+}
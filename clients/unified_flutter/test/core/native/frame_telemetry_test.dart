@@ -0,0 +1,147 @@
+/// Unit tests for FrameTelemetry
+///
+/// Tests that frame timings are forwarded to the Windows runner's frame
+/// telemetry plugin, that only changes of the innermost phase are sent, and
+/// that a missing plugin stops the reports.
+
+import 'dart:typed_data';
+import 'dart:ui' show FrameTiming;
+
+import 'package:flutter/services.dart';
+import 'package:flutter/widgets.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:unified_flutter/core/native/frame_telemetry.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const channel = MethodChannel('com.tamshai.ai/frame_telemetry');
+
+  late TestDefaultBinaryMessenger messenger;
+  late List<MethodCall> calls;
+
+  FrameTiming timing(int start) => FrameTiming(
+        vsyncStart: start,
+        buildStart: start,
+        buildFinish: start + 4000,
+        rasterStart: start + 5000,
+        rasterFinish: start + 11000,
+        rasterFinishWallTime: start + 11000,
+      );
+
+  void reportTimings(List<FrameTiming> timings) {
+    TestWidgetsFlutterBinding.instance.platformDispatcher.onReportTimings!(
+      timings,
+    );
+  }
+
+  setUp(() {
+    messenger =
+        TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+    calls = [];
+    messenger.setMockMethodCallHandler(channel, (call) async {
+      calls.add(call);
+      return null;
+    });
+  });
+
+  tearDown(() {
+    FrameTelemetry.stop();
+    messenger.setMockMethodCallHandler(channel, null);
+  });
+
+  group('FrameTelemetry', () {
+    test('reports build, raster and raster finish per frame', () async {
+      FrameTelemetry.start();
+      reportTimings([timing(1000), timing(20000)]);
+      await Future<void>.delayed(Duration.zero);
+
+      expect(calls.single.method, 'report');
+      expect(
+        calls.single.arguments,
+        Int64List.fromList([4000, 6000, 12000, 4000, 6000, 31000]),
+      );
+    });
+
+    test('sends only changes of the innermost phase', () async {
+      FrameTelemetry.start();
+      FrameTelemetry.enterPhase('chat_streaming');
+      FrameTelemetry.enterPhase('component:OrgChartComponent');
+      FrameTelemetry.enterPhase('component:OrgChartComponent');
+      FrameTelemetry.exitPhase('component:OrgChartComponent');
+      FrameTelemetry.exitPhase('component:OrgChartComponent');
+      FrameTelemetry.exitPhase('chat_streaming');
+      await Future<void>.delayed(Duration.zero);
+
+      expect(calls.map((call) => call.arguments), [
+        {'phase': 'chat_streaming'},
+        {'phase': 'component:OrgChartComponent'},
+        {'phase': 'chat_streaming'},
+        {'phase': null},
+      ]);
+    });
+
+    test('sends the phase already entered when started', () async {
+      FrameTelemetry.enterPhase('chat_streaming');
+      FrameTelemetry.start();
+      FrameTelemetry.exitPhase('chat_streaming');
+      await Future<void>.delayed(Duration.zero);
+
+      expect(calls.map((call) => call.arguments), [
+        {'phase': 'chat_streaming'},
+        {'phase': null},
+      ]);
+    });
+
+    test('stops reporting when the plugin is missing', () async {
+      messenger.setMockMethodCallHandler(channel, (call) async {
+        calls.add(call);
+        throw MissingPluginException();
+      });
+
+      FrameTelemetry.start();
+      reportTimings([timing(1000)]);
+      await Future<void>.delayed(Duration.zero);
+      FrameTelemetry.enterPhase('chat_streaming');
+      FrameTelemetry.exitPhase('chat_streaming');
+      await Future<void>.delayed(Duration.zero);
+
+      expect(calls, hasLength(1));
+    });
+
+    test('returns the runner summary', () async {
+      messenger.setMockMethodCallHandler(channel, (call) async {
+        return {'frames': 2, 'jankyFrames': 1};
+      });
+
+      expect(await FrameTelemetry.summary(), {'frames': 2, 'jankyFrames': 1});
+    });
+
+    test('returns no summary without the plugin', () async {
+      messenger.setMockMethodCallHandler(channel, null);
+
+      expect(await FrameTelemetry.summary(), isNull);
+    });
+  });
+
+  group('FrameTelemetryScope', () {
+    testWidgets('tags frames while it is mounted', (tester) async {
+      FrameTelemetry.start();
+      await tester.pumpWidget(
+        const FrameTelemetryScope(
+          phase: 'component:LeadsDataTable',
+          child: SizedBox(),
+        ),
+      );
+      await tester.pumpWidget(const SizedBox());
+
+      final phases = calls
+          .where((call) => call.method == 'setPhase')
+          .map((call) => call.arguments);
+      expect(phases, [
+        {'phase': 'component:LeadsDataTable'},
+        {'phase': null},
+      ]);
+    });
+  });
+}
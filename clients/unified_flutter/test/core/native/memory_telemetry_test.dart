@@ -0,0 +1,115 @@
+/// Unit tests for MemoryTelemetry
+///
+/// Tests that the Windows runner's memory samples and markers are read into
+/// typed values, and that a missing runner yields nothing.
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:unified_flutter/core/native/memory_telemetry.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const channel = MethodChannel('com.tamshai.ai/memory_telemetry');
+
+  late TestDefaultBinaryMessenger messenger;
+  late List<MethodCall> calls;
+  late Object? reply;
+
+  final sample = {
+    'timeMs': 1760400000000,
+    'privateBytes': 412000000,
+    'peakPrivateBytes': 815000000,
+    'workingSet': 305000000,
+    'peakWorkingSet': 602000000,
+    'handles': 1204,
+    'gdiObjects': 87,
+    'userObjects': 41,
+    'gpu': [
+      {
+        'adapter': 'Intel(R) Iris(R) Xe Graphics',
+        'localBytes': 96000000,
+        'localBudgetBytes': 1800000000,
+        'nonLocalBytes': 12000000,
+      },
+    ],
+  };
+
+  setUp(() {
+    messenger =
+        TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+    calls = [];
+    reply = null;
+    messenger.setMockMethodCallHandler(channel, (call) async {
+      calls.add(call);
+      return reply;
+    });
+  });
+
+  tearDown(() {
+    messenger.setMockMethodCallHandler(channel, null);
+  });
+
+  group('MemoryTelemetry', () {
+    test('reads a sample taken now', () async {
+      reply = sample;
+
+      final result = await MemoryTelemetry.sample();
+
+      expect(calls.single.method, 'sample');
+      expect(result, isNotNull);
+      expect(
+        result!.time,
+        DateTime.fromMillisecondsSinceEpoch(1760400000000),
+      );
+      expect(result.privateBytes, 412000000);
+      expect(result.peakPrivateBytes, 815000000);
+      expect(result.workingSet, 305000000);
+      expect(result.handles, 1204);
+      expect(result.gdiObjects, 87);
+      expect(result.userObjects, 41);
+      expect(result.gpu.single.adapter, 'Intel(R) Iris(R) Xe Graphics');
+      expect(result.gpu.single.localBytes, 96000000);
+      expect(result.gpu.single.localBudgetBytes, 1800000000);
+      expect(result.gpu.single.nonLocalBytes, 12000000);
+    });
+
+    test('reads the history with surface and lifecycle markers', () async {
+      reply = {
+        'samples': [sample],
+        'markers': [
+          {
+            'timeMs': 1760400001000,
+            'kind': 'resize',
+            'width': 2560,
+            'height': 1440,
+            'dpi': 144,
+          },
+          {'timeMs': 1760400002000, 'kind': 'hidden'},
+        ],
+      };
+
+      final history = await MemoryTelemetry.history();
+
+      expect(calls.single.method, 'history');
+      expect(history, isNotNull);
+      expect(history!.samples.single.privateBytes, 412000000);
+      final resize = history.markers.first;
+      expect(resize.kind, 'resize');
+      expect(resize.width, 2560);
+      expect(resize.height, 1440);
+      expect(resize.dpi, 144);
+      final hidden = history.markers.last;
+      expect(hidden.kind, 'hidden');
+      expect(hidden.width, isNull);
+      expect(hidden.dpi, isNull);
+    });
+
+    test('returns null without the runner', () async {
+      messenger.setMockMethodCallHandler(channel, null);
+
+      expect(await MemoryTelemetry.history(), isNull);
+      expect(await MemoryTelemetry.sample(), isNull);
+    });
+  });
+}
@@ -0,0 +1,175 @@
+/// Unit tests for NativeDataTable
+///
+/// Tests loading, querying and counting through the Windows runner's data
+/// tables, and that a missing runner or superseded query yields nothing.
+
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:unified_flutter/core/native/native_data_table.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const channel = MethodChannel('com.tamshai.ai/data_table');
+
+  late TestDefaultBinaryMessenger messenger;
+  late List<MethodCall> calls;
+  late Map<String, Object?> replies;
+
+  setUp(() {
+    messenger =
+        TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+    calls = [];
+    replies = {'load': 7};
+    messenger.setMockMethodCallHandler(channel, (call) async {
+      calls.add(call);
+      return replies[call.method];
+    });
+  });
+
+  tearDown(() {
+    messenger.setMockMethodCallHandler(channel, null);
+  });
+
+  group('NativeDataTable', () {
+    test('loads string and number columns', () async {
+      final table = await NativeDataTable.load(
+        strings: {
+          'name': ['Ada', 'Grace'],
+          'company': [null, 'Navy'],
+        },
+        numbers: {
+          'score': [80, null],
+        },
+      );
+
+      expect(table, isNotNull);
+      final columns = (calls.single.arguments as Map)['columns'] as List;
+      expect(columns[0], {
+        'name': 'name',
+        'strings': ['Ada', 'Grace'],
+      });
+      expect(columns[1], {
+        'name': 'company',
+        'strings': [null, 'Navy'],
+      });
+      final numbers = (columns[2] as Map)['numbers'] as Float64List;
+      expect((columns[2] as Map)['name'], 'score');
+      expect(numbers[0], 80);
+      expect(numbers[1].isNaN, isTrue);
+    });
+
+    test('returns null from load without the runner', () async {
+      messenger.setMockMethodCallHandler(channel, null);
+
+      final table = await NativeDataTable.load(strings: {
+        'name': ['Ada'],
+      });
+
+      expect(table, isNull);
+    });
+
+    test('sends filters, sort and page and returns the rows', () async {
+      final table = await NativeDataTable.load(strings: {
+        'name': ['Ada'],
+      });
+      replies['query'] = {
+        'total': 1200,
+        'rows': Int32List.fromList([4, 2, 9]),
+      };
+
+      final page = await table!.query(
+        filters: [
+          DataTableFilter.equals('status', 'qualified'),
+          DataTableFilter.atLeast('score', 50),
+          DataTableFilter.contains(['name', 'company'], 'acme'),
+        ],
+        sort: const DataTableSort('score', ascending: false),
+        offset: 100,
+        limit: 3,
+      );
+
+      final query = calls.last;
+      expect(query.method, 'query');
+      expect(query.arguments, {
+        'handle': 7,
+        'filters': [
+          {
+            'op': 'equals',
+            'columns': ['status'],
+            'value': 'qualified',
+          },
+          {
+            'op': 'atLeast',
+            'columns': ['score'],
+            'value': 50,
+          },
+          {
+            'op': 'contains',
+            'columns': ['name', 'company'],
+            'value': 'acme',
+          },
+        ],
+        'sort': {'column': 'score', 'ascending': false},
+        'offset': 100,
+        'limit': 3,
+      });
+      expect(page, isNotNull);
+      expect(page!.total, 1200);
+      expect(page.rows, [4, 2, 9]);
+    });
+
+    test('returns null for a superseded query', () async {
+      final table = await NativeDataTable.load(strings: {
+        'name': ['Ada'],
+      });
+      replies['query'] = null;
+
+      expect(await table!.query(), isNull);
+    });
+
+    test('returns counts by value in order', () async {
+      final table = await NativeDataTable.load(strings: {
+        'status': ['contacted', 'qualified', 'contacted'],
+      });
+      replies['group'] = {
+        'values': ['contacted', 'qualified'],
+        'counts': Int32List.fromList([2, 1]),
+      };
+
+      final counts = await table!.group('status');
+
+      expect(calls.last.arguments, {
+        'handle': 7,
+        'column': 'status',
+        'filters': <Object?>[],
+      });
+      expect(counts.keys, ['contacted', 'qualified']);
+      expect(counts, {'contacted': 2, 'qualified': 1});
+    });
+
+    test('returns no counts when the runner fails them', () async {
+      final table = await NativeDataTable.load(strings: {
+        'status': ['contacted'],
+      });
+      messenger.setMockMethodCallHandler(channel, (call) async {
+        throw PlatformException(code: 'unavailable');
+      });
+
+      expect(await table!.group('status'), isEmpty);
+    });
+
+    test('releases the table on dispose', () async {
+      final table = await NativeDataTable.load(strings: {
+        'name': ['Ada'],
+      });
+
+      await table!.dispose();
+
+      expect(calls.last.method, 'release');
+      expect(calls.last.arguments, {'handle': 7});
+    });
+  });
+}
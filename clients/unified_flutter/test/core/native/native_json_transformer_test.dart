@@ -0,0 +1,131 @@
+/// Unit tests for NativeJsonTransformer
+///
+/// Tests that large JSON responses are parsed off the UI isolate, and that
+/// small ones, or all of them without the plugin, fall back to Dio's usual
+/// parsing.
+
+import 'dart:convert';
+
+import 'package:dio/dio.dart';
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:unified_flutter/core/native/native_json_transformer.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const channel = MethodChannel('com.tamshai.ai/json');
+
+  late TestDefaultBinaryMessenger messenger;
+  late List<MethodCall> calls;
+
+  ResponseBody jsonBody(Object document) {
+    return ResponseBody.fromString(
+      jsonEncode(document),
+      200,
+      headers: {
+        Headers.contentTypeHeader: [Headers.jsonContentType],
+      },
+    );
+  }
+
+  setUp(() {
+    messenger =
+        TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+    calls = [];
+  });
+
+  tearDown(() {
+    messenger.setMockMethodCallHandler(channel, null);
+  });
+
+  group('NativeJsonTransformer', () {
+    test('parses large documents off the UI isolate', () async {
+      // Calls made from other isolates go straight to the engine, never to
+      // this isolate's mock.
+      messenger.setMockMethodCallHandler(channel, (call) async {
+        calls.add(call);
+        return jsonDecode(utf8.decode(call.arguments as Uint8List));
+      });
+      final transformer = NativeJsonTransformer();
+      final document = {
+        'type': 'org_chart',
+        'props': {
+          'employees': [
+            for (var i = 0; i < 2000; i++)
+              {'id': 'e$i', 'name': 'Employee $i', 'title': 'Engineer'},
+          ],
+        },
+      };
+      expect(
+        utf8.encode(jsonEncode(document)).length,
+        greaterThanOrEqualTo(transformer.nativeThreshold),
+      );
+
+      final result = await transformer.transformResponse(
+        RequestOptions(),
+        jsonBody(document),
+      );
+
+      expect(calls, isEmpty);
+      expect(result, document);
+      expect(result, isA<Map<String, dynamic>>());
+      expect(result['props'], isA<Map<String, dynamic>>());
+    });
+
+    test('parses small documents in Dart', () async {
+      messenger.setMockMethodCallHandler(channel, (call) async {
+        calls.add(call);
+        return null;
+      });
+      final transformer = NativeJsonTransformer();
+
+      final result = await transformer.transformResponse(
+        RequestOptions(),
+        jsonBody({'type': 'kpi'}),
+      );
+
+      expect(calls, isEmpty);
+      expect(result, {'type': 'kpi'});
+    });
+
+    test('falls back when the plugin is missing', () async {
+      final transformer = NativeJsonTransformer(nativeThreshold: 1);
+
+      final result = await transformer.transformResponse(
+        RequestOptions(),
+        jsonBody({'type': 'kpi'}),
+      );
+
+      expect(result, {'type': 'kpi'});
+    });
+
+    test('reads channel maps the way jsonDecode types them', () {
+      const codec = JsonMessageCodec();
+      final encoded = const StandardMessageCodec().encodeMessage({
+        'list': [
+          {'a': 1},
+        ],
+        'name': 'Alice',
+      });
+
+      final value = codec.decodeMessage(encoded) as dynamic;
+
+      expect(value, isA<Map<String, dynamic>>());
+      expect(value['list'], isA<List<dynamic>>());
+      expect(value['list'].first, isA<Map<String, dynamic>>());
+      expect(value['name'], 'Alice');
+    });
+
+    test('retypes channel values like jsonDecode', () {
+      final value = NativeJsonTransformer.asJson(<Object?, Object?>{
+        'list': <Object?>[
+          <Object?, Object?>{'a': 1},
+        ],
+      });
+
+      expect(value, isA<Map<String, dynamic>>());
+      expect(value['list'].first, isA<Map<String, dynamic>>());
+    });
+  });
+}
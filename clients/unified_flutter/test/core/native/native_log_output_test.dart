@@ -0,0 +1,94 @@
+/// Unit tests for NativeLogOutput
+///
+/// Tests that log records are batched into the binary format the Windows
+/// runner's log sink reads, and that errors and large batches are sent
+/// without waiting for the timer.
+
+import 'dart:convert';
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:logger/logger.dart';
+import 'package:unified_flutter/core/native/native_log_output.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const channel = 'com.tamshai.ai/log';
+
+  late TestDefaultBinaryMessenger messenger;
+  late List<Uint8List> messages;
+
+  setUp(() {
+    messenger =
+        TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+    messages = [];
+    messenger.setMockMessageHandler(channel, (message) async {
+      messages.add(message!.buffer
+          .asUint8List(message.offsetInBytes, message.lengthInBytes));
+      return null;
+    });
+  });
+
+  tearDown(() {
+    messenger.setMockMessageHandler(channel, null);
+  });
+
+  /// Splits a message into (level, text) records.
+  List<(int, String)> decode(Uint8List message) {
+    final data = ByteData.sublistView(message);
+    final records = <(int, String)>[];
+    var offset = 0;
+    while (offset < message.length) {
+      final level = message[offset];
+      final length = data.getUint32(offset + 1, Endian.little);
+      offset += 5;
+      records.add(
+          (level, utf8.decode(message.sublist(offset, offset + length))));
+      offset += length;
+    }
+    return records;
+  }
+
+  OutputEvent event(Level level, List<String> lines) =>
+      OutputEvent(LogEvent(level, lines.join()), lines);
+
+  group('NativeLogOutput', () {
+    test('batches records until the timer fires', () async {
+      final output =
+          NativeLogOutput(flushInterval: const Duration(milliseconds: 10));
+      output.output(event(Level.info, ['Sending query']));
+      output.output(event(Level.debug, ['chunk', 'received']));
+      expect(messages, isEmpty);
+
+      await Future<void>.delayed(const Duration(milliseconds: 30));
+
+      expect(messages, hasLength(1));
+      expect(decode(messages.single), [
+        (2, 'Sending query'),
+        (1, 'chunk\nreceived'),
+      ]);
+    });
+
+    test('sends errors straight away', () {
+      final output = NativeLogOutput();
+      output.output(event(Level.warning, ['slow']));
+      output.output(event(Level.error, ['failed – état']));
+
+      expect(messages, hasLength(1));
+      expect(decode(messages.single), [
+        (3, 'slow'),
+        (4, 'failed – état'),
+      ]);
+    });
+
+    test('sends a large batch without waiting', () {
+      final output = NativeLogOutput();
+      output.write(Level.trace, 'x' * (20 * 1024));
+
+      expect(messages, hasLength(1));
+      expect(decode(messages.single).single.$1, 0);
+    });
+  });
+}
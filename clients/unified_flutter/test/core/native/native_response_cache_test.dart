@@ -0,0 +1,125 @@
+/// Unit tests for NativeResponseCache
+///
+/// Tests lookups and stores through the Windows runner's response cache, and
+/// that a missing runner is treated as a miss.
+
+import 'dart:convert';
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:unified_flutter/core/native/native_response_cache.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const channel = MethodChannel('com.tamshai.ai/response_cache');
+
+  late TestDefaultBinaryMessenger messenger;
+  late List<MethodCall> calls;
+  late Object? reply;
+  late NativeResponseCache cache;
+
+  setUp(() {
+    messenger =
+        TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+    calls = [];
+    reply = null;
+    cache = NativeResponseCache();
+    messenger.setMockMethodCallHandler(channel, (call) async {
+      calls.add(call);
+      return reply;
+    });
+  });
+
+  tearDown(() {
+    messenger.setMockMethodCallHandler(channel, null);
+  });
+
+  group('NativeResponseCache', () {
+    test('keys requests by tenant and user', () {
+      final key = NativeResponseCache.keyFor(
+        tenant: 'https://www.tamshai.com',
+        user: 'user-123',
+        request: 'display:hr:org_chart',
+      );
+
+      expect(key, 'https://www.tamshai.com\nuser-123\ndisplay:hr:org_chart');
+      expect(
+        key,
+        isNot(NativeResponseCache.keyFor(
+          tenant: 'https://www.tamshai.com',
+          user: 'user-456',
+          request: 'display:hr:org_chart',
+        )),
+      );
+    });
+
+    test('returns a hit with its JSON retyped', () async {
+      reply = {
+        'value': {
+          'type': 'OrgChartComponent',
+          'props': <Object?, Object?>{'depth': 1},
+        },
+        'etag': '"v1"',
+        'fresh': false,
+        'ageMs': 90000,
+      };
+
+      final hit = await cache.get('key');
+
+      expect(calls.single.method, 'get');
+      expect(calls.single.arguments, {'key': 'key'});
+      expect(hit, isNotNull);
+      expect(hit!.value, isA<Map<String, dynamic>>());
+      expect(hit.value['props'], isA<Map<String, dynamic>>());
+      expect(hit.etag, '"v1"');
+      expect(hit.fresh, isFalse);
+      expect(hit.age, const Duration(seconds: 90));
+    });
+
+    test('returns null on a miss', () async {
+      expect(await cache.get('key'), isNull);
+    });
+
+    test('stores a body and returns it decoded', () async {
+      final body = Uint8List.fromList(utf8.encode('{"type":"Card"}'));
+      reply = {'type': 'Card'};
+
+      final value = await cache.put(
+        'key',
+        body,
+        etag: '"v2"',
+        cacheControl: 'private, max-age=60',
+      );
+
+      expect(calls.single.method, 'put');
+      expect(calls.single.arguments, {
+        'key': 'key',
+        'body': body,
+        'etag': '"v2"',
+        'cacheControl': 'private, max-age=60',
+      });
+      expect(value, {'type': 'Card'});
+    });
+
+    test('renews and clears', () async {
+      await cache.touch('key', cacheControl: 'max-age=60');
+      await cache.clear();
+
+      expect(calls.map((call) => call.method), ['touch', 'clear']);
+      expect(
+        calls.first.arguments,
+        {'key': 'key', 'cacheControl': 'max-age=60'},
+      );
+    });
+
+    test('misses without the runner', () async {
+      messenger.setMockMethodCallHandler(channel, null);
+
+      expect(await cache.get('key'), isNull);
+      expect(await cache.put('key', Uint8List(0)), isNull);
+      await expectLater(cache.clear(), completes);
+    });
+  });
+}
@@ -0,0 +1,75 @@
+/// Unit tests for WindowChannel
+///
+/// Tests that windows are opened through the Windows runner's multi-window
+/// plugin and that the route of each view is tracked until it goes.
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:unified_flutter/core/native/window_channel.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const channel = MethodChannel('com.tamshai.ai/windows');
+
+  late TestDefaultBinaryMessenger messenger;
+  late List<MethodCall> calls;
+
+  setUp(() {
+    messenger =
+        TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+    calls = [];
+    WindowChannel.routes.value = const {};
+  });
+
+  tearDown(() {
+    messenger.setMockMethodCallHandler(channel, null);
+  });
+
+  group('WindowChannel', () {
+    test('opens a window and records its route', () async {
+      messenger.setMockMethodCallHandler(channel, (call) async {
+        calls.add(call);
+        return 3;
+      });
+
+      final viewId = await WindowChannel.open(
+        name: 'approvals',
+        route: '/approvals',
+        title: 'Approvals',
+        size: const Size(800, 600),
+      );
+
+      expect(viewId, 3);
+      expect(calls.single.method, 'open');
+      expect(calls.single.arguments, {
+        'name': 'approvals',
+        'title': 'Approvals',
+        'width': 800,
+        'height': 600,
+      });
+      expect(WindowChannel.routes.value, {3: '/approvals'});
+    });
+
+    test('returns null when the runner has no multi-window plugin', () async {
+      final viewId = await WindowChannel.open(name: 'chat', route: '/chat');
+
+      expect(viewId, isNull);
+      expect(WindowChannel.routes.value, isEmpty);
+    });
+
+    test('forgets the route of a closed window', () async {
+      messenger.setMockMethodCallHandler(channel, (call) async {
+        calls.add(call);
+        return call.method == 'open' ? 5 : null;
+      });
+
+      await WindowChannel.open(name: 'chat', route: '/chat');
+      await WindowChannel.close(5);
+
+      expect(calls.last.method, 'close');
+      expect(calls.last.arguments, {'viewId': 5});
+      expect(WindowChannel.routes.value, isEmpty);
+    });
+  });
+}
@@ -0,0 +1,148 @@
+/// Unit tests for NativeAudioCapture
+///
+/// Tests the Dart side of the Windows runner's microphone capture:
+/// - start() passes the format and returns the runner's reply
+/// - Batches from the runner are split into fixed-size frames
+/// - Open and capture failures surface as NativeAudioCaptureException
+
+import 'dart:typed_data';
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:unified_flutter/core/speech/services/native_audio_capture.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const methodChannel = MethodChannel('com.tamshai.ai/audio_capture');
+  const eventChannel = EventChannel('com.tamshai.ai/audio_capture/frames');
+
+  late TestDefaultBinaryMessenger messenger;
+  late List<MethodCall> calls;
+  MockStreamHandlerEventSink? events;
+  late bool listening;
+
+  setUp(() {
+    messenger =
+        TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+    calls = [];
+    events = null;
+    listening = false;
+    messenger.setMockMethodCallHandler(methodChannel, (call) async {
+      calls.add(call);
+      if (call.method == 'start') {
+        final arguments = call.arguments as Map;
+        final sampleRate = arguments['sampleRate'] as int;
+        return {
+          'sampleRate': sampleRate,
+          'channels': 1,
+          'frameSamples': sampleRate * (arguments['frameMs'] as int) ~/ 1000,
+        };
+      }
+      return null;
+    });
+    messenger.setMockStreamHandler(
+      eventChannel,
+      MockStreamHandler.inline(
+        onListen: (arguments, sink) {
+          events = sink;
+          listening = true;
+        },
+        onCancel: (arguments) => listening = false,
+      ),
+    );
+  });
+
+  tearDown(() {
+    messenger.setMockMethodCallHandler(methodChannel, null);
+    messenger.setMockStreamHandler(eventChannel, null);
+  });
+
+  /// Let mocked channel replies and listen calls complete.
+  Future<void> settle() async {
+    for (var i = 0; i < 3; i++) {
+      await Future<void>.delayed(Duration.zero);
+    }
+  }
+
+  group('NativeAudioCapture', () {
+    test('starts with the requested format', () async {
+      final capture = NativeAudioCapture();
+
+      final format = await capture.start(sampleRate: 16000, frameMs: 20);
+
+      expect(calls.single.method, 'start');
+      expect(calls.single.arguments, {'sampleRate': 16000, 'frameMs': 20});
+      expect(format.frameSamples, 320);
+      expect(format.frameBytes, 640);
+      expect(format.frameDuration, const Duration(milliseconds: 20));
+      expect(listening, isTrue);
+
+      await capture.dispose();
+    });
+
+    test('splits batches into fixed-size frames', () async {
+      final capture = NativeAudioCapture();
+      final frames = <Uint8List>[];
+      capture.frames.listen(frames.add);
+      await capture.start(sampleRate: 8000, frameMs: 5);
+
+      events!.success(Uint8List.fromList(List.generate(240, (i) => i)));
+      await settle();
+
+      expect(frames, hasLength(3));
+      expect(frames.every((frame) => frame.length == 80), isTrue);
+      expect(frames[1].first, 80);
+
+      await capture.dispose();
+    });
+
+    test('stops the runner and the event stream', () async {
+      final capture = NativeAudioCapture();
+      await capture.start();
+
+      await capture.stop();
+      await settle();
+
+      expect(calls.map((call) => call.method), ['start', 'stop']);
+      expect(capture.format, isNull);
+      expect(listening, isFalse);
+    });
+
+    test('reports a blocked microphone', () async {
+      messenger.setMockMethodCallHandler(methodChannel, (call) async {
+        throw PlatformException(
+          code: 'permission_denied',
+          message: 'Microphone access is turned off',
+        );
+      });
+      final capture = NativeAudioCapture();
+
+      await expectLater(
+        capture.start(),
+        throwsA(
+          isA<NativeAudioCaptureException>()
+              .having((e) => e.code, 'code', 'permission_denied'),
+        ),
+      );
+      await settle();
+      expect(listening, isFalse);
+    });
+
+    test('reports a device that goes away', () async {
+      final capture = NativeAudioCapture();
+      final errors = <Object>[];
+      capture.frames.listen((_) {}, onError: errors.add);
+      await capture.start();
+
+      events!.error(
+        code: 'unavailable',
+        message: 'The microphone was disconnected',
+      );
+      await settle();
+
+      expect(errors.single, isA<NativeAudioCaptureException>());
+      expect(capture.format, isNull);
+    });
+  });
+}
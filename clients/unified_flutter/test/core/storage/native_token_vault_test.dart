@@ -0,0 +1,99 @@
+/// Unit tests for NativeTokenVault
+///
+/// Tests that entries are read from the Windows runner's token vault once,
+/// and that batched writes and clears keep the cached entries in step.
+
+import 'package:flutter/services.dart';
+import 'package:flutter_test/flutter_test.dart';
+import 'package:unified_flutter/core/storage/native_token_vault.dart';
+
+void main() {
+  TestWidgetsFlutterBinding.ensureInitialized();
+
+  const channel = MethodChannel('com.tamshai.ai/token_vault');
+
+  late TestDefaultBinaryMessenger messenger;
+  late List<MethodCall> calls;
+  late Map<String, String> stored;
+
+  setUp(() {
+    messenger =
+        TestDefaultBinaryMessengerBinding.instance.defaultBinaryMessenger;
+    calls = [];
+    stored = {'access_token': 'a1', 'id_token': 'i1'};
+    messenger.setMockMethodCallHandler(channel, (call) async {
+      calls.add(call);
+      switch (call.method) {
+        case 'getAll':
+          return Map.of(stored);
+        case 'putAll':
+          final values = (call.arguments as Map)['values'] as Map;
+          values.forEach((key, value) {
+            if (value == null) {
+              stored.remove(key);
+            } else {
+              stored[key as String] = value as String;
+            }
+          });
+          return null;
+        case 'clear':
+          stored.clear();
+          return null;
+      }
+      return null;
+    });
+  });
+
+  tearDown(() {
+    messenger.setMockMethodCallHandler(channel, null);
+  });
+
+  group('NativeTokenVault', () {
+    test('reads every entry in one call', () async {
+      final vault = NativeTokenVault();
+
+      expect(await vault.readAll(), {'access_token': 'a1', 'id_token': 'i1'});
+      expect(await vault.readAll(), {'access_token': 'a1', 'id_token': 'i1'});
+      expect(calls.map((call) => call.method), ['getAll']);
+    });
+
+    test('writes a batch in one call and updates the cache', () async {
+      final vault = NativeTokenVault();
+      await vault.readAll();
+
+      await vault.writeAll({'access_token': 'a2', 'id_token': null});
+
+      expect(calls.map((call) => call.method), ['getAll', 'putAll']);
+      expect(calls.last.arguments, {
+        'values': {'access_token': 'a2', 'id_token': null},
+      });
+      expect(await vault.readAll(), {'access_token': 'a2'});
+      expect(calls, hasLength(2));
+    });
+
+    test('clear empties the cache', () async {
+      final vault = NativeTokenVault();
+      await vault.readAll();
+
+      await vault.clear();
+
+      expect(await vault.readAll(), isEmpty);
+      expect(calls.map((call) => call.method), ['getAll', 'clear']);
+    });
+
+    test('retries a read that failed', () async {
+      var fail = true;
+      messenger.setMockMethodCallHandler(channel, (call) async {
+        if (fail) {
+          fail = false;
+          throw PlatformException(code: 'unavailable');
+        }
+        return {'access_token': 'a1'};
+      });
+      final vault = NativeTokenVault();
+
+      await expectLater(vault.readAll(), throwsA(isA<PlatformException>()));
+      expect(await vault.readAll(), {'access_token': 'a1'});
+    });
+  });
+}
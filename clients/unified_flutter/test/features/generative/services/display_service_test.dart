@@ -3,10 +3,14 @@
 // Tests the service that fetches generative UI components from the MCP UI API.
 // Uses Mocktail for Dio mocking following TDD methodology.
 
+import 'dart:convert';
+import 'dart:typed_data';
+
 import 'package:dio/dio.dart';
 import 'package:flutter_test/flutter_test.dart';
 import 'package:logger/logger.dart';
 import 'package:mocktail/mocktail.dart';
+import 'package:unified_flutter/core/native/native_response_cache.dart';
 import 'package:unified_flutter/features/generative/models/component_response.dart';
 import 'package:unified_flutter/features/generative/services/display_service.dart';
 
@@ -15,6 +19,8 @@ class MockDio extends Mock implements Dio {}
 
 class MockLogger extends Mock implements Logger {}
 
+class MockNativeResponseCache extends Mock implements NativeResponseCache {}
+
 // Fake classes for mocktail
 class FakeRequestOptions extends Fake implements RequestOptions {}
 
@@ -25,6 +31,7 @@ void main() {
 
   setUpAll(() {
     registerFallbackValue(FakeRequestOptions());
+    registerFallbackValue(Uint8List(0));
   });
 
   setUp(() {
@@ -615,5 +622,201 @@ void main() {
         expect(capturedOptions!.receiveTimeout, equals(const Duration(seconds: 60)));
       });
     });
+
+    group('watchComponent', () {
+      const testDirective = 'show my org chart';
+      final testUserContext = UserContext(
+        userId: 'user-123',
+        roles: ['hr-read'],
+      );
+      const cachedData = <String, dynamic>{
+        'type': 'OrgChartComponent',
+        'props': <String, dynamic>{'revision': 1},
+        'actions': <Map<String, dynamic>>[],
+      };
+      const updatedData = <String, dynamic>{
+        'type': 'OrgChartComponent',
+        'props': <String, dynamic>{'revision': 2},
+        'actions': <Map<String, dynamic>>[],
+      };
+
+      late MockNativeResponseCache mockCache;
+
+      setUp(() {
+        mockCache = MockNativeResponseCache();
+        when(() => mockDio.options)
+            .thenReturn(BaseOptions(baseUrl: 'https://www.tamshai.com'));
+        when(() => mockCache.put(
+              any(),
+              any(),
+              etag: any(named: 'etag'),
+              cacheControl: any(named: 'cacheControl'),
+            )).thenAnswer((invocation) async => jsonDecode(utf8.decode(
+              invocation.positionalArguments[1] as Uint8List,
+            )));
+        when(() => mockCache.touch(any(), cacheControl: any(named: 'cacheControl')))
+            .thenAnswer((_) async {});
+        displayService = DisplayService(
+          dio: mockDio,
+          logger: mockLogger,
+          cache: mockCache,
+        );
+      });
+
+      void stubCached({required bool fresh}) {
+        when(() => mockCache.get(any())).thenAnswer((_) async => CachedResponse(
+              value: cachedData,
+              etag: '"v1"',
+              fresh: fresh,
+              age: const Duration(minutes: 10),
+            ));
+      }
+
+      void stubServer(int statusCode, {Map<String, dynamic>? data, String? etag}) {
+        when(() => mockDio.post<List<int>>(
+              any(),
+              data: any(named: 'data'),
+              options: any(named: 'options'),
+            )).thenAnswer((_) async => Response(
+              data: data == null ? null : utf8.encode(jsonEncode(data)),
+              statusCode: statusCode,
+              headers: Headers.fromMap({
+                if (etag != null) 'etag': [etag],
+                'cache-control': ['private, max-age=300'],
+              }),
+              requestOptions: RequestOptions(path: '/api/display'),
+            ));
+      }
+
+      test('keys the cache by deployment, user and roles', () async {
+        stubCached(fresh: true);
+
+        await displayService.watchComponent(testDirective, testUserContext).toList();
+
+        verify(() => mockCache.get(
+              'https://www.tamshai.com\nuser-123\nhr-read\n$testDirective',
+            )).called(1);
+      });
+
+      test('serves a fresh component without the network', () async {
+        stubCached(fresh: true);
+
+        final components =
+            await displayService.watchComponent(testDirective, testUserContext).toList();
+
+        expect(components.single.props['revision'], 1);
+        verifyNever(() => mockDio.post<List<int>>(
+              any(),
+              data: any(named: 'data'),
+              options: any(named: 'options'),
+            ));
+      });
+
+      test('serves a stale component, then the changed one', () async {
+        stubCached(fresh: false);
+        stubServer(200, data: updatedData, etag: '"v2"');
+
+        final components =
+            await displayService.watchComponent(testDirective, testUserContext).toList();
+
+        expect(components.map((c) => c.props['revision']), [1, 2]);
+        final options = verify(() => mockDio.post<List<int>>(
+              '/api/display',
+              data: {'directive': testDirective},
+              options: captureAny(named: 'options'),
+            )).captured.single as Options;
+        expect(options.headers!['If-None-Match'], '"v1"');
+        expect(options.responseType, ResponseType.bytes);
+        verify(() => mockCache.put(
+              any(),
+              any(),
+              etag: '"v2"',
+              cacheControl: 'private, max-age=300',
+            )).called(1);
+      });
+
+      test('renews a stale component the server did not change', () async {
+        stubCached(fresh: false);
+        stubServer(304);
+
+        final components =
+            await displayService.watchComponent(testDirective, testUserContext).toList();
+
+        expect(components, hasLength(1));
+        verify(() => mockCache.touch(any(), cacheControl: 'private, max-age=300'))
+            .called(1);
+      });
+
+      test('does not re-emit a body with the cached ETag', () async {
+        stubCached(fresh: false);
+        stubServer(200, data: cachedData, etag: '"v1"');
+
+        final components =
+            await displayService.watchComponent(testDirective, testUserContext).toList();
+
+        expect(components, hasLength(1));
+      });
+
+      test('keeps a stale component when revalidation fails', () async {
+        stubCached(fresh: false);
+        when(() => mockDio.post<List<int>>(
+              any(),
+              data: any(named: 'data'),
+              options: any(named: 'options'),
+            )).thenThrow(DioException(
+          type: DioExceptionType.connectionError,
+          requestOptions: RequestOptions(path: '/api/display'),
+        ));
+
+        final components =
+            await displayService.watchComponent(testDirective, testUserContext).toList();
+
+        expect(components.single.props['revision'], 1);
+      });
+
+      test('fetches and caches on a miss', () async {
+        when(() => mockCache.get(any())).thenAnswer((_) async => null);
+        stubServer(200, data: updatedData, etag: '"v2"');
+
+        final components =
+            await displayService.watchComponent(testDirective, testUserContext).toList();
+
+        expect(components.single.props['revision'], 2);
+      });
+
+      test('falls back to decoding when the runner is missing', () async {
+        when(() => mockCache.get(any())).thenAnswer((_) async => null);
+        when(() => mockCache.put(
+              any(),
+              any(),
+              etag: any(named: 'etag'),
+              cacheControl: any(named: 'cacheControl'),
+            )).thenAnswer((_) async => null);
+        stubServer(200, data: updatedData);
+
+        final components =
+            await displayService.watchComponent(testDirective, testUserContext).toList();
+
+        expect(components.single.type, 'OrgChartComponent');
+      });
+
+      test('fails on a miss when the network fails', () async {
+        when(() => mockCache.get(any())).thenAnswer((_) async => null);
+        when(() => mockDio.post<List<int>>(
+              any(),
+              data: any(named: 'data'),
+              options: any(named: 'options'),
+            )).thenThrow(DioException(
+          type: DioExceptionType.connectionTimeout,
+          requestOptions: RequestOptions(path: '/api/display'),
+        ));
+
+        expect(
+          displayService.watchComponent(testDirective, testUserContext).toList(),
+          throwsA(isA<DisplayException>()
+              .having((e) => e.code, 'code', 'TIMEOUT')),
+        );
+      });
+    });
   });
 }
@@ -0,0 +1,389 @@
+// tamshai_ai_bench: launches the runner repeatedly in its benchmark mode
+// (runner/benchmark.h) and gathers the reports into one JSON file, so that
+// releases can be gated on startup and frame-time regressions.
+//
+//   tamshai_ai_bench [--scenario=all|cold_start|warm_start|resize|sse]
+//                    [--iterations=5] [--output=bench_results.json]
+//                    [--sse-replay=<recorded stream>] [--runner=<exe>]
+//
+// cold_start empties the standby page list before each launch, which needs
+// an elevated prompt; without one the launches are reported as warm.
+// warm_start makes one untimed launch first. Every launch also writes the
+// engine's timeline trace next to the output, which only Profile builds of
+// the app honor.
+
+#include <windows.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr DWORD kLaunchTimeoutMs = 120 * 1000;
+constexpr int kDefaultIterations = 5;
+
+// SystemMemoryListInformation and MemoryPurgeStandbyList, from the DDK.
+constexpr int kSystemMemoryListInformation = 80;
+constexpr int kMemoryPurgeStandbyList = 4;
+
+struct Options {
+  std::wstring scenario = L"all";
+  int iterations = kDefaultIterations;
+  std::wstring output = L"bench_results.json";
+  std::wstring sse_replay;
+  std::wstring runner;
+};
+
+// What one launch measured.
+struct Run {
+  bool succeeded = false;
+  // From CreateProcess until the runner exited, scenario included.
+  double process_ms = 0;
+  std::wstring trace_path;
+  std::string report;
+};
+
+std::wstring ExecutableDirectory() {
+  wchar_t path[MAX_PATH];
+  DWORD length = GetModuleFileName(nullptr, path, MAX_PATH);
+  std::wstring directory(path, length);
+  return directory.substr(0, directory.find_last_of(L'\\'));
+}
+
+// The runner starts in its own directory, so paths handed to it must not be
+// relative.
+std::wstring FullPath(const std::wstring& path) {
+  if (path.empty()) {
+    return path;
+  }
+  wchar_t full_path[MAX_PATH];
+  DWORD length = GetFullPathName(path.c_str(), MAX_PATH, full_path, nullptr);
+  return length > 0 && length < MAX_PATH ? std::wstring(full_path, length)
+                                         : path;
+}
+
+std::string Utf8(const std::wstring& text) {
+  if (text.empty()) {
+    return std::string();
+  }
+  int length = WideCharToMultiByte(CP_UTF8, 0, text.data(),
+                                   static_cast<int>(text.size()), nullptr, 0,
+                                   nullptr, nullptr);
+  std::string utf8(static_cast<size_t>(length), '\0');
+  WideCharToMultiByte(CP_UTF8, 0, text.data(), static_cast<int>(text.size()),
+                      utf8.data(), length, nullptr, nullptr);
+  return utf8;
+}
+
+std::string JsonString(const std::wstring& text) {
+  std::string quoted = "\"";
+  for (char c : Utf8(text)) {
+    if (c == '"' || c == '\\') {
+      quoted.push_back('\\');
+    }
+    quoted.push_back(c);
+  }
+  return quoted + "\"";
+}
+
+double Now() {
+  LARGE_INTEGER frequency, now;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&now);
+  return static_cast<double>(now.QuadPart) * 1000.0 /
+         static_cast<double>(frequency.QuadPart);
+}
+
+std::string FormatNumber(double value) {
+  char text[32];
+  snprintf(text, sizeof(text), "%.3f", value);
+  return text;
+}
+
+bool ParseOptions(int argc, wchar_t** argv, Options* options) {
+  for (int i = 1; i < argc; ++i) {
+    std::wstring argument = argv[i];
+    size_t equals = argument.find(L'=');
+    std::wstring name = argument.substr(0, equals);
+    std::wstring value =
+        equals == std::wstring::npos ? std::wstring()
+                                     : argument.substr(equals + 1);
+    if (name == L"--scenario") {
+      options->scenario = value;
+    } else if (name == L"--iterations") {
+      options->iterations = _wtoi(value.c_str());
+    } else if (name == L"--output") {
+      options->output = value;
+    } else if (name == L"--sse-replay") {
+      options->sse_replay = value;
+    } else if (name == L"--runner") {
+      options->runner = value;
+    } else {
+      return false;
+    }
+  }
+  if (options->scenario != L"all" && options->scenario != L"cold_start" &&
+      options->scenario != L"warm_start" && options->scenario != L"resize" &&
+      options->scenario != L"sse") {
+    return false;
+  }
+  if (options->runner.empty()) {
+    options->runner = ExecutableDirectory() + L"\\" + RUNNER_EXECUTABLE;
+  }
+  options->output = FullPath(options->output);
+  options->sse_replay = FullPath(options->sse_replay);
+  options->runner = FullPath(options->runner);
+  return options->iterations > 0;
+}
+
+// Empties the standby list, so the next launch reads everything from disk.
+// Returns false if this process is not allowed to.
+bool PurgeStandbyList() {
+  HANDLE token;
+  if (!OpenProcessToken(GetCurrentProcess(),
+                        TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+    return false;
+  }
+  TOKEN_PRIVILEGES privileges{};
+  privileges.PrivilegeCount = 1;
+  privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+  bool enabled =
+      LookupPrivilegeValue(nullptr, SE_PROF_SINGLE_PROCESS_NAME,
+                           &privileges.Privileges[0].Luid) &&
+      AdjustTokenPrivileges(token, FALSE, &privileges, 0, nullptr, nullptr) &&
+      GetLastError() == ERROR_SUCCESS;
+  CloseHandle(token);
+  if (!enabled) {
+    return false;
+  }
+
+  using NtSetSystemInformation = LONG(WINAPI*)(INT, PVOID, ULONG);
+  auto set_information = reinterpret_cast<NtSetSystemInformation>(
+      GetProcAddress(GetModuleHandle(L"ntdll.dll"), "NtSetSystemInformation"));
+  int command = kMemoryPurgeStandbyList;
+  return set_information &&
+         set_information(kSystemMemoryListInformation, &command,
+                         sizeof(command)) >= 0;
+}
+
+std::string ReadFileContents(const std::wstring& path) {
+  std::string contents;
+  HANDLE file = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                           nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                           nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return contents;
+  }
+  char buffer[4096];
+  DWORD bytes_read = 0;
+  while (ReadFile(file, buffer, sizeof(buffer), &bytes_read, nullptr) &&
+         bytes_read > 0) {
+    contents.append(buffer, bytes_read);
+  }
+  CloseHandle(file);
+  // The runner ends its report with a newline.
+  while (!contents.empty() &&
+         (contents.back() == '\n' || contents.back() == '\r')) {
+    contents.pop_back();
+  }
+  return contents;
+}
+
+// The number after "|key|": in |json|, or 0. With |object|, the key is
+// looked up inside the "|object|":{...} member instead, whose own members
+// the runner keeps flat, so the lookup does not depend on the order of the
+// report's members.
+double FindNumber(const std::string& json,
+                  const std::string& key,
+                  const std::string& object = std::string()) {
+  size_t begin = 0;
+  size_t end = json.size();
+  if (!object.empty()) {
+    std::string member = "\"" + object + "\":{";
+    begin = json.find(member);
+    if (begin == std::string::npos) {
+      return 0;
+    }
+    begin += member.size();
+    end = json.find('}', begin);
+    if (end == std::string::npos) {
+      return 0;
+    }
+  }
+  std::string member = "\"" + key + "\":";
+  size_t found = json.find(member, begin);
+  if (found == std::string::npos || found >= end) {
+    return 0;
+  }
+  return std::strtod(json.c_str() + found + member.size(), nullptr);
+}
+
+double Median(std::vector<double> values) {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  size_t middle = values.size() / 2;
+  return values.size() % 2 ? values[middle]
+                           : (values[middle - 1] + values[middle]) / 2;
+}
+
+// Launches the runner once for |runner_scenario| and waits for its report.
+Run Launch(const Options& options,
+           const std::wstring& runner_scenario,
+           const std::wstring& name) {
+  Run run;
+  std::wstring stem = options.output;
+  size_t extension = stem.rfind(L".json");
+  if (extension != std::wstring::npos) {
+    stem.erase(extension);
+  }
+  std::wstring report_path = stem + L"-" + name + L".report.json";
+  run.trace_path = stem + L"-" + name + L".pftrace";
+  DeleteFile(report_path.c_str());
+
+  // The engine reads extra switches from the environment outside release
+  // builds.
+  SetEnvironmentVariable(L"FLUTTER_ENGINE_SWITCHES", L"2");
+  SetEnvironmentVariable(L"FLUTTER_ENGINE_SWITCH_1", L"trace-startup");
+  SetEnvironmentVariable(L"FLUTTER_ENGINE_SWITCH_2",
+                         (L"trace-to-file=" + run.trace_path).c_str());
+
+  std::wstring command_line = L"\"" + options.runner + L"\" --benchmark=" +
+                              runner_scenario + L" \"--benchmark-output=" +
+                              report_path + L"\"";
+  if (runner_scenario == L"sse") {
+    command_line += L" \"--benchmark-sse=" + options.sse_replay + L"\"";
+  }
+  std::wstring working_directory =
+      options.runner.substr(0, options.runner.find_last_of(L'\\'));
+
+  STARTUPINFO startup_info{};
+  startup_info.cb = sizeof(startup_info);
+  PROCESS_INFORMATION process{};
+  double start = Now();
+  if (!CreateProcess(options.runner.c_str(), command_line.data(), nullptr,
+                     nullptr, FALSE, 0, nullptr, working_directory.c_str(),
+                     &startup_info, &process)) {
+    fwprintf(stderr, L"Could not start %ls (error %lu)\n",
+             options.runner.c_str(), GetLastError());
+    return run;
+  }
+  CloseHandle(process.hThread);
+  if (WaitForSingleObject(process.hProcess, kLaunchTimeoutMs) !=
+      WAIT_OBJECT_0) {
+    TerminateProcess(process.hProcess, EXIT_FAILURE);
+    fwprintf(stderr, L"%ls timed out\n", name.c_str());
+  }
+  run.process_ms = Now() - start;
+  CloseHandle(process.hProcess);
+
+  run.report = ReadFileContents(report_path);
+  run.succeeded = !run.report.empty();
+  DeleteFile(report_path.c_str());
+  return run;
+}
+
+// Runs |scenario| for the configured iterations and returns its JSON result.
+std::string RunScenario(const Options& options,
+                        const std::wstring& scenario,
+                        bool* all_succeeded) {
+  std::wstring runner_scenario = scenario;
+  if (scenario == L"cold_start" || scenario == L"warm_start") {
+    runner_scenario = L"startup";
+  }
+  if (scenario == L"warm_start") {
+    Launch(options, runner_scenario, scenario + L"-warmup");
+  }
+
+  bool cold = scenario == L"cold_start";
+  std::vector<Run> runs;
+  for (int i = 0; i < options.iterations; ++i) {
+    if (cold && !PurgeStandbyList()) {
+      cold = false;
+      fwprintf(stderr,
+               L"Could not empty the standby list; run elevated for cold "
+               L"starts\n");
+    }
+    Run run =
+        Launch(options, runner_scenario, scenario + L"-" + std::to_wstring(i));
+    *all_succeeded = *all_succeeded && run.succeeded;
+    runs.push_back(std::move(run));
+  }
+
+  std::vector<double> first_frame_ms, frame_p99_ms, private_bytes, gpu_bytes;
+  std::string json = "{\"scenario\":" + JsonString(scenario) +
+                     ",\"coldCache\":" + (cold ? "true" : "false") +
+                     ",\"runs\":[";
+  for (size_t i = 0; i < runs.size(); ++i) {
+    const Run& run = runs[i];
+    json += (i ? "," : "") + std::string("{\"processMs\":") +
+            FormatNumber(run.process_ms) +
+            ",\"trace\":" + JsonString(run.trace_path) +
+            ",\"report\":" + (run.succeeded ? run.report : "null") + "}";
+    if (run.succeeded) {
+      first_frame_ms.push_back(FindNumber(run.report, "firstFrameMs"));
+      frame_p99_ms.push_back(FindNumber(run.report, "p99", "frameTimeMs"));
+      private_bytes.push_back(FindNumber(run.report, "privateBytes"));
+      gpu_bytes.push_back(FindNumber(run.report, "gpuLocalBytes"));
+    }
+  }
+  // The process time includes the scenario and waiting for the last
+  // frame timings, so startup is summarized by the first frame alone.
+  json += "],\"median\":{\"firstFrameMs\":" +
+          FormatNumber(Median(first_frame_ms)) +
+          ",\"frameTimeP99Ms\":" + FormatNumber(Median(frame_p99_ms)) +
+          ",\"privateBytes\":" + FormatNumber(Median(private_bytes)) +
+          ",\"gpuLocalBytes\":" + FormatNumber(Median(gpu_bytes)) + "}}";
+  return json;
+}
+
+}  // namespace
+
+int wmain(int argc, wchar_t** argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    fwprintf(stderr,
+             L"usage: tamshai_ai_bench [--scenario=all|cold_start|warm_start|"
+             L"resize|sse] [--iterations=N] [--output=file.json] "
+             L"[--sse-replay=file] [--runner=exe]\n");
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::wstring> scenarios;
+  if (options.scenario == L"all") {
+    scenarios = {L"cold_start", L"warm_start", L"resize"};
+    if (!options.sse_replay.empty()) {
+      scenarios.push_back(L"sse");
+    }
+  } else if (options.scenario == L"sse" && options.sse_replay.empty()) {
+    fwprintf(stderr, L"--scenario=sse needs --sse-replay\n");
+    return EXIT_FAILURE;
+  } else {
+    scenarios = {options.scenario};
+  }
+
+  bool all_succeeded = true;
+  std::string json = "{\"runner\":" + JsonString(options.runner) +
+                     ",\"iterations\":" + std::to_string(options.iterations) +
+                     ",\"results\":[";
+  for (size_t i = 0; i < scenarios.size(); ++i) {
+    wprintf(L"Running %ls\n", scenarios[i].c_str());
+    json += (i ? "," : "") + RunScenario(options, scenarios[i], &all_succeeded);
+  }
+  json += "]}\n";
+
+  FILE* output = nullptr;
+  if (_wfopen_s(&output, options.output.c_str(), L"wb") != 0 || !output) {
+    fwprintf(stderr, L"Could not write %ls\n", options.output.c_str());
+    return EXIT_FAILURE;
+  }
+  fwrite(json.data(), 1, json.size(), output);
+  fclose(output);
+  wprintf(L"Wrote %ls\n", options.output.c_str());
+  return all_succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
+}
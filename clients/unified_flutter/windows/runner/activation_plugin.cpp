@@ -0,0 +1,80 @@
+#include "activation_plugin.h"
+
+#include <flutter/event_stream_handler_functions.h>
+#include <flutter/standard_method_codec.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "single_instance.h"
+
+namespace {
+
+constexpr char kEventChannelName[] = "com.tamshai.ai/activation";
+
+}  // namespace
+
+ActivationPlugin::ActivationPlugin(flutter::BinaryMessenger* messenger,
+                                   PlatformTaskQueue* task_queue,
+                                   std::function<void()> on_activate)
+    : on_activate_(std::move(on_activate)) {
+  event_channel_ =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          messenger, kEventChannelName,
+          &flutter::StandardMethodCodec::GetInstance());
+  event_channel_->SetStreamHandler(
+      std::make_unique<
+          flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [this](const flutter::EncodableValue* arguments,
+                 std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&&
+                     events)
+              -> std::unique_ptr<
+                  flutter::StreamHandlerError<flutter::EncodableValue>> {
+            event_sink_ = std::move(events);
+            for (const auto& activation : pending_) {
+              event_sink_->Success(activation);
+            }
+            pending_.clear();
+            return nullptr;
+          },
+          [this](const flutter::EncodableValue* arguments)
+              -> std::unique_ptr<
+                  flutter::StreamHandlerError<flutter::EncodableValue>> {
+            event_sink_ = nullptr;
+            return nullptr;
+          }));
+
+  std::weak_ptr<bool> alive = alive_;
+  SingleInstance::GetInstance()->SetActivationHandler(
+      [this, task_queue, alive](std::vector<std::string> arguments) {
+        flutter::EncodableList list;
+        for (std::string& argument : arguments) {
+          list.push_back(flutter::EncodableValue(std::move(argument)));
+        }
+        task_queue->PostTask(
+            [this, alive, list = std::move(list)]() mutable {
+              if (alive.lock()) {
+                HandleActivation(std::move(list));
+              }
+            });
+      });
+}
+
+ActivationPlugin::~ActivationPlugin() {
+  // Blocks until any in-flight activation has been posted.
+  SingleInstance::GetInstance()->SetActivationHandler(nullptr);
+  event_channel_->SetStreamHandler(nullptr);
+}
+
+void ActivationPlugin::HandleActivation(flutter::EncodableList arguments) {
+  if (on_activate_) {
+    on_activate_();
+  }
+  flutter::EncodableValue activation(std::move(arguments));
+  if (event_sink_) {
+    event_sink_->Success(activation);
+  } else {
+    pending_.push_back(std::move(activation));
+  }
+}
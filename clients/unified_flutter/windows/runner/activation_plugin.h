@@ -0,0 +1,50 @@
+#ifndef RUNNER_ACTIVATION_PLUGIN_H_
+#define RUNNER_ACTIVATION_PLUGIN_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/event_channel.h>
+
+#include <functional>
+#include <memory>
+
+#include "platform_task_queue.h"
+
+// Delivers command lines forwarded by later launches of the runner (see
+// SingleInstance) to Dart.
+//
+// Event channel "com.tamshai.ai/activation" emits one list of UTF-8 argument
+// strings per forwarded launch. Activations that arrive before Dart listens
+// are buffered and delivered when it does.
+class ActivationPlugin {
+ public:
+  // |on_activate| runs on the platform thread for every forwarded launch,
+  // before the arguments are sent to Dart.
+  ActivationPlugin(flutter::BinaryMessenger* messenger,
+                   PlatformTaskQueue* task_queue,
+                   std::function<void()> on_activate);
+  ~ActivationPlugin();
+
+  // Prevent copying.
+  ActivationPlugin(ActivationPlugin const&) = delete;
+  ActivationPlugin& operator=(ActivationPlugin const&) = delete;
+
+ private:
+  // Handles one forwarded launch on the platform thread.
+  void HandleActivation(flutter::EncodableList arguments);
+
+  std::function<void()> on_activate_;
+
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>>
+      event_channel_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> event_sink_;
+
+  // Activations waiting for a Dart listener.
+  flutter::EncodableList pending_;
+
+  // Tasks posted from the listener thread hold a weak reference to this token
+  // so they become no-ops once the plugin has been destroyed.
+  std::shared_ptr<bool> alive_ = std::make_shared<bool>(true);
+};
+
+#endif  // RUNNER_ACTIVATION_PLUGIN_H_
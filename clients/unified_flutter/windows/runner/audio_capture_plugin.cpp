@@ -0,0 +1,442 @@
+#include "audio_capture_plugin.h"
+
+#include <audioclient.h>
+#include <avrt.h>
+#include <flutter/event_stream_handler_functions.h>
+#include <flutter/standard_method_codec.h>
+#include <mmdeviceapi.h>
+#include <wrl/client.h>
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <utility>
+
+#include "runner_trace.h"
+
+namespace {
+
+constexpr char kMethodChannelName[] = "com.tamshai.ai/audio_capture";
+constexpr char kEventChannelName[] = "com.tamshai.ai/audio_capture/frames";
+
+constexpr int64_t kDefaultSampleRate = 16000;
+constexpr int64_t kMinSampleRate = 8000;
+constexpr int64_t kMaxSampleRate = 48000;
+
+constexpr int64_t kDefaultFrameMs = 10;
+constexpr int64_t kMinFrameMs = 5;
+constexpr int64_t kMaxFrameMs = 100;
+
+// The engine buffer asked for, in 100 ns units. Shared mode rounds it up to
+// the engine period, which is 10 ms on most devices.
+constexpr REFERENCE_TIME kBufferDuration = 10 * 10000;
+
+// How much audio the ring holds before packets are dropped.
+constexpr int64_t kRingMs = 2000;
+
+// A device that signals nothing for this long has stopped working.
+constexpr DWORD kDeviceTimeoutMs = 2000;
+
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+// Returns the integer stored under |key| in |map|, |fallback| if there is
+// none, or nothing if the value is not an integer.
+std::optional<int64_t> LookupInt(const EncodableMap* map,
+                                 const char* key,
+                                 int64_t fallback) {
+  if (!map) {
+    return fallback;
+  }
+  auto it = map->find(EncodableValue(key));
+  if (it == map->end() || it->second.IsNull()) {
+    return fallback;
+  }
+  if (const auto* small = std::get_if<int32_t>(&it->second)) {
+    return *small;
+  }
+  if (const auto* large = std::get_if<int64_t>(&it->second)) {
+    return *large;
+  }
+  return std::nullopt;
+}
+
+// The performance counter in 100 ns units, the clock WASAPI stamps packets
+// with.
+uint64_t PerformanceCounter100ns() {
+  static const int64_t frequency = []() {
+    LARGE_INTEGER value;
+    QueryPerformanceFrequency(&value);
+    return value.QuadPart;
+  }();
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  // Split so the multiplication does not overflow after long uptimes.
+  return static_cast<uint64_t>(now.QuadPart / frequency * 10000000 +
+                               now.QuadPart % frequency * 10000000 /
+                                   frequency);
+}
+
+}  // namespace
+
+AudioCapturePlugin::AudioCapturePlugin(flutter::BinaryMessenger* messenger,
+                                       PlatformTaskQueue* task_queue)
+    : task_queue_(task_queue) {
+  stop_event_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+  frames_ready_event_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+
+  method_channel_ =
+      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+          messenger, kMethodChannelName,
+          &flutter::StandardMethodCodec::GetInstance());
+  method_channel_->SetMethodCallHandler(
+      [this](const auto& call, auto result) {
+        HandleMethodCall(call, std::move(result));
+      });
+
+  event_channel_ =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          messenger, kEventChannelName,
+          &flutter::StandardMethodCodec::GetInstance());
+  event_channel_->SetStreamHandler(
+      std::make_unique<
+          flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [this](const flutter::EncodableValue* arguments,
+                 std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&&
+                     events)
+              -> std::unique_ptr<
+                  flutter::StreamHandlerError<flutter::EncodableValue>> {
+            event_sink_ = std::move(events);
+            return nullptr;
+          },
+          [this](const flutter::EncodableValue* arguments)
+              -> std::unique_ptr<
+                  flutter::StreamHandlerError<flutter::EncodableValue>> {
+            event_sink_ = nullptr;
+            return nullptr;
+          }));
+}
+
+AudioCapturePlugin::~AudioCapturePlugin() {
+  method_channel_->SetMethodCallHandler(nullptr);
+  event_channel_->SetStreamHandler(nullptr);
+  event_sink_ = nullptr;
+  Stop();
+  alive_.reset();
+  if (frames_ready_event_) {
+    CloseHandle(frames_ready_event_);
+  }
+  if (stop_event_) {
+    CloseHandle(stop_event_);
+  }
+}
+
+void AudioCapturePlugin::HandleMethodCall(
+    const flutter::MethodCall<flutter::EncodableValue>& call,
+    Result result) {
+  if (call.method_name() == "stop") {
+    Stop();
+    result->Success();
+    return;
+  }
+  if (call.method_name() != "start") {
+    result->NotImplemented();
+    return;
+  }
+  if (capture_thread_.joinable()) {
+    result->Error("bad_arguments", "Capture has already started");
+    return;
+  }
+  const auto* arguments = std::get_if<EncodableMap>(call.arguments());
+  std::optional<int64_t> sample_rate =
+      LookupInt(arguments, "sampleRate", kDefaultSampleRate);
+  std::optional<int64_t> frame_ms =
+      LookupInt(arguments, "frameMs", kDefaultFrameMs);
+  if (!sample_rate || !frame_ms) {
+    result->Error("bad_arguments", "sampleRate and frameMs must be integers");
+    return;
+  }
+  if (*sample_rate < kMinSampleRate || *sample_rate > kMaxSampleRate ||
+      *frame_ms < kMinFrameMs || *frame_ms > kMaxFrameMs) {
+    result->Error("bad_arguments", "sampleRate or frameMs is out of range");
+    return;
+  }
+  if (!stop_event_ || !frames_ready_event_ ||
+      !RegisterWaitForSingleObject(&frames_ready_wait_, frames_ready_event_,
+                                   &AudioCapturePlugin::OnFramesReady, this,
+                                   INFINITE, WT_EXECUTEDEFAULT)) {
+    frames_ready_wait_ = nullptr;
+    result->Error("unavailable", "Audio capture could not be set up");
+    return;
+  }
+
+  sample_rate_ = static_cast<uint32_t>(*sample_rate);
+  frame_samples_ = static_cast<size_t>(*sample_rate * *frame_ms / 1000);
+  // Allocated here so the capture thread never has to.
+  ring_.assign(static_cast<size_t>(*sample_rate * kRingMs / 1000), 0);
+  ring_written_ = 0;
+  ring_read_ = 0;
+  overruns_ = 0;
+  start_result_ = std::move(result);
+  ++session_;
+  capture_thread_ = std::thread(&AudioCapturePlugin::Capture, this, session_);
+}
+
+void AudioCapturePlugin::Capture(uint64_t session) {
+  HRESULT com_result = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+  DWORD task_index = 0;
+  HANDLE mmcss = AvSetMmThreadCharacteristics(L"Pro Audio", &task_index);
+  if (mmcss) {
+    AvSetMmThreadPriority(mmcss, AVRT_PRIORITY_HIGH);
+  }
+
+  RunCapture(session);
+
+  if (mmcss) {
+    AvRevertMmThreadCharacteristics(mmcss);
+  }
+  if (SUCCEEDED(com_result)) {
+    CoUninitialize();
+  }
+}
+
+void AudioCapturePlugin::RunCapture(uint64_t session) {
+  using Microsoft::WRL::ComPtr;
+
+  ComPtr<IMMDeviceEnumerator> enumerator;
+  ComPtr<IMMDevice> device;
+  ComPtr<IAudioClient> client;
+  ComPtr<IAudioCaptureClient> capture;
+  HANDLE audio_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+
+  WAVEFORMATEX format{};
+  format.wFormatTag = WAVE_FORMAT_PCM;
+  format.nChannels = 1;
+  format.nSamplesPerSec = sample_rate_;
+  format.wBitsPerSample = 16;
+  format.nBlockAlign =
+      static_cast<WORD>(format.nChannels * format.wBitsPerSample / 8);
+  format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
+
+  // The audio engine converts from the device's mix format, so the packets
+  // arrive in the format Dart asked for.
+  HRESULT hr = audio_event ? S_OK : HRESULT_FROM_WIN32(GetLastError());
+  if (SUCCEEDED(hr)) {
+    hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
+                          IID_PPV_ARGS(&enumerator));
+  }
+  if (SUCCEEDED(hr)) {
+    hr = enumerator->GetDefaultAudioEndpoint(eCapture, eCommunications,
+                                             &device);
+  }
+  if (SUCCEEDED(hr)) {
+    hr = device->Activate(__uuidof(IAudioClient), CLSCTX_ALL, nullptr,
+                          reinterpret_cast<void**>(client.GetAddressOf()));
+  }
+  if (SUCCEEDED(hr)) {
+    hr = client->Initialize(AUDCLNT_SHAREMODE_SHARED,
+                            AUDCLNT_STREAMFLAGS_EVENTCALLBACK |
+                                AUDCLNT_STREAMFLAGS_AUTOCONVERTPCM |
+                                AUDCLNT_STREAMFLAGS_SRC_DEFAULT_QUALITY,
+                            kBufferDuration, 0, &format, nullptr);
+  }
+  if (SUCCEEDED(hr)) {
+    hr = client->SetEventHandle(audio_event);
+  }
+  if (SUCCEEDED(hr)) {
+    hr = client->GetService(IID_PPV_ARGS(&capture));
+  }
+  if (SUCCEEDED(hr)) {
+    hr = client->Start();
+  }
+  PostToPlatform([this, session, hr]() { CompleteStart(session, hr); });
+  if (FAILED(hr)) {
+    if (audio_event) {
+      CloseHandle(audio_event);
+    }
+    return;
+  }
+
+  const char* failure = nullptr;
+  HANDLE handles[] = {stop_event_, audio_event};
+  for (;;) {
+    DWORD wait = WaitForMultipleObjects(2, handles, FALSE, kDeviceTimeoutMs);
+    if (wait == WAIT_OBJECT_0) {
+      break;
+    }
+    if (wait != WAIT_OBJECT_0 + 1) {
+      failure = "The microphone stopped delivering audio";
+      break;
+    }
+    UINT32 packet_size = 0;
+    while (SUCCEEDED(hr = capture->GetNextPacketSize(&packet_size)) &&
+           packet_size > 0) {
+      BYTE* data = nullptr;
+      UINT32 frames = 0;
+      DWORD flags = 0;
+      UINT64 capture_time = 0;
+      hr = capture->GetBuffer(&data, &frames, &flags, nullptr, &capture_time);
+      if (FAILED(hr)) {
+        break;
+      }
+      WriteSamples((flags & AUDCLNT_BUFFERFLAGS_SILENT)
+                       ? nullptr
+                       : reinterpret_cast<const int16_t*>(data),
+                   frames);
+      newest_sample_time_.store(
+          capture_time + uint64_t{frames} * 10000000 / sample_rate_,
+          std::memory_order_relaxed);
+      capture->ReleaseBuffer(frames);
+    }
+    if (FAILED(hr)) {
+      failure = hr == AUDCLNT_E_DEVICE_INVALIDATED
+                    ? "The microphone was disconnected"
+                    : "Audio capture failed";
+      break;
+    }
+  }
+  client->Stop();
+  CloseHandle(audio_event);
+
+  if (failure) {
+    PostToPlatform([this, session, failure]() {
+      if (session != session_) {
+        return;
+      }
+      if (event_sink_) {
+        event_sink_->Error("unavailable", failure);
+      }
+      Stop();
+    });
+  }
+}
+
+void AudioCapturePlugin::PostToPlatform(std::function<void()> task) {
+  std::weak_ptr<bool> alive = alive_;
+  task_queue_->PostTask([alive, task = std::move(task)]() {
+    if (alive.lock()) {
+      task();
+    }
+  });
+}
+
+void AudioCapturePlugin::CompleteStart(uint64_t session, HRESULT hr) {
+  if (session != session_ || !start_result_) {
+    return;
+  }
+  Result result = std::move(start_result_);
+  if (FAILED(hr)) {
+    // The capture thread has given up already.
+    Stop();
+    if (hr == E_ACCESSDENIED) {
+      result->Error("permission_denied",
+                    "Microphone access is turned off in the privacy settings");
+    } else {
+      result->Error("unavailable", "No microphone could be opened");
+    }
+    return;
+  }
+  result->Success(EncodableValue(EncodableMap{
+      {EncodableValue("sampleRate"),
+       EncodableValue(static_cast<int64_t>(sample_rate_))},
+      {EncodableValue("channels"), EncodableValue(int64_t{1})},
+      {EncodableValue("frameSamples"),
+       EncodableValue(static_cast<int64_t>(frame_samples_))},
+  }));
+}
+
+void AudioCapturePlugin::WriteSamples(const int16_t* samples, size_t count) {
+  const size_t capacity = ring_.size();
+  uint64_t written = ring_written_.load(std::memory_order_relaxed);
+  uint64_t read = ring_read_.load(std::memory_order_acquire);
+  if (written + count - read > capacity) {
+    overruns_.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  for (size_t copied = 0; copied < count;) {
+    size_t offset = static_cast<size_t>((written + copied) % capacity);
+    size_t run = std::min(count - copied, capacity - offset);
+    if (samples) {
+      memcpy(&ring_[offset], samples + copied, run * sizeof(int16_t));
+    } else {
+      memset(&ring_[offset], 0, run * sizeof(int16_t));
+    }
+    copied += run;
+  }
+  ring_written_.store(written + count, std::memory_order_release);
+  if (written + count - read >= frame_samples_) {
+    SetEvent(frames_ready_event_);
+  }
+}
+
+// static
+void CALLBACK AudioCapturePlugin::OnFramesReady(void* context,
+                                                BOOLEAN timed_out) {
+  auto* that = static_cast<AudioCapturePlugin*>(context);
+  if (!that->delivery_posted_.exchange(true)) {
+    that->PostToPlatform([that]() { that->DeliverFrames(); });
+  }
+}
+
+void AudioCapturePlugin::DeliverFrames() {
+  // Cleared first, so frames that complete from here on post again.
+  delivery_posted_ = false;
+  if (ring_.empty() || frame_samples_ == 0) {
+    return;
+  }
+  uint64_t read = ring_read_.load(std::memory_order_relaxed);
+  uint64_t written = ring_written_.load(std::memory_order_acquire);
+  size_t count = static_cast<size_t>((written - read) / frame_samples_ *
+                                     frame_samples_);
+  if (count == 0) {
+    return;
+  }
+  if (!event_sink_) {
+    // No one is listening; keep the ring from filling up.
+    ring_read_.store(read + count, std::memory_order_release);
+    return;
+  }
+
+  std::vector<uint8_t> bytes(count * sizeof(int16_t));
+  const size_t capacity = ring_.size();
+  for (size_t copied = 0; copied < count;) {
+    size_t offset = static_cast<size_t>((read + copied) % capacity);
+    size_t run = std::min(count - copied, capacity - offset);
+    memcpy(bytes.data() + copied * sizeof(int16_t), &ring_[offset],
+           run * sizeof(int16_t));
+    copied += run;
+  }
+  ring_read_.store(read + count, std::memory_order_release);
+
+  uint64_t newest = newest_sample_time_.load(std::memory_order_relaxed);
+  uint64_t now = PerformanceCounter100ns();
+  TraceLoggingWrite(
+      g_runner_trace_provider, "AudioFrames",
+      TraceLoggingUInt32(static_cast<uint32_t>(count / frame_samples_),
+                         "Frames"),
+      TraceLoggingUInt64(now > newest ? (now - newest) / 10 : 0, "LatencyUs"),
+      TraceLoggingUInt32(overruns_.load(std::memory_order_relaxed),
+                         "Overruns"));
+  event_sink_->Success(EncodableValue(std::move(bytes)));
+}
+
+void AudioCapturePlugin::Stop() {
+  if (!capture_thread_.joinable()) {
+    return;
+  }
+  SetEvent(stop_event_);
+  capture_thread_.join();
+  ResetEvent(stop_event_);
+  if (frames_ready_wait_) {
+    // Waits for a callback that is already running.
+    UnregisterWaitEx(frames_ready_wait_, INVALID_HANDLE_VALUE);
+    frames_ready_wait_ = nullptr;
+  }
+  DeliverFrames();
+  if (start_result_) {
+    start_result_->Error("unavailable", "Capture was stopped");
+    start_result_ = nullptr;
+  }
+  // Anything still queued for this session is stale now.
+  ++session_;
+}
@@ -0,0 +1,134 @@
+#ifndef RUNNER_AUDIO_CAPTURE_PLUGIN_H_
+#define RUNNER_AUDIO_CAPTURE_PLUGIN_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/event_channel.h>
+#include <flutter/method_channel.h>
+#include <windows.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "platform_task_queue.h"
+
+// Captures the microphone with WASAPI for voice input.
+//
+// The default communications device is opened in event-driven shared mode,
+// converted by the audio engine to 16-bit mono PCM at the requested rate, and
+// read on a thread registered with MMCSS as "Pro Audio". That thread only
+// copies packets into a ring buffer allocated before capture starts; it never
+// allocates or takes a lock. Whole frames are forwarded to the platform
+// thread and from there to Dart, so a frame reaches Dart within one engine
+// period (10 ms) of its last sample being captured.
+//
+// Method channel "com.tamshai.ai/audio_capture":
+//   start({sampleRate, frameMs}) - opens the microphone; replies with
+//                                  {sampleRate, channels, frameSamples}. Fails
+//                                  with "permission_denied" if the privacy
+//                                  settings block the microphone, or
+//                                  "unavailable" if there is none.
+//   stop()                       - closes it, after delivering the frames
+//                                  already complete.
+// Event channel "com.tamshai.ai/audio_capture/frames" delivers Uint8Lists of
+// one or more whole frames, and an "unavailable" error if the device goes
+// away mid-capture.
+class AudioCapturePlugin {
+ public:
+  AudioCapturePlugin(flutter::BinaryMessenger* messenger,
+                     PlatformTaskQueue* task_queue);
+  ~AudioCapturePlugin();
+
+  // Prevent copying.
+  AudioCapturePlugin(AudioCapturePlugin const&) = delete;
+  AudioCapturePlugin& operator=(AudioCapturePlugin const&) = delete;
+
+ private:
+  using Result =
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>;
+
+  void HandleMethodCall(
+      const flutter::MethodCall<flutter::EncodableValue>& call,
+      Result result);
+
+  // Body of |capture_thread_| for capture session |session|.
+  void Capture(uint64_t session);
+
+  // Opens the device, replies to start() and then copies packets into the
+  // ring until |stop_event_| is set or the device fails.
+  void RunCapture(uint64_t session);
+
+  // Runs |task| on the platform thread unless the plugin is gone by then.
+  void PostToPlatform(std::function<void()> task);
+
+  // Replies to the start() call of |session| with the outcome of opening the
+  // device. Runs on the platform thread.
+  void CompleteStart(uint64_t session, HRESULT result);
+
+  // Appends |count| samples to the ring, or silence if |samples| is null.
+  // Capture thread only.
+  void WriteSamples(const int16_t* samples, size_t count);
+
+  // Thread pool callback for |frames_ready_event_|.
+  static void CALLBACK OnFramesReady(void* context, BOOLEAN timed_out);
+
+  // Sends the complete frames in the ring to Dart. Runs on the platform
+  // thread.
+  void DeliverFrames();
+
+  // Stops capturing and waits for the capture thread to exit.
+  void Stop();
+
+  PlatformTaskQueue* task_queue_;
+
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>>
+      method_channel_;
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>>
+      event_channel_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> event_sink_;
+
+  // The start() call waiting for the device to open.
+  Result start_result_;
+
+  // Counts capture sessions, so that replies and errors posted by one that
+  // has since been stopped are dropped.
+  uint64_t session_ = 0;
+
+  // Format of the current session.
+  uint32_t sample_rate_ = 0;
+  size_t frame_samples_ = 0;
+
+  std::thread capture_thread_;
+  // Manual-reset; set to stop |capture_thread_|.
+  HANDLE stop_event_ = nullptr;
+  // Auto-reset; set by the capture thread when a frame is complete.
+  HANDLE frames_ready_event_ = nullptr;
+  HANDLE frames_ready_wait_ = nullptr;
+
+  // Single-producer, single-consumer ring of samples. The capture thread
+  // advances |ring_written_|, the platform thread |ring_read_|; both count
+  // samples since the session started.
+  std::vector<int16_t> ring_;
+  std::atomic<uint64_t> ring_written_{0};
+  std::atomic<uint64_t> ring_read_{0};
+
+  // Packets dropped because Dart fell a whole ring behind.
+  std::atomic<uint32_t> overruns_{0};
+
+  // When the newest sample in the ring was captured, in 100 ns units of the
+  // performance counter.
+  std::atomic<uint64_t> newest_sample_time_{0};
+
+  // Whether a DeliverFrames task is queued and has not started yet.
+  std::atomic<bool> delivery_posted_{false};
+
+  // Tasks posted from the capture thread hold a weak reference to this token
+  // so they become no-ops once the plugin has been destroyed.
+  std::shared_ptr<bool> alive_ = std::make_shared<bool>(true);
+};
+
+#endif  // RUNNER_AUDIO_CAPTURE_PLUGIN_H_
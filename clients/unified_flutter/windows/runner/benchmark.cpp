@@ -0,0 +1,312 @@
+#include "benchmark.h"
+
+#include <dxgi1_4.h>
+#include <psapi.h>
+#include <wrl/client.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+
+#include "json_decoder.h"
+#include "sse_event_parser.h"
+#include "utils.h"
+
+namespace {
+
+constexpr char kScenarioFlag[] = "--benchmark=";
+constexpr char kOutputFlag[] = "--benchmark-output=";
+constexpr char kSseFlag[] = "--benchmark-sse=";
+
+// How long the startup scenario keeps recording after the first frame.
+constexpr LONGLONG kStartupTailMs = 1000;
+
+// The resize storm: this many resizes, one per interval, then a pause for
+// the last frames to land.
+constexpr int kResizeSteps = 120;
+constexpr LONGLONG kResizeIntervalMs = 16;
+constexpr LONGLONG kSettleMs = 500;
+
+// How often the sse scenario checks whether the replay is done.
+constexpr LONGLONG kSsePollMs = 50;
+
+// How long to wait for Dart to report the last frames' timings, which the
+// engine hands to it in batches about once a second.
+constexpr LONGLONG kTimingsFlushMs = 1100;
+
+// Bytes handed to the parser at a time, about one network read.
+constexpr size_t kSseChunkSize = 1024;
+
+// Returns the value of |flag| in |arguments|, or empty if it is not there.
+std::string FlagValue(const std::vector<std::string>& arguments,
+                      const char* flag) {
+  std::string prefix(flag);
+  for (const std::string& argument : arguments) {
+    if (argument.compare(0, prefix.size(), prefix) == 0) {
+      return argument.substr(prefix.size());
+    }
+  }
+  return std::string();
+}
+
+int64_t PerformanceCounter() {
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  return now.QuadPart;
+}
+
+double TicksToMs(int64_t ticks) {
+  static const int64_t frequency = []() {
+    LARGE_INTEGER value;
+    QueryPerformanceFrequency(&value);
+    return value.QuadPart;
+  }();
+  return static_cast<double>(ticks) * 1000.0 /
+         static_cast<double>(frequency);
+}
+
+// Milliseconds since this process was created.
+double MsSinceProcessCreation() {
+  FILETIME creation_time, exit_time, kernel_time, user_time;
+  if (!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time,
+                       &kernel_time, &user_time)) {
+    return 0;
+  }
+  FILETIME now;
+  GetSystemTimePreciseAsFileTime(&now);
+  ULARGE_INTEGER start_time;
+  start_time.LowPart = creation_time.dwLowDateTime;
+  start_time.HighPart = creation_time.dwHighDateTime;
+  ULARGE_INTEGER now_time;
+  now_time.LowPart = now.dwLowDateTime;
+  now_time.HighPart = now.dwHighDateTime;
+  // FILETIME counts 100 ns intervals.
+  return static_cast<double>(now_time.QuadPart - start_time.QuadPart) /
+         10000.0;
+}
+
+// Arms |timer| to fire after |due_ms|, then every |period_ms| if non-zero.
+void ArmTimer(HANDLE timer, LONGLONG due_ms, LONG period_ms) {
+  LARGE_INTEGER due_time;
+  due_time.QuadPart = -due_ms * 10000;
+  SetWaitableTimer(timer, &due_time, period_ms, nullptr, nullptr, FALSE);
+}
+
+// Bytes of dedicated GPU memory this process uses, over all adapters.
+uint64_t GpuLocalBytes() {
+  Microsoft::WRL::ComPtr<IDXGIFactory1> factory;
+  if (FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&factory)))) {
+    return 0;
+  }
+  uint64_t total = 0;
+  Microsoft::WRL::ComPtr<IDXGIAdapter1> adapter;
+  for (UINT i = 0; factory->EnumAdapters1(i, &adapter) == S_OK; ++i) {
+    Microsoft::WRL::ComPtr<IDXGIAdapter3> adapter3;
+    DXGI_QUERY_VIDEO_MEMORY_INFO info;
+    if (SUCCEEDED(adapter.As(&adapter3)) &&
+        SUCCEEDED(adapter3->QueryVideoMemoryInfo(
+            0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info))) {
+      total += info.CurrentUsage;
+    }
+  }
+  return total;
+}
+
+std::string FormatMs(double value) {
+  char text[32];
+  snprintf(text, sizeof(text), "%.3f", value);
+  return text;
+}
+
+std::string DistributionToJson(
+    const FrameTelemetry::Distribution& distribution) {
+  return "{\"p50\":" + FormatMs(distribution.p50_ms) +
+         ",\"p90\":" + FormatMs(distribution.p90_ms) +
+         ",\"p99\":" + FormatMs(distribution.p99_ms) +
+         ",\"max\":" + FormatMs(distribution.max_ms) + "}";
+}
+
+}  // namespace
+
+// static
+std::unique_ptr<Benchmark> Benchmark::FromArguments(
+    const std::vector<std::string>& arguments) {
+  std::string scenario = FlagValue(arguments, kScenarioFlag);
+  std::string output = FlagValue(arguments, kOutputFlag);
+  std::string sse = FlagValue(arguments, kSseFlag);
+  if (output.empty() ||
+      (scenario != "startup" && scenario != "resize" && scenario != "sse") ||
+      (scenario == "sse" && sse.empty())) {
+    return nullptr;
+  }
+  return std::unique_ptr<Benchmark>(new Benchmark(
+      std::move(scenario), Utf16FromUtf8(output), Utf16FromUtf8(sse)));
+}
+
+Benchmark::Benchmark(std::string scenario,
+                     std::wstring output_path,
+                     std::wstring sse_path)
+    : scenario_(std::move(scenario)),
+      output_path_(std::move(output_path)),
+      sse_path_(std::move(sse_path)) {}
+
+Benchmark::~Benchmark() {
+  // The run loop is done with the timer by now.
+  if (timer_) {
+    CloseHandle(timer_);
+  }
+  if (sse_thread_.joinable()) {
+    sse_thread_.join();
+  }
+}
+
+void Benchmark::Attach(HWND window,
+                       RunnerEngine* engine,
+                       RunLoop* run_loop,
+                       const FrameTelemetry* telemetry) {
+  window_ = window;
+  engine_ = engine;
+  run_loop_ = run_loop;
+  telemetry_ = telemetry;
+  timer_ = CreateWaitableTimerEx(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+  if (timer_) {
+    timer_wait_ =
+        run_loop_->AddWaitableHandle(timer_, [this]() { OnTimer(); });
+  }
+  engine_->AddNextFrameCallback([this]() { OnFirstFrame(); });
+}
+
+void Benchmark::OnFirstFrame() {
+  first_frame_ms_ = MsSinceProcessCreation();
+  StartScenario();
+}
+
+void Benchmark::StartScenario() {
+  if (!timer_wait_) {
+    Finish();
+    return;
+  }
+  if (scenario_ == "resize") {
+    ArmTimer(timer_, kResizeIntervalMs, static_cast<LONG>(kResizeIntervalMs));
+  } else if (scenario_ == "sse") {
+    sse_thread_ = std::thread(&Benchmark::ReplaySse, this);
+    ArmTimer(timer_, kSsePollMs, static_cast<LONG>(kSsePollMs));
+  } else {
+    ArmTimer(timer_, kStartupTailMs, 0);
+  }
+}
+
+void Benchmark::OnTimer() {
+  if (flushing_) {
+    Finish();
+    return;
+  }
+  if (scenario_ == "resize" && resize_steps_ < kResizeSteps) {
+    // Alternate between shrinking and growing, so that every step changes
+    // the surface size.
+    int step = resize_steps_++;
+    int delta = (step % 20 < 10 ? step % 10 : 10 - step % 10) * 24;
+    SetWindowPos(window_, nullptr, 0, 0, 1280 - delta, 720 - delta,
+                 SWP_NOMOVE | SWP_NOZORDER | SWP_NOACTIVATE);
+    if (resize_steps_ == kResizeSteps) {
+      ArmTimer(timer_, kSettleMs, 0);
+    }
+    return;
+  }
+  if (scenario_ == "sse" && !sse_done_) {
+    return;
+  }
+  Flush();
+}
+
+void Benchmark::ReplaySse() {
+  HANDLE file = CreateFile(sse_path_.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                           nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                           nullptr);
+  if (file != INVALID_HANDLE_VALUE) {
+    std::string stream;
+    char buffer[64 * 1024];
+    DWORD bytes_read = 0;
+    while (ReadFile(file, buffer, sizeof(buffer), &bytes_read, nullptr) &&
+           bytes_read > 0) {
+      stream.append(buffer, bytes_read);
+    }
+    CloseHandle(file);
+
+    // The same work the SSE transport does per event, minus the network.
+    int64_t start = PerformanceCounter();
+    SseEventParser parser([this](const SseEvent& event) {
+      ++sse_events_;
+      if (event.data != "[DONE]") {
+        DecodeJson(event.data);
+      }
+    });
+    for (size_t offset = 0; offset < stream.size(); offset += kSseChunkSize) {
+      parser.Append(stream.data() + offset,
+                    std::min(kSseChunkSize, stream.size() - offset));
+    }
+    parser.Finish();
+    sse_ms_ = TicksToMs(PerformanceCounter() - start);
+    sse_bytes_ = stream.size();
+  }
+  sse_done_ = true;
+}
+
+void Benchmark::Flush() {
+  flushing_ = true;
+  ArmTimer(timer_, kTimingsFlushMs, 0);
+}
+
+void Benchmark::Finish() {
+  if (finished_) {
+    return;
+  }
+  finished_ = true;
+  if (timer_wait_) {
+    run_loop_->RemoveWaitableHandle(timer_wait_);
+    timer_wait_ = 0;
+  }
+  if (sse_thread_.joinable()) {
+    sse_thread_.join();
+  }
+
+  // Covers the frames since launch, or the last FrameTelemetry::kCapacity.
+  FrameTelemetry::Summary frames;
+  if (telemetry_) {
+    frames = telemetry_->Summarize();
+  }
+
+  PROCESS_MEMORY_COUNTERS_EX memory{};
+  memory.cb = sizeof(memory);
+  GetProcessMemoryInfo(GetCurrentProcess(),
+                       reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&memory),
+                       sizeof(memory));
+
+  std::string report = "{\"scenario\":\"" + scenario_ + "\"";
+  report += ",\"wallTimeMs\":" + FormatMs(MsSinceProcessCreation());
+  report += ",\"firstFrameMs\":" + FormatMs(first_frame_ms_);
+  report += ",\"frames\":" + std::to_string(frames.frames);
+  report += ",\"jankyFrames\":" + std::to_string(frames.janky_frames);
+  // Build plus raster.
+  report += ",\"frameTimeMs\":" + DistributionToJson(frames.total);
+  report += ",\"buildMs\":" + DistributionToJson(frames.build);
+  report += ",\"rasterMs\":" + DistributionToJson(frames.raster);
+  report += ",\"privateBytes\":" + std::to_string(memory.PrivateUsage);
+  report += ",\"gpuLocalBytes\":" + std::to_string(GpuLocalBytes());
+  if (scenario_ == "sse") {
+    report += ",\"sse\":{\"events\":" + std::to_string(sse_events_) +
+              ",\"bytes\":" + std::to_string(sse_bytes_) +
+              ",\"parseMs\":" + FormatMs(sse_ms_) + "}";
+  }
+  report += "}\n";
+
+  HANDLE file = CreateFile(output_path_.c_str(), GENERIC_WRITE, 0, nullptr,
+                           CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file != INVALID_HANDLE_VALUE) {
+    DWORD bytes_written = 0;
+    WriteFile(file, report.data(), static_cast<DWORD>(report.size()),
+              &bytes_written, nullptr);
+    CloseHandle(file);
+  }
+  PostMessage(window_, WM_CLOSE, 0, 0);
+}
@@ -0,0 +1,106 @@
+#ifndef RUNNER_BENCHMARK_H_
+#define RUNNER_BENCHMARK_H_
+
+#include <windows.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame_telemetry.h"
+#include "run_loop.h"
+#include "runner_engine.h"
+
+// Runs one benchmark scenario in this process and reports it, for the
+// tamshai_ai_bench harness (windows/bench).
+//
+// Enabled by "--benchmark=<scenario>" on the command line, with the report
+// written as JSON to the path given by "--benchmark-output=<path>":
+//   startup - first frame, then a second of whatever the app draws next.
+//   resize  - a storm of window resizes after the first frame.
+//   sse     - a recorded SSE stream, given by "--benchmark-sse=<path>",
+//             replayed through SseEventParser and DecodeJson on a worker
+//             thread while the app keeps drawing.
+//
+// The report holds the wall time since the process was created, the time to
+// the first frame, percentiles of the time each frame took to build and
+// raster (from the FrameTiming Dart reports to FrameTelemetry, rather than
+// the spacing of presents, which is mostly vsync and idle time), private
+// bytes and the GPU memory the process uses. The window closes once it is
+// written.
+class Benchmark {
+ public:
+  // Returns the benchmark the command line asks for, or null if none.
+  static std::unique_ptr<Benchmark> FromArguments(
+      const std::vector<std::string>& arguments);
+
+  ~Benchmark();
+
+  // Prevent copying.
+  Benchmark(Benchmark const&) = delete;
+  Benchmark& operator=(Benchmark const&) = delete;
+
+  // Starts measuring |window|, which hosts a view of |engine| whose frame
+  // timings |telemetry| collects. Call after the window is created and
+  // before |run_loop| runs; the loop must be done running by the time this
+  // is destroyed.
+  void Attach(HWND window,
+              RunnerEngine* engine,
+              RunLoop* run_loop,
+              const FrameTelemetry* telemetry);
+
+ private:
+  Benchmark(std::string scenario,
+            std::wstring output_path,
+            std::wstring sse_path);
+
+  // Records the first frame and starts the scenario.
+  void OnFirstFrame();
+
+  // Runs the scenario once the first frame is up.
+  void StartScenario();
+
+  // Called by |timer_| during the scenario.
+  void OnTimer();
+
+  // Replays |sse_path_| on |sse_thread_|.
+  void ReplaySse();
+
+  // Waits for the timings of the last frames to be reported, then finishes.
+  void Flush();
+
+  // Writes the report and closes the window.
+  void Finish();
+
+  std::string scenario_;
+  std::wstring output_path_;
+  std::wstring sse_path_;
+
+  HWND window_ = nullptr;
+  RunnerEngine* engine_ = nullptr;
+  RunLoop* run_loop_ = nullptr;
+  const FrameTelemetry* telemetry_ = nullptr;
+
+  HANDLE timer_ = nullptr;
+  RunLoop::Id timer_wait_ = 0;
+  int resize_steps_ = 0;
+
+  bool flushing_ = false;
+  bool finished_ = false;
+
+  // Milliseconds from process creation to the first frame.
+  double first_frame_ms_ = 0;
+
+  std::thread sse_thread_;
+  std::atomic<bool> sse_done_{false};
+
+  // Written by |sse_thread_|; read after it is joined.
+  size_t sse_events_ = 0;
+  size_t sse_bytes_ = 0;
+  double sse_ms_ = 0;
+};
+
+#endif  // RUNNER_BENCHMARK_H_
@@ -0,0 +1,229 @@
+#include "certificate_pinner.h"
+
+#include <bcrypt.h>
+#include <flutter/standard_method_codec.h>
+#include <wincrypt.h>
+
+#include <algorithm>
+#include <cwctype>
+#include <optional>
+#include <utility>
+
+#include "utils.h"
+
+namespace {
+
+constexpr char kMethodChannelName[] = "com.tamshai.ai/certificate_pins";
+
+// The prefix of a pin, as in HTTP public key pinning and OkHttp.
+constexpr char kPinPrefix[] = "sha256/";
+constexpr size_t kPinPrefixSize = sizeof(kPinPrefix) - 1;
+
+// Servers seen in a session are few; this only bounds a misbehaving one.
+constexpr size_t kMaxVerifiedChains = 64;
+
+using flutter::EncodableList;
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+// Returns the strings listed under |key| in |map|, or nothing if it isn't a
+// list of strings.
+std::optional<std::vector<std::string>> LookupStrings(const EncodableMap& map,
+                                                      const char* key) {
+  auto it = map.find(EncodableValue(key));
+  if (it == map.end() || it->second.IsNull()) {
+    return std::vector<std::string>();
+  }
+  const auto* list = std::get_if<EncodableList>(&it->second);
+  if (!list) {
+    return std::nullopt;
+  }
+  std::vector<std::string> strings;
+  for (const auto& item : *list) {
+    const auto* string = std::get_if<std::string>(&item);
+    if (!string) {
+      return std::nullopt;
+    }
+    strings.push_back(*string);
+  }
+  return strings;
+}
+
+// Decodes "sha256/<Base64 digest>". Returns nothing if |pin| isn't one.
+std::optional<CertificatePinner::Digest> ParsePin(const std::string& pin) {
+  if (pin.compare(0, kPinPrefixSize, kPinPrefix) != 0) {
+    return std::nullopt;
+  }
+  CertificatePinner::Digest digest;
+  DWORD size = static_cast<DWORD>(digest.size());
+  if (!CryptStringToBinaryA(pin.c_str() + kPinPrefixSize,
+                            static_cast<DWORD>(pin.size() - kPinPrefixSize),
+                            CRYPT_STRING_BASE64, digest.data(), &size,
+                            nullptr, nullptr) ||
+      size != digest.size()) {
+    return std::nullopt;
+  }
+  return digest;
+}
+
+std::wstring Lowercase(std::wstring text) {
+  std::transform(text.begin(), text.end(), text.begin(),
+                 [](wchar_t c) { return static_cast<wchar_t>(towlower(c)); });
+  return text;
+}
+
+// The SHA-256 digest of |certificate|'s DER-encoded SubjectPublicKeyInfo.
+std::optional<CertificatePinner::Digest> PublicKeyDigest(
+    PCCERT_CONTEXT certificate) {
+  BYTE* encoded = nullptr;
+  DWORD encoded_size = 0;
+  if (!CryptEncodeObjectEx(X509_ASN_ENCODING, X509_PUBLIC_KEY_INFO,
+                           &certificate->pCertInfo->SubjectPublicKeyInfo,
+                           CRYPT_ENCODE_ALLOC_FLAG, nullptr, &encoded,
+                           &encoded_size)) {
+    return std::nullopt;
+  }
+  CertificatePinner::Digest digest;
+  NTSTATUS status =
+      BCryptHash(BCRYPT_SHA256_ALG_HANDLE, nullptr, 0, encoded, encoded_size,
+                 digest.data(), static_cast<ULONG>(digest.size()));
+  LocalFree(encoded);
+  if (status < 0) {
+    return std::nullopt;
+  }
+  return digest;
+}
+
+// Whether any certificate |leaf| chains through, itself included, has one of
+// |pins|. Schannel has already built and validated the chain, so building it
+// again here is served from the chain engine's cache.
+bool ChainIsPinned(PCCERT_CONTEXT leaf,
+                   const std::vector<CertificatePinner::Digest>& pins) {
+  CERT_CHAIN_PARA parameters{};
+  parameters.cbSize = sizeof(parameters);
+  PCCERT_CHAIN_CONTEXT chain = nullptr;
+  if (!CertGetCertificateChain(nullptr, leaf, nullptr, leaf->hCertStore,
+                               &parameters, 0, nullptr, &chain)) {
+    return false;
+  }
+  bool pinned = false;
+  if (chain->cChain > 0) {
+    const CERT_SIMPLE_CHAIN* simple = chain->rgpChain[0];
+    for (DWORD i = 0; i < simple->cElement && !pinned; ++i) {
+      std::optional<CertificatePinner::Digest> digest =
+          PublicKeyDigest(simple->rgpElement[i]->pCertContext);
+      pinned = digest &&
+               std::find(pins.begin(), pins.end(), *digest) != pins.end();
+    }
+  }
+  CertFreeCertificateChain(chain);
+  return pinned;
+}
+
+}  // namespace
+
+// static
+CertificatePinner* CertificatePinner::GetInstance() {
+  static CertificatePinner* instance = new CertificatePinner();
+  return instance;
+}
+
+void CertificatePinner::Attach(flutter::BinaryMessenger* messenger) {
+  channel_ = std::make_unique<flutter::MethodChannel<EncodableValue>>(
+      messenger, kMethodChannelName,
+      &flutter::StandardMethodCodec::GetInstance());
+  channel_->SetMethodCallHandler([this](const auto& call, auto result) {
+    HandleMethodCall(call, std::move(result));
+  });
+}
+
+void CertificatePinner::Detach() {
+  if (channel_) {
+    channel_->SetMethodCallHandler(nullptr);
+    channel_ = nullptr;
+  }
+}
+
+bool CertificatePinner::Verify(HINTERNET request, const std::wstring& host) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!configured_) {
+      return false;
+    }
+    if (pins_.empty() ||
+        std::find(exempt_hosts_.begin(), exempt_hosts_.end(),
+                  Lowercase(host)) != exempt_hosts_.end()) {
+      return true;
+    }
+  }
+
+  PCCERT_CONTEXT leaf = nullptr;
+  DWORD leaf_size = sizeof(leaf);
+  if (!WinHttpQueryOption(request, WINHTTP_OPTION_SERVER_CERT_CONTEXT, &leaf,
+                          &leaf_size)) {
+    return false;
+  }
+  std::string key(reinterpret_cast<const char*>(leaf->pbCertEncoded),
+                  leaf->cbCertEncoded);
+
+  std::vector<Digest> pins;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = verified_.find(key);
+    if (it != verified_.end()) {
+      CertFreeCertificateContext(leaf);
+      return it->second;
+    }
+    pins = pins_;
+  }
+  bool pinned = ChainIsPinned(leaf, pins);
+  CertFreeCertificateContext(leaf);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Pins replaced meanwhile make the result stale, so it isn't kept.
+  if (pins == pins_) {
+    if (verified_.size() >= kMaxVerifiedChains) {
+      verified_.clear();
+    }
+    verified_[std::move(key)] = pinned;
+  }
+  return pinned;
+}
+
+void CertificatePinner::HandleMethodCall(
+    const flutter::MethodCall<EncodableValue>& call,
+    std::unique_ptr<flutter::MethodResult<EncodableValue>> result) {
+  if (call.method_name() != "configure") {
+    result->NotImplemented();
+    return;
+  }
+  const auto* arguments = std::get_if<EncodableMap>(call.arguments());
+  std::optional<std::vector<std::string>> pin_strings =
+      arguments ? LookupStrings(*arguments, "pins") : std::nullopt;
+  std::optional<std::vector<std::string>> host_strings =
+      arguments ? LookupStrings(*arguments, "exemptHosts") : std::nullopt;
+  if (!pin_strings || !host_strings) {
+    result->Error("bad_arguments", "pins and exemptHosts must list strings");
+    return;
+  }
+  std::vector<Digest> pins;
+  for (const auto& pin_string : *pin_strings) {
+    std::optional<Digest> pin = ParsePin(pin_string);
+    if (!pin) {
+      result->Error("bad_arguments", "Not a sha256/ pin: " + pin_string);
+      return;
+    }
+    pins.push_back(*pin);
+  }
+  std::vector<std::wstring> exempt_hosts;
+  for (const auto& host : *host_strings) {
+    exempt_hosts.push_back(Lowercase(Utf16FromUtf8(host)));
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  configured_ = true;
+  pins_ = std::move(pins);
+  exempt_hosts_ = std::move(exempt_hosts);
+  verified_.clear();
+  result->Success();
+}
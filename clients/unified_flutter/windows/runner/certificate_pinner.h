@@ -0,0 +1,71 @@
+#ifndef RUNNER_CERTIFICATE_PINNER_H_
+#define RUNNER_CERTIFICATE_PINNER_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/method_channel.h>
+#include <windows.h>
+#include <winhttp.h>
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Checks the certificates of the runner's WinHTTP connections against the
+// public keys Dart pins.
+//
+// A chain is accepted if any of its certificates has a SubjectPublicKeyInfo
+// whose SHA-256 digest is pinned. The result is kept per leaf certificate for
+// the rest of the session, so reconnects and parallel requests to a server
+// only cost a lookup; the chain is only built and hashed once.
+//
+// Method channel "com.tamshai.ai/certificate_pins":
+//   configure({pins, exemptHosts}) - replaces the pins, each "sha256/" and
+//     the Base64 digest, and the hosts that are not checked. No pins turns
+//     checking off. Until the first configure call, every connection is
+//     refused, so none can go out unpinned before Dart has set the pins.
+class CertificatePinner {
+ public:
+  using Digest = std::array<uint8_t, 32>;
+
+  // Returns the process-wide instance.
+  static CertificatePinner* GetInstance();
+
+  // Prevent copying.
+  CertificatePinner(CertificatePinner const&) = delete;
+  CertificatePinner& operator=(CertificatePinner const&) = delete;
+
+  // Handles configure calls on |messenger| until Detach.
+  void Attach(flutter::BinaryMessenger* messenger);
+  void Detach();
+
+  // Whether HTTPS |request|, to |host|, is connected to a server that
+  // presented a pinned chain. Call from the request's
+  // WINHTTP_CALLBACK_STATUS_SENDING_REQUEST callback, once the connection is
+  // up but before anything is sent on it. False for every request until the
+  // pins have been configured. Safe to call from any thread.
+  bool Verify(HINTERNET request, const std::wstring& host);
+
+ private:
+  CertificatePinner() = default;
+
+  void HandleMethodCall(
+      const flutter::MethodCall<flutter::EncodableValue>& call,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  // Guards all of the below, which Verify reads from request threads.
+  std::mutex mutex_;
+  bool configured_ = false;
+  std::vector<Digest> pins_;
+  std::vector<std::wstring> exempt_hosts_;
+  // Results by the encoded leaf certificate.
+  std::map<std::string, bool> verified_;
+
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> channel_;
+};
+
+#endif  // RUNNER_CERTIFICATE_PINNER_H_
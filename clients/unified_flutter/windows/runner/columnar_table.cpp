@@ -0,0 +1,385 @@
+#include "columnar_table.h"
+
+#include <windows.h>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#endif
+#include <intrin.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+#include "utils.h"
+
+namespace {
+
+constexpr size_t kRowsPerWord = 64;
+
+constexpr uint64_t kSignBit = uint64_t{1} << 63;
+
+// Lowercases |text| the same way whatever the user's locale, for matching.
+std::wstring Fold(const std::wstring& text) {
+  if (text.empty()) {
+    return text;
+  }
+  int size = static_cast<int>(text.size());
+  std::wstring folded(text.size(), L'\0');
+  int written =
+      LCMapStringEx(LOCALE_NAME_INVARIANT, LCMAP_LOWERCASE, text.c_str(), size,
+                    folded.data(), size, nullptr, nullptr, 0);
+  return written == size ? folded : text;
+}
+
+// The bytes that order |text| as the user's locale does, ignoring case and
+// with embedded numbers compared by value ("Lot 9" before "Lot 10").
+std::string SortKey(const std::wstring& text) {
+  if (text.empty()) {
+    return std::string();
+  }
+  constexpr DWORD kFlags =
+      LCMAP_SORTKEY | LINGUISTIC_IGNORECASE | SORT_DIGITSASNUMBERS;
+  int size = LCMapStringEx(LOCALE_NAME_USER_DEFAULT, kFlags, text.c_str(),
+                           static_cast<int>(text.size()), nullptr, 0, nullptr,
+                           nullptr, 0);
+  if (size <= 0) {
+    return std::string();
+  }
+  std::string key(static_cast<size_t>(size), '\0');
+  LCMapStringEx(LOCALE_NAME_USER_DEFAULT, kFlags, text.c_str(),
+                static_cast<int>(text.size()),
+                reinterpret_cast<LPWSTR>(key.data()), size, nullptr, nullptr,
+                0);
+  return key;
+}
+
+// Maps |value| to an integer with the same order, negatives included.
+uint64_t OrderedBits(double value) {
+  if (value == 0) {
+    value = 0;  // -0 sorts with 0.
+  }
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return (bits & kSignBit) ? ~bits : bits | kSignBit;
+}
+
+void ClearBit(size_t row, uint64_t* words) {
+  words[row / kRowsPerWord] &= ~(uint64_t{1} << (row % kRowsPerWord));
+}
+
+// Calls |visit| with each row whose bit is set in |words|, in order.
+template <typename Visit>
+void ForEachRow(const std::vector<uint64_t>& words, Visit visit) {
+  for (size_t word = 0; word < words.size(); ++word) {
+    uint64_t bits = words[word];
+    while (bits != 0) {
+      unsigned long bit;
+      _BitScanForward64(&bit, bits);
+      visit(word * kRowsPerWord + bit);
+      bits &= bits - 1;
+    }
+  }
+}
+
+// Clears the bits of rows whose id is not |id|. Compares four ids at a time
+// with SSE2, skipping words with no rows left.
+void KeepIdsEqual(const uint32_t* ids,
+                  size_t rows,
+                  uint32_t id,
+                  uint64_t* words) {
+  size_t row = 0;
+#if defined(_M_X64) || defined(_M_IX86)
+  const __m128i target = _mm_set1_epi32(static_cast<int>(id));
+  for (; row + kRowsPerWord <= rows; row += kRowsPerWord) {
+    uint64_t& word = words[row / kRowsPerWord];
+    if (word == 0) {
+      continue;
+    }
+    uint64_t match = 0;
+    for (size_t lane = 0; lane < kRowsPerWord; lane += 4) {
+      __m128i chunk = _mm_loadu_si128(
+          reinterpret_cast<const __m128i*>(ids + row + lane));
+      int mask = _mm_movemask_ps(
+          _mm_castsi128_ps(_mm_cmpeq_epi32(chunk, target)));
+      match |= static_cast<uint64_t>(mask) << lane;
+    }
+    word &= match;
+  }
+#endif
+  for (; row < rows; ++row) {
+    if (ids[row] != id) {
+      ClearBit(row, words);
+    }
+  }
+}
+
+// Clears the bits of rows whose number is below |bound| (|at_least|) or
+// above it, or missing. Compares two numbers at a time with SSE2; NaN fails
+// both comparisons.
+void KeepNumbersWithin(const double* numbers,
+                       size_t rows,
+                       double bound,
+                       bool at_least,
+                       uint64_t* words) {
+  size_t row = 0;
+#if defined(_M_X64) || defined(_M_IX86)
+  const __m128d limit = _mm_set1_pd(bound);
+  for (; row + kRowsPerWord <= rows; row += kRowsPerWord) {
+    uint64_t& word = words[row / kRowsPerWord];
+    if (word == 0) {
+      continue;
+    }
+    uint64_t match = 0;
+    for (size_t lane = 0; lane < kRowsPerWord; lane += 2) {
+      __m128d chunk = _mm_loadu_pd(numbers + row + lane);
+      __m128d pass = at_least ? _mm_cmpge_pd(chunk, limit)
+                              : _mm_cmple_pd(chunk, limit);
+      match |= static_cast<uint64_t>(_mm_movemask_pd(pass)) << lane;
+    }
+    word &= match;
+  }
+#endif
+  for (; row < rows; ++row) {
+    bool pass = at_least ? numbers[row] >= bound : numbers[row] <= bound;
+    if (!pass) {
+      ClearBit(row, words);
+    }
+  }
+}
+
+}  // namespace
+
+bool ColumnarTable::AcceptRows(size_t rows) {
+  if (columns_.empty()) {
+    row_count_ = rows;
+    return true;
+  }
+  return rows == row_count_;
+}
+
+bool ColumnarTable::AddStringColumn(
+    std::string name,
+    const std::vector<std::optional<std::string>>& values) {
+  if (!AcceptRows(values.size())) {
+    return false;
+  }
+  Column column;
+  column.name = std::move(name);
+  column.is_string = true;
+  column.ids.reserve(values.size());
+  std::unordered_map<std::string, uint32_t> interned;
+  for (const std::optional<std::string>& value : values) {
+    if (!value) {
+      column.ids.push_back(0);
+      continue;
+    }
+    auto [it, added] = interned.try_emplace(
+        *value, static_cast<uint32_t>(column.values.size() + 1));
+    if (added) {
+      column.values.push_back(*value);
+    }
+    column.ids.push_back(it->second);
+  }
+
+  // Ranks come from sort keys, made once per distinct value, so sorting the
+  // dictionary compares bytes rather than calling into the locale.
+  std::vector<std::string> keys;
+  keys.reserve(column.values.size());
+  column.folded.reserve(column.values.size());
+  for (const std::string& value : column.values) {
+    std::wstring utf16 = Utf16FromUtf8(value);
+    keys.push_back(SortKey(utf16));
+    column.folded.push_back(Fold(utf16));
+  }
+  std::vector<uint32_t> order(column.values.size());
+  for (uint32_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&keys](uint32_t a, uint32_t b) {
+    return keys[a] != keys[b] ? keys[a] < keys[b] : a < b;
+  });
+  // Values the locale considers equal, e.g. differing only in case, share a
+  // rank, so their rows keep row order.
+  column.ranks.assign(column.values.size() + 1, 0);
+  uint32_t rank = 0;
+  for (size_t i = 0; i < order.size(); ++i) {
+    if (i > 0 && keys[order[i]] != keys[order[i - 1]]) {
+      ++rank;
+    }
+    column.ranks[order[i] + 1] = rank;
+  }
+  columns_.push_back(std::move(column));
+  return true;
+}
+
+bool ColumnarTable::AddNumberColumn(std::string name,
+                                    std::vector<double> values) {
+  if (!AcceptRows(values.size())) {
+    return false;
+  }
+  Column column;
+  column.name = std::move(name);
+  column.numbers = std::move(values);
+  columns_.push_back(std::move(column));
+  return true;
+}
+
+std::optional<size_t> ColumnarTable::FindColumn(const std::string& name) const {
+  for (size_t i = 0; i < columns_.size(); ++i) {
+    if (columns_[i].name == name) {
+      return i;
+    }
+  }
+  return std::nullopt;
+}
+
+std::optional<std::vector<uint32_t>> ColumnarTable::Select(
+    const std::vector<Filter>& filters,
+    const std::optional<Sort>& sort,
+    const WorkerPool::CancellationToken& token) const {
+  Bitmap bitmap((row_count_ + kRowsPerWord - 1) / kRowsPerWord, ~uint64_t{0});
+  if (size_t tail = row_count_ % kRowsPerWord; tail != 0) {
+    bitmap.back() = (uint64_t{1} << tail) - 1;
+  }
+  for (const Filter& filter : filters) {
+    if (token.IsCanceled()) {
+      return std::nullopt;
+    }
+    ApplyFilter(filter, &bitmap);
+  }
+
+  std::vector<uint32_t> rows;
+  ForEachRow(bitmap, [&rows](size_t row) {
+    rows.push_back(static_cast<uint32_t>(row));
+  });
+
+  if (sort) {
+    if (token.IsCanceled()) {
+      return std::nullopt;
+    }
+    SortRows(*sort, &rows);
+  }
+  return rows;
+}
+
+std::vector<std::pair<std::string, uint32_t>> ColumnarTable::Count(
+    size_t column,
+    const std::vector<uint32_t>& rows) const {
+  const Column& counted = columns_[column];
+  std::vector<uint32_t> counts(counted.values.size() + 1, 0);
+  for (uint32_t row : rows) {
+    ++counts[counted.ids[row]];
+  }
+  std::vector<uint32_t> ids;
+  for (uint32_t id = 1; id < counts.size(); ++id) {
+    if (counts[id] != 0) {
+      ids.push_back(id);
+    }
+  }
+  std::sort(ids.begin(), ids.end(), [&counted](uint32_t a, uint32_t b) {
+    return counted.ranks[a] != counted.ranks[b]
+               ? counted.ranks[a] < counted.ranks[b]
+               : a < b;
+  });
+  std::vector<std::pair<std::string, uint32_t>> tally;
+  tally.reserve(ids.size());
+  for (uint32_t id : ids) {
+    tally.emplace_back(counted.values[id - 1], counts[id]);
+  }
+  return tally;
+}
+
+void ColumnarTable::ApplyFilter(const Filter& filter, Bitmap* bitmap) const {
+  switch (filter.op) {
+    case Filter::Op::kEquals: {
+      const Column& column = columns_[filter.columns.front()];
+      auto it = std::find(column.values.begin(), column.values.end(),
+                          filter.text);
+      if (it == column.values.end()) {
+        std::fill(bitmap->begin(), bitmap->end(), 0);
+        return;
+      }
+      uint32_t id = static_cast<uint32_t>(it - column.values.begin()) + 1;
+      KeepIdsEqual(column.ids.data(), row_count_, id, bitmap->data());
+      return;
+    }
+    case Filter::Op::kAtLeast:
+    case Filter::Op::kAtMost: {
+      const Column& column = columns_[filter.columns.front()];
+      KeepNumbersWithin(column.numbers.data(), row_count_, filter.number,
+                        filter.op == Filter::Op::kAtLeast, bitmap->data());
+      return;
+    }
+    case Filter::Op::kContains: {
+      std::wstring needle = Fold(Utf16FromUtf8(filter.text));
+      if (needle.empty()) {
+        return;
+      }
+      // Each distinct value is searched once; rows then only look up their
+      // id.
+      std::vector<std::vector<bool>> hits;
+      hits.reserve(filter.columns.size());
+      for (size_t index : filter.columns) {
+        const Column& column = columns_[index];
+        std::vector<bool> column_hits(column.values.size() + 1, false);
+        for (size_t i = 0; i < column.folded.size(); ++i) {
+          column_hits[i + 1] =
+              column.folded[i].find(needle) != std::wstring::npos;
+        }
+        hits.push_back(std::move(column_hits));
+      }
+      Bitmap kept = *bitmap;
+      ForEachRow(kept, [&](size_t row) {
+        for (size_t i = 0; i < filter.columns.size(); ++i) {
+          if (hits[i][columns_[filter.columns[i]].ids[row]]) {
+            return;
+          }
+        }
+        ClearBit(row, bitmap->data());
+      });
+      return;
+    }
+  }
+}
+
+void ColumnarTable::SortRows(const Sort& sort,
+                             std::vector<uint32_t>* rows) const {
+  struct Keyed {
+    uint64_t key;
+    uint32_t row;
+  };
+  const Column& column = columns_[sort.column];
+  std::vector<Keyed> keyed;
+  keyed.reserve(rows->size());
+  // |rows| arrives in row order, so nulls stay in it.
+  std::vector<uint32_t> nulls;
+  for (uint32_t row : *rows) {
+    uint64_t key;
+    if (column.is_string) {
+      uint32_t id = column.ids[row];
+      if (id == 0) {
+        nulls.push_back(row);
+        continue;
+      }
+      key = column.ranks[id];
+    } else {
+      double number = column.numbers[row];
+      if (std::isnan(number)) {
+        nulls.push_back(row);
+        continue;
+      }
+      key = OrderedBits(number);
+    }
+    keyed.push_back({sort.ascending ? key : ~key, row});
+  }
+  std::sort(keyed.begin(), keyed.end(), [](const Keyed& a, const Keyed& b) {
+    return a.key != b.key ? a.key < b.key : a.row < b.row;
+  });
+  rows->clear();
+  for (const Keyed& entry : keyed) {
+    rows->push_back(entry.row);
+  }
+  rows->insert(rows->end(), nulls.begin(), nulls.end());
+}
@@ -0,0 +1,118 @@
+#ifndef RUNNER_COLUMNAR_TABLE_H_
+#define RUNNER_COLUMNAR_TABLE_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "worker_pool.h"
+
+// A read-only table held column by column, for filtering and sorting large
+// lists (leads, employees) without walking objects in Dart.
+//
+// String columns store each row as an id into the column's dictionary of
+// distinct values, so equality filters compare integers and sorting
+// compares precomputed ranks; number columns store doubles, with NaN for a
+// missing value. Filters build a bitmap of the matching rows, 64 rows to a
+// word, with SSE2 where the machine has it.
+class ColumnarTable {
+ public:
+  struct Filter {
+    enum class Op {
+      // A string column equals |text| exactly, e.g. an enum name.
+      kEquals,
+      // A number column is at least, or at most, |number|. Missing values
+      // never match.
+      kAtLeast,
+      kAtMost,
+      // Any of the string columns contains |text|, ignoring case.
+      kContains,
+    };
+
+    Op op = Op::kEquals;
+    // One column, or any number for kContains.
+    std::vector<size_t> columns;
+    std::string text;
+    double number = 0;
+  };
+
+  struct Sort {
+    size_t column = 0;
+    bool ascending = true;
+  };
+
+  ColumnarTable() = default;
+
+  // Prevent copying.
+  ColumnarTable(ColumnarTable const&) = delete;
+  ColumnarTable& operator=(ColumnarTable const&) = delete;
+
+  // Adds a column of UTF-8 strings; rows without a value are null. Every
+  // column must have as many rows as the first. Returns false otherwise.
+  bool AddStringColumn(std::string name,
+                       const std::vector<std::optional<std::string>>& values);
+
+  // Adds a column of numbers, NaN where a row has none. Returns false if it
+  // doesn't have as many rows as the first column.
+  bool AddNumberColumn(std::string name, std::vector<double> values);
+
+  // The index of the column called |name|, if there is one.
+  std::optional<size_t> FindColumn(const std::string& name) const;
+
+  bool IsStringColumn(size_t column) const {
+    return columns_[column].is_string;
+  }
+
+  size_t row_count() const { return row_count_; }
+
+  // Returns the rows that pass every filter, in |sort| order or in row order
+  // without one; rows that tie, and null values, which always sort last,
+  // keep row order. Returns nothing if |token| is cancelled first. Filters
+  // must name columns of the kind their op needs.
+  std::optional<std::vector<uint32_t>> Select(
+      const std::vector<Filter>& filters,
+      const std::optional<Sort>& sort,
+      const WorkerPool::CancellationToken& token) const;
+
+  // Counts each value of the string |column| among |rows|, in sort order of
+  // the values. Null values are left out.
+  std::vector<std::pair<std::string, uint32_t>> Count(
+      size_t column,
+      const std::vector<uint32_t>& rows) const;
+
+ private:
+  // A bit per row, set if the row is still selected.
+  using Bitmap = std::vector<uint64_t>;
+
+  struct Column {
+    std::string name;
+    bool is_string = false;
+
+    // String columns: per row, 0 for null or one more than the index of the
+    // row's value in |values|.
+    std::vector<uint32_t> ids;
+    // The distinct values as given, lowercased for matching, and the
+    // position of each id in the user's collation order (rank[0] unused).
+    std::vector<std::string> values;
+    std::vector<std::wstring> folded;
+    std::vector<uint32_t> ranks;
+
+    // Number columns.
+    std::vector<double> numbers;
+  };
+
+  bool AcceptRows(size_t rows);
+
+  // Clears the bits in |bitmap| of rows that fail |filter|.
+  void ApplyFilter(const Filter& filter, Bitmap* bitmap) const;
+
+  // Sorts |rows| by |sort| in place.
+  void SortRows(const Sort& sort, std::vector<uint32_t>* rows) const;
+
+  std::vector<Column> columns_;
+  size_t row_count_ = 0;
+};
+
+#endif  // RUNNER_COLUMNAR_TABLE_H_
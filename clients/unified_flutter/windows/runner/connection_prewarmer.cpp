@@ -0,0 +1,328 @@
+// WinSock 2 has to come before anything that includes windows.h, which would
+// otherwise pull in the conflicting WinSock 1 declarations.
+#include <winsock2.h>
+#include <ws2tcpip.h>
+
+#include "connection_prewarmer.h"
+
+#include <flutter/standard_method_codec.h>
+
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <utility>
+
+#include "runner_trace.h"
+#include "utils.h"
+
+namespace {
+
+constexpr char kMethodChannelName[] = "com.tamshai.ai/prewarm";
+
+// Registry key the recorded endpoints are stored under, one REG_MULTI_SZ
+// value per list.
+constexpr wchar_t kPrewarmRegKey[] =
+    L"Software\\Tamshai Corp\\Tamshai AI\\Prewarm";
+constexpr wchar_t kConnectValue[] = L"Connect";
+constexpr wchar_t kResolveValue[] = L"Resolve";
+
+// A warm-up that takes longer than this is no longer ahead of the first
+// query, so it is given up on.
+constexpr int kResolveTimeoutMs = 3000;
+constexpr int kConnectTimeoutMs = 5000;
+constexpr int kReceiveTimeoutMs = 5000;
+
+using flutter::EncodableList;
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+std::vector<std::wstring> ReadUrls(const wchar_t* value) {
+  DWORD size = 0;
+  if (RegGetValue(HKEY_CURRENT_USER, kPrewarmRegKey, value,
+                  RRF_RT_REG_MULTI_SZ, nullptr, nullptr,
+                  &size) != ERROR_SUCCESS) {
+    return {};
+  }
+  std::wstring data(size / sizeof(wchar_t), L'\0');
+  if (RegGetValue(HKEY_CURRENT_USER, kPrewarmRegKey, value,
+                  RRF_RT_REG_MULTI_SZ, nullptr, data.data(),
+                  &size) != ERROR_SUCCESS) {
+    return {};
+  }
+  data.resize(size / sizeof(wchar_t));
+
+  std::vector<std::wstring> urls;
+  size_t start = 0;
+  while (start < data.size() && data[start] != L'\0') {
+    size_t end = data.find(L'\0', start);
+    if (end == std::wstring::npos) {
+      end = data.size();
+    }
+    urls.emplace_back(data, start, end - start);
+    start = end + 1;
+  }
+  return urls;
+}
+
+void WriteUrls(const wchar_t* value, const std::vector<std::wstring>& urls) {
+  std::wstring data;
+  for (const auto& url : urls) {
+    data.append(url);
+    data.push_back(L'\0');
+  }
+  data.push_back(L'\0');
+  RegSetKeyValue(HKEY_CURRENT_USER, kPrewarmRegKey, value, REG_MULTI_SZ,
+                 data.data(),
+                 static_cast<DWORD>(data.size() * sizeof(wchar_t)));
+}
+
+// Converts a list of URL strings. Returns nothing if it isn't one.
+std::optional<std::vector<std::wstring>> ParseUrls(const EncodableMap& map,
+                                                   const char* key) {
+  auto it = map.find(EncodableValue(key));
+  if (it == map.end() || it->second.IsNull()) {
+    return std::vector<std::wstring>();
+  }
+  const auto* list = std::get_if<EncodableList>(&it->second);
+  if (!list) {
+    return std::nullopt;
+  }
+  std::vector<std::wstring> urls;
+  for (const auto& item : *list) {
+    const auto* url = std::get_if<std::string>(&item);
+    if (!url) {
+      return std::nullopt;
+    }
+    urls.push_back(Utf16FromUtf8(*url));
+  }
+  return urls;
+}
+
+// Splits |url| into its host, port and whether it is HTTPS. Returns false if
+// it isn't an HTTP or HTTPS URL.
+bool CrackOrigin(const std::wstring& url,
+                 std::wstring* host,
+                 INTERNET_PORT* port,
+                 bool* secure) {
+  URL_COMPONENTS parts{};
+  parts.dwStructSize = sizeof(parts);
+  parts.dwHostNameLength = static_cast<DWORD>(-1);
+  if (!WinHttpCrackUrl(url.c_str(), 0, 0, &parts) ||
+      (parts.nScheme != INTERNET_SCHEME_HTTP &&
+       parts.nScheme != INTERNET_SCHEME_HTTPS)) {
+    return false;
+  }
+  host->assign(parts.lpszHostName, parts.dwHostNameLength);
+  *port = parts.nPort;
+  *secure = parts.nScheme == INTERNET_SCHEME_HTTPS;
+  return true;
+}
+
+double MsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+// static
+ConnectionPrewarmer* ConnectionPrewarmer::GetInstance() {
+  static ConnectionPrewarmer* instance = new ConnectionPrewarmer();
+  return instance;
+}
+
+void ConnectionPrewarmer::Start() {
+  if (!session()) {
+    return;
+  }
+  recorded_connect_ = ReadUrls(kConnectValue);
+  recorded_resolve_ = ReadUrls(kResolveValue);
+  if (recorded_connect_.empty() && recorded_resolve_.empty()) {
+    return;
+  }
+  warmer_ = std::thread(&ConnectionPrewarmer::Warm, this, recorded_connect_,
+                        recorded_resolve_);
+}
+
+void ConnectionPrewarmer::Stop() {
+  stopping_ = true;
+  {
+    std::lock_guard<std::mutex> lock(request_mutex_);
+    if (request_) {
+      WinHttpCloseHandle(request_);
+      request_ = nullptr;
+    }
+  }
+  // A lookup in progress can't be cancelled, so this waits for it.
+  if (warmer_.joinable()) {
+    warmer_.join();
+  }
+  if (session_) {
+    WinHttpCloseHandle(session_);
+    session_ = nullptr;
+  }
+}
+
+HINTERNET ConnectionPrewarmer::session() {
+  if (!session_ && !stopping_) {
+    session_ = WinHttpOpen(L"TamshaiAI", WINHTTP_ACCESS_TYPE_AUTOMATIC_PROXY,
+                           WINHTTP_NO_PROXY_NAME, WINHTTP_NO_PROXY_BYPASS, 0);
+    if (session_) {
+      // Servers that offer HTTP/2 get one multiplexed connection for all of
+      // the streams. Older versions of Windows ignore this and use HTTP/1.1.
+      DWORD protocols = WINHTTP_PROTOCOL_FLAG_HTTP2;
+      WinHttpSetOption(session_, WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL,
+                       &protocols, sizeof(protocols));
+    }
+  }
+  return session_;
+}
+
+void ConnectionPrewarmer::Attach(flutter::BinaryMessenger* messenger) {
+  channel_ = std::make_unique<flutter::MethodChannel<EncodableValue>>(
+      messenger, kMethodChannelName,
+      &flutter::StandardMethodCodec::GetInstance());
+  channel_->SetMethodCallHandler([this](const auto& call, auto result) {
+    HandleMethodCall(call, std::move(result));
+  });
+}
+
+void ConnectionPrewarmer::Detach() {
+  if (channel_) {
+    channel_->SetMethodCallHandler(nullptr);
+    channel_ = nullptr;
+  }
+}
+
+void ConnectionPrewarmer::Warm(std::vector<std::wstring> connect,
+                               std::vector<std::wstring> resolve) {
+  // The hosts that are connected to are resolved on the way.
+  std::vector<std::wstring> hosts;
+  for (const auto& url : resolve) {
+    std::wstring host;
+    INTERNET_PORT port = 0;
+    bool secure = false;
+    if (CrackOrigin(url, &host, &port, &secure) &&
+        std::find(hosts.begin(), hosts.end(), host) == hosts.end()) {
+      hosts.push_back(std::move(host));
+    }
+  }
+  for (const auto& url : connect) {
+    std::wstring host;
+    INTERNET_PORT port = 0;
+    bool secure = false;
+    if (CrackOrigin(url, &host, &port, &secure)) {
+      hosts.erase(std::remove(hosts.begin(), hosts.end(), host), hosts.end());
+    }
+  }
+
+  // The gateway first, as the first query waits on it the longest.
+  for (const auto& url : connect) {
+    if (stopping_) {
+      return;
+    }
+    Connect(url);
+  }
+
+  WSADATA wsa_data;
+  if (hosts.empty() || WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+    return;
+  }
+  for (const auto& host : hosts) {
+    if (stopping_) {
+      break;
+    }
+    auto start = std::chrono::steady_clock::now();
+    ADDRINFOW hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    ADDRINFOW* addresses = nullptr;
+    bool resolved =
+        GetAddrInfoW(host.c_str(), nullptr, &hints, &addresses) == 0;
+    if (addresses) {
+      FreeAddrInfoW(addresses);
+    }
+    TraceLoggingWrite(g_runner_trace_provider, "PrewarmResolve",
+                      TraceLoggingWideString(host.c_str(), "Host"),
+                      TraceLoggingBool(resolved, "Resolved"),
+                      TraceLoggingFloat64(MsSince(start), "ElapsedMs"));
+  }
+  WSACleanup();
+}
+
+void ConnectionPrewarmer::Connect(const std::wstring& url) {
+  std::wstring host;
+  INTERNET_PORT port = 0;
+  bool secure = false;
+  if (!CrackOrigin(url, &host, &port, &secure)) {
+    return;
+  }
+  auto start = std::chrono::steady_clock::now();
+  HINTERNET connection = WinHttpConnect(session_, host.c_str(), port, 0);
+  if (!connection) {
+    return;
+  }
+  HINTERNET request = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(request_mutex_);
+    if (!stopping_) {
+      request_ = WinHttpOpenRequest(
+          connection, L"HEAD", L"/", nullptr, WINHTTP_NO_REFERER,
+          WINHTTP_DEFAULT_ACCEPT_TYPES, secure ? WINHTTP_FLAG_SECURE : 0);
+      request = request_;
+    }
+  }
+  bool connected = false;
+  if (request) {
+    WinHttpSetTimeouts(request, kResolveTimeoutMs, kConnectTimeoutMs,
+                       kConnectTimeoutMs, kReceiveTimeoutMs);
+    // A redirect would warm up some other origin.
+    DWORD features = WINHTTP_DISABLE_REDIRECTS;
+    WinHttpSetOption(request, WINHTTP_OPTION_DISABLE_FEATURE, &features,
+                     sizeof(features));
+    // Whatever the status, the response completes the exchange and leaves
+    // the connection in the session's pool.
+    connected = WinHttpSendRequest(request, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
+                                   WINHTTP_NO_REQUEST_DATA, 0, 0, 0) &&
+                WinHttpReceiveResponse(request, nullptr);
+    std::lock_guard<std::mutex> lock(request_mutex_);
+    if (request_) {
+      WinHttpCloseHandle(request_);
+      request_ = nullptr;
+    }
+  }
+  WinHttpCloseHandle(connection);
+  TraceLoggingWrite(g_runner_trace_provider, "PrewarmConnect",
+                    TraceLoggingWideString(host.c_str(), "Host"),
+                    TraceLoggingBool(connected, "Connected"),
+                    TraceLoggingFloat64(MsSince(start), "ElapsedMs"));
+}
+
+void ConnectionPrewarmer::HandleMethodCall(
+    const flutter::MethodCall<EncodableValue>& call,
+    std::unique_ptr<flutter::MethodResult<EncodableValue>> result) {
+  if (call.method_name() != "record") {
+    result->NotImplemented();
+    return;
+  }
+  const auto* arguments = std::get_if<EncodableMap>(call.arguments());
+  std::optional<std::vector<std::wstring>> connect =
+      arguments ? ParseUrls(*arguments, "connect") : std::nullopt;
+  std::optional<std::vector<std::wstring>> resolve =
+      arguments ? ParseUrls(*arguments, "resolve") : std::nullopt;
+  if (!connect || !resolve) {
+    result->Error("bad_arguments", "connect and resolve must list URLs");
+    return;
+  }
+  // The config is compiled in, so this only writes after an update.
+  if (*connect != recorded_connect_) {
+    WriteUrls(kConnectValue, *connect);
+    recorded_connect_ = std::move(*connect);
+  }
+  if (*resolve != recorded_resolve_) {
+    WriteUrls(kResolveValue, *resolve);
+    recorded_resolve_ = std::move(*resolve);
+  }
+  result->Success();
+}
@@ -0,0 +1,84 @@
+#ifndef RUNNER_CONNECTION_PREWARMER_H_
+#define RUNNER_CONNECTION_PREWARMER_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/method_channel.h>
+#include <windows.h>
+#include <winhttp.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Warms up the connections the first query needs while the engine boots.
+//
+// The endpoints come from Dart's environment config, which is compiled into
+// the snapshot and so can't be read before the engine runs: Dart reports
+// them on every launch, and Start uses those of the launch before. On a
+// background thread, it resolves every host, so that their addresses are in
+// the system's DNS cache when dio looks them up, and opens and completes a
+// HEAD request to each gateway origin on the HTTP/2-enabled WinHTTP session
+// that SseStreamPlugin then sends its requests on. WinHTTP keeps those
+// connections, TLS handshake done, for the first stream to reuse.
+//
+// Method channel "com.tamshai.ai/prewarm":
+//   record({connect, resolve}) - stores the URLs whose origins the next
+//     launch connects to, and those whose hosts it only resolves.
+class ConnectionPrewarmer {
+ public:
+  // Returns the process-wide instance.
+  static ConnectionPrewarmer* GetInstance();
+
+  // Prevent copying.
+  ConnectionPrewarmer(ConnectionPrewarmer const&) = delete;
+  ConnectionPrewarmer& operator=(ConnectionPrewarmer const&) = delete;
+
+  // Opens the session and, if a previous launch recorded endpoints, starts
+  // warming them up. Returns immediately.
+  void Start();
+
+  // Abandons any warm-up still in progress and closes the session.
+  void Stop();
+
+  // The session to send gateway requests on, owned by the prewarmer until
+  // Stop. Opened here if Start wasn't called. Called on the platform thread.
+  HINTERNET session();
+
+  // Handles record calls on |messenger| until Detach.
+  void Attach(flutter::BinaryMessenger* messenger);
+  void Detach();
+
+ private:
+  ConnectionPrewarmer() = default;
+
+  // Body of |warmer_|.
+  void Warm(std::vector<std::wstring> connect,
+            std::vector<std::wstring> resolve);
+
+  // Completes a HEAD request to the origin of |url| on |session_|.
+  void Connect(const std::wstring& url);
+
+  void HandleMethodCall(
+      const flutter::MethodCall<flutter::EncodableValue>& call,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  HINTERNET session_ = nullptr;
+  std::thread warmer_;
+  std::atomic<bool> stopping_{false};
+
+  // Guards |request_|, which Stop closes to abandon a warm-up.
+  std::mutex request_mutex_;
+  HINTERNET request_ = nullptr;
+
+  // What Start read, so that record only writes when the config changed.
+  std::vector<std::wstring> recorded_connect_;
+  std::vector<std::wstring> recorded_resolve_;
+
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>> channel_;
+};
+
+#endif  // RUNNER_CONNECTION_PREWARMER_H_
@@ -0,0 +1,433 @@
+#include "data_table_plugin.h"
+
+#include <flutter/standard_method_codec.h>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "runner_trace.h"
+
+namespace {
+
+constexpr char kMethodChannelName[] = "com.tamshai.ai/data_table";
+
+// Rows in a page when the query doesn't say.
+constexpr int64_t kDefaultPageSize = 100;
+
+using flutter::EncodableList;
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+using Op = ColumnarTable::Filter::Op;
+
+const EncodableValue* Lookup(const EncodableMap& map, const char* key) {
+  auto it = map.find(EncodableValue(key));
+  return it == map.end() ? nullptr : &it->second;
+}
+
+const std::string* LookupString(const EncodableMap& map, const char* key) {
+  const EncodableValue* value = Lookup(map, key);
+  return value ? std::get_if<std::string>(value) : nullptr;
+}
+
+std::optional<int64_t> LookupInt(const EncodableMap& map, const char* key) {
+  const EncodableValue* value = Lookup(map, key);
+  if (!value) {
+    return std::nullopt;
+  }
+  if (const auto* small = std::get_if<int32_t>(value)) {
+    return *small;
+  }
+  if (const auto* large = std::get_if<int64_t>(value)) {
+    return *large;
+  }
+  return std::nullopt;
+}
+
+std::optional<double> ToNumber(const EncodableValue& value) {
+  if (const auto* small = std::get_if<int32_t>(&value)) {
+    return *small;
+  }
+  if (const auto* large = std::get_if<int64_t>(&value)) {
+    return static_cast<double>(*large);
+  }
+  if (const auto* real = std::get_if<double>(&value)) {
+    return *real;
+  }
+  return std::nullopt;
+}
+
+// A column as Dart sent it, copied off the channel's message.
+struct ColumnSpec {
+  std::string name;
+  std::optional<std::vector<std::optional<std::string>>> strings;
+  std::vector<double> numbers;
+};
+
+// A filter naming its columns, resolved against the table on the sequence.
+struct FilterSpec {
+  Op op = Op::kEquals;
+  std::vector<std::string> columns;
+  std::string text;
+  double number = 0;
+};
+
+struct SortSpec {
+  std::string column;
+  bool ascending = true;
+};
+
+std::optional<std::vector<ColumnSpec>> ParseColumns(const EncodableMap& map) {
+  const EncodableValue* value = Lookup(map, "columns");
+  const auto* list = value ? std::get_if<EncodableList>(value) : nullptr;
+  if (!list || list->empty()) {
+    return std::nullopt;
+  }
+  std::vector<ColumnSpec> columns;
+  for (const EncodableValue& entry : *list) {
+    const auto* column = std::get_if<EncodableMap>(&entry);
+    const std::string* name = column ? LookupString(*column, "name") : nullptr;
+    if (!name) {
+      return std::nullopt;
+    }
+    ColumnSpec spec;
+    spec.name = *name;
+    const EncodableValue* strings = Lookup(*column, "strings");
+    const EncodableValue* numbers = Lookup(*column, "numbers");
+    if (const auto* values =
+            strings ? std::get_if<EncodableList>(strings) : nullptr) {
+      spec.strings.emplace();
+      spec.strings->reserve(values->size());
+      for (const EncodableValue& cell : *values) {
+        const auto* text = std::get_if<std::string>(&cell);
+        spec.strings->push_back(text ? std::optional<std::string>(*text)
+                                     : std::nullopt);
+      }
+    } else if (const auto* series =
+                   numbers ? std::get_if<std::vector<double>>(numbers)
+                           : nullptr) {
+      spec.numbers = *series;
+    } else {
+      return std::nullopt;
+    }
+    columns.push_back(std::move(spec));
+  }
+  return columns;
+}
+
+std::optional<std::vector<FilterSpec>> ParseFilters(const EncodableMap& map) {
+  std::vector<FilterSpec> filters;
+  const EncodableValue* value = Lookup(map, "filters");
+  if (!value || value->IsNull()) {
+    return filters;
+  }
+  const auto* list = std::get_if<EncodableList>(value);
+  if (!list) {
+    return std::nullopt;
+  }
+  for (const EncodableValue& entry : *list) {
+    const auto* filter = std::get_if<EncodableMap>(&entry);
+    const std::string* op = filter ? LookupString(*filter, "op") : nullptr;
+    const EncodableValue* columns =
+        filter ? Lookup(*filter, "columns") : nullptr;
+    const auto* names =
+        columns ? std::get_if<EncodableList>(columns) : nullptr;
+    const EncodableValue* operand = filter ? Lookup(*filter, "value") : nullptr;
+    if (!op || !names || names->empty() || !operand) {
+      return std::nullopt;
+    }
+    FilterSpec spec;
+    for (const EncodableValue& name : *names) {
+      const auto* column = std::get_if<std::string>(&name);
+      if (!column) {
+        return std::nullopt;
+      }
+      spec.columns.push_back(*column);
+    }
+    if (*op == "equals" || *op == "contains") {
+      const auto* text = std::get_if<std::string>(operand);
+      if (!text) {
+        return std::nullopt;
+      }
+      spec.op = *op == "equals" ? Op::kEquals : Op::kContains;
+      spec.text = *text;
+    } else if (*op == "atLeast" || *op == "atMost") {
+      std::optional<double> number = ToNumber(*operand);
+      if (!number) {
+        return std::nullopt;
+      }
+      spec.op = *op == "atLeast" ? Op::kAtLeast : Op::kAtMost;
+      spec.number = *number;
+    } else {
+      return std::nullopt;
+    }
+    if (spec.op != Op::kContains && spec.columns.size() != 1) {
+      return std::nullopt;
+    }
+    filters.push_back(std::move(spec));
+  }
+  return filters;
+}
+
+// Returns false if "sort" is there but malformed.
+bool ParseSort(const EncodableMap& map, std::optional<SortSpec>* sort) {
+  const EncodableValue* value = Lookup(map, "sort");
+  if (!value || value->IsNull()) {
+    return true;
+  }
+  const auto* spec = std::get_if<EncodableMap>(value);
+  const std::string* column = spec ? LookupString(*spec, "column") : nullptr;
+  if (!column) {
+    return false;
+  }
+  const EncodableValue* ascending = Lookup(*spec, "ascending");
+  const bool* flag = ascending ? std::get_if<bool>(ascending) : nullptr;
+  *sort = SortSpec{*column, flag ? *flag : true};
+  return true;
+}
+
+// Identifies a selection, so that the rows of the last one can be reused.
+std::string ViewKey(const std::vector<FilterSpec>& filters,
+                    const std::optional<SortSpec>& sort) {
+  std::string key;
+  for (const FilterSpec& filter : filters) {
+    key += std::to_string(static_cast<int>(filter.op));
+    for (const std::string& column : filter.columns) {
+      key += '\x1F' + column;
+    }
+    uint64_t number;
+    std::memcpy(&number, &filter.number, sizeof(number));
+    key += '\x1E' + filter.text + '\x1E' + std::to_string(number);
+    key += '\x1D';
+  }
+  if (sort) {
+    key += '\x1C' + sort->column + (sort->ascending ? "+" : "-");
+  }
+  return key;
+}
+
+// Resolves |specs| to the columns of |table|, or returns nothing if a column
+// is missing or of the wrong kind.
+std::optional<std::vector<ColumnarTable::Filter>> ResolveFilters(
+    const ColumnarTable& table,
+    const std::vector<FilterSpec>& specs) {
+  std::vector<ColumnarTable::Filter> filters;
+  for (const FilterSpec& spec : specs) {
+    ColumnarTable::Filter filter;
+    filter.op = spec.op;
+    filter.text = spec.text;
+    filter.number = spec.number;
+    bool wants_string = spec.op == Op::kEquals || spec.op == Op::kContains;
+    for (const std::string& name : spec.columns) {
+      std::optional<size_t> column = table.FindColumn(name);
+      if (!column || table.IsStringColumn(*column) != wants_string) {
+        return std::nullopt;
+      }
+      filter.columns.push_back(*column);
+    }
+    filters.push_back(std::move(filter));
+  }
+  return filters;
+}
+
+}  // namespace
+
+DataTablePlugin::DataTablePlugin(flutter::BinaryMessenger* messenger,
+                                 PlatformTaskQueue* task_queue)
+    : pending_results_(task_queue,
+                       "The table or a column it names is not loaded") {
+  method_channel_ =
+      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+          messenger, kMethodChannelName,
+          &flutter::StandardMethodCodec::GetInstance());
+  method_channel_->SetMethodCallHandler(
+      [this](const auto& call, auto result) {
+        HandleMethodCall(call, std::move(result));
+      });
+}
+
+DataTablePlugin::~DataTablePlugin() {
+  method_channel_->SetMethodCallHandler(nullptr);
+}
+
+void DataTablePlugin::HandleMethodCall(
+    const flutter::MethodCall<flutter::EncodableValue>& call,
+    Result result) {
+  const auto* arguments = std::get_if<EncodableMap>(call.arguments());
+  if (!arguments) {
+    result->Error("bad_arguments", "Arguments must be a map");
+    return;
+  }
+
+  if (call.method_name() == "load") {
+    std::optional<std::vector<ColumnSpec>> columns = ParseColumns(*arguments);
+    if (!columns) {
+      result->Error("bad_arguments",
+                    "columns must be a list of {name, strings|numbers}");
+      return;
+    }
+    int64_t handle = next_handle_++;
+    queries_[handle] = WorkerPool::CancellationToken();
+    Enqueue(
+        [this, handle, specs = std::move(*columns)]() mutable
+        -> std::optional<EncodableValue> {
+          TraceSpan span("DataTableLoad");
+          auto table = std::make_unique<Table>();
+          for (ColumnSpec& spec : specs) {
+            bool added =
+                spec.strings
+                    ? table->columns.AddStringColumn(std::move(spec.name),
+                                                     *spec.strings)
+                    : table->columns.AddNumberColumn(std::move(spec.name),
+                                                     std::move(spec.numbers));
+            if (!added) {
+              return std::nullopt;
+            }
+          }
+          tables_[handle] = std::move(table);
+          return EncodableValue(handle);
+        },
+        std::move(result));
+    return;
+  }
+
+  std::optional<int64_t> handle = LookupInt(*arguments, "handle");
+  if (!handle) {
+    result->Error("bad_arguments", "handle is required");
+    return;
+  }
+
+  if (call.method_name() == "release") {
+    queries_.erase(*handle);
+    Enqueue(
+        [this, table_handle = *handle]() -> std::optional<EncodableValue> {
+          tables_.erase(table_handle);
+          return EncodableValue();
+        },
+        std::move(result));
+    return;
+  }
+
+  std::optional<std::vector<FilterSpec>> filters = ParseFilters(*arguments);
+  if (!filters) {
+    result->Error("bad_arguments",
+                  "filters must be a list of {op, columns, value}");
+    return;
+  }
+
+  if (call.method_name() == "query") {
+    std::optional<SortSpec> sort;
+    if (!ParseSort(*arguments, &sort)) {
+      result->Error("bad_arguments", "sort must be {column, ascending}");
+      return;
+    }
+    int64_t offset = std::max<int64_t>(
+        LookupInt(*arguments, "offset").value_or(0), 0);
+    int64_t limit = std::max<int64_t>(
+        LookupInt(*arguments, "limit").value_or(kDefaultPageSize), 0);
+    // The query still running for this table is no longer wanted.
+    auto previous = queries_.find(*handle);
+    if (previous != queries_.end()) {
+      previous->second.Cancel();
+    }
+    WorkerPool::CancellationToken token;
+    queries_[*handle] = token;
+    Enqueue(
+        [this, table_handle = *handle, specs = std::move(*filters), sort,
+         offset, limit, token]() -> std::optional<EncodableValue> {
+          if (token.IsCanceled()) {
+            return EncodableValue();
+          }
+          auto it = tables_.find(table_handle);
+          if (it == tables_.end()) {
+            return std::nullopt;
+          }
+          Table& table = *it->second;
+          std::string key = ViewKey(specs, sort);
+          if (!table.has_view || table.view_key != key) {
+            std::optional<std::vector<ColumnarTable::Filter>> resolved =
+                ResolveFilters(table.columns, specs);
+            std::optional<ColumnarTable::Sort> order;
+            if (sort) {
+              std::optional<size_t> column =
+                  table.columns.FindColumn(sort->column);
+              if (!column) {
+                return std::nullopt;
+              }
+              order = ColumnarTable::Sort{*column, sort->ascending};
+            }
+            if (!resolved) {
+              return std::nullopt;
+            }
+            TraceSpan span("DataTableQuery");
+            std::optional<std::vector<uint32_t>> rows =
+                table.columns.Select(*resolved, order, token);
+            if (!rows) {
+              return EncodableValue();
+            }
+            table.view = std::move(*rows);
+            table.view_key = std::move(key);
+            table.has_view = true;
+          }
+          size_t total = table.view.size();
+          size_t begin = std::min(static_cast<size_t>(offset), total);
+          size_t end = std::min(begin + static_cast<size_t>(limit), total);
+          std::vector<int32_t> page(table.view.begin() + begin,
+                                    table.view.begin() + end);
+          return EncodableValue(EncodableMap{
+              {EncodableValue("total"),
+               EncodableValue(static_cast<int64_t>(total))},
+              {EncodableValue("rows"), EncodableValue(std::move(page))},
+          });
+        },
+        std::move(result));
+  } else if (call.method_name() == "group") {
+    const std::string* column = LookupString(*arguments, "column");
+    if (!column) {
+      result->Error("bad_arguments", "column is required");
+      return;
+    }
+    Enqueue(
+        [this, table_handle = *handle, specs = std::move(*filters),
+         name = *column]() -> std::optional<EncodableValue> {
+          auto it = tables_.find(table_handle);
+          if (it == tables_.end()) {
+            return std::nullopt;
+          }
+          const ColumnarTable& table = it->second->columns;
+          std::optional<size_t> grouped = table.FindColumn(name);
+          std::optional<std::vector<ColumnarTable::Filter>> resolved =
+              ResolveFilters(table, specs);
+          if (!grouped || !table.IsStringColumn(*grouped) || !resolved) {
+            return std::nullopt;
+          }
+          // Counting isn't superseded by queries, so it gets a token of its
+          // own that is never cancelled.
+          std::optional<std::vector<uint32_t>> rows = table.Select(
+              *resolved, std::nullopt, WorkerPool::CancellationToken());
+          EncodableList values;
+          std::vector<int32_t> counts;
+          for (auto& [value, count] : table.Count(*grouped, *rows)) {
+            values.push_back(EncodableValue(std::move(value)));
+            counts.push_back(static_cast<int32_t>(count));
+          }
+          return EncodableValue(EncodableMap{
+              {EncodableValue("values"), EncodableValue(std::move(values))},
+              {EncodableValue("counts"), EncodableValue(std::move(counts))},
+          });
+        },
+        std::move(result));
+  } else {
+    result->NotImplemented();
+  }
+}
+
+void DataTablePlugin::Enqueue(Job job, Result result) {
+  int64_t id = pending_results_.Add(std::move(result));
+  table_sequence_.Post([this, id, work = std::move(job)]() {
+    pending_results_.Complete(id, work());
+  });
+}
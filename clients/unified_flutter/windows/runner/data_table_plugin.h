@@ -0,0 +1,96 @@
+#ifndef RUNNER_DATA_TABLE_PLUGIN_H_
+#define RUNNER_DATA_TABLE_PLUGIN_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/method_channel.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "columnar_table.h"
+#include "pending_results.h"
+#include "platform_task_queue.h"
+#include "worker_pool.h"
+
+// Filters, sorts and pages large lists for Dart in ColumnarTables.
+//
+// Dart loads a list once as columns, then asks for one page of the rows
+// that match at a time, so neither the filtering nor the widgets scale with
+// the whole list. Work runs in order on the worker pool; a query cancels the
+// one still running for the same table, and the last result is kept per
+// table, so turning pages doesn't filter again.
+//
+// Method channel "com.tamshai.ai/data_table":
+//   load({columns}) - a handle for a table of |columns|, each {name, strings}
+//                     (a list of strings or nulls) or {name, numbers} (a
+//                     Float64List, NaN for none) of the same length.
+//   query({handle, filters, sort, offset, limit}) - {total, rows}: how many
+//                     rows pass every filter, and the indices (an Int32List)
+//                     of |limit| of them from |offset|, sorted by |sort|
+//                     ({column, ascending}) if given. Each filter is {op,
+//                     columns, value}, with op one of "equals", "atLeast",
+//                     "atMost" or "contains". Null if a later query replaced
+//                     it.
+//   group({handle, column, filters}) - {values, counts}: each value of the
+//                     string |column| among the rows that pass |filters|,
+//                     with how many have it.
+//   release({handle}) - frees the table.
+class DataTablePlugin {
+ public:
+  DataTablePlugin(flutter::BinaryMessenger* messenger,
+                  PlatformTaskQueue* task_queue);
+  ~DataTablePlugin();
+
+  // Prevent copying.
+  DataTablePlugin(DataTablePlugin const&) = delete;
+  DataTablePlugin& operator=(DataTablePlugin const&) = delete;
+
+ private:
+  using Result =
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>;
+
+  // Table work run on |table_sequence_|. Returns the value to complete the
+  // call with, or nothing if the table or a column it names isn't loaded.
+  using Job = std::function<std::optional<flutter::EncodableValue>()>;
+
+  struct Table {
+    ColumnarTable columns;
+    // The last query's filters and sort, and the rows they selected.
+    std::string view_key;
+    std::vector<uint32_t> view;
+    bool has_view = false;
+  };
+
+  void HandleMethodCall(
+      const flutter::MethodCall<flutter::EncodableValue>& call,
+      Result result);
+
+  // Runs |job| in order after the jobs before it, then completes |result|
+  // with its outcome on the platform thread.
+  void Enqueue(Job job, Result result);
+
+  // Calls waiting for their job.
+  PendingResults pending_results_;
+
+  // The latest query of each table, by handle. Platform thread only.
+  std::map<int64_t, WorkerPool::CancellationToken> queries_;
+  int64_t next_handle_ = 1;
+
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>>
+      method_channel_;
+
+  // By handle. |table_sequence_| only.
+  std::map<int64_t, std::unique_ptr<Table>> tables_;
+
+  // Declared last, so that it goes first: it finishes the job in progress
+  // and drops queued ones.
+  WorkerPool::Sequence table_sequence_{WorkerPool::Priority::kInteractive};
+};
+
+#endif  // RUNNER_DATA_TABLE_PLUGIN_H_
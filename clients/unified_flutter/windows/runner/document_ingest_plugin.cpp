@@ -0,0 +1,457 @@
+#include "document_ingest_plugin.h"
+
+#include <bcrypt.h>
+#include <flutter/event_stream_handler_functions.h>
+#include <flutter/standard_method_codec.h>
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+
+#include "runner_trace.h"
+#include "text_transcoder.h"
+#include "utils.h"
+
+namespace {
+
+constexpr char kMethodChannelName[] = "com.tamshai.ai/document_ingest";
+constexpr char kEventChannelName[] = "com.tamshai.ai/document_ingest/events";
+
+// How much of a file is hashed and checked between progress events.
+constexpr size_t kChunkBytes = 1024 * 1024;
+
+// The gateway takes request bodies of up to 10 MB, which the documents share
+// with the query and the JSON around it.
+constexpr size_t kMaxEscapedBytes = 8 * 1024 * 1024;
+
+// No larger file fits under that limit, even as UTF-16.
+constexpr uint64_t kMaxFileBytes = 2 * kMaxEscapedBytes;
+
+// The longest UTF-8 sequence, which the end of a chunk may cut short.
+constexpr size_t kMaxSequenceBytes = 4;
+
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+// Returns the value stored under |key| in |map|, or nullptr.
+const EncodableValue* Lookup(const EncodableMap& map, const char* key) {
+  auto it = map.find(EncodableValue(key));
+  return it == map.end() ? nullptr : &it->second;
+}
+
+// Returns the integer stored under |key| in |map|, or std::nullopt if it is
+// missing or not an integer.
+std::optional<int64_t> LookupInt(const EncodableMap& map, const char* key) {
+  const EncodableValue* value = Lookup(map, key);
+  if (!value) {
+    return std::nullopt;
+  }
+  if (const auto* value32 = std::get_if<int32_t>(value)) {
+    return *value32;
+  }
+  if (const auto* value64 = std::get_if<int64_t>(value)) {
+    return *value64;
+  }
+  return std::nullopt;
+}
+
+EncodableMap MakeEvent(const char* type, int64_t handle) {
+  return EncodableMap{{EncodableValue("type"), EncodableValue(type)},
+                      {EncodableValue("handle"), EncodableValue(handle)}};
+}
+
+std::string FileName(const std::wstring& path) {
+  size_t separator = path.find_last_of(L"\\/");
+  return Utf8FromUtf16(path.c_str() +
+                       (separator == std::wstring::npos ? 0 : separator + 1));
+}
+
+// Whether |path| is on a local fixed disk. Reading a mapped file that has
+// gone away, as a network share or USB stick can, raises an exception
+// wherever the memory is touched, so other files are copied instead.
+bool IsOnFixedDrive(const std::wstring& path) {
+  wchar_t volume[MAX_PATH];
+  return GetVolumePathName(path.c_str(), volume, MAX_PATH) &&
+         GetDriveType(volume) == DRIVE_FIXED;
+}
+
+// Reads all |size| bytes of |file| into |contents|.
+bool ReadWholeFile(HANDLE file, size_t size, std::string* contents) {
+  contents->resize(size);
+  size_t offset = 0;
+  while (offset < size) {
+    DWORD bytes_read = 0;
+    DWORD wanted = static_cast<DWORD>(std::min(size - offset, kChunkBytes));
+    if (!ReadFile(file, &(*contents)[offset], wanted, &bytes_read, nullptr) ||
+        bytes_read == 0) {
+      return false;
+    }
+    offset += bytes_read;
+  }
+  return true;
+}
+
+void ReleaseMapping(DocumentIngestPlugin::Document* document) {
+  if (document->view) {
+    UnmapViewOfFile(document->view);
+    document->view = nullptr;
+  }
+  if (document->mapping) {
+    CloseHandle(document->mapping);
+    document->mapping = nullptr;
+  }
+  if (document->file != INVALID_HANDLE_VALUE) {
+    CloseHandle(document->file);
+    document->file = INVALID_HANDLE_VALUE;
+  }
+}
+
+// SHA-256, fed a piece at a time.
+class Sha256 {
+ public:
+  Sha256() {
+    BCryptCreateHash(BCRYPT_SHA256_ALG_HANDLE, &hash_, nullptr, 0, nullptr,
+                     0, 0);
+  }
+
+  ~Sha256() {
+    if (hash_) {
+      BCryptDestroyHash(hash_);
+    }
+  }
+
+  // Prevent copying.
+  Sha256(Sha256 const&) = delete;
+  Sha256& operator=(Sha256 const&) = delete;
+
+  void Update(const void* data, size_t size) {
+    if (hash_) {
+      BCryptHashData(hash_,
+                     static_cast<PUCHAR>(const_cast<void*>(data)),
+                     static_cast<ULONG>(size), 0);
+    }
+  }
+
+  // Returns the digest in hex, or an empty string on failure.
+  std::string Finish() {
+    unsigned char digest[32];
+    if (!hash_ || BCryptFinishHash(hash_, digest, sizeof(digest), 0) < 0) {
+      return std::string();
+    }
+    static constexpr char kHexDigits[] = "0123456789abcdef";
+    std::string hex;
+    for (unsigned char byte : digest) {
+      hex.push_back(kHexDigits[byte >> 4]);
+      hex.push_back(kHexDigits[byte & 0xF]);
+    }
+    return hex;
+  }
+
+ private:
+  BCRYPT_HASH_HANDLE hash_ = nullptr;
+};
+
+}  // namespace
+
+DocumentIngestPlugin::Document::~Document() {
+  ReleaseMapping(this);
+}
+
+DocumentIngestPlugin::DocumentIngestPlugin(
+    flutter::BinaryMessenger* messenger,
+    PlatformTaskQueue* task_queue)
+    : task_queue_(task_queue) {
+  method_channel_ =
+      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+          messenger, kMethodChannelName,
+          &flutter::StandardMethodCodec::GetInstance());
+  method_channel_->SetMethodCallHandler(
+      [this](const auto& call, auto result) {
+        HandleMethodCall(call, std::move(result));
+      });
+
+  event_channel_ =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          messenger, kEventChannelName,
+          &flutter::StandardMethodCodec::GetInstance());
+  event_channel_->SetStreamHandler(
+      std::make_unique<
+          flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [this](const flutter::EncodableValue* arguments,
+                 std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&&
+                     events)
+              -> std::unique_ptr<
+                  flutter::StreamHandlerError<flutter::EncodableValue>> {
+            event_sink_ = std::move(events);
+            return nullptr;
+          },
+          [this](const flutter::EncodableValue* arguments)
+              -> std::unique_ptr<
+                  flutter::StreamHandlerError<flutter::EncodableValue>> {
+            event_sink_ = nullptr;
+            return nullptr;
+          }));
+}
+
+DocumentIngestPlugin::~DocumentIngestPlugin() {
+  method_channel_->SetMethodCallHandler(nullptr);
+  event_channel_->SetStreamHandler(nullptr);
+  for (auto& entry : documents_) {
+    entry.second->closed = true;
+  }
+  alive_.reset();
+}
+
+std::shared_ptr<const DocumentIngestPlugin::Document>
+DocumentIngestPlugin::Find(int64_t handle) const {
+  auto it = documents_.find(handle);
+  if (it == documents_.end() || !it->second->ready) {
+    return nullptr;
+  }
+  return it->second;
+}
+
+void DocumentIngestPlugin::IngestDroppedFiles(
+    const std::vector<std::wstring>& paths) {
+  // Nobody would ever close them.
+  if (!event_sink_) {
+    return;
+  }
+  for (const std::wstring& path : paths) {
+    int64_t handle = StartIngest(path);
+    EncodableMap event = MakeEvent("added", handle);
+    event[EncodableValue("name")] = EncodableValue(documents_[handle]->name);
+    SendEvent(std::move(event));
+  }
+}
+
+void DocumentIngestPlugin::HandleMethodCall(
+    const flutter::MethodCall<flutter::EncodableValue>& call,
+    Result result) {
+  const auto* arguments = std::get_if<EncodableMap>(call.arguments());
+  if (call.method_name() == "open") {
+    const EncodableValue* path_value =
+        arguments ? Lookup(*arguments, "path") : nullptr;
+    const auto* path =
+        path_value ? std::get_if<std::string>(path_value) : nullptr;
+    if (!path || path->empty()) {
+      result->Error("bad_arguments", "path is required");
+      return;
+    }
+    int64_t handle = StartIngest(Utf16FromUtf8(*path));
+    result->Success(EncodableValue(EncodableMap{
+        {EncodableValue("handle"), EncodableValue(handle)},
+        {EncodableValue("name"), EncodableValue(documents_[handle]->name)},
+    }));
+  } else if (call.method_name() == "close") {
+    std::optional<int64_t> handle =
+        arguments ? LookupInt(*arguments, "handle") : std::nullopt;
+    if (!handle) {
+      result->Error("bad_arguments", "handle must be an integer");
+      return;
+    }
+    auto it = documents_.find(*handle);
+    if (it != documents_.end()) {
+      it->second->closed = true;
+      documents_.erase(it);
+    }
+    result->Success();
+  } else {
+    result->NotImplemented();
+  }
+}
+
+int64_t DocumentIngestPlugin::StartIngest(const std::wstring& path) {
+  int64_t handle = next_handle_++;
+  auto document = std::make_shared<Document>();
+  document->path = path;
+  document->name = FileName(path);
+  documents_[handle] = document;
+
+  std::weak_ptr<bool> alive = alive_;
+  ingest_tasks_.Post([this, alive, handle, document]() {
+    std::string message;
+    const char* error = Ingest(document.get(), handle, &message);
+    if (error) {
+      ReleaseMapping(document.get());
+      document->converted.clear();
+      document->converted.shrink_to_fit();
+    }
+    task_queue_->PostTask([this, alive, handle, document, error, message]() {
+      if (!alive.lock()) {
+        return;
+      }
+      auto it = documents_.find(handle);
+      if (it == documents_.end() || document->closed) {
+        return;
+      }
+      if (error) {
+        EncodableMap event = MakeEvent("failed", handle);
+        event[EncodableValue("error")] = EncodableValue(error);
+        event[EncodableValue("message")] = EncodableValue(message);
+        SendEvent(std::move(event));
+        return;
+      }
+      document->ready = true;
+      EncodableMap event = MakeEvent("ready", handle);
+      event[EncodableValue("sha256")] = EncodableValue(document->sha256);
+      SendEvent(std::move(event));
+    });
+  });
+  return handle;
+}
+
+const char* DocumentIngestPlugin::Ingest(Document* document,
+                                         int64_t handle,
+                                         std::string* message) {
+  TraceSpan span("IngestDocument");
+  const std::wstring& path = document->path;
+  bool copy = !IsOnFixedDrive(path);
+  // Writers are shut out while the document is open, so the text that was
+  // checked and measured is the text that gets sent. A file that another
+  // app holds open for writing, as spreadsheet apps do, is copied instead.
+  document->file =
+      CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                 OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (document->file == INVALID_HANDLE_VALUE &&
+      GetLastError() == ERROR_SHARING_VIOLATION) {
+    copy = true;
+    document->file = CreateFile(
+        path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  }
+  LARGE_INTEGER file_size;
+  if (document->file == INVALID_HANDLE_VALUE ||
+      !GetFileSizeEx(document->file, &file_size)) {
+    *message = "The file could not be opened";
+    return "unavailable";
+  }
+  document->size = static_cast<uint64_t>(file_size.QuadPart);
+  if (document->size > kMaxFileBytes) {
+    *message = "The file is larger than a query can carry";
+    return "too_large";
+  }
+  PostProgress(handle, 0, document->size);
+
+  const size_t size = static_cast<size_t>(document->size);
+  Sha256 hash;
+  std::string snapshot;
+  const unsigned char* bytes = nullptr;
+  if (size == 0) {
+    bytes = reinterpret_cast<const unsigned char*>(snapshot.data());
+  } else if (copy) {
+    if (!ReadWholeFile(document->file, size, &snapshot)) {
+      *message = "The file could not be read";
+      return "unavailable";
+    }
+    ReleaseMapping(document);
+    bytes = reinterpret_cast<const unsigned char*>(snapshot.data());
+  } else {
+    document->mapping = CreateFileMapping(document->file, nullptr,
+                                          PAGE_READONLY, 0, 0, nullptr);
+    document->view = document->mapping
+                         ? MapViewOfFile(document->mapping, FILE_MAP_READ,
+                                         0, 0, 0)
+                         : nullptr;
+    if (!document->view) {
+      *message = "The file could not be mapped";
+      return "unavailable";
+    }
+    bytes = static_cast<const unsigned char*>(document->view);
+  }
+
+  const bool utf16 = size >= 2 && bytes[0] == 0xFF && bytes[1] == 0xFE;
+  size_t start = 0;
+  if (utf16) {
+    start = 2;
+  } else if (size >= 3 && bytes[0] == 0xEF && bytes[1] == 0xBB &&
+             bytes[2] == 0xBF) {
+    start = 3;
+  }
+  if (utf16 && size % 2 != 0) {
+    *message = "The file is not valid UTF-16 text";
+    return "unsupported_format";
+  }
+
+  // Where the text not yet checked or converted starts.
+  size_t pending = start;
+  for (size_t offset = 0; offset < size;) {
+    if (document->closed) {
+      return nullptr;
+    }
+    const size_t end = std::min(offset + kChunkBytes, size);
+    const bool last = end == size;
+    hash.Update(bytes + offset, end - offset);
+    if (utf16) {
+      // A high surrogate the chunk cut off from its pair waits for the next.
+      const auto* units = reinterpret_cast<const wchar_t*>(bytes + pending);
+      size_t count = (end - pending) / 2;
+      if (!last && count > 0 && units[count - 1] >= 0xD800 &&
+          units[count - 1] <= 0xDBFF) {
+        --count;
+      }
+      size_t converted = document->converted.size();
+      if (!AppendUtf8FromUtf16(units, count, &document->converted)) {
+        *message = "The file is not valid UTF-16 text";
+        return "unsupported_format";
+      }
+      document->escaped_size +=
+          JsonEscapedSize(document->converted.data() + converted,
+                          document->converted.size() - converted);
+      pending += count * 2;
+    } else {
+      const auto* text = reinterpret_cast<const char*>(bytes);
+      const size_t text_offset = std::max(offset, start);
+      pending += ValidUtf8Prefix(text + pending, end - pending);
+      if (pending < end && (last || end - pending >= kMaxSequenceBytes)) {
+        *message = "The file is not UTF-8 or UTF-16 text";
+        return "unsupported_format";
+      }
+      document->escaped_size +=
+          JsonEscapedSize(text + text_offset, end - text_offset);
+    }
+    if (document->escaped_size > kMaxEscapedBytes) {
+      *message = "The file is larger than a query can carry";
+      return "too_large";
+    }
+    offset = end;
+    PostProgress(handle, offset, document->size);
+  }
+  document->sha256 = hash.Finish();
+
+  if (utf16) {
+    ReleaseMapping(document);
+    document->text = document->converted.data();
+    document->text_size = document->converted.size();
+  } else if (copy || size == 0) {
+    document->converted = std::move(snapshot);
+    document->text = document->converted.data() + start;
+    document->text_size = document->converted.size() - start;
+  } else {
+    document->text = static_cast<const char*>(document->view) + start;
+    document->text_size = size - start;
+  }
+  return nullptr;
+}
+
+void DocumentIngestPlugin::PostProgress(int64_t handle,
+                                        uint64_t processed,
+                                        uint64_t size) {
+  std::weak_ptr<bool> alive = alive_;
+  task_queue_->PostTask([this, alive, handle, processed, size]() {
+    if (!alive.lock() || !documents_.count(handle)) {
+      return;
+    }
+    EncodableMap event = MakeEvent("progress", handle);
+    event[EncodableValue("processed")] =
+        EncodableValue(static_cast<int64_t>(processed));
+    event[EncodableValue("size")] = EncodableValue(static_cast<int64_t>(size));
+    SendEvent(std::move(event));
+  });
+}
+
+void DocumentIngestPlugin::SendEvent(EncodableMap event) {
+  if (event_sink_) {
+    event_sink_->Success(EncodableValue(std::move(event)));
+  }
+}
@@ -0,0 +1,142 @@
+#ifndef RUNNER_DOCUMENT_INGEST_PLUGIN_H_
+#define RUNNER_DOCUMENT_INGEST_PLUGIN_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/event_channel.h>
+#include <flutter/method_channel.h>
+#include <windows.h>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "platform_task_queue.h"
+#include "worker_pool.h"
+
+// Reads documents attached to a chat message, such as large CSV exports, so
+// that their text never passes through Dart strings.
+//
+// A file, opened from Dart or dropped onto the main window, is memory-mapped
+// (or copied, off local disks) and walked on the worker pool in 1 MB chunks:
+// hashed with SHA-256, checked to be UTF-8, or converted to it from UTF-16,
+// and measured as a JSON string. Dart only gets a handle and progress
+// events. SseStreamPlugin then writes the text into the query it sends to
+// the MCP Gateway, escaping it a piece at a time straight from the mapping.
+//
+// Method channel "com.tamshai.ai/document_ingest":
+//   open({path})    - starts reading a file; replies with {handle, name}.
+//   close({handle}) - releases it. Queries already sent with it keep it
+//                     until they are done.
+// Event channel "com.tamshai.ai/document_ingest/events" delivers maps with a
+// "type" and the "handle" they are about:
+//   added    - a file was dropped onto the window, with its name.
+//   progress - with the bytes processed so far, and the file's size.
+//   ready    - with the file's "sha256" in hex.
+//   failed   - with an "error" of "unavailable", "too_large" or
+//              "unsupported_format", and a "message".
+class DocumentIngestPlugin {
+ public:
+  // A document's text, valid for as long as the document is referenced.
+  struct Document {
+    Document() = default;
+    ~Document();
+
+    // Prevent copying.
+    Document(Document const&) = delete;
+    Document& operator=(Document const&) = delete;
+
+    std::wstring path;
+
+    // File name, as UTF-8.
+    std::string name;
+
+    // Bytes on disk.
+    uint64_t size = 0;
+
+    // UTF-8 text without a byte order mark: the mapped file itself, or
+    // |converted| when the file could not be used as it is.
+    const char* text = nullptr;
+    size_t text_size = 0;
+
+    // Size of |text| escaped as a JSON string.
+    size_t escaped_size = 0;
+
+    // SHA-256 of the file, in hex.
+    std::string sha256;
+
+    // Set on the platform thread once ingestion has succeeded; nothing above
+    // changes after that.
+    bool ready = false;
+
+    // Set when Dart closes the document, to stop ingestion early.
+    std::atomic<bool> closed{false};
+
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+    const void* view = nullptr;
+    std::string converted;
+  };
+
+  DocumentIngestPlugin(flutter::BinaryMessenger* messenger,
+                       PlatformTaskQueue* task_queue);
+  ~DocumentIngestPlugin();
+
+  // Prevent copying.
+  DocumentIngestPlugin(DocumentIngestPlugin const&) = delete;
+  DocumentIngestPlugin& operator=(DocumentIngestPlugin const&) = delete;
+
+  // Returns document |handle| if it is ready, or nullptr.
+  std::shared_ptr<const Document> Find(int64_t handle) const;
+
+  // Starts reading files dropped onto a window, announcing each to Dart.
+  void IngestDroppedFiles(const std::vector<std::wstring>& paths);
+
+ private:
+  using Result =
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>;
+
+  void HandleMethodCall(
+      const flutter::MethodCall<flutter::EncodableValue>& call,
+      Result result);
+
+  // Registers a document for |path| and queues it for reading. Returns
+  // its handle; failures to read it are reported as events.
+  int64_t StartIngest(const std::wstring& path);
+
+  // Reads |document| on the worker pool. Returns nullptr on success, or
+  // the error code to report along with |message|.
+  const char* Ingest(Document* document, int64_t handle, std::string* message);
+
+  // Sends a progress event for |handle| from the worker pool.
+  void PostProgress(int64_t handle, uint64_t processed, uint64_t size);
+
+  // Sends |event| to Dart. Platform thread only.
+  void SendEvent(flutter::EncodableMap event);
+
+  PlatformTaskQueue* task_queue_;
+
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>>
+      method_channel_;
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>>
+      event_channel_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> event_sink_;
+
+  // Open documents by handle. Platform thread only.
+  std::map<int64_t, std::shared_ptr<Document>> documents_;
+  int64_t next_handle_ = 1;
+
+  // Expires when the plugin is destroyed, so callbacks still queued on the
+  // platform thread can tell they arrived too late.
+  std::shared_ptr<bool> alive_ = std::make_shared<bool>(true);
+
+  // Declared last, so that it goes first: the destructor closes every
+  // document, so the ones being read stop at their next chunk, and the rest
+  // are dropped.
+  WorkerPool::TaskGroup ingest_tasks_{WorkerPool::Priority::kBackground};
+};
+
+#endif  // RUNNER_DOCUMENT_INGEST_PLUGIN_H_
@@ -0,0 +1,119 @@
+#include "file_drop_target.h"
+
+#include <shellapi.h>
+
+#include <utility>
+
+namespace {
+
+FORMATETC FileListFormat() {
+  return {CF_HDROP, nullptr, DVASPECT_CONTENT, -1, TYMED_HGLOBAL};
+}
+
+// The effect to report for a drag that may or may not carry files, given
+// the effects its source allows.
+DWORD CopyEffect(bool has_files, DWORD allowed) {
+  return has_files && (allowed & DROPEFFECT_COPY) ? DROPEFFECT_COPY
+                                                  : DROPEFFECT_NONE;
+}
+
+}  // namespace
+
+// static
+FileDropTarget* FileDropTarget::Register(HWND window, Callback callback) {
+  auto* target = new FileDropTarget(window, std::move(callback));
+  if (FAILED(RegisterDragDrop(window, target))) {
+    target->Release();
+    return nullptr;
+  }
+  return target;
+}
+
+FileDropTarget::FileDropTarget(HWND window, Callback callback)
+    : window_(window), callback_(std::move(callback)) {}
+
+void FileDropTarget::Revoke() {
+  RevokeDragDrop(window_);
+  callback_ = nullptr;
+  Release();
+}
+
+HRESULT FileDropTarget::QueryInterface(REFIID iid, void** object) {
+  if (iid == IID_IUnknown || iid == IID_IDropTarget) {
+    *object = static_cast<IDropTarget*>(this);
+    AddRef();
+    return S_OK;
+  }
+  *object = nullptr;
+  return E_NOINTERFACE;
+}
+
+ULONG FileDropTarget::AddRef() {
+  return ++references_;
+}
+
+ULONG FileDropTarget::Release() {
+  ULONG references = --references_;
+  if (references == 0) {
+    delete this;
+  }
+  return references;
+}
+
+HRESULT FileDropTarget::DragEnter(IDataObject* data,
+                                  DWORD key_state,
+                                  POINTL point,
+                                  DWORD* effect) {
+  FORMATETC format = FileListFormat();
+  has_files_ = data->QueryGetData(&format) == S_OK;
+  *effect = CopyEffect(has_files_, *effect);
+  return S_OK;
+}
+
+HRESULT FileDropTarget::DragOver(DWORD key_state,
+                                 POINTL point,
+                                 DWORD* effect) {
+  *effect = CopyEffect(has_files_, *effect);
+  return S_OK;
+}
+
+HRESULT FileDropTarget::DragLeave() {
+  has_files_ = false;
+  return S_OK;
+}
+
+HRESULT FileDropTarget::Drop(IDataObject* data,
+                             DWORD key_state,
+                             POINTL point,
+                             DWORD* effect) {
+  *effect = CopyEffect(has_files_, *effect);
+  has_files_ = false;
+  if (*effect == DROPEFFECT_NONE) {
+    return S_OK;
+  }
+
+  std::vector<std::wstring> paths;
+  FORMATETC format = FileListFormat();
+  STGMEDIUM medium{};
+  if (FAILED(data->GetData(&format, &medium))) {
+    *effect = DROPEFFECT_NONE;
+    return S_OK;
+  }
+  if (auto drop = static_cast<HDROP>(GlobalLock(medium.hGlobal))) {
+    UINT count = DragQueryFile(drop, 0xFFFFFFFF, nullptr, 0);
+    for (UINT i = 0; i < count; ++i) {
+      UINT length = DragQueryFile(drop, i, nullptr, 0);
+      std::wstring path(length, L'\0');
+      if (length > 0 && DragQueryFile(drop, i, path.data(), length + 1)) {
+        paths.push_back(std::move(path));
+      }
+    }
+    GlobalUnlock(medium.hGlobal);
+  }
+  ReleaseStgMedium(&medium);
+
+  if (callback_ && !paths.empty()) {
+    callback_(paths);
+  }
+  return S_OK;
+}
@@ -0,0 +1,63 @@
+#ifndef RUNNER_FILE_DROP_TARGET_H_
+#define RUNNER_FILE_DROP_TARGET_H_
+
+#include <windows.h>
+#include <oleidl.h>
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Accepts files dragged onto a window from Explorer or another app.
+//
+// Only file lists (CF_HDROP) are accepted, and always as a copy; the files
+// are left where they are. OLE must have been initialized on the platform
+// thread with OleInitialize.
+class FileDropTarget : public IDropTarget {
+ public:
+  using Callback = std::function<void(const std::vector<std::wstring>& paths)>;
+
+  // Registers a target that calls |callback| with the paths of the files
+  // dropped onto |window| or its children. Returns nullptr if OLE refuses.
+  static FileDropTarget* Register(HWND window, Callback callback);
+
+  // Prevent copying.
+  FileDropTarget(FileDropTarget const&) = delete;
+  FileDropTarget& operator=(FileDropTarget const&) = delete;
+
+  // Unregisters the target and releases it.
+  void Revoke();
+
+  // IUnknown:
+  HRESULT STDMETHODCALLTYPE QueryInterface(REFIID iid, void** object) override;
+  ULONG STDMETHODCALLTYPE AddRef() override;
+  ULONG STDMETHODCALLTYPE Release() override;
+
+  // IDropTarget:
+  HRESULT STDMETHODCALLTYPE DragEnter(IDataObject* data,
+                                      DWORD key_state,
+                                      POINTL point,
+                                      DWORD* effect) override;
+  HRESULT STDMETHODCALLTYPE DragOver(DWORD key_state,
+                                     POINTL point,
+                                     DWORD* effect) override;
+  HRESULT STDMETHODCALLTYPE DragLeave() override;
+  HRESULT STDMETHODCALLTYPE Drop(IDataObject* data,
+                                 DWORD key_state,
+                                 POINTL point,
+                                 DWORD* effect) override;
+
+ private:
+  FileDropTarget(HWND window, Callback callback);
+  ~FileDropTarget() = default;
+
+  HWND window_;
+  Callback callback_;
+  std::atomic<ULONG> references_{1};
+
+  // Whether the drag over the window carries files.
+  bool has_files_ = false;
+};
+
+#endif  // RUNNER_FILE_DROP_TARGET_H_
@@ -1,11 +1,11 @@
 #include "flutter_window.h"
 
 #include <optional>
+#include <utility>
 
-#include "flutter/generated_plugin_registrant.h"
+#include "runner_trace.h"
 
-FlutterWindow::FlutterWindow(const flutter::DartProject& project)
-    : project_(project) {}
+FlutterWindow::FlutterWindow(RunnerEngine* engine) : engine_(engine) {}
 
 FlutterWindow::~FlutterWindow() {}
 
@@ -18,17 +18,30 @@ bool FlutterWindow::OnCreate() {
 
   // The size here must match the window dimensions to avoid unnecessary surface
   // creation / destruction in the startup path.
-  flutter_controller_ = std::make_unique<flutter::FlutterViewController>(
-      frame.right - frame.left, frame.bottom - frame.top, project_);
+  TraceSpan controller_span("FlutterViewController");
+  flutter_controller_ = std::make_unique<RunnerViewController>(
+      frame.right - frame.left, frame.bottom - frame.top, engine_);
+  controller_span.End();
   // Ensure that basic setup of the controller was successful.
-  if (!flutter_controller_->engine() || !flutter_controller_->view()) {
+  if (!flutter_controller_->engine()) {
     return false;
   }
-  RegisterPlugins(flutter_controller_->engine());
-  SetChildContent(flutter_controller_->view()->GetNativeWindow());
+  view_id_ = flutter_controller_->view_id();
+  SetChildContent(flutter_controller_->GetNativeWindow());
+  visibility_tracker_ =
+      std::make_unique<WindowVisibilityTracker>(GetHandle(), engine_);
 
-  flutter_controller_->engine()->SetNextFrameCallback([&]() {
+  // Spans from here until the first frame has been shown.
+  first_frame_span_ = std::make_unique<TraceSpan>("FirstFrame");
+  alive_ = std::make_shared<bool>(true);
+  std::weak_ptr<bool> alive = alive_;
+  engine_->AddNextFrameCallback([this, alive]() {
+    if (!alive.lock()) {
+      return;
+    }
     this->Show();
+    first_frame_span_ = nullptr;
+    OnFirstFrame();
   });
 
   // Flutter can complete the first frame before the "show window" callback is
@@ -40,6 +53,9 @@ bool FlutterWindow::OnCreate() {
 }
 
 void FlutterWindow::OnDestroy() {
+  alive_ = nullptr;
+  first_frame_span_ = nullptr;
+  visibility_tracker_ = nullptr;
   if (flutter_controller_) {
     flutter_controller_ = nullptr;
   }
@@ -47,10 +63,19 @@ void FlutterWindow::OnDestroy() {
   Win32Window::OnDestroy();
 }
 
+void FlutterWindow::OnFirstFrame() {
+  // No-op; provided for subclasses.
+}
+
 LRESULT
 FlutterWindow::MessageHandler(HWND hwnd, UINT const message,
                               WPARAM const wparam,
                               LPARAM const lparam) noexcept {
+  if (visibility_tracker_ &&
+      visibility_tracker_->HandleMessage(message, wparam, lparam)) {
+    return 0;
+  }
+
   // Give Flutter, including plugins, an opportunity to handle window messages.
   if (flutter_controller_) {
     std::optional<LRESULT> result =
@@ -61,11 +86,5 @@ FlutterWindow::MessageHandler(HWND hwnd, UINT const message,
     }
   }
 
-  switch (message) {
-    case WM_FONTCHANGE:
-      flutter_controller_->engine()->ReloadSystemFonts();
-      break;
-  }
-
   return Win32Window::MessageHandler(hwnd, message, wparam, lparam);
 }
@@ -1,20 +1,25 @@
 #ifndef RUNNER_FLUTTER_WINDOW_H_
 #define RUNNER_FLUTTER_WINDOW_H_
 
-#include <flutter/dart_project.h>
-#include <flutter/flutter_view_controller.h>
-
 #include <memory>
 
+#include "runner_engine.h"
+#include "runner_trace.h"
 #include "win32_window.h"
+#include "window_visibility_tracker.h"
 
 // A window that does nothing but host a Flutter view.
 class FlutterWindow : public Win32Window {
  public:
-  // Creates a new FlutterWindow hosting a Flutter view running |project|.
-  explicit FlutterWindow(const flutter::DartProject& project);
+  // Creates a new FlutterWindow hosting a view of |engine|, which may already
+  // be running and must outlive the window. Several windows can share one
+  // engine.
+  explicit FlutterWindow(RunnerEngine* engine);
   virtual ~FlutterWindow();
 
+  // The id of the hosted view, once the window has been created.
+  FlutterDesktopViewId view_id() { return view_id_; }
+
  protected:
   // Win32Window:
   bool OnCreate() override;
@@ -22,12 +27,29 @@ class FlutterWindow : public Win32Window {
   LRESULT MessageHandler(HWND window, UINT const message, WPARAM const wparam,
                          LPARAM const lparam) noexcept override;
 
+  // Called once the window has been shown with its first frame.
+  virtual void OnFirstFrame();
+
+  // The engine the view belongs to.
+  RunnerEngine* engine() { return engine_; }
+
  private:
-  // The project to run.
-  flutter::DartProject project_;
+  RunnerEngine* engine_;
+
+  // The Flutter view hosted by this window.
+  std::unique_ptr<RunnerViewController> flutter_controller_;
+
+  FlutterDesktopViewId view_id_ = -1;
+
+  // Stops frames and lowers QoS while the window cannot be seen.
+  std::unique_ptr<WindowVisibilityTracker> visibility_tracker_;
+
+  // Traces startup until the first frame is shown.
+  std::unique_ptr<TraceSpan> first_frame_span_;
 
-  // The Flutter instance hosted by this window.
-  std::unique_ptr<flutter::FlutterViewController> flutter_controller_;
+  // Expires when the view goes, so a first frame callback that is still
+  // pending can tell it arrived too late.
+  std::shared_ptr<bool> alive_;
 };
 
 #endif  // RUNNER_FLUTTER_WINDOW_H_
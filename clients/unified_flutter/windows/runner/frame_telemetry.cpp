@@ -0,0 +1,243 @@
+#include "frame_telemetry.h"
+
+#include <dwmapi.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "runner_trace.h"
+
+namespace {
+
+constexpr ULONGLONG kSummaryIntervalMs = 10 * 1000;
+
+// Budget assumed until DWM reports the refresh rate.
+constexpr double kDefaultRefreshMs = 1000.0 / 60;
+
+constexpr int64_t kMicrosecondsPerSecond = 1000 * 1000;
+
+// Converts |microseconds| to performance counter ticks without overflowing
+// for uptimes of many days.
+int64_t MicrosecondsToTicks(int64_t microseconds, int64_t frequency) {
+  return microseconds / kMicrosecondsPerSecond * frequency +
+         microseconds % kMicrosecondsPerSecond * frequency /
+             kMicrosecondsPerSecond;
+}
+
+FrameTelemetry::Distribution Distribute(std::vector<double>& values_ms) {
+  FrameTelemetry::Distribution distribution;
+  if (values_ms.empty()) {
+    return distribution;
+  }
+  std::sort(values_ms.begin(), values_ms.end());
+  auto percentile = [&values_ms](double fraction) {
+    size_t index = static_cast<size_t>(
+        fraction * static_cast<double>(values_ms.size() - 1) + 0.5);
+    return values_ms[std::min(index, values_ms.size() - 1)];
+  };
+  distribution.p50_ms = percentile(0.5);
+  distribution.p90_ms = percentile(0.9);
+  distribution.p99_ms = percentile(0.99);
+  distribution.max_ms = values_ms.back();
+  for (double value : values_ms) {
+    size_t bucket = 0;
+    while (bucket < FrameTelemetry::kBucketLimitsMs.size() &&
+           value > FrameTelemetry::kBucketLimitsMs[bucket]) {
+      ++bucket;
+    }
+    ++distribution.histogram[bucket];
+  }
+  return distribution;
+}
+
+int32_t ClampToInt32(int64_t value) {
+  return static_cast<int32_t>(
+      std::clamp<int64_t>(value, 0, std::numeric_limits<int32_t>::max()));
+}
+
+}  // namespace
+
+FrameTelemetry::FrameTelemetry() : phase_names_{std::string()} {
+  LARGE_INTEGER frequency;
+  QueryPerformanceFrequency(&frequency);
+  counter_frequency_ = frequency.QuadPart;
+  last_summary_tick_ = GetTickCount64();
+}
+
+FrameTelemetry::~FrameTelemetry() {}
+
+void FrameTelemetry::AddFrames(const std::vector<Frame>& frames) {
+  // One sample covers the batch: Dart reports frames shortly after they are
+  // rasterized, and the refresh period rarely changes in between.
+  UpdateCompositionTiming();
+  const std::string& phase_name = phase_names_[phase_];
+  for (const Frame& frame : frames) {
+    int32_t build_us = ClampToInt32(frame.build_us);
+    int32_t raster_us = ClampToInt32(frame.raster_us);
+    int32_t present_us = PresentLatency(frame.raster_finish_us);
+
+    uint64_t index = written_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[index % kCapacity];
+    uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.build_us.store(build_us, std::memory_order_relaxed);
+    slot.raster_us.store(raster_us, std::memory_order_relaxed);
+    slot.present_us.store(present_us, std::memory_order_relaxed);
+    slot.phase.store(phase_, std::memory_order_relaxed);
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    written_.store(index + 1, std::memory_order_release);
+
+    TraceLoggingWrite(g_runner_trace_provider, "Frame",
+                      TraceLoggingInt32(build_us, "BuildUs"),
+                      TraceLoggingInt32(raster_us, "RasterUs"),
+                      TraceLoggingInt32(present_us, "PresentUs"),
+                      TraceLoggingString(phase_name.c_str(), "Phase"));
+  }
+  MaybeTraceSummary();
+}
+
+void FrameTelemetry::SetPhase(const std::string& phase) {
+  auto found = std::find(phase_names_.begin(), phase_names_.end(), phase);
+  if (found != phase_names_.end()) {
+    phase_ = static_cast<uint32_t>(found - phase_names_.begin());
+    return;
+  }
+  std::lock_guard<std::mutex> lock(phase_names_mutex_);
+  phase_names_.push_back(phase);
+  phase_ = static_cast<uint32_t>(phase_names_.size() - 1);
+}
+
+FrameTelemetry::Summary FrameTelemetry::Summarize() const {
+  Summary summary;
+  summary.dwm_frames_missed = frames_missed_.load(std::memory_order_relaxed);
+  int64_t refresh_us = refresh_us_.load(std::memory_order_relaxed);
+  summary.refresh_ms =
+      refresh_us > 0 ? static_cast<double>(refresh_us) / 1000
+                     : kDefaultRefreshMs;
+  std::vector<std::string> phase_names;
+  {
+    std::lock_guard<std::mutex> lock(phase_names_mutex_);
+    phase_names = phase_names_;
+  }
+
+  std::vector<double> build_ms, raster_ms, present_ms, total_ms;
+  std::map<uint32_t, std::vector<double>> phase_total_ms;
+  uint64_t written = written_.load(std::memory_order_acquire);
+  uint64_t count = std::min<uint64_t>(written, kCapacity);
+  for (uint64_t index = written - count; index < written; ++index) {
+    const Slot& slot = slots_[index % kCapacity];
+    uint32_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before & 1) {
+      continue;
+    }
+    int32_t build_us = slot.build_us.load(std::memory_order_relaxed);
+    int32_t raster_us = slot.raster_us.load(std::memory_order_relaxed);
+    int32_t present_us = slot.present_us.load(std::memory_order_relaxed);
+    uint32_t phase = slot.phase.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != before) {
+      // Overwritten while it was read.
+      continue;
+    }
+
+    double total = static_cast<double>(build_us + raster_us) / 1000;
+    bool janky = total > summary.refresh_ms;
+    ++summary.frames;
+    summary.janky_frames += janky ? 1 : 0;
+    build_ms.push_back(static_cast<double>(build_us) / 1000);
+    raster_ms.push_back(static_cast<double>(raster_us) / 1000);
+    total_ms.push_back(total);
+    if (present_us >= 0) {
+      present_ms.push_back(static_cast<double>(present_us) / 1000);
+    }
+    if (phase != 0 && phase < phase_names.size()) {
+      PhaseSummary& phase_summary = summary.phases[phase_names[phase]];
+      ++phase_summary.frames;
+      phase_summary.janky_frames += janky ? 1 : 0;
+      phase_total_ms[phase].push_back(total);
+    }
+  }
+
+  summary.build = Distribute(build_ms);
+  summary.raster = Distribute(raster_ms);
+  summary.present = Distribute(present_ms);
+  summary.total = Distribute(total_ms);
+  for (auto& phase_values : phase_total_ms) {
+    summary.phases[phase_names[phase_values.first]].total =
+        Distribute(phase_values.second);
+  }
+  return summary;
+}
+
+void FrameTelemetry::UpdateCompositionTiming() {
+  DWM_TIMING_INFO timing{};
+  timing.cbSize = sizeof(timing);
+  // Only the desktop's timing is available, hence no window.
+  if (FAILED(DwmGetCompositionTimingInfo(nullptr, &timing))) {
+    return;
+  }
+  last_vblank_ = static_cast<int64_t>(timing.qpcVBlank);
+  refresh_period_ = static_cast<int64_t>(timing.qpcRefreshPeriod);
+  if (!has_first_frames_missed_) {
+    has_first_frames_missed_ = true;
+    first_frames_missed_ = timing.cFramesMissed;
+  }
+  frames_missed_.store(
+      static_cast<uint32_t>(timing.cFramesMissed - first_frames_missed_),
+      std::memory_order_relaxed);
+  if (counter_frequency_ > 0) {
+    refresh_us_.store(
+        refresh_period_ * kMicrosecondsPerSecond / counter_frequency_,
+        std::memory_order_relaxed);
+  }
+}
+
+int32_t FrameTelemetry::PresentLatency(int64_t raster_finish_us) const {
+  if (last_vblank_ <= 0 || refresh_period_ <= 0 || counter_frequency_ <= 0) {
+    return -1;
+  }
+  // The engine's clock is std::chrono::steady_clock, which counts
+  // performance counter ticks on Windows, so the two line up.
+  int64_t finished =
+      MicrosecondsToTicks(raster_finish_us, counter_frequency_);
+  int64_t vblank;
+  if (finished <= last_vblank_) {
+    vblank = last_vblank_ -
+             (last_vblank_ - finished) / refresh_period_ * refresh_period_;
+  } else {
+    vblank = last_vblank_ + ((finished - last_vblank_ + refresh_period_ - 1) /
+                             refresh_period_) *
+                                refresh_period_;
+  }
+  int64_t latency_us =
+      (vblank - finished) * kMicrosecondsPerSecond / counter_frequency_;
+  // Further than a second off means the clocks did not line up after all.
+  if (latency_us < 0 || latency_us > kMicrosecondsPerSecond) {
+    return -1;
+  }
+  return static_cast<int32_t>(latency_us);
+}
+
+void FrameTelemetry::MaybeTraceSummary() {
+  ULONGLONG now = GetTickCount64();
+  if (now - last_summary_tick_ < kSummaryIntervalMs ||
+      !TraceLoggingProviderEnabled(g_runner_trace_provider, 0, 0)) {
+    return;
+  }
+  last_summary_tick_ = now;
+  Summary summary = Summarize();
+  TraceLoggingWrite(
+      g_runner_trace_provider, "FrameSummary",
+      TraceLoggingUInt32(summary.frames, "Frames"),
+      TraceLoggingUInt32(summary.janky_frames, "JankyFrames"),
+      TraceLoggingUInt32(summary.dwm_frames_missed, "DwmFramesMissed"),
+      TraceLoggingFloat64(summary.refresh_ms, "RefreshMs"),
+      TraceLoggingFloat64(summary.total.p50_ms, "TotalP50Ms"),
+      TraceLoggingFloat64(summary.total.p90_ms, "TotalP90Ms"),
+      TraceLoggingFloat64(summary.total.p99_ms, "TotalP99Ms"),
+      TraceLoggingFloat64(summary.present.p90_ms, "PresentP90Ms"),
+      TraceLoggingUInt32FixedArray(summary.total.histogram.data(),
+                                   static_cast<UINT16>(kBucketCount),
+                                   "TotalHistogram"));
+}
@@ -0,0 +1,133 @@
+#ifndef RUNNER_FRAME_TELEMETRY_H_
+#define RUNNER_FRAME_TELEMETRY_H_
+
+#include <windows.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Frame pacing telemetry for the app's frames.
+//
+// Dart reports the engine's FrameTiming for each frame: build and raster
+// time, and when rasterization finished. These are joined with DWM's
+// composition clock to get each frame's present latency, the wait from the
+// end of rasterization to the vblank DWM composes it on. The last
+// kCapacity frames are kept in a lock-free ring, so that any thread can
+// summarize them while the platform thread records more. Each frame is
+// also written to ETW as a "Frame" event, with a "FrameSummary" event at
+// most every ten seconds.
+//
+// Frames are tagged with the phase Dart set last, such as a streaming reply
+// or the generative component on screen, so jank can be traced to it.
+class FrameTelemetry {
+ public:
+  // One FrameTiming from Dart, in microseconds of the engine's clock.
+  struct Frame {
+    int64_t build_us;
+    int64_t raster_us;
+    int64_t raster_finish_us;
+  };
+
+  // Upper bounds of the histogram buckets, in milliseconds; the last bucket
+  // holds everything above.
+  static constexpr std::array<double, 8> kBucketLimitsMs = {
+      4, 8, 12, 16.7, 25, 33.4, 50, 100};
+  static constexpr size_t kBucketCount = kBucketLimitsMs.size() + 1;
+
+  struct Distribution {
+    double p50_ms = 0;
+    double p90_ms = 0;
+    double p99_ms = 0;
+    double max_ms = 0;
+    std::array<uint32_t, kBucketCount> histogram{};
+  };
+
+  struct PhaseSummary {
+    uint32_t frames = 0;
+    uint32_t janky_frames = 0;
+    Distribution total;
+  };
+
+  struct Summary {
+    uint32_t frames = 0;
+    // Frames whose build and raster took longer than a refresh.
+    uint32_t janky_frames = 0;
+    // Compositions DWM missed since the telemetry started, across the
+    // desktop.
+    uint32_t dwm_frames_missed = 0;
+    double refresh_ms = 0;
+    Distribution build;
+    Distribution raster;
+    Distribution present;
+    // Build plus raster.
+    Distribution total;
+    std::map<std::string, PhaseSummary> phases;
+  };
+
+  static constexpr size_t kCapacity = 1024;
+
+  FrameTelemetry();
+  ~FrameTelemetry();
+
+  // Prevent copying.
+  FrameTelemetry(FrameTelemetry const&) = delete;
+  FrameTelemetry& operator=(FrameTelemetry const&) = delete;
+
+  // Records |frames|, oldest first. Platform thread only.
+  void AddFrames(const std::vector<Frame>& frames);
+
+  // Tags the frames recorded from now on with |phase|, or with none if it is
+  // empty. Platform thread only.
+  void SetPhase(const std::string& phase);
+
+  // Summarizes the frames in the ring. Safe to call from any thread.
+  Summary Summarize() const;
+
+ private:
+  // A ring entry, written under a sequence lock: |sequence| is odd while
+  // the writer is changing the fields, so readers skip or retry it.
+  struct Slot {
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<int32_t> build_us{0};
+    std::atomic<int32_t> raster_us{0};
+    // Negative if DWM's clock was not available.
+    std::atomic<int32_t> present_us{0};
+    std::atomic<uint32_t> phase{0};
+  };
+
+  // Samples the DWM composition clock into the members below.
+  void UpdateCompositionTiming();
+
+  // Microseconds from |raster_finish_us| to the vblank after it, or -1.
+  int32_t PresentLatency(int64_t raster_finish_us) const;
+
+  // Writes a FrameSummary event if it is time for one.
+  void MaybeTraceSummary();
+
+  std::array<Slot, kCapacity> slots_;
+  // Frames written so far; the next goes in slot |written_| % kCapacity.
+  std::atomic<uint64_t> written_{0};
+
+  // Index of the current phase in |phase_names_|; 0 is no phase.
+  uint32_t phase_ = 0;
+  mutable std::mutex phase_names_mutex_;
+  std::vector<std::string> phase_names_;
+
+  // Last DWM sample, in performance counter ticks. Platform thread only.
+  int64_t counter_frequency_ = 0;
+  int64_t last_vblank_ = 0;
+  int64_t refresh_period_ = 0;
+  uint64_t first_frames_missed_ = 0;
+  bool has_first_frames_missed_ = false;
+  std::atomic<uint32_t> frames_missed_{0};
+  std::atomic<int64_t> refresh_us_{0};
+
+  ULONGLONG last_summary_tick_ = 0;
+};
+
+#endif  // RUNNER_FRAME_TELEMETRY_H_
@@ -0,0 +1,129 @@
+#include "frame_telemetry_plugin.h"
+
+#include <flutter/standard_method_codec.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr char kMethodChannelName[] = "com.tamshai.ai/frame_telemetry";
+
+using flutter::EncodableList;
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+EncodableValue DistributionToValue(
+    const FrameTelemetry::Distribution& distribution) {
+  EncodableList histogram;
+  for (uint32_t count : distribution.histogram) {
+    histogram.push_back(EncodableValue(static_cast<int64_t>(count)));
+  }
+  return EncodableValue(EncodableMap{
+      {EncodableValue("p50Ms"), EncodableValue(distribution.p50_ms)},
+      {EncodableValue("p90Ms"), EncodableValue(distribution.p90_ms)},
+      {EncodableValue("p99Ms"), EncodableValue(distribution.p99_ms)},
+      {EncodableValue("maxMs"), EncodableValue(distribution.max_ms)},
+      {EncodableValue("histogram"), EncodableValue(std::move(histogram))},
+  });
+}
+
+EncodableValue SummaryToValue(const FrameTelemetry::Summary& summary) {
+  EncodableList bucket_limits;
+  for (double limit : FrameTelemetry::kBucketLimitsMs) {
+    bucket_limits.push_back(EncodableValue(limit));
+  }
+  EncodableMap phases;
+  for (const auto& [name, phase] : summary.phases) {
+    phases[EncodableValue(name)] = EncodableValue(EncodableMap{
+        {EncodableValue("frames"),
+         EncodableValue(static_cast<int64_t>(phase.frames))},
+        {EncodableValue("jankyFrames"),
+         EncodableValue(static_cast<int64_t>(phase.janky_frames))},
+        {EncodableValue("total"), DistributionToValue(phase.total)},
+    });
+  }
+  return EncodableValue(EncodableMap{
+      {EncodableValue("frames"),
+       EncodableValue(static_cast<int64_t>(summary.frames))},
+      {EncodableValue("jankyFrames"),
+       EncodableValue(static_cast<int64_t>(summary.janky_frames))},
+      {EncodableValue("dwmFramesMissed"),
+       EncodableValue(static_cast<int64_t>(summary.dwm_frames_missed))},
+      {EncodableValue("refreshMs"), EncodableValue(summary.refresh_ms)},
+      {EncodableValue("bucketLimitsMs"),
+       EncodableValue(std::move(bucket_limits))},
+      {EncodableValue("build"), DistributionToValue(summary.build)},
+      {EncodableValue("raster"), DistributionToValue(summary.raster)},
+      {EncodableValue("present"), DistributionToValue(summary.present)},
+      {EncodableValue("total"), DistributionToValue(summary.total)},
+      {EncodableValue("phases"), EncodableValue(std::move(phases))},
+  });
+}
+
+}  // namespace
+
+FrameTelemetryPlugin::FrameTelemetryPlugin(
+    flutter::BinaryMessenger* messenger) {
+  method_channel_ =
+      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+          messenger, kMethodChannelName,
+          &flutter::StandardMethodCodec::GetInstance());
+  method_channel_->SetMethodCallHandler(
+      [this](const auto& call, auto result) {
+        HandleMethodCall(call, std::move(result));
+      });
+}
+
+FrameTelemetryPlugin::~FrameTelemetryPlugin() {
+  method_channel_->SetMethodCallHandler(nullptr);
+}
+
+void FrameTelemetryPlugin::HandleMethodCall(
+    const flutter::MethodCall<flutter::EncodableValue>& call,
+    Result result) {
+  const std::string& method = call.method_name();
+  if (method == "report") {
+    const auto* timings = std::get_if<std::vector<int64_t>>(call.arguments());
+    if (!timings || timings->size() % 3 != 0) {
+      result->Error("bad_arguments",
+                    "report takes three Int64List entries per frame");
+      return;
+    }
+    std::vector<FrameTelemetry::Frame> frames;
+    frames.reserve(timings->size() / 3);
+    for (size_t i = 0; i < timings->size(); i += 3) {
+      frames.push_back({(*timings)[i], (*timings)[i + 1], (*timings)[i + 2]});
+    }
+    telemetry_.AddFrames(frames);
+    result->Success();
+    return;
+  }
+  if (method == "setPhase") {
+    const auto* arguments = std::get_if<EncodableMap>(call.arguments());
+    if (!arguments) {
+      result->Error("bad_arguments", "setPhase takes {phase}");
+      return;
+    }
+    std::string phase;
+    auto it = arguments->find(EncodableValue("phase"));
+    if (it != arguments->end()) {
+      if (const auto* name = std::get_if<std::string>(&it->second)) {
+        phase = *name;
+      } else if (!it->second.IsNull()) {
+        result->Error("bad_arguments", "phase must be a string or null");
+        return;
+      }
+    }
+    telemetry_.SetPhase(phase);
+    result->Success();
+    return;
+  }
+  if (method == "summary") {
+    result->Success(SummaryToValue(telemetry_.Summarize()));
+    return;
+  }
+  result->NotImplemented();
+}
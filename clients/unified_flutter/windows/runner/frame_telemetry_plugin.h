@@ -0,0 +1,47 @@
+#ifndef RUNNER_FRAME_TELEMETRY_PLUGIN_H_
+#define RUNNER_FRAME_TELEMETRY_PLUGIN_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/method_channel.h>
+
+#include <memory>
+
+#include "frame_telemetry.h"
+
+// Collects frame pacing telemetry from Dart (see FrameTelemetry).
+//
+// Method channel "com.tamshai.ai/frame_telemetry":
+//   report(timings)  - records frames; |timings| is an Int64List of
+//                      [build_us, raster_us, raster_finish_us] per frame.
+//   setPhase(args)   - tags the frames that follow with {phase: String}, or
+//                      with none if the phase is null or empty.
+//   summary()        - the percentiles and histograms of the frames kept,
+//                      overall and per phase.
+class FrameTelemetryPlugin {
+ public:
+  explicit FrameTelemetryPlugin(flutter::BinaryMessenger* messenger);
+  ~FrameTelemetryPlugin();
+
+  // Prevent copying.
+  FrameTelemetryPlugin(FrameTelemetryPlugin const&) = delete;
+  FrameTelemetryPlugin& operator=(FrameTelemetryPlugin const&) = delete;
+
+  // The frames Dart has reported.
+  const FrameTelemetry* telemetry() const { return &telemetry_; }
+
+ private:
+  using Result =
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>;
+
+  void HandleMethodCall(
+      const flutter::MethodCall<flutter::EncodableValue>& call,
+      Result result);
+
+  FrameTelemetry telemetry_;
+
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>>
+      method_channel_;
+};
+
+#endif  // RUNNER_FRAME_TELEMETRY_PLUGIN_H_
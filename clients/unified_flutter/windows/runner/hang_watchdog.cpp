@@ -0,0 +1,669 @@
+#include "hang_watchdog.h"
+
+#include <dbghelp.h>
+#include <delayimp.h>
+#include <psapi.h>
+#include <shlobj.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+
+#include "runner_trace.h"
+#include "utils.h"
+
+namespace {
+
+constexpr const wchar_t kPingWindowClassName[] = L"TAMSHAI_HANG_WATCHDOG";
+
+constexpr wchar_t kSlowVariable[] = L"TAMSHAI_HANG_SLOW_MS";
+constexpr wchar_t kHangVariable[] = L"TAMSHAI_HANG_MS";
+
+// Folder under %LOCALAPPDATA% for the log and dumps, and their names.
+constexpr const wchar_t kHangsFolder[] = L"\\Tamshai Corp\\Tamshai AI\\Hangs";
+constexpr wchar_t kLogName[] = L"\\hangs.log";
+constexpr wchar_t kRolledLogName[] = L"\\hangs.1.log";
+constexpr wchar_t kDumpPattern[] = L"\\hang-*.dmp";
+
+// The log is rolled over once it reaches this size.
+constexpr uint64_t kMaxLogBytes = 1024 * 1024;
+
+// Dumps kept on disk, oldest deleted first, and written per run at most.
+constexpr size_t kMaxDumps = 5;
+constexpr int kMaxDumpsPerRun = 3;
+
+// How long a ping may wait for the platform thread to look at its messages.
+constexpr UINT kPingTimeoutMs = 20;
+
+// How often a dispatch that runs a modal loop is checked on.
+constexpr double kPumpingPollMs = 500;
+
+// How often a dispatch is checked on once every threshold has been passed.
+constexpr double kBusyPollMs = 1000;
+
+// How long without any dispatch before the watchdog waits for the next one
+// rather than polling.
+constexpr double kParkAfterMs = 1000;
+
+// The most of the platform thread's stack that is copied, from the top, and
+// frames unwound from it.
+constexpr size_t kMaxStackCopy = 256 * 1024;
+constexpr size_t kMaxFrames = 32;
+
+// Finished dispatches queued for the watchdog thread at most.
+constexpr size_t kMaxFinished = 64;
+
+constexpr struct {
+  UINT message;
+  const char* name;
+} kMessageNames[] = {
+    {WM_NULL, "WM_NULL"},
+    {WM_MOVE, "WM_MOVE"},
+    {WM_SIZE, "WM_SIZE"},
+    {WM_ACTIVATE, "WM_ACTIVATE"},
+    {WM_SETFOCUS, "WM_SETFOCUS"},
+    {WM_KILLFOCUS, "WM_KILLFOCUS"},
+    {WM_PAINT, "WM_PAINT"},
+    {WM_CLOSE, "WM_CLOSE"},
+    {WM_SETTINGCHANGE, "WM_SETTINGCHANGE"},
+    {WM_WINDOWPOSCHANGED, "WM_WINDOWPOSCHANGED"},
+    {WM_NCLBUTTONDOWN, "WM_NCLBUTTONDOWN"},
+    {WM_KEYDOWN, "WM_KEYDOWN"},
+    {WM_KEYUP, "WM_KEYUP"},
+    {WM_CHAR, "WM_CHAR"},
+    {WM_SYSKEYDOWN, "WM_SYSKEYDOWN"},
+    {WM_SYSCOMMAND, "WM_SYSCOMMAND"},
+    {WM_TIMER, "WM_TIMER"},
+    {WM_MOUSEMOVE, "WM_MOUSEMOVE"},
+    {WM_LBUTTONDOWN, "WM_LBUTTONDOWN"},
+    {WM_LBUTTONUP, "WM_LBUTTONUP"},
+    {WM_RBUTTONDOWN, "WM_RBUTTONDOWN"},
+    {WM_RBUTTONUP, "WM_RBUTTONUP"},
+    {WM_MOUSEWHEEL, "WM_MOUSEWHEEL"},
+    {WM_POINTERUPDATE, "WM_POINTERUPDATE"},
+    {WM_POINTERDOWN, "WM_POINTERDOWN"},
+    {WM_POINTERUP, "WM_POINTERUP"},
+    {WM_DPICHANGED, "WM_DPICHANGED"},
+    {WM_APP + 1, "WM_APP+1"},
+};
+
+int64_t PerformanceCounter() {
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  return now.QuadPart;
+}
+
+double TicksToMs(int64_t ticks) {
+  LARGE_INTEGER frequency;
+  QueryPerformanceFrequency(&frequency);
+  return static_cast<double>(ticks) * 1000.0 /
+         static_cast<double>(frequency.QuadPart);
+}
+
+// Whether |elapsed_ms| has passed |threshold_ms|, which is off if 0.
+bool Exceeds(double elapsed_ms, DWORD threshold_ms) {
+  return threshold_ms != 0 && elapsed_ms >= threshold_ms;
+}
+
+DWORD MsFromEnvironment(const wchar_t* name, DWORD fallback) {
+  wchar_t value[16];
+  DWORD length = GetEnvironmentVariable(name, value, 16);
+  if (length == 0 || length >= 16) {
+    return fallback;
+  }
+  wchar_t* end = nullptr;
+  unsigned long ms = wcstoul(value, &end, 10);
+  return end != value && *end == L'\0' ? static_cast<DWORD>(ms) : fallback;
+}
+
+std::string MessageName(UINT message) {
+  if (message == HangWatchdog::kWaitCallback) {
+    return "wait callback";
+  }
+  if (message == HangWatchdog::kIdleCallback) {
+    return "idle callback";
+  }
+  for (const auto& entry : kMessageNames) {
+    if (entry.message == message) {
+      return entry.name;
+    }
+  }
+  char hex[16];
+  snprintf(hex, sizeof(hex), "0x%04X", message);
+  return hex;
+}
+
+std::string WindowClass(HWND window) {
+  wchar_t name[64];
+  if (!window || GetClassName(window, name, 64) == 0) {
+    return std::string();
+  }
+  return Utf8FromUtf16(name);
+}
+
+// The message and the class of the window it went to, for the log.
+std::string Describe(UINT message, HWND window) {
+  std::string description = MessageName(message);
+  std::string window_class = WindowClass(window);
+  if (!window_class.empty()) {
+    description += " to " + window_class;
+  }
+  return description;
+}
+
+std::string FormatMs(double ms) {
+  char text[32];
+  snprintf(text, sizeof(text), "%.1f ms", ms);
+  return text;
+}
+
+std::string Timestamp() {
+  SYSTEMTIME time;
+  GetLocalTime(&time);
+  char text[32];
+  snprintf(text, sizeof(text), "%04d-%02d-%02d %02d:%02d:%02d.%03d",
+           time.wYear, time.wMonth, time.wDay, time.wHour, time.wMinute,
+           time.wSecond, time.wMilliseconds);
+  return text;
+}
+
+struct Module {
+  uintptr_t base;
+  uintptr_t end;
+  std::string name;
+};
+
+// Lists the loaded modules. The psapi calls read the loader's lists like
+// they would another process's, without the loader lock, which the stuck
+// thread may hold.
+std::vector<Module> LoadedModules() {
+  HANDLE process = GetCurrentProcess();
+  std::vector<HMODULE> handles(256);
+  DWORD needed = 0;
+  for (;;) {
+    DWORD size = static_cast<DWORD>(handles.size() * sizeof(HMODULE));
+    if (!EnumProcessModules(process, handles.data(), size, &needed)) {
+      return {};
+    }
+    if (needed <= size) {
+      break;
+    }
+    handles.resize(needed / sizeof(HMODULE));
+  }
+  handles.resize(needed / sizeof(HMODULE));
+
+  std::vector<Module> modules;
+  for (HMODULE handle : handles) {
+    MODULEINFO info;
+    wchar_t name[MAX_PATH];
+    if (!GetModuleInformation(process, handle, &info, sizeof(info)) ||
+        GetModuleBaseName(process, handle, name, MAX_PATH) == 0) {
+      continue;
+    }
+    auto base = reinterpret_cast<uintptr_t>(info.lpBaseOfDll);
+    modules.push_back({base, base + info.SizeOfImage, Utf8FromUtf16(name)});
+  }
+  return modules;
+}
+
+// Formats |frames| as module+offset, innermost first, for symbolizing
+// against the PDBs later.
+std::string DescribeStack(const std::vector<uintptr_t>& frames) {
+  if (frames.empty()) {
+    return std::string();
+  }
+  std::vector<Module> modules = LoadedModules();
+  std::string stack;
+  for (uintptr_t frame : frames) {
+    auto module = std::find_if(modules.begin(), modules.end(),
+                               [frame](const Module& candidate) {
+                                 return frame >= candidate.base &&
+                                        frame < candidate.end;
+                               });
+    char text[32];
+    if (module != modules.end()) {
+      snprintf(text, sizeof(text), "+0x%llx",
+               static_cast<unsigned long long>(frame - module->base));
+      stack += module->name + text;
+    } else {
+      snprintf(text, sizeof(text), "0x%llx",
+               static_cast<unsigned long long>(frame));
+      stack += text;
+    }
+    stack += ' ';
+  }
+  stack.pop_back();
+  return stack;
+}
+
+#if defined(_M_X64)
+// Unwinds |context|, whose stack has been copied to [low, high), into
+// |frames|. Returns the number of frames. Unwind data can lead anywhere once
+// it goes wrong, so faults end the walk instead of the process.
+size_t UnwindStack(CONTEXT* context,
+                   DWORD64 low,
+                   DWORD64 high,
+                   uintptr_t* frames,
+                   size_t max_frames) {
+  size_t count = 0;
+  __try {
+    while (count < max_frames && context->Rip) {
+      frames[count++] = context->Rip;
+      if (context->Rsp < low || context->Rsp + sizeof(DWORD64) > high) {
+        break;
+      }
+      DWORD64 image_base = 0;
+      PRUNTIME_FUNCTION function =
+          RtlLookupFunctionEntry(context->Rip, &image_base, nullptr);
+      if (!function) {
+        // A leaf function, which keeps its return address on top.
+        context->Rip = *reinterpret_cast<DWORD64*>(context->Rsp);
+        context->Rsp += sizeof(DWORD64);
+        continue;
+      }
+      void* handler_data = nullptr;
+      DWORD64 establisher_frame = 0;
+      RtlVirtualUnwind(UNW_FLAG_NHANDLER, image_base, context->Rip, function,
+                       context, &handler_data, &establisher_frame, nullptr);
+    }
+  } __except (GetExceptionCode() == EXCEPTION_ACCESS_VIOLATION
+                  ? EXCEPTION_EXECUTE_HANDLER
+                  : EXCEPTION_CONTINUE_SEARCH) {
+  }
+  return count;
+}
+#endif
+
+}  // namespace
+
+// static
+HangWatchdog::Thresholds HangWatchdog::ThresholdsFromEnvironment() {
+  Thresholds thresholds;
+  thresholds.slow_ms = MsFromEnvironment(kSlowVariable, thresholds.slow_ms);
+  thresholds.hang_ms = MsFromEnvironment(kHangVariable, thresholds.hang_ms);
+  return thresholds;
+}
+
+HangWatchdog::HangWatchdog(Thresholds thresholds) : thresholds_(thresholds) {
+  LARGE_INTEGER frequency;
+  QueryPerformanceFrequency(&frequency);
+  slow_ticks_ = thresholds_.slow_ms
+                    ? frequency.QuadPart * thresholds_.slow_ms / 1000
+                    : std::numeric_limits<int64_t>::max();
+  if (!thresholds_.slow_ms && !thresholds_.hang_ms) {
+    return;
+  }
+
+  DuplicateHandle(GetCurrentProcess(), GetCurrentThread(),
+                  GetCurrentProcess(), &platform_thread_,
+                  THREAD_SUSPEND_RESUME | THREAD_GET_CONTEXT |
+                      THREAD_QUERY_LIMITED_INFORMATION,
+                  FALSE, 0);
+  ULONG_PTR stack_low = 0;
+  ULONG_PTR stack_high = 0;
+  GetCurrentThreadStackLimits(&stack_low, &stack_high);
+  stack_top_ = stack_high;
+
+  static bool class_registered = false;
+  if (!class_registered) {
+    WNDCLASS window_class{};
+    window_class.lpszClassName = kPingWindowClassName;
+    window_class.hInstance = GetModuleHandle(nullptr);
+    window_class.lpfnWndProc = DefWindowProc;
+    RegisterClass(&window_class);
+    class_registered = true;
+  }
+  ping_window_ = CreateWindowEx(0, kPingWindowClassName, L"", 0, 0, 0, 0, 0,
+                                HWND_MESSAGE, nullptr,
+                                GetModuleHandle(nullptr), nullptr);
+
+  wake_event_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+  stop_event_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+  if (platform_thread_ && ping_window_ && wake_event_ && stop_event_) {
+    thread_ = std::thread(&HangWatchdog::Watch, this);
+  }
+}
+
+HangWatchdog::~HangWatchdog() {
+  if (thread_.joinable()) {
+    SetEvent(stop_event_);
+    thread_.join();
+  }
+  for (HANDLE handle : {stop_event_, wake_event_, platform_thread_}) {
+    if (handle) {
+      CloseHandle(handle);
+    }
+  }
+  if (ping_window_) {
+    DestroyWindow(ping_window_);
+  }
+}
+
+void HangWatchdog::BeginDispatch(UINT message, HWND window) {
+  if (depth_++ > 0) {
+    return;
+  }
+  start_ = PerformanceCounter();
+  message_ = message;
+  window_ = window;
+  dispatch_start_.store(start_, std::memory_order_relaxed);
+  dispatch_message_.store(message, std::memory_order_relaxed);
+  dispatch_window_.store(window, std::memory_order_relaxed);
+  // Publishes the above. Paired with the watchdog setting |parked_| before
+  // it reads the sequence, one side always sees the other's write.
+  sequence_.fetch_add(1);
+  if (parked_.load() && parked_.exchange(false)) {
+    SetEvent(wake_event_);
+  }
+}
+
+void HangWatchdog::EndDispatch() {
+  if (--depth_ > 0) {
+    return;
+  }
+  int64_t duration = PerformanceCounter() - start_;
+  uint64_t sequence = sequence_.fetch_add(1);
+  if (duration < slow_ticks_) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (finished_.size() < kMaxFinished) {
+      finished_.push_back({sequence, message_, window_, TicksToMs(duration)});
+    }
+  }
+  SetEvent(wake_event_);
+}
+
+void HangWatchdog::Watch() {
+  // Bind dbghelp now rather than while the platform thread is stuck, perhaps
+  // holding the loader lock.
+  __HrLoadAllImportsForDll("dbghelp.dll");
+  stack_copy_.resize(kMaxStackCopy);
+  stack_.reserve(kMaxFrames);
+
+  double poll_ms = std::min<double>(
+      kBusyPollMs, thresholds_.slow_ms ? thresholds_.slow_ms
+                                       : thresholds_.hang_ms);
+  const HANDLE handles[] = {stop_event_, wake_event_};
+  // The dispatch being timed, and when its clock started.
+  uint64_t watched = 0;
+  int64_t since = 0;
+  bool sampled = false;
+  bool hung = false;
+  // The last dispatch found running a modal loop.
+  uint64_t pumping = 0;
+  int64_t last_busy = PerformanceCounter();
+  for (;;) {
+    int64_t now = PerformanceCounter();
+    uint64_t sequence = sequence_.load();
+    DWORD timeout = static_cast<DWORD>(poll_ms);
+    if (sequence & 1) {
+      if (sequence != watched) {
+        since = dispatch_start_.load(std::memory_order_relaxed);
+        if (sequence_.load() != sequence) {
+          continue;
+        }
+        watched = sequence;
+        sampled = false;
+        hung = false;
+      }
+      last_busy = now;
+
+      double elapsed_ms = TicksToMs(now - since);
+      bool slow = !sampled && Exceeds(elapsed_ms, thresholds_.slow_ms);
+      bool hang = !hung && Exceeds(elapsed_ms, thresholds_.hang_ms);
+      if ((slow || hang) && PlatformThreadPumping()) {
+        pumping = sequence;
+        since = PerformanceCounter();
+        elapsed_ms = 0;
+      } else if (slow || hang) {
+        if (!sampled) {
+          SampleStack();
+          stack_sequence_ = sequence;
+          sampled = true;
+        }
+        if (hang) {
+          ReportHang(elapsed_ms);
+          hung = true;
+        }
+      }
+
+      double next_ms = kBusyPollMs;
+      if (!sampled && thresholds_.slow_ms) {
+        next_ms = std::min(next_ms, thresholds_.slow_ms - elapsed_ms);
+      }
+      if (!hung && thresholds_.hang_ms) {
+        next_ms = std::min(next_ms, thresholds_.hang_ms - elapsed_ms);
+      }
+      if (pumping == sequence) {
+        next_ms = std::max(next_ms, kPumpingPollMs);
+      }
+      timeout = static_cast<DWORD>(std::max(next_ms, 1.0));
+    } else if (TicksToMs(now - last_busy) >= kParkAfterMs) {
+      // Nothing to time for a while: sleep until the next dispatch starts.
+      // The sequence is read again after parking, as one may have started
+      // just before.
+      parked_.store(true);
+      if (sequence_.load() != sequence) {
+        parked_.store(false);
+        continue;
+      }
+      timeout = INFINITE;
+    }
+
+    DWORD result = WaitForMultipleObjects(2, handles, FALSE, timeout);
+    parked_.store(false);
+    ReportFinished(pumping);
+    if (result == WAIT_OBJECT_0) {
+      return;
+    }
+  }
+}
+
+bool HangWatchdog::PlatformThreadPumping() {
+  // A sent message is handled whenever the thread looks at its queue, which
+  // a modal loop does and a stuck thread does not.
+  DWORD_PTR reply = 0;
+  return SendMessageTimeout(ping_window_, WM_NULL, 0, 0,
+                            SMTO_BLOCK | SMTO_ABORTIFHUNG, kPingTimeoutMs,
+                            &reply) != 0;
+}
+
+void HangWatchdog::SampleStack() {
+  stack_.clear();
+#if defined(_M_X64)
+  CONTEXT context{};
+  context.ContextFlags = CONTEXT_FULL;
+  DWORD64 bottom = 0;
+  size_t size = 0;
+  // Nothing that may take a lock, allocating included, happens while the
+  // thread is suspended, as it may be holding that lock.
+  if (SuspendThread(platform_thread_) == static_cast<DWORD>(-1)) {
+    return;
+  }
+  if (GetThreadContext(platform_thread_, &context) &&
+      context.Rsp < stack_top_) {
+    bottom = context.Rsp;
+    size = std::min<size_t>(static_cast<size_t>(stack_top_ - bottom),
+                            stack_copy_.size());
+    memcpy(stack_copy_.data(), reinterpret_cast<const void*>(bottom), size);
+  }
+  ResumeThread(platform_thread_);
+  if (size == 0) {
+    return;
+  }
+
+  // Pointers into the stack, such as frame pointers and saved registers,
+  // are moved into the copy, so the unwinder reads the stack as it was.
+  auto copy = reinterpret_cast<DWORD64>(stack_copy_.data());
+  auto rebase = [bottom, size, copy](DWORD64* value) {
+    if (*value >= bottom && *value < bottom + size) {
+      *value = *value - bottom + copy;
+    }
+  };
+  for (size_t offset = 0; offset + sizeof(DWORD64) <= size;
+       offset += sizeof(DWORD64)) {
+    rebase(reinterpret_cast<DWORD64*>(stack_copy_.data() + offset));
+  }
+  for (DWORD64* reg : {&context.Rsp, &context.Rbp, &context.Rbx, &context.Rsi,
+                       &context.Rdi, &context.R12, &context.R13, &context.R14,
+                       &context.R15}) {
+    rebase(reg);
+  }
+
+  stack_.resize(kMaxFrames);
+  stack_.resize(
+      UnwindStack(&context, copy, copy + size, stack_.data(), kMaxFrames));
+#endif
+}
+
+void HangWatchdog::ReportHang(double elapsed_ms) {
+  std::string description =
+      Describe(dispatch_message_.load(std::memory_order_relaxed),
+               dispatch_window_.load(std::memory_order_relaxed));
+  std::string stack = DescribeStack(stack_);
+  std::wstring dump = WriteDump("Platform thread " +
+                                std::to_string(GetThreadId(platform_thread_)) +
+                                " hung in " + description);
+  TraceLoggingWrite(g_runner_trace_provider, "Hang",
+                    TraceLoggingString(description.c_str(), "Dispatch"),
+                    TraceLoggingFloat64(elapsed_ms, "ElapsedMs"),
+                    TraceLoggingString(stack.c_str(), "Stack"),
+                    TraceLoggingWideString(dump.c_str(), "Dump"));
+
+  std::string line = "hang " + FormatMs(elapsed_ms) + " " + description;
+  if (!stack.empty()) {
+    line += " at " + stack;
+  }
+  if (!dump.empty()) {
+    line += " dump " + Utf8FromUtf16(dump.c_str());
+  }
+  AppendToLog(line);
+}
+
+std::wstring HangWatchdog::WriteDump(const std::string& comment) {
+  if (dumps_written_ >= kMaxDumpsPerRun || folder().empty()) {
+    return std::wstring();
+  }
+
+  // Make room for this one. The names sort by the time they were written.
+  std::vector<std::wstring> dumps;
+  WIN32_FIND_DATA found;
+  HANDLE find = FindFirstFile((folder() + kDumpPattern).c_str(), &found);
+  if (find != INVALID_HANDLE_VALUE) {
+    do {
+      dumps.push_back(found.cFileName);
+    } while (FindNextFile(find, &found));
+    FindClose(find);
+  }
+  std::sort(dumps.begin(), dumps.end());
+  for (size_t i = 0; i + kMaxDumps <= dumps.size(); ++i) {
+    DeleteFile((folder() + L"\\" + dumps[i]).c_str());
+  }
+
+  SYSTEMTIME time;
+  GetLocalTime(&time);
+  wchar_t name[48];
+  swprintf(name, 48, L"\\hang-%04d%02d%02d-%02d%02d%02d-%lu.dmp", time.wYear,
+           time.wMonth, time.wDay, time.wHour, time.wMinute, time.wSecond,
+           GetCurrentProcessId());
+  std::wstring path = folder() + name;
+  HANDLE file = CreateFile(path.c_str(), GENERIC_WRITE, 0, nullptr,
+                           CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return std::wstring();
+  }
+  std::string text = comment;
+  MINIDUMP_USER_STREAM stream{CommentStreamA,
+                              static_cast<ULONG>(text.size() + 1),
+                              text.data()};
+  MINIDUMP_USER_STREAM_INFORMATION streams{1, &stream};
+  BOOL written = MiniDumpWriteDump(
+      GetCurrentProcess(), GetCurrentProcessId(), file,
+      static_cast<MINIDUMP_TYPE>(MiniDumpWithThreadInfo |
+                                 MiniDumpWithUnloadedModules),
+      nullptr, &streams, nullptr);
+  CloseHandle(file);
+  if (!written) {
+    DeleteFile(path.c_str());
+    return std::wstring();
+  }
+  ++dumps_written_;
+  return path;
+}
+
+void HangWatchdog::ReportFinished(uint64_t pumping_sequence) {
+  std::vector<Finished> finished;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished.swap(finished_);
+  }
+  for (const Finished& dispatch : finished) {
+    // Its duration includes the modal loop it ran, which stalled nothing.
+    if (dispatch.sequence == pumping_sequence) {
+      continue;
+    }
+    std::string description = Describe(dispatch.message, dispatch.window);
+    std::string stack = dispatch.sequence == stack_sequence_
+                            ? DescribeStack(stack_)
+                            : std::string();
+    TraceLoggingWrite(g_runner_trace_provider, "SlowDispatch",
+                      TraceLoggingUInt32(dispatch.message, "Message"),
+                      TraceLoggingString(description.c_str(), "Dispatch"),
+                      TraceLoggingFloat64(dispatch.duration_ms, "DurationMs"),
+                      TraceLoggingString(stack.c_str(), "Stack"));
+
+    std::string line =
+        "slow " + FormatMs(dispatch.duration_ms) + " " + description;
+    if (!stack.empty()) {
+      line += " at " + stack;
+    }
+    AppendToLog(line);
+  }
+}
+
+void HangWatchdog::AppendToLog(const std::string& line) {
+  if (folder().empty()) {
+    return;
+  }
+  std::wstring path = folder() + kLogName;
+  WIN32_FILE_ATTRIBUTE_DATA attributes;
+  if (GetFileAttributesEx(path.c_str(), GetFileExInfoStandard, &attributes) &&
+      ((static_cast<uint64_t>(attributes.nFileSizeHigh) << 32) |
+       attributes.nFileSizeLow) >= kMaxLogBytes) {
+    MoveFileEx(path.c_str(), (folder() + kRolledLogName).c_str(),
+               MOVEFILE_REPLACE_EXISTING);
+  }
+  // Another instance, such as a benchmark run, may be appending as well.
+  HANDLE file = CreateFile(path.c_str(), FILE_APPEND_DATA,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                           OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return;
+  }
+  std::string text = Timestamp() + " " + line + "\r\n";
+  DWORD written = 0;
+  WriteFile(file, text.data(), static_cast<DWORD>(text.size()), &written,
+            nullptr);
+  CloseHandle(file);
+}
+
+const std::wstring& HangWatchdog::folder() {
+  if (folder_.empty()) {
+    PWSTR local_app_data = nullptr;
+    if (SUCCEEDED(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr,
+                                       &local_app_data))) {
+      std::wstring folder = std::wstring(local_app_data) + kHangsFolder;
+      int result = SHCreateDirectoryEx(nullptr, folder.c_str(), nullptr);
+      if (result == ERROR_SUCCESS || result == ERROR_ALREADY_EXISTS ||
+          result == ERROR_FILE_EXISTS) {
+        folder_ = folder;
+      }
+    }
+    CoTaskMemFree(local_app_data);
+  }
+  return folder_;
+}
@@ -0,0 +1,146 @@
+#ifndef RUNNER_HANG_WATCHDOG_H_
+#define RUNNER_HANG_WATCHDOG_H_
+
+#include <windows.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Watches the platform thread for dispatches that stall it.
+//
+// RunLoop brackets every message it dispatches, and every handle and idle
+// callback it runs, with BeginDispatch and EndDispatch, which only store a
+// timestamp. A thread of its own checks on the dispatch in progress:
+//
+//  * Past the slow threshold (50 ms by default) the platform thread is
+//    suspended just long enough to copy its stack, which is then unwound, so
+//    the record shows which window procedure, plugin or engine call it was
+//    in. Once the dispatch ends it is written out with its full duration.
+//  * Past the hang threshold (2 s by default) a minidump of the process is
+//    written as well.
+//
+// A dispatch that enters a modal loop of its own, such as moving the window
+// or a file dialog, keeps the thread pumping messages; the watchdog pings a
+// window on the platform thread before blaming it, and restarts the clock
+// while the ping is answered.
+//
+// Records go to ETW as "SlowDispatch" and "Hang" events, and to hangs.log
+// beside the dumps in %LOCALAPPDATA%\Tamshai Corp\Tamshai AI\Hangs, which is
+// kept under a megabyte by rolling it over to hangs.1.log. The thresholds can
+// be set, in milliseconds, with the TAMSHAI_HANG_SLOW_MS and TAMSHAI_HANG_MS
+// environment variables; 0 turns the check off.
+class HangWatchdog {
+ public:
+  struct Thresholds {
+    DWORD slow_ms = 50;
+    DWORD hang_ms = 2000;
+  };
+
+  // Pseudo message ids for the RunLoop callbacks, beyond the range of real
+  // messages.
+  static constexpr UINT kWaitCallback = 0x10000;
+  static constexpr UINT kIdleCallback = 0x10001;
+
+  // Returns the defaults, overridden by the environment.
+  static Thresholds ThresholdsFromEnvironment();
+
+  // Starts watching the calling thread, which must pump messages.
+  explicit HangWatchdog(Thresholds thresholds);
+  ~HangWatchdog();
+
+  // Prevent copying.
+  HangWatchdog(HangWatchdog const&) = delete;
+  HangWatchdog& operator=(HangWatchdog const&) = delete;
+
+  // Bracket one dispatch of |message| to |window|. Platform thread only;
+  // nested calls are folded into the outermost.
+  void BeginDispatch(UINT message, HWND window);
+  void EndDispatch();
+
+ private:
+  // A dispatch that took longer than the slow threshold.
+  struct Finished {
+    uint64_t sequence;
+    UINT message;
+    HWND window;
+    double duration_ms;
+  };
+
+  // Body of |thread_|.
+  void Watch();
+
+  // Whether the platform thread is pumping messages, as it does in a modal
+  // loop, rather than stuck.
+  bool PlatformThreadPumping();
+
+  // Copies the platform thread's stack while it is suspended, and unwinds the
+  // copy into |stack_| once it is running again.
+  void SampleStack();
+
+  // Records the dispatch in progress as hung after |elapsed_ms|, with a
+  // minidump.
+  void ReportHang(double elapsed_ms);
+
+  // Writes a minidump with |comment| attached. Returns its path, or an empty
+  // string if none was written.
+  std::wstring WriteDump(const std::string& comment);
+
+  // Writes out the dispatches EndDispatch has queued, except
+  // |pumping_sequence|, which ran a modal loop.
+  void ReportFinished(uint64_t pumping_sequence);
+
+  // Appends |line| to hangs.log, rolling it over if it is full.
+  void AppendToLog(const std::string& line);
+
+  // The folder for the log and dumps, created on first use. Watchdog thread
+  // only.
+  const std::wstring& folder();
+
+  Thresholds thresholds_;
+  int64_t slow_ticks_ = 0;
+
+  HANDLE platform_thread_ = nullptr;
+  // Message-only window on the platform thread, pinged from |thread_|.
+  HWND ping_window_ = nullptr;
+  // Top of the platform thread's stack.
+  uintptr_t stack_top_ = 0;
+
+  // Odd while a dispatch is in progress; bumped at its start and end.
+  std::atomic<uint64_t> sequence_{0};
+  std::atomic<int64_t> dispatch_start_{0};
+  std::atomic<UINT> dispatch_message_{0};
+  std::atomic<HWND> dispatch_window_{nullptr};
+
+  // Platform thread only: nesting depth, and the outermost dispatch.
+  int depth_ = 0;
+  int64_t start_ = 0;
+  UINT message_ = 0;
+  HWND window_ = nullptr;
+
+  // Set while |thread_| waits with nothing to time, so that the next
+  // dispatch wakes it.
+  std::atomic<bool> parked_{false};
+
+  std::mutex mutex_;
+  std::vector<Finished> finished_;
+
+  // Auto-reset; wakes |thread_| for a new dispatch or a finished one.
+  HANDLE wake_event_ = nullptr;
+  // Manual-reset; stops |thread_|.
+  HANDLE stop_event_ = nullptr;
+  std::thread thread_;
+
+  // Watchdog thread only: the copied stack, and the frames unwound from it
+  // for dispatch |stack_sequence_|, or empty.
+  std::vector<uint8_t> stack_copy_;
+  std::vector<uintptr_t> stack_;
+  uint64_t stack_sequence_ = 0;
+  std::wstring folder_;
+  int dumps_written_ = 0;
+};
+
+#endif  // RUNNER_HANG_WATCHDOG_H_
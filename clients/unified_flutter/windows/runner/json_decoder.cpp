@@ -0,0 +1,443 @@
+#include "json_decoder.h"
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#include <intrin.h>
+#endif
+
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <string>
+#include <utility>
+
+namespace {
+
+// Nesting deeper than this is rejected rather than risking stack exhaustion
+// on hostile input.
+constexpr int kMaxDepth = 128;
+
+// Appends the UTF-8 encoding of |code_point| to |out|.
+void AppendUtf8(uint32_t code_point, std::string& out) {
+  if (code_point < 0x80) {
+    out.push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else if (code_point < 0x10000) {
+    out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else {
+    out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  }
+}
+
+bool IsWhitespace(char c) {
+  return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Ends a run of plain string characters: a quote, an escape or a control
+// character, which JSON does not allow unescaped.
+bool EndsStringRun(char c) {
+  return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+}
+
+#if defined(_M_X64) || defined(_M_IX86)
+// Index of the lowest set bit of a non-zero movemask.
+size_t LowestBit(int mask) {
+  unsigned long index;
+  _BitScanForward(&index, static_cast<unsigned long>(mask));
+  return index;
+}
+#endif
+
+// Returns the offset of the first byte in |data| that ends a string run, or
+// |size| if there is none. Checks 16 bytes at a time with SSE2, which every
+// x86 Windows 10 machine has; long strings such as names and descriptions in
+// generated components are where a document spends most of its bytes.
+size_t FindStringRunEnd(const char* data, size_t size) {
+  size_t offset = 0;
+#if defined(_M_X64) || defined(_M_IX86)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i last_control = _mm_set1_epi8(0x1F);
+  for (; offset + 16 <= size; offset += 16) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+    // A byte is a control character if its unsigned minimum with 0x1F is
+    // itself.
+    __m128i control =
+        _mm_cmpeq_epi8(_mm_min_epu8(chunk, last_control), chunk);
+    __m128i special = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                     _mm_cmpeq_epi8(chunk, backslash)),
+        control);
+    int mask = _mm_movemask_epi8(special);
+    if (mask != 0) {
+      return offset + LowestBit(mask);
+    }
+  }
+#endif
+  while (offset < size && !EndsStringRun(data[offset])) {
+    ++offset;
+  }
+  return offset;
+}
+
+// Returns the offset of the first byte in |data| that is not whitespace, or
+// |size| if there is none. Indented documents have long runs of it.
+size_t FindNonWhitespace(const char* data, size_t size) {
+  size_t offset = 0;
+#if defined(_M_X64) || defined(_M_IX86)
+  const __m128i space = _mm_set1_epi8(' ');
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i carriage_return = _mm_set1_epi8('\r');
+  const __m128i tab = _mm_set1_epi8('\t');
+  for (; offset + 16 <= size; offset += 16) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + offset));
+    __m128i whitespace = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, space),
+                     _mm_cmpeq_epi8(chunk, newline)),
+        _mm_or_si128(_mm_cmpeq_epi8(chunk, carriage_return),
+                     _mm_cmpeq_epi8(chunk, tab)));
+    int mask = ~_mm_movemask_epi8(whitespace) & 0xFFFF;
+    if (mask != 0) {
+      return offset + LowestBit(mask);
+    }
+  }
+#endif
+  while (offset < size && IsWhitespace(data[offset])) {
+    ++offset;
+  }
+  return offset;
+}
+
+// Recursive-descent parser over a single in-memory document.
+class JsonParser {
+ public:
+  explicit JsonParser(std::string_view json) : json_(json) {}
+
+  std::optional<flutter::EncodableValue> ParseDocument() {
+    flutter::EncodableValue value;
+    if (!ParseValue(value, 0)) {
+      return std::nullopt;
+    }
+    SkipWhitespace();
+    if (position_ != json_.size()) {
+      return std::nullopt;
+    }
+    return value;
+  }
+
+ private:
+  void SkipWhitespace() {
+    // Compact documents have no whitespace between tokens; don't set up a
+    // scan for them.
+    if (position_ >= json_.size() || !IsWhitespace(json_[position_])) {
+      return;
+    }
+    position_ += FindNonWhitespace(json_.data() + position_,
+                                   json_.size() - position_);
+  }
+
+  bool ConsumeLiteral(std::string_view literal) {
+    if (json_.substr(position_, literal.size()) != literal) {
+      return false;
+    }
+    position_ += literal.size();
+    return true;
+  }
+
+  bool ParseValue(flutter::EncodableValue& out, int depth) {
+    if (depth > kMaxDepth) {
+      return false;
+    }
+    SkipWhitespace();
+    if (position_ >= json_.size()) {
+      return false;
+    }
+    switch (json_[position_]) {
+      case '{':
+        return ParseObject(out, depth);
+      case '[':
+        return ParseArray(out, depth);
+      case '"': {
+        std::string text;
+        if (!ParseString(text)) {
+          return false;
+        }
+        out = flutter::EncodableValue(std::move(text));
+        return true;
+      }
+      case 't':
+        out = flutter::EncodableValue(true);
+        return ConsumeLiteral("true");
+      case 'f':
+        out = flutter::EncodableValue(false);
+        return ConsumeLiteral("false");
+      case 'n':
+        out = flutter::EncodableValue();
+        return ConsumeLiteral("null");
+      default:
+        return ParseNumber(out);
+    }
+  }
+
+  bool ParseObject(flutter::EncodableValue& out, int depth) {
+    ++position_;  // '{'
+    flutter::EncodableMap map;
+    SkipWhitespace();
+    if (position_ < json_.size() && json_[position_] == '}') {
+      ++position_;
+      out = flutter::EncodableValue(std::move(map));
+      return true;
+    }
+    for (;;) {
+      SkipWhitespace();
+      if (position_ >= json_.size() || json_[position_] != '"') {
+        return false;
+      }
+      std::string key;
+      if (!ParseString(key)) {
+        return false;
+      }
+      SkipWhitespace();
+      if (position_ >= json_.size() || json_[position_] != ':') {
+        return false;
+      }
+      ++position_;
+      flutter::EncodableValue value;
+      if (!ParseValue(value, depth + 1)) {
+        return false;
+      }
+      map[flutter::EncodableValue(std::move(key))] = std::move(value);
+      SkipWhitespace();
+      if (position_ >= json_.size()) {
+        return false;
+      }
+      char c = json_[position_++];
+      if (c == '}') {
+        break;
+      }
+      if (c != ',') {
+        return false;
+      }
+    }
+    out = flutter::EncodableValue(std::move(map));
+    return true;
+  }
+
+  bool ParseArray(flutter::EncodableValue& out, int depth) {
+    ++position_;  // '['
+    flutter::EncodableList list;
+    SkipWhitespace();
+    if (position_ < json_.size() && json_[position_] == ']') {
+      ++position_;
+      out = flutter::EncodableValue(std::move(list));
+      return true;
+    }
+    for (;;) {
+      flutter::EncodableValue value;
+      if (!ParseValue(value, depth + 1)) {
+        return false;
+      }
+      list.push_back(std::move(value));
+      SkipWhitespace();
+      if (position_ >= json_.size()) {
+        return false;
+      }
+      char c = json_[position_++];
+      if (c == ']') {
+        break;
+      }
+      if (c != ',') {
+        return false;
+      }
+    }
+    out = flutter::EncodableValue(std::move(list));
+    return true;
+  }
+
+  bool ParseHex4(uint32_t& out) {
+    if (position_ + 4 > json_.size()) {
+      return false;
+    }
+    out = 0;
+    for (int i = 0; i < 4; ++i) {
+      char c = json_[position_++];
+      out <<= 4;
+      if (c >= '0' && c <= '9') {
+        out |= static_cast<uint32_t>(c - '0');
+      } else if (c >= 'a' && c <= 'f') {
+        out |= static_cast<uint32_t>(c - 'a' + 10);
+      } else if (c >= 'A' && c <= 'F') {
+        out |= static_cast<uint32_t>(c - 'A' + 10);
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool ParseString(std::string& out) {
+    ++position_;  // '"'
+    for (;;) {
+      // Copy the run of plain characters up to the next quote or escape in
+      // one append.
+      size_t run_start = position_;
+      position_ += FindStringRunEnd(json_.data() + position_,
+                                    json_.size() - position_);
+      out.append(json_.data() + run_start, position_ - run_start);
+      if (position_ >= json_.size()) {
+        return false;
+      }
+
+      char c = json_[position_++];
+      if (c == '"') {
+        return true;
+      }
+      if (c != '\\' || position_ >= json_.size()) {
+        // Unescaped control character or truncated escape.
+        return false;
+      }
+      char escape = json_[position_++];
+      switch (escape) {
+        case '"':
+        case '\\':
+        case '/':
+          out.push_back(escape);
+          break;
+        case 'b':
+          out.push_back('\b');
+          break;
+        case 'f':
+          out.push_back('\f');
+          break;
+        case 'n':
+          out.push_back('\n');
+          break;
+        case 'r':
+          out.push_back('\r');
+          break;
+        case 't':
+          out.push_back('\t');
+          break;
+        case 'u': {
+          uint32_t code_point;
+          if (!ParseHex4(code_point)) {
+            return false;
+          }
+          if (code_point >= 0xD800 && code_point <= 0xDBFF) {
+            uint32_t low;
+            if (!ConsumeLiteral("\\u") || !ParseHex4(low) || low < 0xDC00 ||
+                low > 0xDFFF) {
+              return false;
+            }
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) +
+                         (low - 0xDC00);
+          } else if (code_point >= 0xDC00 && code_point <= 0xDFFF) {
+            return false;
+          }
+          AppendUtf8(code_point, out);
+          break;
+        }
+        default:
+          return false;
+      }
+    }
+  }
+
+  bool ParseNumber(flutter::EncodableValue& out) {
+    size_t start = position_;
+    bool negative = false;
+    if (position_ < json_.size() && json_[position_] == '-') {
+      negative = true;
+      ++position_;
+    }
+
+    // Accumulate the integer part directly; most numbers in gateway payloads
+    // are integral and never need strtod.
+    uint64_t magnitude = 0;
+    bool overflow = false;
+    size_t digits_start = position_;
+    while (position_ < json_.size() && json_[position_] >= '0' &&
+           json_[position_] <= '9') {
+      uint64_t digit = static_cast<uint64_t>(json_[position_] - '0');
+      if (magnitude > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+        overflow = true;
+      } else {
+        magnitude = magnitude * 10 + digit;
+      }
+      ++position_;
+    }
+    size_t digit_count = position_ - digits_start;
+    if (digit_count == 0 ||
+        (digit_count > 1 && json_[digits_start] == '0')) {
+      return false;
+    }
+
+    bool is_integer = true;
+    if (position_ < json_.size() && json_[position_] == '.') {
+      is_integer = false;
+      ++position_;
+      size_t fraction_start = position_;
+      while (position_ < json_.size() && json_[position_] >= '0' &&
+             json_[position_] <= '9') {
+        ++position_;
+      }
+      if (position_ == fraction_start) {
+        return false;
+      }
+    }
+    if (position_ < json_.size() &&
+        (json_[position_] == 'e' || json_[position_] == 'E')) {
+      is_integer = false;
+      ++position_;
+      if (position_ < json_.size() &&
+          (json_[position_] == '+' || json_[position_] == '-')) {
+        ++position_;
+      }
+      size_t exponent_start = position_;
+      while (position_ < json_.size() && json_[position_] >= '0' &&
+             json_[position_] <= '9') {
+        ++position_;
+      }
+      if (position_ == exponent_start) {
+        return false;
+      }
+    }
+
+    constexpr uint64_t kMaxInt64 =
+        static_cast<uint64_t>(std::numeric_limits<int64_t>::max());
+    if (is_integer && !overflow &&
+        magnitude <= (negative ? kMaxInt64 + 1 : kMaxInt64)) {
+      int64_t value = negative ? static_cast<int64_t>(0 - magnitude)
+                               : static_cast<int64_t>(magnitude);
+      if (value >= std::numeric_limits<int32_t>::min() &&
+          value <= std::numeric_limits<int32_t>::max()) {
+        out = flutter::EncodableValue(static_cast<int32_t>(value));
+      } else {
+        out = flutter::EncodableValue(value);
+      }
+      return true;
+    }
+
+    std::string token(json_.data() + start, position_ - start);
+    out = flutter::EncodableValue(std::strtod(token.c_str(), nullptr));
+    return true;
+  }
+
+  std::string_view json_;
+  size_t position_ = 0;
+};
+
+}  // namespace
+
+std::optional<flutter::EncodableValue> DecodeJson(std::string_view json) {
+  return JsonParser(json).ParseDocument();
+}
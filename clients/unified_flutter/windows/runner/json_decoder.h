@@ -0,0 +1,17 @@
+#ifndef RUNNER_JSON_DECODER_H_
+#define RUNNER_JSON_DECODER_H_
+
+#include <flutter/encodable_value.h>
+
+#include <optional>
+#include <string_view>
+
+// Parses the UTF-8 JSON document |json| into an EncodableValue tree that can
+// be sent over a StandardMethodCodec channel without further conversion.
+//
+// Objects become EncodableMap with string keys, arrays become EncodableList,
+// integers that fit are stored as int32_t or int64_t and all other numbers as
+// double. Returns std::nullopt if |json| is not a single valid document.
+std::optional<flutter::EncodableValue> DecodeJson(std::string_view json);
+
+#endif  // RUNNER_JSON_DECODER_H_
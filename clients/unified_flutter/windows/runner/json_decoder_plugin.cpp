@@ -0,0 +1,68 @@
+#include "json_decoder_plugin.h"
+
+#include <flutter/standard_method_codec.h>
+
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "json_decoder.h"
+#include "runner_trace.h"
+
+namespace {
+
+constexpr char kMethodChannelName[] = "com.tamshai.ai/json";
+
+using flutter::EncodableValue;
+
+}  // namespace
+
+JsonDecoderPlugin::JsonDecoderPlugin(flutter::BinaryMessenger* messenger,
+                                     PlatformTaskQueue* task_queue)
+    : messenger_(messenger),
+      pending_results_(task_queue, "The document could not be decoded") {
+  messenger_->SetMessageHandler(
+      kMethodChannelName, [this](const uint8_t* message, size_t message_size,
+                                 flutter::BinaryReply reply) {
+        int64_t id = pending_results_.AddReply(std::move(reply));
+        // The engine frees |message| on return, so its bytes are copied
+        // once; everything else happens on the worker.
+        decode_tasks_.Post(
+            [this, id,
+             call = std::vector<uint8_t>(message, message + message_size)]() {
+              pending_results_.Send(id, HandleMessage(call));
+            });
+      });
+}
+
+JsonDecoderPlugin::~JsonDecoderPlugin() {
+  messenger_->SetMessageHandler(kMethodChannelName, nullptr);
+}
+
+// static
+std::unique_ptr<std::vector<uint8_t>> JsonDecoderPlugin::HandleMessage(
+    const std::vector<uint8_t>& message) {
+  const flutter::StandardMethodCodec& codec =
+      flutter::StandardMethodCodec::GetInstance();
+  std::unique_ptr<flutter::MethodCall<EncodableValue>> call =
+      codec.DecodeMethodCall(message);
+  if (!call || call->method_name() != "decode") {
+    return nullptr;
+  }
+  const auto* bytes = std::get_if<std::vector<uint8_t>>(call->arguments());
+  if (!bytes) {
+    return codec.EncodeErrorEnvelope(
+        "bad_arguments", "decode takes the document's UTF-8 bytes");
+  }
+
+  TraceSpan span("DecodeJson");
+  std::optional<EncodableValue> document = DecodeJson(std::string_view(
+      reinterpret_cast<const char*>(bytes->data()), bytes->size()));
+  span.End();
+  if (!document) {
+    return codec.EncodeErrorEnvelope("bad_arguments",
+                                     "The document is not valid JSON");
+  }
+  TraceSpan encode_span("EncodeJsonReply");
+  return codec.EncodeSuccessEnvelope(&*document);
+}
@@ -0,0 +1,55 @@
+#ifndef RUNNER_JSON_DECODER_PLUGIN_H_
+#define RUNNER_JSON_DECODER_PLUGIN_H_
+
+#include <flutter/binary_messenger.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "pending_results.h"
+#include "platform_task_queue.h"
+#include "worker_pool.h"
+
+// Parses large JSON documents for Dart off the UI isolate.
+//
+// Dart hands over the UTF-8 bytes of a response; the runner parses them with
+// DecodeJson on the worker pool, several at once, and replies with the
+// document as an EncodableValue tree, which arrives in Dart as plain maps,
+// lists and values decoded straight from the StandardMethodCodec reply.
+//
+// Calls are taken by a raw message handler and both decoded and answered on
+// the worker, including encoding the reply envelope, so the platform thread
+// only copies the call's bytes out of the engine and passes the encoded
+// reply back.
+//
+// Method channel "com.tamshai.ai/json":
+//   decode(bytes) - the document in |bytes| (a Uint8List). Fails with
+//                   "bad_arguments" if it is not valid JSON.
+class JsonDecoderPlugin {
+ public:
+  JsonDecoderPlugin(flutter::BinaryMessenger* messenger,
+                    PlatformTaskQueue* task_queue);
+  ~JsonDecoderPlugin();
+
+  // Prevent copying.
+  JsonDecoderPlugin(JsonDecoderPlugin const&) = delete;
+  JsonDecoderPlugin& operator=(JsonDecoderPlugin const&) = delete;
+
+ private:
+  // Handles the method call encoded in |message| and returns the encoded
+  // reply, or null for an unknown method. Runs on the worker pool.
+  static std::unique_ptr<std::vector<uint8_t>> HandleMessage(
+      const std::vector<uint8_t>& message);
+
+  flutter::BinaryMessenger* messenger_;
+
+  // Calls waiting for their document.
+  PendingResults pending_results_;
+
+  // Declared last, so that it goes first: it finishes the documents being
+  // decoded and drops the rest.
+  WorkerPool::TaskGroup decode_tasks_{WorkerPool::Priority::kInteractive};
+};
+
+#endif  // RUNNER_JSON_DECODER_PLUGIN_H_
@@ -0,0 +1,386 @@
+#include "log_sink.h"
+
+#include <fcntl.h>
+#include <io.h>
+#include <shlobj.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "runner_trace.h"
+
+namespace {
+
+constexpr char kChannelName[] = "com.tamshai.ai/log";
+
+// Folder under %LOCALAPPDATA% for the log, and its name.
+constexpr wchar_t kLogsFolder[] = L"\\Tamshai Corp\\Tamshai AI\\Logs";
+constexpr wchar_t kLogBaseName[] = L"\\runner";
+
+// The log is rolled over once it reaches this size, into this many older
+// files.
+constexpr uint64_t kMaxLogBytes = 4 * 1024 * 1024;
+constexpr int kRolledLogs = 3;
+
+// How often the writer drains the ring when nothing wakes it sooner.
+constexpr DWORD kDrainIntervalMs = 250;
+
+// Slots a single record may take; longer text is cut short.
+constexpr uint64_t kMaxRecordSlots = 16;
+
+// Buffer of each capture pipe.
+constexpr DWORD kPipeBytes = 64 * 1024;
+
+// Indexed by LogSink::Level: one letter for the file, a word for ETW.
+constexpr char kLevelLetters[] = "TDIWEF";
+constexpr const char* kLevelNames[] = {"trace",   "debug", "info",
+                                       "warning", "error", "fatal"};
+
+// The log's path without its extension, or an empty string.
+std::wstring LogBasePath() {
+  PWSTR local_app_data = nullptr;
+  std::wstring path;
+  if (SUCCEEDED(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr,
+                                     &local_app_data))) {
+    std::wstring folder = std::wstring(local_app_data) + kLogsFolder;
+    int result = SHCreateDirectoryEx(nullptr, folder.c_str(), nullptr);
+    if (result == ERROR_SUCCESS || result == ERROR_ALREADY_EXISTS ||
+        result == ERROR_FILE_EXISTS) {
+      path = folder + kLogBaseName;
+    }
+  }
+  CoTaskMemFree(local_app_data);
+  return path;
+}
+
+// "runner.log" for 0, "runner.N.log" after it, on |base|.
+std::wstring LogName(const std::wstring& base, int index) {
+  return index == 0 ? base + L".log"
+                    : base + L"." + std::to_wstring(index) + L".log";
+}
+
+void AppendTimestamp(const FILETIME& time, std::string* text) {
+  FILETIME local;
+  SYSTEMTIME parts;
+  if (!FileTimeToLocalFileTime(&time, &local) ||
+      !FileTimeToSystemTime(&local, &parts)) {
+    GetLocalTime(&parts);
+  }
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%04d-%02d-%02d %02d:%02d:%02d.%03d",
+           parts.wYear, parts.wMonth, parts.wDay, parts.wHour, parts.wMinute,
+           parts.wSecond, parts.wMilliseconds);
+  text->append(buffer);
+}
+
+bool IsValid(HANDLE handle) {
+  return handle && handle != INVALID_HANDLE_VALUE;
+}
+
+}  // namespace
+
+// static
+LogSink* LogSink::GetInstance() {
+  static LogSink* instance = new LogSink();
+  return instance;
+}
+
+LogSink::LogSink() : slots_(new Slot[kSlotCount]) {
+  for (size_t i = 0; i < kSlotCount; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  wake_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+}
+
+void LogSink::Start() {
+  if (running_.exchange(true)) {
+    return;
+  }
+  Capture(STD_OUTPUT_HANDLE, stdout, "stdout", kInfo, &stdout_);
+  Capture(STD_ERROR_HANDLE, stderr, "stderr", kWarning, &stderr_);
+  echo_ = IsValid(stdout_.original) ? stdout_.original : stderr_.original;
+  writer_ = std::thread(&LogSink::Drain, this);
+}
+
+void LogSink::Stop() {
+  if (!running_) {
+    return;
+  }
+  // Closing the pipes ends their readers once they have read the rest.
+  Release(&stdout_);
+  Release(&stderr_);
+  running_ = false;
+  SetEvent(wake_);
+  writer_.join();
+  if (file_ != INVALID_HANDLE_VALUE) {
+    CloseHandle(file_);
+    file_ = INVALID_HANDLE_VALUE;
+  }
+}
+
+void LogSink::Attach(flutter::BinaryMessenger* messenger) {
+  messenger_ = messenger;
+  messenger_->SetMessageHandler(
+      kChannelName, [this](const uint8_t* message, size_t message_size,
+                           flutter::BinaryReply reply) {
+        HandleMessage(message, message_size);
+        reply(nullptr, 0);
+      });
+}
+
+void LogSink::Detach() {
+  if (messenger_) {
+    messenger_->SetMessageHandler(kChannelName, nullptr);
+    messenger_ = nullptr;
+  }
+}
+
+void LogSink::Write(Level level,
+                    const char* source,
+                    const char* text,
+                    size_t length) {
+  constexpr size_t kSlotText = sizeof(Slot::text);
+  length = std::min<size_t>(length, kMaxRecordSlots * kSlotText);
+  const uint64_t count =
+      length == 0 ? 1 : (length + kSlotText - 1) / kSlotText;
+
+  // Claims |count| slots from |position|. The writer frees slots in order,
+  // so once the last of them is free for this lap, all of them are.
+  uint64_t position = head_.load(std::memory_order_relaxed);
+  for (;;) {
+    const Slot& last = slots_[(position + count - 1) % kSlotCount];
+    auto lag = static_cast<int64_t>(
+        last.sequence.load(std::memory_order_acquire) -
+        (position + count - 1));
+    if (lag == 0) {
+      if (head_.compare_exchange_weak(position, position + count,
+                                      std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (lag < 0) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    } else {
+      position = head_.load(std::memory_order_relaxed);
+    }
+  }
+
+  for (uint64_t i = 0; i < count; ++i) {
+    Slot& slot = slots_[(position + i) % kSlotCount];
+    size_t offset = static_cast<size_t>(i) * kSlotText;
+    slot.length = static_cast<uint16_t>(std::min(kSlotText, length - offset));
+    memcpy(slot.text, text + offset, slot.length);
+  }
+  Slot& first = slots_[position % kSlotCount];
+  first.source = source;
+  first.level = level;
+  first.slots = static_cast<uint8_t>(count);
+  GetSystemTimePreciseAsFileTime(&first.time);
+  // The first slot goes last: once the writer sees it, it sees the rest.
+  for (uint64_t i = count; i-- > 0;) {
+    slots_[(position + i) % kSlotCount].sequence.store(
+        position + i + 1, std::memory_order_release);
+  }
+
+  if (level >= kError ||
+      position + count - tail_.load(std::memory_order_relaxed) >=
+          kSlotCount / 2) {
+    SetEvent(wake_);
+  }
+}
+
+void LogSink::Drain() {
+  path_ = LogBasePath();
+  while (running_) {
+    WaitForSingleObject(wake_, kDrainIntervalMs);
+    WriteRecords();
+  }
+  WriteRecords();
+}
+
+void LogSink::WriteRecords() {
+  std::string batch;
+  std::string message;
+  uint64_t tail = tail_.load(std::memory_order_relaxed);
+  for (;;) {
+    Slot& first = slots_[tail % kSlotCount];
+    if (first.sequence.load(std::memory_order_acquire) != tail + 1) {
+      break;
+    }
+    const uint8_t count = first.slots;
+    message.clear();
+    for (uint64_t i = 0; i < count; ++i) {
+      const Slot& slot = slots_[(tail + i) % kSlotCount];
+      message.append(slot.text, slot.length);
+    }
+
+    AppendTimestamp(first.time, &batch);
+    batch.push_back(' ');
+    batch.push_back(kLevelLetters[first.level]);
+    batch.append(" [");
+    batch.append(first.source);
+    batch.append("] ");
+    batch.append(message);
+    batch.append("\r\n");
+    TraceLoggingWrite(
+        g_runner_trace_provider, "Log",
+        TraceLoggingString(kLevelNames[first.level], "Level"),
+        TraceLoggingString(first.source, "Source"),
+        TraceLoggingFileTime(first.time, "Time"),
+        TraceLoggingCountedUtf8String(message.data(),
+                                      static_cast<USHORT>(message.size()),
+                                      "Message"));
+
+    for (uint64_t i = 0; i < count; ++i) {
+      slots_[(tail + i) % kSlotCount].sequence.store(
+          tail + i + kSlotCount, std::memory_order_release);
+    }
+    tail += count;
+    tail_.store(tail, std::memory_order_relaxed);
+  }
+
+  uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+  if (dropped != reported_dropped_) {
+    FILETIME now;
+    GetSystemTimePreciseAsFileTime(&now);
+    AppendTimestamp(now, &batch);
+    batch.append(" W [log] " + std::to_string(dropped - reported_dropped_) +
+                 " records dropped while the log was full\r\n");
+    reported_dropped_ = dropped;
+  }
+  if (batch.empty()) {
+    return;
+  }
+  WriteToFile(batch);
+  if (IsValid(echo_)) {
+    DWORD written = 0;
+    WriteFile(echo_, batch.data(), static_cast<DWORD>(batch.size()), &written,
+              nullptr);
+  }
+}
+
+void LogSink::WriteToFile(const std::string& text) {
+  if (path_.empty()) {
+    return;
+  }
+  if (file_ != INVALID_HANDLE_VALUE && file_size_ >= kMaxLogBytes) {
+    CloseHandle(file_);
+    file_ = INVALID_HANDLE_VALUE;
+    for (int index = kRolledLogs; index > 0; --index) {
+      MoveFileEx(LogName(path_, index - 1).c_str(),
+                 LogName(path_, index).c_str(), MOVEFILE_REPLACE_EXISTING);
+    }
+  }
+  if (file_ == INVALID_HANDLE_VALUE) {
+    // Another instance, such as a benchmark run, may be appending as well,
+    // and rolling the file over.
+    file_ = CreateFile(LogName(path_, 0).c_str(), FILE_APPEND_DATA,
+                       FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                       nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    LARGE_INTEGER size;
+    if (file_ == INVALID_HANDLE_VALUE || !GetFileSizeEx(file_, &size)) {
+      return;
+    }
+    file_size_ = static_cast<uint64_t>(size.QuadPart);
+  }
+  DWORD written = 0;
+  WriteFile(file_, text.data(), static_cast<DWORD>(text.size()), &written,
+            nullptr);
+  file_size_ += written;
+}
+
+void LogSink::Capture(DWORD std_handle,
+                      FILE* stream,
+                      const char* source,
+                      Level level,
+                      Captured* captured) {
+  captured->original = GetStdHandle(std_handle);
+  HANDLE read = nullptr;
+  HANDLE write = nullptr;
+  if (!CreatePipe(&read, &write, nullptr, kPipeBytes)) {
+    return;
+  }
+  int write_fd = _open_osfhandle(reinterpret_cast<intptr_t>(write), _O_TEXT);
+  if (write_fd < 0) {
+    CloseHandle(read);
+    CloseHandle(write);
+    return;
+  }
+
+  fflush(stream);
+  captured->stream = stream;
+  captured->std_handle = std_handle;
+  captured->saved_fd = _fileno(stream) >= 0 ? _dup(_fileno(stream)) : -1;
+  // Without a console the stream has no descriptor to replace.
+  if (_fileno(stream) < 0) {
+    FILE* unused;
+    freopen_s(&unused, "NUL", "w", stream);
+  }
+  _dup2(write_fd, _fileno(stream));
+  _close(write_fd);
+  // Each write goes straight into the pipe, which costs no more than a
+  // buffer copy until the pipe is full.
+  setvbuf(stream, nullptr, _IONBF, 0);
+  SetStdHandle(std_handle,
+               reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(stream))));
+  captured->reader =
+      std::thread(&LogSink::ReadPipe, this, read, source, level);
+}
+
+void LogSink::Release(Captured* captured) {
+  if (!captured->stream) {
+    return;
+  }
+  fflush(captured->stream);
+  SetStdHandle(captured->std_handle, captured->original);
+  if (captured->saved_fd >= 0) {
+    _dup2(captured->saved_fd, _fileno(captured->stream));
+    _close(captured->saved_fd);
+  } else {
+    FILE* unused;
+    freopen_s(&unused, "NUL", "w", captured->stream);
+  }
+  captured->reader.join();
+  captured->stream = nullptr;
+}
+
+void LogSink::ReadPipe(HANDLE pipe, const char* source, Level level) {
+  std::string pending;
+  char buffer[4096];
+  DWORD bytes_read = 0;
+  while (ReadFile(pipe, buffer, sizeof(buffer), &bytes_read, nullptr) &&
+         bytes_read > 0) {
+    pending.append(buffer, bytes_read);
+    size_t start = 0;
+    for (size_t end; (end = pending.find('\n', start)) != std::string::npos;
+         start = end + 1) {
+      size_t length = end - start;
+      if (length > 0 && pending[start + length - 1] == '\r') {
+        --length;
+      }
+      Write(level, source, pending.data() + start, length);
+    }
+    pending.erase(0, start);
+  }
+  if (!pending.empty()) {
+    Write(level, source, pending);
+  }
+  CloseHandle(pipe);
+}
+
+void LogSink::HandleMessage(const uint8_t* message, size_t message_size) {
+  size_t offset = 0;
+  while (message_size - offset >= 5) {
+    uint8_t level = message[offset];
+    uint32_t length;
+    memcpy(&length, message + offset + 1, sizeof(length));
+    offset += 5;
+    if (length > message_size - offset) {
+      break;
+    }
+    Write(static_cast<Level>(std::min<uint8_t>(level, kFatal)), "dart",
+          reinterpret_cast<const char*>(message + offset), length);
+    offset += length;
+  }
+}
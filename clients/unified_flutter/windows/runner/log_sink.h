@@ -0,0 +1,154 @@
+#ifndef RUNNER_LOG_SINK_H_
+#define RUNNER_LOG_SINK_H_
+
+#include <flutter/binary_messenger.h>
+#include <stdio.h>
+#include <windows.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// The runner's log, which takes records from any thread without blocking it.
+//
+// Records are copied into a fixed ring of slots that producers claim with a
+// compare-and-swap, so logging takes no lock and makes no system call; when
+// the ring is full, records are counted and dropped rather than waited for.
+// A writer thread drains the ring a few times a second, or as soon as an
+// error is logged or the ring fills up, and writes the records to:
+//
+//  * runner.log in %LOCALAPPDATA%\Tamshai Corp\Tamshai AI\Logs, rolled over
+//    at 4 MB through runner.1.log to runner.3.log;
+//  * ETW, as "Log" events with the record's level, source and time;
+//  * the console or pipe the process was started with, if any, so output
+//    still shows under 'flutter run' or a debugger.
+//
+// Dart's logger output arrives over the binary channel "com.tamshai.ai/log"
+// as a batch of records, each a level byte (0 trace to 5 fatal), a
+// little-endian 32-bit length and that many bytes of UTF-8. What the runner
+// and the plugins write to stdout and stderr is captured through pipes.
+class LogSink {
+ public:
+  enum Level : uint8_t {
+    kTrace = 0,
+    kDebug,
+    kInfo,
+    kWarning,
+    kError,
+    kFatal,
+  };
+
+  // Returns the process-wide instance.
+  static LogSink* GetInstance();
+
+  // Prevent copying.
+  LogSink(LogSink const&) = delete;
+  LogSink& operator=(LogSink const&) = delete;
+
+  // Opens the log, starts the writer thread and captures stdout and stderr.
+  // Call once any console has been attached.
+  void Start();
+
+  // Writes out what is left, and gives stdout and stderr back.
+  void Stop();
+
+  // Handles Dart's records on |messenger| until Detach.
+  void Attach(flutter::BinaryMessenger* messenger);
+  void Detach();
+
+  // Logs |length| bytes of UTF-8 |text| from |source|, a string literal.
+  // Safe to call from any thread at any time; records logged before Start
+  // are written once it has been called.
+  void Write(Level level,
+             const char* source,
+             const char* text,
+             size_t length);
+  void Write(Level level, const char* source, const std::string& text) {
+    Write(level, source, text.data(), text.size());
+  }
+
+ private:
+  // One slot of the ring. A record takes as many consecutive slots as its
+  // text needs.
+  struct Slot {
+    // Where the slot is in its lap: its position while free, one past it
+    // once written.
+    std::atomic<uint64_t> sequence;
+    const char* source;
+    FILETIME time;
+    Level level;
+    // Slots the record takes, in its first slot.
+    uint8_t slots;
+    // Bytes of text in this slot.
+    uint16_t length;
+    char text[224];
+  };
+
+  // A standard stream redirected into a pipe.
+  struct Captured {
+    FILE* stream = nullptr;
+    DWORD std_handle = 0;
+    // Where the stream went before, or nullptr.
+    HANDLE original = nullptr;
+    // A duplicate of the stream's descriptor before, or -1.
+    int saved_fd = -1;
+    std::thread reader;
+  };
+
+  static constexpr size_t kSlotCount = 4096;
+
+  LogSink();
+
+  // Body of |writer_|.
+  void Drain();
+
+  // Writes out the records published so far.
+  void WriteRecords();
+
+  // Appends |text| to the log, rolling it over first if it is full.
+  void WriteToFile(const std::string& text);
+
+  // Points |stream| and the std handle |std_handle| at a pipe whose lines
+  // are logged from |source| at |level|.
+  void Capture(DWORD std_handle,
+               FILE* stream,
+               const char* source,
+               Level level,
+               Captured* captured);
+
+  // Points a captured stream back where it went, and waits for its reader.
+  void Release(Captured* captured);
+
+  // Body of the thread reading |pipe|.
+  void ReadPipe(HANDLE pipe, const char* source, Level level);
+
+  void HandleMessage(const uint8_t* message, size_t message_size);
+
+  Slot* slots_;
+  std::atomic<uint64_t> head_{0};
+  std::atomic<uint64_t> tail_{0};
+  std::atomic<uint64_t> dropped_{0};
+  std::atomic<bool> running_{false};
+
+  // Wakes |writer_| before its next round.
+  HANDLE wake_ = nullptr;
+  std::thread writer_;
+
+  // Only touched by |writer_|.
+  std::wstring path_;
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  uint64_t file_size_ = 0;
+  uint64_t reported_dropped_ = 0;
+
+  Captured stdout_;
+  Captured stderr_;
+
+  // Where stdout went before it was captured, or stderr, to copy the records
+  // to. May be nullptr.
+  HANDLE echo_ = nullptr;
+
+  flutter::BinaryMessenger* messenger_ = nullptr;
+};
+
+#endif  // RUNNER_LOG_SINK_H_
@@ -1,43 +1,123 @@
-#include <flutter/dart_project.h>
-#include <flutter/flutter_view_controller.h>
 #include <windows.h>
 
-#include "flutter_window.h"
+#include "benchmark.h"
+#include "connection_prewarmer.h"
+#include "hang_watchdog.h"
+#include "log_sink.h"
+#include "main_window.h"
+#include "runner_engine.h"
+#include "run_loop.h"
+#include "runner_trace.h"
+#include "single_instance.h"
+#include "startup_prefetch.h"
+#include "system_settings.h"
+#include "token_vault.h"
 #include "utils.h"
+#include "worker_pool.h"
 
 int APIENTRY wWinMain(_In_ HINSTANCE instance, _In_opt_ HINSTANCE prev,
                       _In_ wchar_t *command_line, _In_ int show_command) {
+  RegisterRunnerTraceProvider();
+
+  // Benchmark launches from tamshai_ai_bench run on their own, beside any
+  // instance that is already running.
+  std::unique_ptr<Benchmark> benchmark =
+      Benchmark::FromArguments(GetCommandLineArguments());
+
+  // If the app is already running, hand this launch's arguments to it and
+  // exit before doing any engine work. If the running instance can't be
+  // reached, start normally.
+  SingleInstance* single_instance = SingleInstance::GetInstance();
+  if (!benchmark) {
+    if (!single_instance->AcquirePrimary() &&
+        single_instance->ForwardToPrimary(GetCommandLineArguments())) {
+      UnregisterRunnerTraceProvider();
+      return EXIT_SUCCESS;
+    }
+    single_instance->StartListening();
+  }
+
+  // Connect to the gateway the last launch used while the engine boots, so
+  // that the first query doesn't wait on DNS, TCP and TLS.
+  ConnectionPrewarmer::GetInstance()->Start();
+
+  // Pull the snapshot, ICU data and assets into the file cache, so that the
+  // engine's page faults on them below don't each wait on the disk.
+  StartupPrefetch::GetInstance()->Start(L"data");
+
+  // Shared by the runner's components that work off the platform thread.
+  WorkerPool::GetInstance()->Start();
+
+  // Decrypt the stored tokens while the engine starts and the window is
+  // created, so that Dart's first read of them doesn't wait on DPAPI.
+  TokenVault::GetInstance()->Prefetch();
+
   // Attach to console when present (e.g., 'flutter run') or create a
   // new console when running with a debugger.
   if (!::AttachConsole(ATTACH_PARENT_PROCESS) && ::IsDebuggerPresent()) {
     CreateAndAttachConsole();
   }
+  // Take over stdout and stderr, so that what the runner and Dart log
+  // reaches the console, and the log file, from the log's own thread.
+  LogSink::GetInstance()->Start();
 
   // Initialize COM, so that it is available for use in the library and/or
-  // plugins.
-  ::CoInitializeEx(nullptr, COINIT_APARTMENTTHREADED);
-
-  flutter::DartProject project(L"data");
-
-  std::vector<std::string> command_line_arguments =
-      GetCommandLineArguments();
+  // plugins, along with the OLE drag and drop the main window accepts files
+  // through.
+  {
+    TraceSpan span("OleInitialize");
+    ::OleInitialize(nullptr);
+  }
 
-  project.set_dart_entrypoint_arguments(std::move(command_line_arguments));
+  // Start the engine before creating the window, so that the snapshot and
+  // isolate load on the engine's threads while the window is being created.
+  TraceSpan engine_span("EngineStart");
+  std::unique_ptr<RunnerEngine> engine =
+      RunnerEngine::Start(L"data", GetCommandLineArguments());
+  engine_span.End();
+  if (!engine) {
+    WorkerPool::GetInstance()->Stop();
+    ConnectionPrewarmer::GetInstance()->Stop();
+    LogSink::GetInstance()->Stop();
+    UnregisterRunnerTraceProvider();
+    return EXIT_FAILURE;
+  }
 
-  FlutterWindow window(project);
+  RunLoop run_loop;
+  // Declared after the loop, whose dispatches it times.
+  HangWatchdog watchdog(HangWatchdog::ThresholdsFromEnvironment());
+  run_loop.SetWatchdog(&watchdog);
+  SystemSettings::GetInstance()->Watch(&run_loop);
+  // Declared after the engine, so that the window and its views go first.
+  MainWindow window(engine.get());
   Win32Window::Point origin(10, 10);
   Win32Window::Size size(1280, 720);
+  window.SetPlacementName(L"Main");
+  // Closing only hides the window, so that reopening it is not another cold
+  // start. Benchmark launches measure that start, and close when done.
+  window.SetTrayResident(!benchmark);
   if (!window.Create(L"Tamshai AI", origin, size)) {
+    WorkerPool::GetInstance()->Stop();
+    ConnectionPrewarmer::GetInstance()->Stop();
+    LogSink::GetInstance()->Stop();
+    UnregisterRunnerTraceProvider();
     return EXIT_FAILURE;
   }
   window.SetQuitOnClose(true);
-
-  ::MSG msg;
-  while (::GetMessage(&msg, nullptr, 0, 0)) {
-    ::TranslateMessage(&msg);
-    ::DispatchMessage(&msg);
+  if (benchmark) {
+    benchmark->Attach(window.GetHandle(), engine.get(), &run_loop,
+                      window.frame_telemetry());
   }
 
-  ::CoUninitialize();
+  run_loop.Run();
+
+  SystemSettings::GetInstance()->StopWatching();
+  single_instance->StopListening();
+  ::OleUninitialize();
+  // After the window, whose plugins post to the pool.
+  WorkerPool::GetInstance()->Stop();
+  ConnectionPrewarmer::GetInstance()->Stop();
+  LogSink::GetInstance()->Stop();
+  UnregisterRunnerTraceProvider();
   return EXIT_SUCCESS;
 }
@@ -0,0 +1,158 @@
+#include "main_window.h"
+
+#include "certificate_pinner.h"
+#include "connection_prewarmer.h"
+#include "log_sink.h"
+#include "memory_telemetry.h"
+#include "memory_trimmer.h"
+#include "runner_trace.h"
+#include "startup_prefetch.h"
+#include "system_settings.h"
+
+MainWindow::MainWindow(RunnerEngine* engine) : FlutterWindow(engine) {}
+
+MainWindow::~MainWindow() {}
+
+void MainWindow::SetTrayResident(bool tray_resident) {
+  tray_resident_ = tray_resident;
+}
+
+bool MainWindow::OnCreate() {
+  if (!FlutterWindow::OnCreate()) {
+    return false;
+  }
+
+  plugin_loader_ =
+      std::make_unique<PluginLoader>(engine(), engine()->messenger());
+  {
+    TraceSpan span("RegisterPlugins");
+    plugin_loader_->RegisterEagerPlugins();
+  }
+  LogSink::GetInstance()->Attach(engine()->messenger());
+  CertificatePinner::GetInstance()->Attach(engine()->messenger());
+  task_queue_ = std::make_unique<PlatformTaskQueue>();
+  document_ingest_plugin_ = std::make_unique<DocumentIngestPlugin>(
+      engine()->messenger(), task_queue_.get());
+  sse_stream_plugin_ = std::make_unique<SseStreamPlugin>(
+      engine()->messenger(), task_queue_.get(), document_ingest_plugin_.get());
+  SetFileDropHandler([this](const std::vector<std::wstring>& paths) {
+    document_ingest_plugin_->IngestDroppedFiles(paths);
+  });
+  activation_plugin_ = std::make_unique<ActivationPlugin>(
+      engine()->messenger(), task_queue_.get(),
+      [this]() { Reopen("launch"); });
+  oauth_callback_plugin_ = std::make_unique<OAuthCallbackPlugin>(
+      engine()->messenger(), task_queue_.get());
+  json_decoder_plugin_ = std::make_unique<JsonDecoderPlugin>(
+      engine()->messenger(), task_queue_.get());
+  token_vault_plugin_ = std::make_unique<TokenVaultPlugin>(
+      engine()->messenger(), task_queue_.get());
+  response_cache_plugin_ = std::make_unique<ResponseCachePlugin>(
+      engine()->messenger(), task_queue_.get());
+  data_table_plugin_ = std::make_unique<DataTablePlugin>(
+      engine()->messenger(), task_queue_.get());
+  frame_telemetry_plugin_ =
+      std::make_unique<FrameTelemetryPlugin>(engine()->messenger());
+  audio_capture_plugin_ = std::make_unique<AudioCapturePlugin>(
+      engine()->messenger(), task_queue_.get());
+  multi_window_plugin_ =
+      std::make_unique<MultiWindowPlugin>(engine(), task_queue_.get());
+  MemoryTrimmer::GetInstance()->Attach(engine());
+  ConnectionPrewarmer::GetInstance()->Attach(engine()->messenger());
+  MemoryTelemetry::GetInstance()->Attach(engine()->messenger(),
+                                         task_queue_.get());
+  if (tray_resident_) {
+    tray_icon_ = std::make_unique<TrayIcon>(
+        GetHandle(), [this](const char* source) { Reopen(source); },
+        [this]() { Quit(); });
+  }
+  return true;
+}
+
+void MainWindow::OnDestroy() {
+  // The other windows go with this one, and runner plugins hold channels on
+  // the engine's messenger, so all of them go before the view does.
+  tray_icon_ = nullptr;
+  MemoryTelemetry::GetInstance()->Detach();
+  ConnectionPrewarmer::GetInstance()->Detach();
+  MemoryTrimmer::GetInstance()->Detach();
+  multi_window_plugin_ = nullptr;
+  audio_capture_plugin_ = nullptr;
+  frame_telemetry_plugin_ = nullptr;
+  data_table_plugin_ = nullptr;
+  response_cache_plugin_ = nullptr;
+  token_vault_plugin_ = nullptr;
+  json_decoder_plugin_ = nullptr;
+  oauth_callback_plugin_ = nullptr;
+  activation_plugin_ = nullptr;
+  sse_stream_plugin_ = nullptr;
+  document_ingest_plugin_ = nullptr;
+  task_queue_ = nullptr;
+  plugin_loader_ = nullptr;
+  CertificatePinner::GetInstance()->Detach();
+  LogSink::GetInstance()->Detach();
+
+  FlutterWindow::OnDestroy();
+}
+
+void MainWindow::OnFirstFrame() {
+  // Startup is over for the files it prefetched.
+  StartupPrefetch* prefetch = StartupPrefetch::GetInstance();
+  prefetch->Finish();
+  if (prefetch->recording()) {
+    // The launch only existed to write the manifest.
+    Quit();
+  }
+}
+
+void MainWindow::OnSystemSettingsChanged(unsigned int changes) {
+  FlutterWindow::OnSystemSettingsChanged(changes);
+  // Only once for the engine, however many windows share it.
+  if ((changes & SystemSettings::kFontChange) && engine()) {
+    engine()->ReloadSystemFonts();
+  }
+}
+
+LRESULT
+MainWindow::MessageHandler(HWND hwnd, UINT const message, WPARAM const wparam,
+                           LPARAM const lparam) noexcept {
+  if (tray_icon_) {
+    if (tray_icon_->HandleMessage(message, wparam, lparam)) {
+      return 0;
+    }
+    // Before the view and its plugins, so that none takes it for an exit.
+    if (message == WM_CLOSE) {
+      HideToTray();
+      return 0;
+    }
+  }
+  return FlutterWindow::MessageHandler(hwnd, message, wparam, lparam);
+}
+
+void MainWindow::HideToTray() {
+  if (hidden_to_tray_) {
+    return;
+  }
+  hidden_to_tray_ = true;
+  TraceLoggingWrite(g_runner_trace_provider, "TrayHide");
+  // The visibility tracker sees the window go, and stops frames once no
+  // window of the app is left in sight.
+  ShowWindow(GetHandle(), SW_HIDE);
+  MemoryTrimmer::GetInstance()->TrimIfHidden("tray");
+}
+
+void MainWindow::Reopen(const char* source) {
+  TraceLoggingWrite(g_runner_trace_provider, "TrayReopen",
+                    TraceLoggingString(source, "Source"),
+                    TraceLoggingBoolean(hidden_to_tray_, "WasHidden"));
+  if (hidden_to_tray_) {
+    hidden_to_tray_ = false;
+    ShowWindow(GetHandle(), SW_SHOW);
+  }
+  BringToFront();
+}
+
+void MainWindow::Quit() {
+  tray_icon_ = nullptr;
+  PostMessage(GetHandle(), WM_CLOSE, 0, 0);
+}
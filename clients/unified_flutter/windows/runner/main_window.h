@@ -0,0 +1,113 @@
+#ifndef RUNNER_MAIN_WINDOW_H_
+#define RUNNER_MAIN_WINDOW_H_
+
+#include <memory>
+
+#include "activation_plugin.h"
+#include "audio_capture_plugin.h"
+#include "data_table_plugin.h"
+#include "document_ingest_plugin.h"
+#include "flutter_window.h"
+#include "frame_telemetry_plugin.h"
+#include "json_decoder_plugin.h"
+#include "multi_window_plugin.h"
+#include "oauth_callback_plugin.h"
+#include "platform_task_queue.h"
+#include "plugin_loader.h"
+#include "response_cache_plugin.h"
+#include "runner_engine.h"
+#include "sse_stream_plugin.h"
+#include "token_vault_plugin.h"
+#include "tray_icon.h"
+
+// The app's first window, which hosts the implicit view and the runner
+// plugins for the engine it shares with any further windows.
+class MainWindow : public FlutterWindow {
+ public:
+  // Creates the main window for |engine|, which must outlive it.
+  explicit MainWindow(RunnerEngine* engine);
+  ~MainWindow() override;
+
+  // If true, closing the window only hides it, leaving the engine running
+  // and a tray icon to reopen it from, until the user quits from the icon's
+  // menu. Must be called before |Create|.
+  void SetTrayResident(bool tray_resident);
+
+  // The frame timings Dart has reported, once the window has been created.
+  const FrameTelemetry* frame_telemetry() const {
+    return frame_telemetry_plugin_ ? frame_telemetry_plugin_->telemetry()
+                                   : nullptr;
+  }
+
+ protected:
+  // FlutterWindow:
+  bool OnCreate() override;
+  void OnDestroy() override;
+  void OnFirstFrame() override;
+  void OnSystemSettingsChanged(unsigned int changes) override;
+  LRESULT MessageHandler(HWND window, UINT const message, WPARAM const wparam,
+                         LPARAM const lparam) noexcept override;
+
+ private:
+  // Hides the window in place of closing it, and trims memory while it is
+  // away.
+  void HideToTray();
+
+  // Shows the window again if it was hidden to the tray, and brings it to
+  // the front. |source| says how the user asked, for the trace.
+  void Reopen(const char* source);
+
+  // Closes the window for good, quitting the app.
+  void Quit();
+
+  bool tray_resident_ = false;
+
+  // Whether the window is hidden to the tray.
+  bool hidden_to_tray_ = false;
+
+  // Present while closing hides the window.
+  std::unique_ptr<TrayIcon> tray_icon_;
+
+  // Registers the app's plugins, deferring those the first frame can do
+  // without.
+  std::unique_ptr<PluginLoader> plugin_loader_;
+
+  // Runs results from runner worker threads on the platform thread.
+  std::unique_ptr<PlatformTaskQueue> task_queue_;
+
+  // Reads documents attached to chat messages, for the SSE transport to
+  // send.
+  std::unique_ptr<DocumentIngestPlugin> document_ingest_plugin_;
+
+  // Native transport for the MCP Gateway's SSE responses.
+  std::unique_ptr<SseStreamPlugin> sse_stream_plugin_;
+
+  // Forwards command lines from later launches to Dart.
+  std::unique_ptr<ActivationPlugin> activation_plugin_;
+
+  // Loopback listener for the desktop OAuth redirect.
+  std::unique_ptr<OAuthCallbackPlugin> oauth_callback_plugin_;
+
+  // Parses large API responses off the UI isolate.
+  std::unique_ptr<JsonDecoderPlugin> json_decoder_plugin_;
+
+  // Encrypted token bundle, read and written in one call.
+  std::unique_ptr<TokenVaultPlugin> token_vault_plugin_;
+
+  // On-disk cache of generative component responses, shared by the windows.
+  std::unique_ptr<ResponseCachePlugin> response_cache_plugin_;
+
+  // Native columnar filtering, sorting and paging for large lead lists.
+  std::unique_ptr<DataTablePlugin> data_table_plugin_;
+
+  // Frame pacing and jank telemetry reported by Dart.
+  std::unique_ptr<FrameTelemetryPlugin> frame_telemetry_plugin_;
+
+  // Low-latency microphone capture for voice input.
+  std::unique_ptr<AudioCapturePlugin> audio_capture_plugin_;
+
+  // Opens the chat, approvals and dashboard windows on the same engine.
+  std::unique_ptr<MultiWindowPlugin> multi_window_plugin_;
+};
+
+#endif  // RUNNER_MAIN_WINDOW_H_
@@ -0,0 +1,318 @@
+#include "memory_telemetry.h"
+
+#include <flutter/standard_method_codec.h>
+#include <psapi.h>
+
+#include <utility>
+
+#include "runner_trace.h"
+#include "utils.h"
+
+namespace {
+
+constexpr char kMethodChannelName[] = "com.tamshai.ai/memory_telemetry";
+
+constexpr UINT kSampleIntervalMs = 30 * 1000;
+
+// How long after a marker to sample, so that a burst of resizes during a
+// drag is measured once, after the engine has reallocated its surfaces.
+constexpr UINT kSettleMs = 1000;
+
+// An hour of samples at the interval, with room for those after markers.
+constexpr size_t kMaxSamples = 240;
+constexpr size_t kMaxMarkers = 256;
+
+using flutter::EncodableList;
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+int64_t NowMs() {
+  FILETIME now;
+  GetSystemTimeAsFileTime(&now);
+  ULARGE_INTEGER ticks;
+  ticks.LowPart = now.dwLowDateTime;
+  ticks.HighPart = now.dwHighDateTime;
+  // From 100 ns intervals since 1601 to milliseconds since 1970.
+  return static_cast<int64_t>((ticks.QuadPart - 116444736000000000ULL) /
+                              10000);
+}
+
+EncodableValue Bytes(uint64_t value) {
+  return EncodableValue(static_cast<int64_t>(value));
+}
+
+EncodableValue SampleToValue(const MemoryTelemetry::Sample& sample) {
+  EncodableList gpu;
+  for (const MemoryTelemetry::GpuUse& use : sample.gpu) {
+    gpu.push_back(EncodableValue(EncodableMap{
+        {EncodableValue("adapter"), EncodableValue(use.adapter)},
+        {EncodableValue("localBytes"), Bytes(use.local_bytes)},
+        {EncodableValue("localBudgetBytes"), Bytes(use.local_budget_bytes)},
+        {EncodableValue("nonLocalBytes"), Bytes(use.non_local_bytes)},
+    }));
+  }
+  return EncodableValue(EncodableMap{
+      {EncodableValue("timeMs"), EncodableValue(sample.time_ms)},
+      {EncodableValue("privateBytes"), Bytes(sample.private_bytes)},
+      {EncodableValue("peakPrivateBytes"), Bytes(sample.peak_private_bytes)},
+      {EncodableValue("workingSet"), Bytes(sample.working_set)},
+      {EncodableValue("peakWorkingSet"), Bytes(sample.peak_working_set)},
+      {EncodableValue("handles"),
+       EncodableValue(static_cast<int32_t>(sample.handles))},
+      {EncodableValue("gdiObjects"),
+       EncodableValue(static_cast<int32_t>(sample.gdi_objects))},
+      {EncodableValue("userObjects"),
+       EncodableValue(static_cast<int32_t>(sample.user_objects))},
+      {EncodableValue("gpu"), EncodableValue(std::move(gpu))},
+  });
+}
+
+EncodableValue MarkerToValue(const MemoryTelemetry::Marker& marker) {
+  EncodableMap value{
+      {EncodableValue("timeMs"), EncodableValue(marker.time_ms)},
+      {EncodableValue("kind"), EncodableValue(marker.kind)},
+  };
+  if (marker.dpi != 0) {
+    value[EncodableValue("width")] = EncodableValue(marker.width);
+    value[EncodableValue("height")] = EncodableValue(marker.height);
+    value[EncodableValue("dpi")] =
+        EncodableValue(static_cast<int32_t>(marker.dpi));
+  }
+  return EncodableValue(std::move(value));
+}
+
+}  // namespace
+
+// static
+MemoryTelemetry* MemoryTelemetry::GetInstance() {
+  static MemoryTelemetry* instance = new MemoryTelemetry();
+  return instance;
+}
+
+void MemoryTelemetry::Attach(flutter::BinaryMessenger* messenger,
+                             PlatformTaskQueue* task_queue) {
+  task_queue_ = task_queue;
+  alive_ = std::make_shared<bool>(true);
+  sample_sequence_ = std::make_unique<WorkerPool::Sequence>(
+      WorkerPool::Priority::kBackground);
+  method_channel_ =
+      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+          messenger, kMethodChannelName,
+          &flutter::StandardMethodCodec::GetInstance());
+  method_channel_->SetMethodCallHandler(
+      [this](const auto& call, auto result) {
+        HandleMethodCall(call, std::move(result));
+      });
+  interval_timer_ =
+      SetTimer(nullptr, 0, kSampleIntervalMs, &MemoryTelemetry::OnTimer);
+  // The first sample is the baseline the session grows from.
+  PostSample(0);
+}
+
+void MemoryTelemetry::Detach() {
+  if (!method_channel_) {
+    return;
+  }
+  KillTimer(nullptr, interval_timer_);
+  interval_timer_ = 0;
+  if (settle_timer_ != 0) {
+    KillTimer(nullptr, settle_timer_);
+    settle_timer_ = 0;
+  }
+  method_channel_->SetMethodCallHandler(nullptr);
+  method_channel_ = nullptr;
+  sample_sequence_ = nullptr;
+  alive_.reset();
+  pending_results_.clear();
+  task_queue_ = nullptr;
+}
+
+void MemoryTelemetry::MarkSurface(const char* kind,
+                                  HWND window,
+                                  int32_t width,
+                                  int32_t height) {
+  Marker marker;
+  marker.kind = kind;
+  marker.width = width;
+  marker.height = height;
+  marker.dpi = GetDpiForWindow(window);
+  Record(std::move(marker));
+}
+
+void MemoryTelemetry::Mark(const char* kind) {
+  Marker marker;
+  marker.kind = kind;
+  Record(std::move(marker));
+}
+
+// static
+void CALLBACK MemoryTelemetry::OnTimer(HWND window,
+                                       UINT message,
+                                       UINT_PTR timer_id,
+                                       DWORD time) {
+  MemoryTelemetry* that = GetInstance();
+  if (timer_id == that->settle_timer_) {
+    KillTimer(nullptr, that->settle_timer_);
+    that->settle_timer_ = 0;
+  } else if (timer_id != that->interval_timer_) {
+    return;
+  }
+  that->PostSample(0);
+}
+
+void MemoryTelemetry::Record(Marker marker) {
+  marker.time_ms = NowMs();
+  TraceLoggingWrite(g_runner_trace_provider, "MemoryMarker",
+                    TraceLoggingString(marker.kind.c_str(), "Kind"),
+                    TraceLoggingInt32(marker.width, "Width"),
+                    TraceLoggingInt32(marker.height, "Height"),
+                    TraceLoggingUInt32(marker.dpi, "Dpi"));
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    markers_.push_back(std::move(marker));
+    if (markers_.size() > kMaxMarkers) {
+      markers_.pop_front();
+    }
+  }
+  if (method_channel_) {
+    // Re-arming with the same id pushes the sample back.
+    settle_timer_ =
+        SetTimer(nullptr, settle_timer_, kSettleMs, &MemoryTelemetry::OnTimer);
+  }
+}
+
+void MemoryTelemetry::PostSample(int64_t job_id) {
+  if (!sample_sequence_) {
+    return;
+  }
+  std::weak_ptr<bool> alive = alive_;
+  PlatformTaskQueue* task_queue = task_queue_;
+  sample_sequence_->Post([this, alive, job_id, task_queue]() {
+    Sample sample = TakeSample();
+    TraceLoggingWrite(
+        g_runner_trace_provider, "MemorySample",
+        TraceLoggingUInt64(sample.private_bytes, "PrivateBytes"),
+        TraceLoggingUInt64(sample.peak_private_bytes, "PeakPrivateBytes"),
+        TraceLoggingUInt64(sample.working_set, "WorkingSet"),
+        TraceLoggingUInt64(sample.peak_working_set, "PeakWorkingSet"),
+        TraceLoggingUInt32(sample.handles, "Handles"),
+        TraceLoggingUInt32(sample.gdi_objects, "GdiObjects"),
+        TraceLoggingUInt32(sample.user_objects, "UserObjects"));
+    for (const GpuUse& use : sample.gpu) {
+      TraceLoggingWrite(
+          g_runner_trace_provider, "GpuMemory",
+          TraceLoggingString(use.adapter.c_str(), "Adapter"),
+          TraceLoggingUInt64(use.local_bytes, "LocalBytes"),
+          TraceLoggingUInt64(use.local_budget_bytes, "LocalBudgetBytes"),
+          TraceLoggingUInt64(use.non_local_bytes, "NonLocalBytes"));
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      samples_.push_back(sample);
+      if (samples_.size() > kMaxSamples) {
+        samples_.pop_front();
+      }
+    }
+    if (job_id == 0) {
+      return;
+    }
+    task_queue->PostTask([this, alive, job_id, sample]() {
+      if (!alive.lock()) {
+        return;
+      }
+      auto it = pending_results_.find(job_id);
+      if (it == pending_results_.end()) {
+        return;
+      }
+      Result pending = std::move(it->second);
+      pending_results_.erase(it);
+      pending->Success(SampleToValue(sample));
+    });
+  });
+}
+
+MemoryTelemetry::Sample MemoryTelemetry::TakeSample() {
+  Sample sample;
+  sample.time_ms = NowMs();
+  HANDLE process = GetCurrentProcess();
+  PROCESS_MEMORY_COUNTERS_EX counters{};
+  counters.cb = sizeof(counters);
+  if (GetProcessMemoryInfo(
+          process, reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters),
+          sizeof(counters))) {
+    sample.private_bytes = counters.PrivateUsage;
+    // The commit charge's peak; PrivateUsage has no peak of its own.
+    sample.peak_private_bytes = counters.PeakPagefileUsage;
+    sample.working_set = counters.WorkingSetSize;
+    sample.peak_working_set = counters.PeakWorkingSetSize;
+  }
+  DWORD handles = 0;
+  if (GetProcessHandleCount(process, &handles)) {
+    sample.handles = handles;
+  }
+  sample.gdi_objects = GetGuiResources(process, GR_GDIOBJECTS);
+  sample.user_objects = GetGuiResources(process, GR_USEROBJECTS);
+
+  // A factory stops listing adapters added or removed after it was made,
+  // e.g. an external GPU, so it is replaced once it is out of date.
+  if (!factory_ || !factory_->IsCurrent()) {
+    factory_.Reset();
+    if (FAILED(CreateDXGIFactory1(IID_PPV_ARGS(&factory_)))) {
+      factory_.Reset();
+      return sample;
+    }
+  }
+  Microsoft::WRL::ComPtr<IDXGIAdapter1> adapter;
+  for (UINT i = 0; factory_->EnumAdapters1(i, &adapter) == S_OK; ++i) {
+    DXGI_ADAPTER_DESC1 description;
+    Microsoft::WRL::ComPtr<IDXGIAdapter3> adapter3;
+    if (FAILED(adapter->GetDesc1(&description)) ||
+        (description.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) ||
+        FAILED(adapter.As(&adapter3))) {
+      continue;
+    }
+    DXGI_QUERY_VIDEO_MEMORY_INFO local;
+    DXGI_QUERY_VIDEO_MEMORY_INFO non_local;
+    if (FAILED(adapter3->QueryVideoMemoryInfo(
+            0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &local)) ||
+        FAILED(adapter3->QueryVideoMemoryInfo(
+            0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &non_local))) {
+      continue;
+    }
+    GpuUse use;
+    use.adapter = Utf8FromUtf16(description.Description);
+    use.local_bytes = local.CurrentUsage;
+    use.local_budget_bytes = local.Budget;
+    use.non_local_bytes = non_local.CurrentUsage;
+    sample.gpu.push_back(std::move(use));
+  }
+  return sample;
+}
+
+void MemoryTelemetry::HandleMethodCall(
+    const flutter::MethodCall<flutter::EncodableValue>& call,
+    Result result) {
+  if (call.method_name() == "history") {
+    EncodableList samples;
+    EncodableList markers;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const Sample& sample : samples_) {
+        samples.push_back(SampleToValue(sample));
+      }
+      for (const Marker& marker : markers_) {
+        markers.push_back(MarkerToValue(marker));
+      }
+    }
+    result->Success(EncodableValue(EncodableMap{
+        {EncodableValue("samples"), EncodableValue(std::move(samples))},
+        {EncodableValue("markers"), EncodableValue(std::move(markers))},
+    }));
+  } else if (call.method_name() == "sample") {
+    int64_t id = next_job_id_++;
+    pending_results_[id] = std::move(result);
+    PostSample(id);
+  } else {
+    result->NotImplemented();
+  }
+}
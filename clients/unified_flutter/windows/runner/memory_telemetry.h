@@ -0,0 +1,146 @@
+#ifndef RUNNER_MEMORY_TELEMETRY_H_
+#define RUNNER_MEMORY_TELEMETRY_H_
+
+#include <dxgi1_4.h>
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/method_channel.h>
+#include <windows.h>
+#include <wrl/client.h>
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "platform_task_queue.h"
+#include "worker_pool.h"
+
+// Samples the process's memory use, so that sessions that grow can be
+// traced to leaks or oversized surfaces in the field.
+//
+// While attached, a sample is taken every thirty seconds and shortly after
+// each marker, on the worker pool: private bytes (the commit charge) and
+// the working set with their peaks, handle, GDI and USER object counts, and
+// the dedicated and shared GPU memory this process uses on each adapter, as
+// DXGI reports it. Markers note what may explain a change: window surfaces
+// resized on WM_SIZE or WM_DPICHANGED, trims and restores, and the app
+// being hidden or shown. Samples are written to ETW as "MemorySample" and
+// "GpuMemory" events, and markers as "MemoryMarker" events; the last of
+// each are kept for Dart.
+//
+// Method channel "com.tamshai.ai/memory_telemetry":
+//   history() - {samples, markers}, oldest first.
+//   sample()  - takes a sample now and returns it.
+class MemoryTelemetry {
+ public:
+  struct GpuUse {
+    std::string adapter;
+    uint64_t local_bytes = 0;
+    uint64_t local_budget_bytes = 0;
+    uint64_t non_local_bytes = 0;
+  };
+
+  struct Sample {
+    // Milliseconds since the Unix epoch.
+    int64_t time_ms = 0;
+    uint64_t private_bytes = 0;
+    uint64_t peak_private_bytes = 0;
+    uint64_t working_set = 0;
+    uint64_t peak_working_set = 0;
+    uint32_t handles = 0;
+    uint32_t gdi_objects = 0;
+    uint32_t user_objects = 0;
+    std::vector<GpuUse> gpu;
+  };
+
+  struct Marker {
+    int64_t time_ms = 0;
+    // "resize", "dpi", "trim", "restore", "hidden" or "shown".
+    std::string kind;
+    // For surfaces, the new size in physical pixels and the DPI.
+    int32_t width = 0;
+    int32_t height = 0;
+    uint32_t dpi = 0;
+  };
+
+  // Returns the process-wide instance.
+  static MemoryTelemetry* GetInstance();
+
+  // Prevent copying.
+  MemoryTelemetry(MemoryTelemetry const&) = delete;
+  MemoryTelemetry& operator=(MemoryTelemetry const&) = delete;
+
+  // Starts sampling, and handles calls on |messenger| until Detach.
+  void Attach(flutter::BinaryMessenger* messenger,
+              PlatformTaskQueue* task_queue);
+  // Stops sampling, waiting for a sample in progress.
+  void Detach();
+
+  // Notes that |window|'s client area is now |width| by |height|, after a
+  // |kind| "resize" or "dpi" change. Platform thread only.
+  void MarkSurface(const char* kind,
+                   HWND window,
+                   int32_t width,
+                   int32_t height);
+
+  // Notes a |kind| of event that may change memory use. Platform thread
+  // only.
+  void Mark(const char* kind);
+
+ private:
+  using Result =
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>;
+
+  MemoryTelemetry() = default;
+
+  static void CALLBACK OnTimer(HWND window,
+                               UINT message,
+                               UINT_PTR timer_id,
+                               DWORD time);
+
+  void Record(Marker marker);
+
+  // Takes a sample on |sample_sequence_|, then completes |job_id|'s call,
+  // if any, on the platform thread.
+  void PostSample(int64_t job_id);
+
+  // Reads the counters. |sample_sequence_| only.
+  Sample TakeSample();
+
+  void HandleMethodCall(
+      const flutter::MethodCall<flutter::EncodableValue>& call,
+      Result result);
+
+  PlatformTaskQueue* task_queue_ = nullptr;
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>>
+      method_channel_;
+
+  // Calls waiting for a sample, by job id. Platform thread only.
+  std::map<int64_t, Result> pending_results_;
+  int64_t next_job_id_ = 1;
+
+  UINT_PTR interval_timer_ = 0;
+  // Fires once, shortly after the last marker.
+  UINT_PTR settle_timer_ = 0;
+
+  // Kept for the adapters' lifetime. |sample_sequence_| only.
+  Microsoft::WRL::ComPtr<IDXGIFactory1> factory_;
+
+  std::mutex mutex_;
+  // Guarded by |mutex_|.
+  std::deque<Sample> samples_;
+  std::deque<Marker> markers_;
+
+  // Expires on Detach, so callbacks still queued on the platform thread can
+  // tell they arrived too late.
+  std::shared_ptr<bool> alive_;
+
+  // While attached. Destroyed first on Detach, so no sample outlives it.
+  std::unique_ptr<WorkerPool::Sequence> sample_sequence_;
+};
+
+#endif  // RUNNER_MEMORY_TELEMETRY_H_
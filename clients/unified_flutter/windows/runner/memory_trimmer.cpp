@@ -0,0 +1,329 @@
+#include "memory_trimmer.h"
+
+#include <psapi.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "memory_telemetry.h"
+#include "runner_trace.h"
+#include "worker_pool.h"
+
+namespace {
+
+// Channel the framework takes memory pressure notifications on, as JSON.
+constexpr char kSystemChannel[] = "flutter/system";
+constexpr char kMemoryPressureMessage[] = "{\"type\":\"memoryPressure\"}";
+
+// How often the session's input is checked while the app is in use, and how
+// long without any counts as idle.
+constexpr UINT kIdleCheckMs = 60 * 1000;
+constexpr DWORD kIdleTrimMs = 15 * 60 * 1000;
+
+// How long every window must stay hidden before a trim, so that a quick
+// minimize and restore costs nothing.
+constexpr UINT kHiddenTrimDelayMs = 30 * 1000;
+
+// Time for the framework to drop its caches before the working set goes.
+constexpr UINT kPressureSettleMs = 2 * 1000;
+
+// How often the input is checked after an idle trim, to restore promptly.
+constexpr UINT kInputPollMs = 1000;
+
+struct MemoryUse {
+  uint64_t private_bytes = 0;
+  uint64_t working_set = 0;
+};
+
+MemoryUse ReadMemoryUse() {
+  PROCESS_MEMORY_COUNTERS_EX counters{};
+  counters.cb = sizeof(counters);
+  MemoryUse use;
+  if (GetProcessMemoryInfo(
+          GetCurrentProcess(),
+          reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters),
+          sizeof(counters))) {
+    use.private_bytes = counters.PrivateUsage;
+    use.working_set = counters.WorkingSetSize;
+  }
+  return use;
+}
+
+// Tick count of the session's last input.
+DWORD LastInputTick() {
+  LASTINPUTINFO info{};
+  info.cbSize = sizeof(info);
+  return GetLastInputInfo(&info) ? info.dwTime : GetTickCount();
+}
+
+int64_t PerformanceCounter() {
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  return now.QuadPart;
+}
+
+double TicksToMs(int64_t ticks) {
+  LARGE_INTEGER frequency;
+  QueryPerformanceFrequency(&frequency);
+  return static_cast<double>(ticks) * 1000.0 /
+         static_cast<double>(frequency.QuadPart);
+}
+
+// Returns the pages in the working set, merged into runs.
+std::vector<WIN32_MEMORY_RANGE_ENTRY> ResidentRanges() {
+  SYSTEM_INFO system_info;
+  GetSystemInfo(&system_info);
+  const uintptr_t page_size = system_info.dwPageSize;
+
+  // The first call only reports the size; the working set may grow a little
+  // before the second.
+  std::vector<ULONG_PTR> buffer(2);
+  for (int attempt = 0; attempt < 2; ++attempt) {
+    DWORD size = static_cast<DWORD>(buffer.size() * sizeof(ULONG_PTR));
+    if (QueryWorkingSet(GetCurrentProcess(), buffer.data(), size)) {
+      break;
+    }
+    if (GetLastError() != ERROR_BAD_LENGTH) {
+      return {};
+    }
+    size_t entries = buffer[0];
+    buffer.assign(entries + entries / 8 + 256 + 1, 0);
+  }
+  auto* info = reinterpret_cast<PSAPI_WORKING_SET_INFORMATION*>(buffer.data());
+  size_t count = std::min<size_t>(info->NumberOfEntries, buffer.size() - 1);
+  if (count == 0) {
+    return {};
+  }
+
+  std::vector<uintptr_t> pages;
+  pages.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    pages.push_back(info->WorkingSetInfo[i].VirtualPage * page_size);
+  }
+  std::sort(pages.begin(), pages.end());
+
+  std::vector<WIN32_MEMORY_RANGE_ENTRY> ranges;
+  for (uintptr_t page : pages) {
+    if (!ranges.empty()) {
+      WIN32_MEMORY_RANGE_ENTRY& last = ranges.back();
+      if (reinterpret_cast<uintptr_t>(last.VirtualAddress) +
+              last.NumberOfBytes ==
+          page) {
+        last.NumberOfBytes += page_size;
+        continue;
+      }
+    }
+    ranges.push_back({reinterpret_cast<void*>(page), page_size});
+  }
+  return ranges;
+}
+
+// Reads |ranges| back in, skipping whatever has been freed or protected
+// since they were noted. Returns the bytes asked for.
+uint64_t PrefetchRanges(const std::vector<WIN32_MEMORY_RANGE_ENTRY>& ranges) {
+  std::vector<WIN32_MEMORY_RANGE_ENTRY> valid;
+  valid.reserve(ranges.size());
+  uint64_t bytes = 0;
+  for (const WIN32_MEMORY_RANGE_ENTRY& range : ranges) {
+    auto start = reinterpret_cast<uintptr_t>(range.VirtualAddress);
+    uintptr_t end = start + range.NumberOfBytes;
+    while (start < end) {
+      MEMORY_BASIC_INFORMATION region;
+      if (!VirtualQuery(reinterpret_cast<void*>(start), &region,
+                        sizeof(region))) {
+        break;
+      }
+      uintptr_t region_end = reinterpret_cast<uintptr_t>(region.BaseAddress) +
+                             region.RegionSize;
+      uintptr_t run_end = std::min(end, region_end);
+      if (region.State == MEM_COMMIT &&
+          !(region.Protect & (PAGE_NOACCESS | PAGE_GUARD))) {
+        valid.push_back({reinterpret_cast<void*>(start), run_end - start});
+        bytes += run_end - start;
+      }
+      start = run_end;
+    }
+  }
+  if (valid.empty() ||
+      !PrefetchVirtualMemory(GetCurrentProcess(), valid.size(), valid.data(),
+                             0)) {
+    return 0;
+  }
+  return bytes;
+}
+
+}  // namespace
+
+// static
+MemoryTrimmer* MemoryTrimmer::GetInstance() {
+  static MemoryTrimmer* instance = new MemoryTrimmer();
+  return instance;
+}
+
+void MemoryTrimmer::Attach(RunnerEngine* engine) {
+  engine_ = engine;
+  state_ = app_hidden_ ? State::kHidden : State::kActive;
+  Arm(app_hidden_ ? kHiddenTrimDelayMs : kIdleCheckMs);
+}
+
+void MemoryTrimmer::Detach() {
+  if (timer_) {
+    KillTimer(nullptr, timer_);
+    timer_ = 0;
+  }
+  engine_ = nullptr;
+  state_ = State::kActive;
+  hot_ranges_.clear();
+}
+
+void MemoryTrimmer::SetAppHidden(bool hidden) {
+  app_hidden_ = hidden;
+  if (!engine_) {
+    return;
+  }
+  if (hidden) {
+    if (state_ == State::kActive) {
+      state_ = State::kHidden;
+      Arm(kHiddenTrimDelayMs);
+    } else if (state_ == State::kTrimmed && timer_) {
+      // Showing a window restores; input no longer needs polling.
+      KillTimer(nullptr, timer_);
+      timer_ = 0;
+    }
+    return;
+  }
+  switch (state_) {
+    case State::kHidden:
+    case State::kPressured:
+      state_ = State::kActive;
+      Arm(kIdleCheckMs);
+      break;
+    case State::kTrimmed:
+      Restore();
+      break;
+    case State::kActive:
+      break;
+  }
+}
+
+void MemoryTrimmer::TrimIfHidden(const char* reason) {
+  if (engine_ && state_ == State::kHidden) {
+    BeginTrim(reason);
+  }
+}
+
+// static
+void CALLBACK MemoryTrimmer::OnTimer(HWND window,
+                                     UINT message,
+                                     UINT_PTR timer_id,
+                                     DWORD time) {
+  MemoryTrimmer* that = GetInstance();
+  if (!that->engine_ || timer_id != that->timer_) {
+    return;
+  }
+  switch (that->state_) {
+    case State::kActive:
+      if (GetTickCount() - LastInputTick() >= kIdleTrimMs) {
+        that->BeginTrim("idle");
+      } else {
+        that->Arm(kIdleCheckMs);
+      }
+      break;
+    case State::kHidden:
+      that->BeginTrim("hidden");
+      break;
+    case State::kPressured:
+      that->FinishTrim();
+      break;
+    case State::kTrimmed:
+      if (LastInputTick() != that->input_tick_) {
+        that->Restore();
+      } else {
+        that->Arm(kInputPollMs);
+      }
+      break;
+  }
+}
+
+void MemoryTrimmer::Arm(UINT delay_ms) {
+  // Re-arming with the same id replaces the pending timer.
+  timer_ = SetTimer(nullptr, timer_, delay_ms, &MemoryTrimmer::OnTimer);
+}
+
+void MemoryTrimmer::BeginTrim(const char* reason) {
+  reason_ = reason;
+  input_tick_ = LastInputTick();
+  MemoryUse before = ReadMemoryUse();
+  private_bytes_before_ = before.private_bytes;
+  working_set_before_ = before.working_set;
+
+  // Clears the image cache, among others, and lets the isolate's garbage go
+  // before the pages are trimmed.
+  engine_->messenger()->Send(
+      kSystemChannel,
+      reinterpret_cast<const uint8_t*>(kMemoryPressureMessage),
+      sizeof(kMemoryPressureMessage) - 1);
+  state_ = State::kPressured;
+  Arm(kPressureSettleMs);
+}
+
+void MemoryTrimmer::FinishTrim() {
+  TraceSpan span("MemoryTrim");
+  HeapCompact(GetProcessHeap(), 0);
+  hot_ranges_ = ResidentRanges();
+  SetProcessWorkingSetSize(GetCurrentProcess(), static_cast<SIZE_T>(-1),
+                           static_cast<SIZE_T>(-1));
+  span.End();
+
+  MemoryUse after = ReadMemoryUse();
+  TraceLoggingWrite(
+      g_runner_trace_provider, "MemoryTrim",
+      TraceLoggingString(reason_, "Reason"),
+      TraceLoggingUInt64(private_bytes_before_, "PrivateBytesBefore"),
+      TraceLoggingUInt64(after.private_bytes, "PrivateBytesAfter"),
+      TraceLoggingUInt64(working_set_before_, "WorkingSetBefore"),
+      TraceLoggingUInt64(after.working_set, "WorkingSetAfter"),
+      TraceLoggingUInt32(static_cast<uint32_t>(hot_ranges_.size()),
+                         "HotRanges"));
+  MemoryTelemetry::GetInstance()->Mark("trim");
+
+  state_ = State::kTrimmed;
+  if (app_hidden_) {
+    // Showing a window restores; there is nothing to poll for.
+    KillTimer(nullptr, timer_);
+    timer_ = 0;
+  } else {
+    Arm(kInputPollMs);
+  }
+}
+
+void MemoryTrimmer::Restore() {
+  // Needs nothing of the trimmer, as the pages belong to this process and
+  // the read only warms them; Stop drops it if it has not started.
+  WorkerPool::GetInstance()->Post(
+      WorkerPool::Priority::kBackground,
+      [ranges = std::move(hot_ranges_)]() {
+        TraceSpan span("MemoryRestorePrefetch");
+        uint64_t bytes = PrefetchRanges(ranges);
+        TraceLoggingWrite(g_runner_trace_provider, "MemoryRestorePrefetch",
+                          TraceLoggingUInt64(bytes, "PrefetchedBytes"));
+      });
+  hot_ranges_.clear();
+  MemoryTelemetry::GetInstance()->Mark("restore");
+
+  const char* reason = reason_;
+  int64_t start = PerformanceCounter();
+  engine_->AddNextFrameCallback([reason, start]() {
+    MemoryUse use = ReadMemoryUse();
+    TraceLoggingWrite(
+        g_runner_trace_provider, "MemoryRestore",
+        TraceLoggingString(reason, "Reason"),
+        TraceLoggingFloat64(TicksToMs(PerformanceCounter() - start),
+                            "TimeToFrameMs"),
+        TraceLoggingUInt64(use.private_bytes, "PrivateBytes"),
+        TraceLoggingUInt64(use.working_set, "WorkingSet"));
+  });
+
+  state_ = State::kActive;
+  Arm(kIdleCheckMs);
+}
@@ -0,0 +1,97 @@
+#ifndef RUNNER_MEMORY_TRIMMER_H_
+#define RUNNER_MEMORY_TRIMMER_H_
+
+#include <windows.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "runner_engine.h"
+
+// Gives memory back while the app is out of use.
+//
+// Once every window has been hidden for a while (see
+// WindowVisibilityTracker), or the session has had no input for a long
+// time, the framework is sent a memory pressure notification, so it drops
+// its image caches and the isolate's garbage can be collected. Shortly after,
+// the pages the process had resident are noted and its working set is
+// emptied. When a window shows again or input resumes, those pages are
+// prefetched in one go rather than faulted back in one by one.
+//
+// Each trim is written to ETW as a "MemoryTrim" event with private bytes and
+// the working set before and after, and each restore as a "MemoryRestore"
+// event with the time until the next frame was drawn.
+class MemoryTrimmer {
+ public:
+  // Returns the process-wide instance.
+  static MemoryTrimmer* GetInstance();
+
+  // Prevent copying.
+  MemoryTrimmer(MemoryTrimmer const&) = delete;
+  MemoryTrimmer& operator=(MemoryTrimmer const&) = delete;
+
+  // Starts watching for idle periods on behalf of |engine|, which must stay
+  // running until Detach.
+  void Attach(RunnerEngine* engine);
+  void Detach();
+
+  // Reports whether every window of the app is out of sight.
+  void SetAppHidden(bool hidden);
+
+  // Trims now rather than after the usual delay if every window is out of
+  // sight, for when the app was put away on purpose, e.g. closed to the
+  // tray, and is not about to be shown again.
+  void TrimIfHidden(const char* reason);
+
+ private:
+  enum class State {
+    // In use; the session's input is checked every so often.
+    kActive,
+    // Hidden, and trimmed if it stays that way.
+    kHidden,
+    // The framework has been told to release memory; the working set goes
+    // next.
+    kPressured,
+    // Trimmed, until a window shows or input resumes.
+    kTrimmed,
+  };
+
+  MemoryTrimmer() = default;
+
+  static void CALLBACK OnTimer(HWND window,
+                               UINT message,
+                               UINT_PTR timer_id,
+                               DWORD time);
+
+  // (Re)arms |timer_| to fire in |delay_ms|.
+  void Arm(UINT delay_ms);
+
+  // Sends the memory pressure notification.
+  void BeginTrim(const char* reason);
+
+  // Empties the working set, noting the pages that were resident.
+  void FinishTrim();
+
+  // Prefetches the noted pages and measures the time to the next frame.
+  void Restore();
+
+  RunnerEngine* engine_ = nullptr;
+  UINT_PTR timer_ = 0;
+  State state_ = State::kActive;
+  bool app_hidden_ = false;
+
+  // Why the current trim happened, for the trace events.
+  const char* reason_ = "";
+
+  // Tick of the session's last input when the trim began.
+  DWORD input_tick_ = 0;
+
+  // Memory use when the trim began.
+  uint64_t private_bytes_before_ = 0;
+  uint64_t working_set_before_ = 0;
+
+  // Pages resident before the working set was emptied.
+  std::vector<WIN32_MEMORY_RANGE_ENTRY> hot_ranges_;
+};
+
+#endif  // RUNNER_MEMORY_TRIMMER_H_
@@ -0,0 +1,161 @@
+#include "multi_window_plugin.h"
+
+#include <flutter/standard_method_codec.h>
+
+#include <utility>
+
+#include "utils.h"
+
+namespace {
+
+constexpr char kMethodChannelName[] = "com.tamshai.ai/windows";
+
+// Size of a window whose open call gives none, in logical pixels.
+constexpr unsigned int kDefaultWidth = 960;
+constexpr unsigned int kDefaultHeight = 720;
+
+// Offset between the default positions of successive windows, so that a new
+// window does not hide the one before it.
+constexpr unsigned int kCascadeStep = 32;
+
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+// Returns the value stored under |key| in |map|, or nullptr.
+const EncodableValue* Lookup(const EncodableMap& map, const char* key) {
+  auto it = map.find(EncodableValue(key));
+  return it == map.end() ? nullptr : &it->second;
+}
+
+// Returns the string stored under |key| in |map|, or nullptr if it is missing
+// or not a string.
+const std::string* LookupString(const EncodableMap& map, const char* key) {
+  const EncodableValue* value = Lookup(map, key);
+  return value ? std::get_if<std::string>(value) : nullptr;
+}
+
+// Returns the positive integer stored under |key| in |map|, or |fallback|.
+unsigned int LookupSize(const EncodableMap& map,
+                        const char* key,
+                        unsigned int fallback) {
+  const EncodableValue* value = Lookup(map, key);
+  if (!value || !(std::holds_alternative<int32_t>(*value) ||
+                  std::holds_alternative<int64_t>(*value))) {
+    return fallback;
+  }
+  int64_t size = value->LongValue();
+  return size > 0 ? static_cast<unsigned int>(size) : fallback;
+}
+
+}  // namespace
+
+MultiWindowPlugin::MultiWindowPlugin(RunnerEngine* engine,
+                                     PlatformTaskQueue* task_queue)
+    : engine_(engine), task_queue_(task_queue) {
+  method_channel_ =
+      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+          engine_->messenger(), kMethodChannelName,
+          &flutter::StandardMethodCodec::GetInstance());
+  method_channel_->SetMethodCallHandler(
+      [this](const auto& call, auto result) {
+        HandleMethodCall(call, std::move(result));
+      });
+}
+
+MultiWindowPlugin::~MultiWindowPlugin() {
+  method_channel_->SetMethodCallHandler(nullptr);
+  alive_.reset();
+  // Destroyed explicitly, so that each window's OnDestroy removes its view
+  // while the window object is still whole.
+  for (auto& entry : windows_) {
+    entry.second->Destroy();
+  }
+  windows_.clear();
+}
+
+void MultiWindowPlugin::HandleMethodCall(
+    const flutter::MethodCall<flutter::EncodableValue>& call,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  const auto* arguments = std::get_if<EncodableMap>(call.arguments());
+  if (!arguments) {
+    result->Error("bad_arguments", "Arguments must be a map");
+    return;
+  }
+
+  if (call.method_name() == "open") {
+    const std::string* name = LookupString(*arguments, "name");
+    if (!name || name->empty()) {
+      result->Error("bad_arguments", "name is required");
+      return;
+    }
+    const std::string* title = LookupString(*arguments, "title");
+    FlutterDesktopViewId view_id =
+        Open(*name, Utf16FromUtf8(title ? *title : *name),
+             LookupSize(*arguments, "width", kDefaultWidth),
+             LookupSize(*arguments, "height", kDefaultHeight));
+    if (view_id < 0) {
+      result->Error("unavailable", "The window could not be created");
+      return;
+    }
+    result->Success(EncodableValue(static_cast<int64_t>(view_id)));
+  } else if (call.method_name() == "close") {
+    const EncodableValue* view_id_value = Lookup(*arguments, "viewId");
+    if (!view_id_value || !(std::holds_alternative<int32_t>(*view_id_value) ||
+                            std::holds_alternative<int64_t>(*view_id_value))) {
+      result->Error("bad_arguments", "viewId must be an integer");
+      return;
+    }
+    int64_t view_id = view_id_value->LongValue();
+    for (auto it = windows_.begin(); it != windows_.end(); ++it) {
+      if (it->second->view_id() == view_id) {
+        it->second->Destroy();
+        windows_.erase(it);
+        break;
+      }
+    }
+    result->Success();
+  } else {
+    result->NotImplemented();
+  }
+}
+
+FlutterDesktopViewId MultiWindowPlugin::Open(const std::string& name,
+                                             const std::wstring& title,
+                                             unsigned int width,
+                                             unsigned int height) {
+  auto existing = windows_.find(name);
+  if (existing != windows_.end()) {
+    existing->second->BringToFront();
+    return existing->second->view_id();
+  }
+
+  auto window = std::make_unique<FlutterWindow>(engine_);
+  FlutterWindow* window_pointer = window.get();
+  std::weak_ptr<bool> alive = alive_;
+  window->SetOnDestroyed([this, alive, name, window_pointer]() {
+    // The window is still running its WM_DESTROY handler, so it is deleted
+    // afterwards.
+    task_queue_->PostTask([this, alive, name, window_pointer]() {
+      if (!alive.lock()) {
+        return;
+      }
+      auto it = windows_.find(name);
+      if (it != windows_.end() && it->second.get() == window_pointer) {
+        windows_.erase(it);
+      }
+    });
+  });
+  window->SetPlacementName(L"Window." + Utf16FromUtf8(name));
+
+  unsigned int offset =
+      kCascadeStep * (static_cast<unsigned int>(windows_.size()) + 1);
+  Win32Window::Point origin(10 + offset, 10 + offset);
+  Win32Window::Size size(width, height);
+  if (!window->Create(title, origin, size)) {
+    window->Destroy();
+    return -1;
+  }
+  FlutterDesktopViewId view_id = window->view_id();
+  windows_[name] = std::move(window);
+  return view_id;
+}
@@ -0,0 +1,67 @@
+#ifndef RUNNER_MULTI_WINDOW_PLUGIN_H_
+#define RUNNER_MULTI_WINDOW_PLUGIN_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/method_channel.h>
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "flutter_window.h"
+#include "platform_task_queue.h"
+#include "runner_engine.h"
+
+// Opens further top-level windows on the main window's engine.
+//
+// Each window hosts another view of the same engine, so it shares the
+// running isolate, the AOT snapshot and the GPU context and opens without
+// starting anything; Dart builds its content for the new view id. Windows
+// are kept one per name, and each remembers its own placement.
+//
+// Method channel "com.tamshai.ai/windows":
+//   open({name, title, width, height}) - opens the window called |name|, or
+//                                        brings it to the front if it is
+//                                        open, and returns its view id.
+//                                        The size is in logical pixels.
+//   close({viewId})                    - closes the window showing a view.
+//
+// A window the user closes removes its view, which Dart sees as the view
+// leaving PlatformDispatcher.views.
+class MultiWindowPlugin {
+ public:
+  MultiWindowPlugin(RunnerEngine* engine, PlatformTaskQueue* task_queue);
+  ~MultiWindowPlugin();
+
+  // Prevent copying.
+  MultiWindowPlugin(MultiWindowPlugin const&) = delete;
+  MultiWindowPlugin& operator=(MultiWindowPlugin const&) = delete;
+
+ private:
+  void HandleMethodCall(
+      const flutter::MethodCall<flutter::EncodableValue>& call,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  // Returns the view id of the window called |name|, opening it if needed,
+  // or -1 if it could not be created.
+  FlutterDesktopViewId Open(const std::string& name,
+                            const std::wstring& title,
+                            unsigned int width,
+                            unsigned int height);
+
+  RunnerEngine* engine_;
+  PlatformTaskQueue* task_queue_;
+
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>>
+      method_channel_;
+
+  // Open windows by name.
+  std::map<std::string, std::unique_ptr<FlutterWindow>> windows_;
+
+  // Expires when the plugin is destroyed, so callbacks still queued on the
+  // platform thread can tell they arrived too late.
+  std::shared_ptr<bool> alive_ = std::make_shared<bool>(true);
+};
+
+#endif  // RUNNER_MULTI_WINDOW_PLUGIN_H_
@@ -0,0 +1,442 @@
+// WinSock 2 has to come before anything that includes windows.h, which would
+// otherwise pull in the conflicting WinSock 1 declarations.
+#include <winsock2.h>
+
+#include "oauth_callback_plugin.h"
+
+#include <flutter/standard_method_codec.h>
+
+#include <cstdlib>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+namespace {
+
+constexpr char kMethodChannelName[] = "com.tamshai.ai/oauth_callback";
+
+// Ports registered as redirect URIs in Keycloak, in order of preference.
+// Must match DesktopOAuthService._preferredPorts.
+constexpr u_short kPreferredPorts[] = {18765, 18766, 18767, 18768, 18769};
+
+// A browser redirect is one small GET; anything larger is not one.
+constexpr size_t kMaxRequestSize = 8 * 1024;
+
+// How long a connected browser may take to send its request.
+constexpr DWORD kClientTimeoutMs = 2000;
+
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+constexpr char kSuccessPage[] = R"(<!DOCTYPE html>
+<html>
+<head><title>Login Successful</title></head>
+<body style="font-family: sans-serif; text-align: center; padding: 50px;">
+  <h1>Login Successful!</h1>
+  <p>You can close this window and return to the application.</p>
+  <script>window.close();</script>
+</body>
+</html>
+)";
+
+constexpr char kInvalidCallbackPage[] = R"(<!DOCTYPE html>
+<html>
+<head><title>Error</title></head>
+<body style="font-family: sans-serif; text-align: center; padding: 50px;">
+  <h1>Error</h1>
+  <p>Invalid callback response.</p>
+</body>
+</html>
+)";
+
+// Returns the value of hex digit |c|, or -1.
+int HexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+// Decodes a application/x-www-form-urlencoded query component.
+std::string DecodeQueryComponent(std::string_view component) {
+  std::string decoded;
+  decoded.reserve(component.size());
+  for (size_t i = 0; i < component.size(); ++i) {
+    char c = component[i];
+    if (c == '+') {
+      decoded += ' ';
+    } else if (c == '%' && i + 2 < component.size() &&
+               HexValue(component[i + 1]) >= 0 &&
+               HexValue(component[i + 2]) >= 0) {
+      decoded += static_cast<char>(HexValue(component[i + 1]) * 16 +
+                                   HexValue(component[i + 2]));
+      i += 2;
+    } else {
+      decoded += c;
+    }
+  }
+  return decoded;
+}
+
+// Escapes |text| for inclusion in an HTML page.
+std::string EscapeHtml(const std::string& text) {
+  std::string escaped;
+  escaped.reserve(text.size());
+  for (char c : text) {
+    switch (c) {
+      case '&':
+        escaped += "&amp;";
+        break;
+      case '<':
+        escaped += "&lt;";
+        break;
+      case '>':
+        escaped += "&gt;";
+        break;
+      case '"':
+        escaped += "&quot;";
+        break;
+      default:
+        escaped += c;
+    }
+  }
+  return escaped;
+}
+
+// Parameters of the redirect Keycloak sends to /callback.
+struct CallbackParameters {
+  std::optional<std::string> code;
+  std::optional<std::string> state;
+  std::optional<std::string> error;
+  std::optional<std::string> error_description;
+};
+
+CallbackParameters ParseQuery(std::string_view query) {
+  CallbackParameters parameters;
+  while (!query.empty()) {
+    size_t end = query.find('&');
+    std::string_view pair = query.substr(0, end);
+    query = end == std::string_view::npos ? std::string_view()
+                                          : query.substr(end + 1);
+
+    size_t equals = pair.find('=');
+    std::string name = DecodeQueryComponent(pair.substr(0, equals));
+    std::string value = equals == std::string_view::npos
+                            ? std::string()
+                            : DecodeQueryComponent(pair.substr(equals + 1));
+    if (name == "code") {
+      parameters.code = std::move(value);
+    } else if (name == "state") {
+      parameters.state = std::move(value);
+    } else if (name == "error") {
+      parameters.error = std::move(value);
+    } else if (name == "error_description") {
+      parameters.error_description = std::move(value);
+    }
+  }
+  return parameters;
+}
+
+EncodableValue OptionalString(const std::optional<std::string>& value) {
+  return value ? EncodableValue(*value) : EncodableValue();
+}
+
+// Sends a complete HTTP/1.1 response and asks the browser to close.
+void SendResponse(SOCKET client,
+                  const char* status,
+                  const std::string& body) {
+  std::string response = std::string("HTTP/1.1 ") + status +
+                         "\r\n"
+                         "Content-Type: text/html; charset=utf-8\r\n"
+                         "Content-Length: " +
+                         std::to_string(body.size()) +
+                         "\r\n"
+                         "Cache-Control: no-store\r\n"
+                         "Connection: close\r\n"
+                         "\r\n" +
+                         body;
+  size_t sent = 0;
+  while (sent < response.size()) {
+    int result = send(client, response.data() + sent,
+                      static_cast<int>(response.size() - sent), 0);
+    if (result == SOCKET_ERROR) {
+      return;
+    }
+    sent += static_cast<size_t>(result);
+  }
+  shutdown(client, SD_SEND);
+}
+
+}  // namespace
+
+// Accepts connections on the loopback callback port on a background thread.
+class OAuthCallbackPlugin::Listener {
+ public:
+  // Receives the {code, state, error, errorDescription} map of each
+  // /callback request, on the listener thread.
+  using CallbackHandler = std::function<void(EncodableMap callback)>;
+
+  explicit Listener(CallbackHandler handler) : handler_(std::move(handler)) {}
+
+  ~Listener() {
+    if (thread_.joinable()) {
+      SetEvent(stop_event_);
+      thread_.join();
+    }
+    if (socket_ != INVALID_SOCKET) {
+      closesocket(socket_);
+    }
+    if (accept_event_ != WSA_INVALID_EVENT) {
+      WSACloseEvent(accept_event_);
+    }
+    if (stop_event_) {
+      CloseHandle(stop_event_);
+    }
+    if (winsock_initialized_) {
+      WSACleanup();
+    }
+  }
+
+  // Prevent copying.
+  Listener(Listener const&) = delete;
+  Listener& operator=(Listener const&) = delete;
+
+  // Binds the first free preferred port and starts serving it. Returns false
+  // if none could be bound.
+  bool Start() {
+    WSADATA wsa_data;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+      return false;
+    }
+    winsock_initialized_ = true;
+
+    for (u_short port : kPreferredPorts) {
+      SOCKET candidate = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+      if (candidate == INVALID_SOCKET) {
+        return false;
+      }
+      // Refuse to share the port, so no other process can bind it alongside
+      // us and read the authorization code.
+      BOOL exclusive = TRUE;
+      setsockopt(candidate, SOL_SOCKET, SO_EXCLUSIVEADDRUSE,
+                 reinterpret_cast<const char*>(&exclusive), sizeof(exclusive));
+
+      sockaddr_in address{};
+      address.sin_family = AF_INET;
+      address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      address.sin_port = htons(port);
+      if (bind(candidate, reinterpret_cast<const sockaddr*>(&address),
+               sizeof(address)) == 0 &&
+          listen(candidate, SOMAXCONN) == 0) {
+        socket_ = candidate;
+        port_ = port;
+        break;
+      }
+      closesocket(candidate);
+    }
+    if (socket_ == INVALID_SOCKET) {
+      return false;
+    }
+
+    accept_event_ = WSACreateEvent();
+    stop_event_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+    if (accept_event_ == WSA_INVALID_EVENT || !stop_event_ ||
+        WSAEventSelect(socket_, accept_event_, FD_ACCEPT) != 0) {
+      return false;
+    }
+    thread_ = std::thread(&Listener::Serve, this);
+    return true;
+  }
+
+  // The bound port, or 0.
+  int port() const { return port_; }
+
+ private:
+  // Body of the listener thread.
+  void Serve() {
+    HANDLE handles[] = {accept_event_, stop_event_};
+    while (WaitForMultipleObjects(2, handles, FALSE, INFINITE) ==
+           WAIT_OBJECT_0) {
+      WSANETWORKEVENTS events;
+      WSAEnumNetworkEvents(socket_, accept_event_, &events);
+
+      // The listening socket is non-blocking; drain every pending connection.
+      for (;;) {
+        SOCKET client = accept(socket_, nullptr, nullptr);
+        if (client == INVALID_SOCKET) {
+          break;
+        }
+        ServeClient(client);
+        closesocket(client);
+      }
+    }
+  }
+
+  // Reads one request from |client| and answers it.
+  void ServeClient(SOCKET client) {
+    // Accepted sockets inherit the listener's event selection; undo it so
+    // the timeouts below apply to blocking reads.
+    WSAEventSelect(client, nullptr, 0);
+    u_long non_blocking = 0;
+    ioctlsocket(client, FIONBIO, &non_blocking);
+    DWORD timeout = kClientTimeoutMs;
+    setsockopt(client, SOL_SOCKET, SO_RCVTIMEO,
+               reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+    setsockopt(client, SOL_SOCKET, SO_SNDTIMEO,
+               reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+
+    std::string request;
+    while (request.find("\r\n\r\n") == std::string::npos) {
+      if (request.size() >= kMaxRequestSize) {
+        return;
+      }
+      char buffer[1024];
+      int received = recv(client, buffer, sizeof(buffer), 0);
+      if (received <= 0) {
+        return;
+      }
+      request.append(buffer, static_cast<size_t>(received));
+    }
+
+    // Request line: "GET /callback?code=...&state=... HTTP/1.1".
+    std::string_view line(request);
+    line = line.substr(0, line.find("\r\n"));
+    size_t target_start = line.find(' ');
+    size_t target_end = target_start == std::string_view::npos
+                            ? std::string_view::npos
+                            : line.find(' ', target_start + 1);
+    if (target_end == std::string_view::npos ||
+        line.substr(0, target_start) != "GET") {
+      SendResponse(client, "400 Bad Request", kInvalidCallbackPage);
+      return;
+    }
+    std::string_view target =
+        line.substr(target_start + 1, target_end - target_start - 1);
+    size_t query_start = target.find('?');
+    if (target.substr(0, query_start) != "/callback") {
+      // Favicon requests and the like.
+      SendResponse(client, "404 Not Found", std::string());
+      return;
+    }
+
+    CallbackParameters parameters =
+        ParseQuery(query_start == std::string_view::npos
+                       ? std::string_view()
+                       : target.substr(query_start + 1));
+    if (parameters.error) {
+      SendResponse(client, "200 OK",
+                   std::string(R"(<!DOCTYPE html>
+<html>
+<head><title>Login Failed</title></head>
+<body style="font-family: sans-serif; text-align: center; padding: 50px;">
+  <h1>Login Failed</h1>
+  <p>Error: )") + EscapeHtml(*parameters.error) +
+                       "</p>\n  <p>" +
+                       EscapeHtml(parameters.error_description.value_or("")) +
+                       R"(</p>
+  <p>You can close this window.</p>
+</body>
+</html>
+)");
+    } else if (parameters.code) {
+      SendResponse(client, "200 OK", kSuccessPage);
+    } else {
+      SendResponse(client, "200 OK", kInvalidCallbackPage);
+    }
+
+    handler_(EncodableMap{
+        {EncodableValue("code"), OptionalString(parameters.code)},
+        {EncodableValue("state"), OptionalString(parameters.state)},
+        {EncodableValue("error"), OptionalString(parameters.error)},
+        {EncodableValue("errorDescription"),
+         OptionalString(parameters.error_description)},
+    });
+  }
+
+  CallbackHandler handler_;
+
+  bool winsock_initialized_ = false;
+  SOCKET socket_ = INVALID_SOCKET;
+  int port_ = 0;
+
+  // Signalled by WinSock when a connection is waiting to be accepted.
+  WSAEVENT accept_event_ = WSA_INVALID_EVENT;
+
+  // Signalled to wake the listener for shutdown.
+  HANDLE stop_event_ = nullptr;
+
+  std::thread thread_;
+};
+
+OAuthCallbackPlugin::OAuthCallbackPlugin(flutter::BinaryMessenger* messenger,
+                                         PlatformTaskQueue* task_queue)
+    : task_queue_(task_queue) {
+  std::weak_ptr<bool> alive = alive_;
+  listener_ = std::make_unique<Listener>([this, alive](EncodableMap callback) {
+    task_queue_->PostTask([this, alive, callback = std::move(callback)]() {
+      if (alive.lock()) {
+        CompletePending(EncodableValue(callback));
+      }
+    });
+  });
+  if (!listener_->Start()) {
+    listener_.reset();
+  }
+
+  method_channel_ =
+      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+          messenger, kMethodChannelName,
+          &flutter::StandardMethodCodec::GetInstance());
+  method_channel_->SetMethodCallHandler(
+      [this](const auto& call, auto result) {
+        HandleMethodCall(call, std::move(result));
+      });
+}
+
+OAuthCallbackPlugin::~OAuthCallbackPlugin() {
+  method_channel_->SetMethodCallHandler(nullptr);
+  // Joins the listener thread, after which nothing else can post tasks.
+  listener_.reset();
+  alive_.reset();
+}
+
+void OAuthCallbackPlugin::HandleMethodCall(
+    const flutter::MethodCall<flutter::EncodableValue>& call,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  if (call.method_name() == "getPort") {
+    if (listener_) {
+      result->Success(EncodableValue(listener_->port()));
+    } else {
+      result->Success();
+    }
+  } else if (call.method_name() == "awaitCallback") {
+    if (!listener_) {
+      result->Error("unavailable", "No OAuth callback port could be bound");
+      return;
+    }
+    // Only one login runs at a time; a new one supersedes a stale wait.
+    CompletePending(EncodableValue());
+    pending_result_ = std::move(result);
+  } else if (call.method_name() == "cancel") {
+    CompletePending(EncodableValue());
+    result->Success();
+  } else {
+    result->NotImplemented();
+  }
+}
+
+void OAuthCallbackPlugin::CompletePending(flutter::EncodableValue callback) {
+  if (pending_result_) {
+    auto result = std::move(pending_result_);
+    result->Success(callback);
+  }
+}
@@ -0,0 +1,62 @@
+#ifndef RUNNER_OAUTH_CALLBACK_PLUGIN_H_
+#define RUNNER_OAUTH_CALLBACK_PLUGIN_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/method_channel.h>
+
+#include <memory>
+
+#include "platform_task_queue.h"
+
+// Receives the OAuth redirect of the desktop login flow on a loopback port.
+//
+// The listening socket is bound when the window is created, on the first
+// free port among those registered as redirect URIs in Keycloak, so a login
+// never waits for a server to start. Requests are read and parsed on a
+// background thread; Dart only receives the authorization code and state.
+//
+// Method channel "com.tamshai.ai/oauth_callback":
+//   getPort()       - the bound port, or null if none could be bound.
+//   awaitCallback() - completes with {code, state, error, errorDescription}
+//                     when the browser hits /callback, or null if cancelled.
+//   cancel()        - completes a pending awaitCallback with null.
+class OAuthCallbackPlugin {
+ public:
+  OAuthCallbackPlugin(flutter::BinaryMessenger* messenger,
+                      PlatformTaskQueue* task_queue);
+  ~OAuthCallbackPlugin();
+
+  // Prevent copying.
+  OAuthCallbackPlugin(OAuthCallbackPlugin const&) = delete;
+  OAuthCallbackPlugin& operator=(OAuthCallbackPlugin const&) = delete;
+
+ private:
+  // Owns the socket and the thread serving it; defined in the .cpp so that
+  // WinSock headers stay out of this one.
+  class Listener;
+
+  void HandleMethodCall(
+      const flutter::MethodCall<flutter::EncodableValue>& call,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  // Completes the pending awaitCallback, if any. Runs on the platform thread.
+  void CompletePending(flutter::EncodableValue callback);
+
+  PlatformTaskQueue* task_queue_;
+
+  std::unique_ptr<Listener> listener_;
+
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>>
+      method_channel_;
+
+  // The outstanding awaitCallback call, if any.
+  std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>
+      pending_result_;
+
+  // Expires when the plugin is destroyed, so callbacks still queued on the
+  // platform thread can tell they arrived too late.
+  std::shared_ptr<bool> alive_ = std::make_shared<bool>(true);
+};
+
+#endif  // RUNNER_OAUTH_CALLBACK_PLUGIN_H_
@@ -0,0 +1,79 @@
+#include "pending_results.h"
+
+#include <utility>
+
+PendingResults::PendingResults(PlatformTaskQueue* task_queue,
+                               std::string error_message)
+    : task_queue_(task_queue), error_message_(std::move(error_message)) {}
+
+PendingResults::~PendingResults() {
+  alive_.reset();
+  // Dropped results reply with nothing as they go; raw replies have to be
+  // sent, or Dart waits for them forever.
+  for (const auto& entry : replies_) {
+    entry.second(nullptr, 0);
+  }
+}
+
+int64_t PendingResults::Add(Result result) {
+  int64_t id = next_id_++;
+  results_[id] = std::move(result);
+  return id;
+}
+
+void PendingResults::Complete(int64_t id,
+                              std::optional<flutter::EncodableValue> outcome) {
+  Finish(id, [this, outcome = std::move(outcome)](
+                 flutter::MethodResult<flutter::EncodableValue>* result) {
+    if (outcome) {
+      result->Success(*outcome);
+    } else {
+      result->Error("unavailable", error_message_);
+    }
+  });
+}
+
+void PendingResults::Finish(int64_t id, Reply reply) {
+  std::weak_ptr<bool> alive = alive_;
+  task_queue_->PostTask([this, alive, id, reply = std::move(reply)]() {
+    if (!alive.lock()) {
+      return;
+    }
+    auto it = results_.find(id);
+    if (it == results_.end()) {
+      return;
+    }
+    Result result = std::move(it->second);
+    results_.erase(it);
+    reply(result.get());
+  });
+}
+
+int64_t PendingResults::AddReply(flutter::BinaryReply reply) {
+  int64_t id = next_id_++;
+  replies_[id] = std::move(reply);
+  return id;
+}
+
+void PendingResults::Send(int64_t id,
+                          std::unique_ptr<std::vector<uint8_t>> envelope) {
+  std::weak_ptr<bool> alive = alive_;
+  // Shared, as tasks must be copyable.
+  std::shared_ptr<std::vector<uint8_t>> data = std::move(envelope);
+  task_queue_->PostTask([this, alive, id, data]() {
+    if (!alive.lock()) {
+      return;
+    }
+    auto it = replies_.find(id);
+    if (it == replies_.end()) {
+      return;
+    }
+    flutter::BinaryReply reply = std::move(it->second);
+    replies_.erase(it);
+    if (data) {
+      reply(data->data(), data->size());
+    } else {
+      reply(nullptr, 0);
+    }
+  });
+}
@@ -0,0 +1,84 @@
+#ifndef RUNNER_PENDING_RESULTS_H_
+#define RUNNER_PENDING_RESULTS_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/method_result.h>
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "platform_task_queue.h"
+
+// Method call results a plugin completes once work off the platform thread
+// is done.
+//
+// The plugin hands each call's result to Add and passes the id it gets to
+// the work, which finishes with Complete or Finish from whichever thread it
+// runs on; the result itself is completed on the platform thread, through
+// |task_queue|, unless the PendingResults is gone by then. Declare it before
+// the Sequence or TaskGroup the work runs on, so that it outlives the work.
+//
+// Plugins whose replies are large take their calls with a raw message
+// handler instead, and hand its reply to AddReply. The work then decodes the
+// call and encodes the reply envelope itself, and passes it to Send, so the
+// platform thread only hands over bytes in either direction.
+class PendingResults {
+ public:
+  using Result =
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>;
+
+  // Replies to a call through its result.
+  using Reply =
+      std::function<void(flutter::MethodResult<flutter::EncodableValue>*)>;
+
+  // Calls completed without a value fail as "unavailable" with
+  // |error_message|.
+  PendingResults(PlatformTaskQueue* task_queue, std::string error_message);
+  // Drops the results still pending, and any completions on their way.
+  ~PendingResults();
+
+  // Prevent copying.
+  PendingResults(PendingResults const&) = delete;
+  PendingResults& operator=(PendingResults const&) = delete;
+
+  // Holds |result| until its id is completed. Platform thread only.
+  int64_t Add(Result result);
+
+  // Completes |id|'s call with |outcome|, or fails it if there is none.
+  // Safe to call from any thread.
+  void Complete(int64_t id, std::optional<flutter::EncodableValue> outcome);
+
+  // Replies to |id|'s call with |reply|, for replies Complete cannot make.
+  // Safe to call from any thread.
+  void Finish(int64_t id, Reply reply);
+
+  // Holds |reply|, for a call taken by a raw message handler, until its id
+  // is sent. Platform thread only.
+  int64_t AddReply(flutter::BinaryReply reply);
+
+  // Replies to |id|'s raw call with |envelope|, an encoded method call reply,
+  // or with nothing, as for a method that is not implemented, if it is null.
+  // Safe to call from any thread.
+  void Send(int64_t id, std::unique_ptr<std::vector<uint8_t>> envelope);
+
+ private:
+  PlatformTaskQueue* task_queue_;
+  std::string error_message_;
+
+  // By id. Platform thread only.
+  std::map<int64_t, Result> results_;
+  std::map<int64_t, flutter::BinaryReply> replies_;
+  int64_t next_id_ = 1;
+
+  // Expires on destruction, so completions still queued on the platform
+  // thread can tell they arrived too late.
+  std::shared_ptr<bool> alive_ = std::make_shared<bool>(true);
+};
+
+#endif  // RUNNER_PENDING_RESULTS_H_
@@ -0,0 +1,80 @@
+#include "platform_task_queue.h"
+
+#include <utility>
+
+namespace {
+
+constexpr const wchar_t kTaskQueueWindowClassName[] =
+    L"TAMSHAI_PLATFORM_TASK_QUEUE";
+
+// Posted to the message-only window when the queue becomes non-empty.
+constexpr UINT kRunTasksMessage = WM_APP + 1;
+
+}  // namespace
+
+PlatformTaskQueue::PlatformTaskQueue() {
+  static bool class_registered = false;
+  if (!class_registered) {
+    WNDCLASS window_class{};
+    window_class.lpszClassName = kTaskQueueWindowClassName;
+    window_class.hInstance = GetModuleHandle(nullptr);
+    window_class.lpfnWndProc = PlatformTaskQueue::WndProc;
+    RegisterClass(&window_class);
+    class_registered = true;
+  }
+  window_ = CreateWindowEx(0, kTaskQueueWindowClassName, L"", 0, 0, 0, 0, 0,
+                           HWND_MESSAGE, nullptr, GetModuleHandle(nullptr),
+                           this);
+}
+
+PlatformTaskQueue::~PlatformTaskQueue() {
+  if (window_) {
+    DestroyWindow(window_);
+    window_ = nullptr;
+  }
+}
+
+void PlatformTaskQueue::PostTask(Task task) {
+  bool was_empty;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    was_empty = tasks_.empty();
+    tasks_.push_back(std::move(task));
+  }
+  // A single wake-up drains everything queued before it runs, so only the
+  // transition from empty needs to post a message.
+  if (was_empty && window_) {
+    PostMessage(window_, kRunTasksMessage, 0, 0);
+  }
+}
+
+void PlatformTaskQueue::RunPendingTasks() {
+  std::deque<Task> tasks;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks.swap(tasks_);
+  }
+  for (Task& task : tasks) {
+    task();
+  }
+}
+
+// static
+LRESULT CALLBACK PlatformTaskQueue::WndProc(HWND const window,
+                                            UINT const message,
+                                            WPARAM const wparam,
+                                            LPARAM const lparam) noexcept {
+  if (message == WM_NCCREATE) {
+    auto window_struct = reinterpret_cast<CREATESTRUCT*>(lparam);
+    SetWindowLongPtr(window, GWLP_USERDATA,
+                     reinterpret_cast<LONG_PTR>(window_struct->lpCreateParams));
+  } else if (message == kRunTasksMessage) {
+    auto that = reinterpret_cast<PlatformTaskQueue*>(
+        GetWindowLongPtr(window, GWLP_USERDATA));
+    if (that) {
+      that->RunPendingTasks();
+    }
+    return 0;
+  }
+  return DefWindowProc(window, message, wparam, lparam);
+}
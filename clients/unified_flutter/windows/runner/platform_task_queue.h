@@ -0,0 +1,50 @@
+#ifndef RUNNER_PLATFORM_TASK_QUEUE_H_
+#define RUNNER_PLATFORM_TASK_QUEUE_H_
+
+#include <windows.h>
+
+#include <deque>
+#include <functional>
+#include <mutex>
+
+// A queue of closures that can be posted from any thread and are run on the
+// thread that created the queue. Runner components use it to hand results
+// from worker threads back to the platform thread, where all channel traffic
+// with the engine has to happen.
+class PlatformTaskQueue {
+ public:
+  using Task = std::function<void()>;
+
+  // Creates the queue. Must be called on the platform thread.
+  PlatformTaskQueue();
+  ~PlatformTaskQueue();
+
+  // Prevent copying.
+  PlatformTaskQueue(PlatformTaskQueue const&) = delete;
+  PlatformTaskQueue& operator=(PlatformTaskQueue const&) = delete;
+
+  // Schedules |task| to run on the platform thread. Safe to call from any
+  // thread. Tasks run in the order they were posted.
+  void PostTask(Task task);
+
+ private:
+  // Window procedure of the message-only window used to wake the platform
+  // thread.
+  static LRESULT CALLBACK WndProc(HWND const window,
+                                  UINT const message,
+                                  WPARAM const wparam,
+                                  LPARAM const lparam) noexcept;
+
+  // Runs every task queued at the time of the call.
+  void RunPendingTasks();
+
+  // Message-only window that receives the wake-up message.
+  HWND window_ = nullptr;
+
+  std::mutex mutex_;
+
+  // Tasks waiting to run; guarded by |mutex_|.
+  std::deque<Task> tasks_;
+};
+
+#endif  // RUNNER_PLATFORM_TASK_QUEUE_H_
@@ -0,0 +1,266 @@
+#include "plugin_loader.h"
+
+#include <flutter/method_result_functions.h>
+#include <flutter/standard_method_codec.h>
+#include <flutter_secure_storage_windows/flutter_secure_storage_windows_plugin.h>
+#include <local_auth_windows/local_auth_plugin.h>
+#include <permission_handler_windows/permission_handler_windows_plugin.h>
+#include <url_launcher_windows/url_launcher_windows.h>
+
+#include <cstring>
+#include <string>
+#include <utility>
+
+#include "runner_trace.h"
+
+namespace {
+
+constexpr char kReplayChannelName[] = "com.tamshai.ai/plugins";
+
+// Upper bound on the channels a deferred plugin listens on.
+constexpr size_t kMaxPluginChannels = 3;
+
+struct PluginEntry {
+  // Registrar name, as in generated_plugin_registrant.cc.
+  const char* name;
+  void (*register_with_registrar)(FlutterDesktopPluginRegistrarRef);
+  // Whether registration can wait until first use.
+  bool deferred;
+  // Channels the plugin's Dart side sends on, null-padded. Only needed for
+  // deferred plugins; they must match the plugin versions in pubspec.lock.
+  const char* channels[kMaxPluginChannels];
+};
+
+// Every plugin in generated_plugin_registrant.cc, which this table replaces.
+// A plugin added to pubspec.yaml must be added here too. Deferred plugins must
+// also be listed in CMakeLists.txt so that their DLLs are delay-loaded.
+const PluginEntry kPlugins[] = {
+    // Tokens are read from secure storage to decide the first route.
+    {"FlutterSecureStorageWindowsPlugin",
+     FlutterSecureStorageWindowsPluginRegisterWithRegistrar,
+     false,
+     {}},
+    // Biometric unlock screen only.
+    {"LocalAuthPlugin",
+     LocalAuthPluginRegisterWithRegistrar,
+     true,
+     {"dev.flutter.pigeon.local_auth_windows.LocalAuthApi.isDeviceSupported",
+      "dev.flutter.pigeon.local_auth_windows.LocalAuthApi.authenticate"}},
+    // Voice input permission prompts only.
+    {"PermissionHandlerWindowsPlugin",
+     PermissionHandlerWindowsPluginRegisterWithRegistrar,
+     true,
+     {"flutter.baseflow.com/permissions/methods"}},
+    // Opening the browser for login.
+    {"UrlLauncherWindows",
+     UrlLauncherWindowsRegisterWithRegistrar,
+     true,
+     {"dev.flutter.pigeon.url_launcher_windows.UrlLauncherApi.canLaunchUrl",
+      "dev.flutter.pigeon.url_launcher_windows.UrlLauncherApi.launchUrl"}},
+};
+
+constexpr size_t kPluginCount = sizeof(kPlugins) / sizeof(kPlugins[0]);
+
+using flutter::EncodableList;
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+// Returns the value stored under |key| in |map|, or nullptr.
+const EncodableValue* Lookup(const EncodableMap& map, const char* key) {
+  auto it = map.find(EncodableValue(key));
+  return it == map.end() ? nullptr : &it->second;
+}
+
+}  // namespace
+
+PluginLoader::PluginLoader(flutter::PluginRegistry* registry,
+                           flutter::BinaryMessenger* messenger)
+    : registry_(registry),
+      messenger_(messenger),
+      registered_(kPluginCount, false),
+      deferred_(kPluginCount) {
+  replay_channel_ =
+      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+          messenger, kReplayChannelName,
+          &flutter::StandardMethodCodec::GetInstance());
+  replay_channel_->SetMethodCallHandler(
+      [this](const auto& call, auto result) {
+        HandleReplayCall(call, std::move(result));
+      });
+
+  for (size_t index = 0; index < kPluginCount; ++index) {
+    if (!kPlugins[index].deferred) {
+      continue;
+    }
+    for (const char* channel : kPlugins[index].channels) {
+      if (!channel) {
+        break;
+      }
+      messenger_->SetMessageHandler(
+          channel, [this, index, channel](const uint8_t* message,
+                                          size_t message_size,
+                                          flutter::BinaryReply reply) {
+            HandleStubMessage(index, channel, message, message_size,
+                              std::move(reply));
+          });
+    }
+  }
+}
+
+PluginLoader::~PluginLoader() {
+  replay_channel_->SetMethodCallHandler(nullptr);
+  alive_.reset();
+  // Registered plugins have replaced the stubs with their own handlers, which
+  // must be left alone.
+  for (size_t index = 0; index < kPluginCount; ++index) {
+    if (!kPlugins[index].deferred || registered_[index]) {
+      continue;
+    }
+    for (const char* channel : kPlugins[index].channels) {
+      if (!channel) {
+        break;
+      }
+      messenger_->SetMessageHandler(channel, nullptr);
+    }
+  }
+}
+
+void PluginLoader::RegisterEagerPlugins() {
+  for (size_t index = 0; index < kPluginCount; ++index) {
+    if (!kPlugins[index].deferred) {
+      Register(index);
+    }
+  }
+}
+
+void PluginLoader::Register(size_t index) {
+  if (registered_[index]) {
+    return;
+  }
+  const PluginEntry& plugin = kPlugins[index];
+  TraceSpan span(std::string("RegisterPlugin.") + plugin.name);
+  // Sets the plugin's own handlers on its channels, replacing the stubs.
+  plugin.register_with_registrar(registry_->GetRegistrarForPlugin(plugin.name));
+  registered_[index] = true;
+}
+
+void PluginLoader::HandleStubMessage(size_t index,
+                                     const char* channel,
+                                     const uint8_t* message,
+                                     size_t message_size,
+                                     flutter::BinaryReply reply) {
+  Deferred& plugin = deferred_[index];
+  if (plugin.replays_to_drop > 0) {
+    // Dart resent an earlier batch behind a register call that found more
+    // queued; it sends the whole queue again.
+    --plugin.replays_to_drop;
+    reply(nullptr, 0);
+    return;
+  }
+  plugin.pending.push_back(
+      {channel, std::vector<uint8_t>(message, message + message_size),
+       std::move(reply)});
+  if (plugin.replaying) {
+    return;
+  }
+  plugin.replaying = true;
+  plugin.sent = plugin.pending.size();
+
+  EncodableMap arguments{
+      {EncodableValue("plugin"), EncodableValue(kPlugins[index].name)},
+      {EncodableValue("messages"), PendingList(index)},
+  };
+  std::weak_ptr<bool> alive = alive_;
+  // Without a replay handler in Dart, the empty replies surface there as
+  // MissingPluginExceptions, as they would have without the stubs.
+  replay_channel_->InvokeMethod(
+      "replay", std::make_unique<EncodableValue>(std::move(arguments)),
+      std::make_unique<flutter::MethodResultFunctions<EncodableValue>>(
+          [this, alive, index](const EncodableValue* replies) {
+            if (alive.lock()) {
+              FinishReplay(index, replies
+                                      ? std::get_if<EncodableList>(replies)
+                                      : nullptr);
+            }
+          },
+          [this, alive, index](const std::string& error_code,
+                               const std::string& error_message,
+                               const EncodableValue* error_details) {
+            if (alive.lock()) {
+              FinishReplay(index, nullptr);
+            }
+          },
+          [this, alive, index]() {
+            if (alive.lock()) {
+              FinishReplay(index, nullptr);
+            }
+          }));
+}
+
+void PluginLoader::HandleReplayCall(
+    const flutter::MethodCall<flutter::EncodableValue>& call,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  if (call.method_name() != "register") {
+    result->NotImplemented();
+    return;
+  }
+  const auto* arguments = std::get_if<EncodableMap>(call.arguments());
+  const EncodableValue* plugin_value =
+      arguments ? Lookup(*arguments, "plugin") : nullptr;
+  const auto* name =
+      plugin_value ? std::get_if<std::string>(plugin_value) : nullptr;
+  const EncodableValue* count_value =
+      arguments ? Lookup(*arguments, "count") : nullptr;
+  const auto* count =
+      count_value ? std::get_if<int32_t>(count_value) : nullptr;
+  size_t index = 0;
+  while (name && index < kPluginCount &&
+         std::strcmp(kPlugins[index].name, name->c_str()) != 0) {
+    ++index;
+  }
+  if (!name || index == kPluginCount || !count || *count < 0) {
+    result->Error("bad_arguments", "register takes a plugin and a count");
+    return;
+  }
+
+  Deferred& plugin = deferred_[index];
+  if (registered_[index] || plugin.pending.size() == plugin.sent) {
+    // The replays follow this call, ahead of anything else Dart sends.
+    Register(index);
+    result->Success(EncodableValue(true));
+    return;
+  }
+  plugin.replays_to_drop += static_cast<size_t>(*count);
+  plugin.sent = plugin.pending.size();
+  result->Success(PendingList(index));
+}
+
+EncodableValue PluginLoader::PendingList(size_t index) const {
+  EncodableList messages;
+  for (const PendingMessage& pending : deferred_[index].pending) {
+    messages.push_back(EncodableValue(EncodableMap{
+        {EncodableValue("channel"), EncodableValue(pending.channel)},
+        {EncodableValue("message"), EncodableValue(pending.message)},
+    }));
+  }
+  return EncodableValue(std::move(messages));
+}
+
+void PluginLoader::FinishReplay(size_t index,
+                                const EncodableList* replies) {
+  Deferred& plugin = deferred_[index];
+  // Registered either way, so that later calls reach the plugin.
+  Register(index);
+  std::vector<PendingMessage> pending = std::move(plugin.pending);
+  plugin = Deferred();
+  for (size_t i = 0; i < pending.size(); ++i) {
+    const auto* bytes = replies && i < replies->size()
+                            ? std::get_if<std::vector<uint8_t>>(&(*replies)[i])
+                            : nullptr;
+    if (bytes) {
+      pending[i].reply(bytes->data(), bytes->size());
+    } else {
+      pending[i].reply(nullptr, 0);
+    }
+  }
+}
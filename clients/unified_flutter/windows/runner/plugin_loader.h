@@ -0,0 +1,102 @@
+#ifndef RUNNER_PLUGIN_LOADER_H_
+#define RUNNER_PLUGIN_LOADER_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/method_channel.h>
+#include <flutter/plugin_registry.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Registers the app's plugins in two tiers, in place of the generated
+// RegisterPlugins.
+//
+// Plugins the first frame depends on are registered by RegisterEagerPlugins.
+// The rest are delay-loaded (see CMakeLists.txt) and left unregistered until
+// Dart first uses them, so a session that never needs one never loads it.
+//
+// Until then a stub handler on each of their channels queues what Dart
+// sends. A stub cannot hand those messages to the plugin's handler
+// directly, so it asks Dart to send them again over "com.tamshai.ai/plugins"
+// (see lib/core/native/deferred_plugin_replay.dart) and forwards the
+// replies. Dart first calls register({plugin, count}) and, without yielding,
+// resends the |count| messages: the plugin is registered on that call, so
+// nothing else sent on its channels can come between it and the replays.
+// If more messages reached the stubs meanwhile, register returns the whole
+// queue instead of registering, the stubs drop the |count| replays that
+// follow, and Dart tries again with the queue, so calls reach the plugin in
+// the order they were made.
+class PluginLoader {
+ public:
+  PluginLoader(flutter::PluginRegistry* registry,
+               flutter::BinaryMessenger* messenger);
+  ~PluginLoader();
+
+  // Prevent copying.
+  PluginLoader(PluginLoader const&) = delete;
+  PluginLoader& operator=(PluginLoader const&) = delete;
+
+  // Registers the plugins needed before the first frame.
+  void RegisterEagerPlugins();
+
+ private:
+  // A message that reached a stub, waiting for its replay.
+  struct PendingMessage {
+    const char* channel;
+    std::vector<uint8_t> message;
+    flutter::BinaryReply reply;
+  };
+
+  // A deferred plugin's queue while it is not registered.
+  struct Deferred {
+    std::vector<PendingMessage> pending;
+    // Whether a replay is in flight, and how many of |pending| Dart was last
+    // sent.
+    bool replaying = false;
+    size_t sent = 0;
+    // Replays of an earlier batch still to arrive at the stubs.
+    size_t replays_to_drop = 0;
+  };
+
+  // Registers the plugin at |index| in the plugin table, if it is not
+  // registered yet.
+  void Register(size_t index);
+
+  // Handles a message that reached the stub on |channel| of the deferred
+  // plugin at |index|.
+  void HandleStubMessage(size_t index,
+                         const char* channel,
+                         const uint8_t* message,
+                         size_t message_size,
+                         flutter::BinaryReply reply);
+
+  // Handles register({plugin, count}) from Dart.
+  void HandleReplayCall(
+      const flutter::MethodCall<flutter::EncodableValue>& call,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  // The messages in |index|'s queue, as Dart replays them.
+  flutter::EncodableValue PendingList(size_t index) const;
+
+  // Forwards the replies to |index|'s queued messages, or empty replies if
+  // |replies| is null.
+  void FinishReplay(size_t index, const flutter::EncodableList* replies);
+
+  flutter::PluginRegistry* registry_;
+  flutter::BinaryMessenger* messenger_;
+
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>>
+      replay_channel_;
+
+  // Indexed like the plugin table.
+  std::vector<bool> registered_;
+  std::vector<Deferred> deferred_;
+
+  // Expires when the loader is destroyed, for replays still in flight.
+  std::shared_ptr<bool> alive_ = std::make_shared<bool>(true);
+};
+
+#endif  // RUNNER_PLUGIN_LOADER_H_
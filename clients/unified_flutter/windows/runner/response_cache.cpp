@@ -0,0 +1,596 @@
+#include "response_cache.h"
+
+#include <shlobj.h>
+#include <wincrypt.h>
+
+#include <cstring>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Folder under %LOCALAPPDATA% for the cache, and its files.
+constexpr wchar_t kCacheFolder[] = L"\\Tamshai Corp\\Tamshai AI\\Cache";
+constexpr wchar_t kSegmentFile[] = L"\\responses.seg";
+constexpr wchar_t kKeyFile[] = L"\\responses.key";
+constexpr wchar_t kTemporarySuffix[] = L".tmp";
+
+// Mixed into the key's protection, as for the token vault.
+constexpr char kEntropy[] = "TamshaiAI.ResponseCache.v1";
+
+// An AES-256 key for the bodies, then an HMAC-SHA256 key for the keys.
+constexpr size_t kSecretSize = 64;
+constexpr size_t kAesKeySize = 32;
+
+constexpr uint32_t kSegmentMagic = 0x31435254;  // "TRC1"
+constexpr uint32_t kSegmentVersion = 1;
+constexpr uint32_t kRecordMagic = 0x63657254;  // "Trec"
+
+// Record kinds. A touch renews the freshness of the key's current record,
+// and a removal forgets it.
+constexpr uint8_t kStoreRecord = 1;
+constexpr uint8_t kTouchRecord = 2;
+constexpr uint8_t kRemoveRecord = 3;
+
+// Once the segment would grow past this, it is rewritten with the most
+// recently used entries that fit in the smaller size.
+constexpr uint64_t kMaxSegmentBytes = 64 * 1024 * 1024;
+constexpr uint64_t kCompactedBytes = 32 * 1024 * 1024;
+
+// Larger responses are not cached, so that one can't push out the rest.
+constexpr size_t kMaxBodyBytes = 8 * 1024 * 1024;
+
+// How long past its max-age a response is still shown while it is
+// revalidated.
+constexpr int64_t kMaxStaleMs = 7LL * 24 * 60 * 60 * 1000;
+
+struct SegmentHeader {
+  uint32_t magic;
+  uint32_t version;
+};
+
+struct RecordHeader {
+  uint32_t magic;
+  // Of the whole record, padding included.
+  uint32_t size;
+  uint8_t kind;
+  uint8_t reserved[3];
+  uint32_t etag_size;
+  uint32_t body_size;
+  int64_t stored_ms;
+  int64_t max_age_ms;
+  uint8_t digest[32];
+  uint8_t nonce[12];
+  uint8_t tag[16];
+};
+
+// Records are padded to keep the next header aligned in the mapping.
+uint32_t RecordSize(size_t etag_size, size_t body_size) {
+  size_t size = sizeof(RecordHeader) + etag_size + body_size;
+  return static_cast<uint32_t>((size + 7) & ~static_cast<size_t>(7));
+}
+
+int64_t NowMs() {
+  FILETIME now;
+  GetSystemTimeAsFileTime(&now);
+  ULARGE_INTEGER ticks;
+  ticks.LowPart = now.dwLowDateTime;
+  ticks.HighPart = now.dwHighDateTime;
+  // From 100 ns intervals since 1601 to milliseconds since 1970.
+  return static_cast<int64_t>((ticks.QuadPart - 116444736000000000ULL) /
+                              10000);
+}
+
+DATA_BLOB EntropyBlob() {
+  DATA_BLOB entropy;
+  entropy.pbData = reinterpret_cast<BYTE*>(const_cast<char*>(kEntropy));
+  entropy.cbData = sizeof(kEntropy) - 1;
+  return entropy;
+}
+
+// Reads and unprotects the secret at |path|.
+bool LoadSecret(const std::wstring& path, uint8_t* secret) {
+  HANDLE file = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                           nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                           nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  std::vector<uint8_t> protected_secret(4096);
+  DWORD bytes_read = 0;
+  bool read = ReadFile(file, protected_secret.data(),
+                       static_cast<DWORD>(protected_secret.size()),
+                       &bytes_read, nullptr) != FALSE;
+  CloseHandle(file);
+  if (!read) {
+    return false;
+  }
+
+  DATA_BLOB input{bytes_read, protected_secret.data()};
+  DATA_BLOB entropy = EntropyBlob();
+  DATA_BLOB output{};
+  if (!CryptUnprotectData(&input, nullptr, &entropy, nullptr, nullptr,
+                          CRYPTPROTECT_UI_FORBIDDEN, &output)) {
+    return false;
+  }
+  bool loaded = output.cbData == kSecretSize;
+  if (loaded) {
+    memcpy(secret, output.pbData, kSecretSize);
+  }
+  SecureZeroMemory(output.pbData, output.cbData);
+  LocalFree(output.pbData);
+  return loaded;
+}
+
+// Makes a new secret and stores it at |path|, protected for the user.
+bool CreateSecret(const std::wstring& path, uint8_t* secret) {
+  if (BCryptGenRandom(nullptr, secret, static_cast<ULONG>(kSecretSize),
+                      BCRYPT_USE_SYSTEM_PREFERRED_RNG) < 0) {
+    return false;
+  }
+  DATA_BLOB input{static_cast<DWORD>(kSecretSize), secret};
+  DATA_BLOB entropy = EntropyBlob();
+  DATA_BLOB output{};
+  if (!CryptProtectData(&input, L"Tamshai AI response cache", &entropy,
+                        nullptr, nullptr, CRYPTPROTECT_UI_FORBIDDEN,
+                        &output)) {
+    return false;
+  }
+  HANDLE file = CreateFile(path.c_str(), GENERIC_WRITE, 0, nullptr,
+                           CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  bool written = file != INVALID_HANDLE_VALUE;
+  if (written) {
+    DWORD bytes_written = 0;
+    written = WriteFile(file, output.pbData, output.cbData, &bytes_written,
+                        nullptr) &&
+              bytes_written == output.cbData;
+    CloseHandle(file);
+  }
+  LocalFree(output.pbData);
+  return written;
+}
+
+bool WriteAt(HANDLE file, uint64_t offset, const void* data, size_t size) {
+  LARGE_INTEGER position;
+  position.QuadPart = static_cast<LONGLONG>(offset);
+  DWORD bytes_written = 0;
+  return SetFilePointerEx(file, position, nullptr, FILE_BEGIN) &&
+         WriteFile(file, data, static_cast<DWORD>(size), &bytes_written,
+                   nullptr) &&
+         bytes_written == size;
+}
+
+// Cuts |file| down to an empty segment.
+bool ResetSegment(HANDLE file) {
+  LARGE_INTEGER start{};
+  SegmentHeader header{kSegmentMagic, kSegmentVersion};
+  return SetFilePointerEx(file, start, nullptr, FILE_BEGIN) &&
+         SetEndOfFile(file) && WriteAt(file, 0, &header, sizeof(header));
+}
+
+}  // namespace
+
+// static
+std::unique_ptr<ResponseCache> ResponseCache::Open() {
+  std::wstring folder;
+  PWSTR local_app_data = nullptr;
+  if (SUCCEEDED(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr,
+                                     &local_app_data))) {
+    folder = std::wstring(local_app_data) + kCacheFolder;
+    int result = SHCreateDirectoryEx(nullptr, folder.c_str(), nullptr);
+    if (result != ERROR_SUCCESS && result != ERROR_ALREADY_EXISTS &&
+        result != ERROR_FILE_EXISTS) {
+      folder.clear();
+    }
+  }
+  CoTaskMemFree(local_app_data);
+  if (folder.empty()) {
+    return nullptr;
+  }
+
+  std::unique_ptr<ResponseCache> cache(new ResponseCache());
+  cache->path_ = folder + kSegmentFile;
+  cache->file_ = CreateFile(cache->path_.c_str(), GENERIC_READ | GENERIC_WRITE,
+                            FILE_SHARE_READ, nullptr, OPEN_ALWAYS,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (cache->file_ == INVALID_HANDLE_VALUE) {
+    return nullptr;
+  }
+
+  // Without the key the segment can't be read, so a new key starts a new
+  // segment.
+  uint8_t secret[kSecretSize];
+  bool loaded = LoadSecret(folder + kKeyFile, secret);
+  if (!loaded && (!CreateSecret(folder + kKeyFile, secret) ||
+                  !ResetSegment(cache->file_))) {
+    SecureZeroMemory(secret, sizeof(secret));
+    return nullptr;
+  }
+  NTSTATUS status = BCryptGenerateSymmetricKey(
+      BCRYPT_AES_GCM_ALG_HANDLE, &cache->key_, nullptr, 0, secret,
+      static_cast<ULONG>(kAesKeySize), 0);
+  memcpy(cache->hmac_key_.data(), secret + kAesKeySize,
+         cache->hmac_key_.size());
+  SecureZeroMemory(secret, sizeof(secret));
+  if (status < 0 || !cache->Load()) {
+    return nullptr;
+  }
+  return cache;
+}
+
+ResponseCache::~ResponseCache() {
+  Unmap();
+  if (file_ != INVALID_HANDLE_VALUE) {
+    CloseHandle(file_);
+  }
+  if (key_) {
+    BCryptDestroyKey(key_);
+  }
+  SecureZeroMemory(hmac_key_.data(), hmac_key_.size());
+}
+
+std::optional<ResponseCache::Hit> ResponseCache::Get(const std::string& key) {
+  auto it = entries_.find(KeyDigest(key));
+  if (it == entries_.end()) {
+    return std::nullopt;
+  }
+  Entry& entry = it->second;
+  int64_t age_ms = NowMs() - entry.stored_ms;
+  if (age_ms > entry.max_age_ms + kMaxStaleMs) {
+    Forget(it);
+    return std::nullopt;
+  }
+  // Records appended since the segment was mapped are past the view.
+  if (entry.offset + entry.size > view_size_ && !Map()) {
+    return std::nullopt;
+  }
+
+  RecordHeader header;
+  memcpy(&header, view_ + entry.offset, sizeof(header));
+  Hit hit;
+  hit.body.resize(header.body_size);
+  hit.etag = entry.etag;
+  hit.fresh = age_ms <= entry.max_age_ms;
+  hit.age_ms = age_ms;
+
+  BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO info;
+  BCRYPT_INIT_AUTH_MODE_INFO(info);
+  info.pbNonce = header.nonce;
+  info.cbNonce = sizeof(header.nonce);
+  info.pbAuthData = header.digest;
+  info.cbAuthData = sizeof(header.digest);
+  info.pbTag = header.tag;
+  info.cbTag = sizeof(header.tag);
+  ULONG decrypted = 0;
+  PUCHAR ciphertext = const_cast<PUCHAR>(view_ + entry.offset +
+                                         sizeof(header) + header.etag_size);
+  if (BCryptDecrypt(key_, ciphertext, header.body_size, &info, nullptr, 0,
+                    reinterpret_cast<PUCHAR>(hit.body.data()),
+                    header.body_size, &decrypted, 0) < 0) {
+    // Damaged, or written under another key.
+    Forget(it);
+    return std::nullopt;
+  }
+  recency_.splice(recency_.begin(), recency_, entry.recency);
+  return hit;
+}
+
+bool ResponseCache::Put(const std::string& key,
+                        const std::string& body,
+                        const std::string& etag,
+                        int64_t max_age_ms) {
+  Digest digest = KeyDigest(key);
+  auto it = entries_.find(digest);
+  if (it != entries_.end() && !etag.empty() && it->second.etag == etag) {
+    return Touch(key, max_age_ms);
+  }
+  if (body.size() > kMaxBodyBytes) {
+    return Remove(key);
+  }
+
+  uint32_t size = RecordSize(etag.size(), body.size());
+  if (end_ + size > kMaxSegmentBytes && !Compact()) {
+    return false;
+  }
+  std::vector<uint8_t> record(size);
+  RecordHeader header{};
+  header.magic = kRecordMagic;
+  header.size = size;
+  header.kind = kStoreRecord;
+  header.etag_size = static_cast<uint32_t>(etag.size());
+  header.body_size = static_cast<uint32_t>(body.size());
+  header.stored_ms = NowMs();
+  header.max_age_ms = max_age_ms;
+  memcpy(header.digest, digest.data(), digest.size());
+  if (BCryptGenRandom(nullptr, header.nonce, sizeof(header.nonce),
+                      BCRYPT_USE_SYSTEM_PREFERRED_RNG) < 0) {
+    return false;
+  }
+  memcpy(record.data() + sizeof(header), etag.data(), etag.size());
+
+  BCRYPT_AUTHENTICATED_CIPHER_MODE_INFO info;
+  BCRYPT_INIT_AUTH_MODE_INFO(info);
+  info.pbNonce = header.nonce;
+  info.cbNonce = sizeof(header.nonce);
+  info.pbAuthData = header.digest;
+  info.cbAuthData = sizeof(header.digest);
+  info.pbTag = header.tag;
+  info.cbTag = sizeof(header.tag);
+  ULONG encrypted = 0;
+  if (BCryptEncrypt(key_,
+                    reinterpret_cast<PUCHAR>(const_cast<char*>(body.data())),
+                    header.body_size, &info, nullptr, 0,
+                    record.data() + sizeof(header) + etag.size(),
+                    header.body_size, &encrypted, 0) < 0) {
+    return false;
+  }
+  memcpy(record.data(), &header, sizeof(header));
+
+  uint64_t offset = end_;
+  if (!Append(record.data(), record.size())) {
+    return false;
+  }
+  it = entries_.find(digest);
+  if (it != entries_.end()) {
+    Forget(it);
+  }
+  recency_.push_front(digest);
+  entries_[digest] =
+      Entry{offset, size, etag, header.stored_ms, max_age_ms, recency_.begin()};
+  return true;
+}
+
+bool ResponseCache::Touch(const std::string& key, int64_t max_age_ms) {
+  Digest digest = KeyDigest(key);
+  auto it = entries_.find(digest);
+  if (it == entries_.end()) {
+    return false;
+  }
+  it->second.stored_ms = NowMs();
+  it->second.max_age_ms = max_age_ms;
+  recency_.splice(recency_.begin(), recency_, it->second.recency);
+  return AppendMarker(kTouchRecord, digest, &it->second);
+}
+
+bool ResponseCache::Remove(const std::string& key) {
+  Digest digest = KeyDigest(key);
+  auto it = entries_.find(digest);
+  if (it == entries_.end()) {
+    return true;
+  }
+  Forget(it);
+  return AppendMarker(kRemoveRecord, digest, nullptr);
+}
+
+bool ResponseCache::Clear() {
+  Unmap();
+  entries_.clear();
+  recency_.clear();
+  end_ = sizeof(SegmentHeader);
+  return ResetSegment(file_) && Map();
+}
+
+bool ResponseCache::Load() {
+  LARGE_INTEGER size;
+  SegmentHeader header{};
+  DWORD bytes_read = 0;
+  LARGE_INTEGER start{};
+  if (!GetFileSizeEx(file_, &size)) {
+    return false;
+  }
+  if (size.QuadPart < static_cast<LONGLONG>(sizeof(header)) ||
+      !SetFilePointerEx(file_, start, nullptr, FILE_BEGIN) ||
+      !ReadFile(file_, &header, sizeof(header), &bytes_read, nullptr) ||
+      bytes_read != sizeof(header) || header.magic != kSegmentMagic ||
+      header.version != kSegmentVersion) {
+    end_ = sizeof(SegmentHeader);
+    return ResetSegment(file_) && Map();
+  }
+  end_ = static_cast<uint64_t>(size.QuadPart);
+  if (!Map()) {
+    return false;
+  }
+
+  uint64_t offset = sizeof(SegmentHeader);
+  while (offset + sizeof(RecordHeader) <= end_) {
+    RecordHeader record;
+    memcpy(&record, view_ + offset, sizeof(record));
+    if (record.magic != kRecordMagic || record.size < sizeof(record) ||
+        record.size > end_ - offset ||
+        static_cast<uint64_t>(record.etag_size) + record.body_size >
+            record.size - sizeof(record)) {
+      break;
+    }
+    Digest digest;
+    memcpy(digest.data(), record.digest, digest.size());
+    auto it = entries_.find(digest);
+    if (record.kind == kStoreRecord) {
+      if (it != entries_.end()) {
+        Forget(it);
+      }
+      recency_.push_front(digest);
+      std::string etag(
+          reinterpret_cast<const char*>(view_ + offset + sizeof(record)),
+          record.etag_size);
+      entries_[digest] = Entry{offset,
+                               record.size,
+                               std::move(etag),
+                               record.stored_ms,
+                               record.max_age_ms,
+                               recency_.begin()};
+    } else if (record.kind == kTouchRecord && it != entries_.end()) {
+      it->second.stored_ms = record.stored_ms;
+      it->second.max_age_ms = record.max_age_ms;
+      recency_.splice(recency_.begin(), recency_, it->second.recency);
+    } else if (record.kind == kRemoveRecord && it != entries_.end()) {
+      Forget(it);
+    }
+    offset += record.size;
+  }
+
+  // What follows is the tail of a write cut short.
+  if (offset < end_) {
+    Unmap();
+    LARGE_INTEGER valid_end;
+    valid_end.QuadPart = static_cast<LONGLONG>(offset);
+    if (!SetFilePointerEx(file_, valid_end, nullptr, FILE_BEGIN) ||
+        !SetEndOfFile(file_)) {
+      return false;
+    }
+    end_ = offset;
+    return Map();
+  }
+  return true;
+}
+
+bool ResponseCache::Map() {
+  Unmap();
+  LARGE_INTEGER size;
+  size.QuadPart = static_cast<LONGLONG>(end_);
+  mapping_ = CreateFileMapping(file_, nullptr, PAGE_READONLY, size.HighPart,
+                               size.LowPart, nullptr);
+  if (!mapping_) {
+    return false;
+  }
+  view_ = static_cast<const uint8_t*>(
+      MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+  if (!view_) {
+    Unmap();
+    return false;
+  }
+  view_size_ = end_;
+  return true;
+}
+
+void ResponseCache::Unmap() {
+  if (view_) {
+    UnmapViewOfFile(view_);
+    view_ = nullptr;
+  }
+  if (mapping_) {
+    CloseHandle(mapping_);
+    mapping_ = nullptr;
+  }
+  view_size_ = 0;
+}
+
+ResponseCache::Digest ResponseCache::KeyDigest(const std::string& key) const {
+  Digest digest{};
+  BCryptHash(BCRYPT_HMAC_SHA256_ALG_HANDLE,
+             const_cast<PUCHAR>(hmac_key_.data()),
+             static_cast<ULONG>(hmac_key_.size()),
+             reinterpret_cast<PUCHAR>(const_cast<char*>(key.data())),
+             static_cast<ULONG>(key.size()), digest.data(),
+             static_cast<ULONG>(digest.size()));
+  return digest;
+}
+
+bool ResponseCache::Append(const void* record, size_t size) {
+  // Not flushed: a record lost to a crash is only a miss, and Load drops a
+  // torn one.
+  if (!WriteAt(file_, end_, record, size)) {
+    return false;
+  }
+  end_ += size;
+  return true;
+}
+
+bool ResponseCache::AppendMarker(uint8_t kind,
+                                 const Digest& digest,
+                                 const Entry* entry) {
+  uint32_t size = RecordSize(0, 0);
+  if (end_ + size > kMaxSegmentBytes && !Compact()) {
+    return false;
+  }
+  std::vector<uint8_t> record(size);
+  RecordHeader header{};
+  header.magic = kRecordMagic;
+  header.size = size;
+  header.kind = kind;
+  if (entry) {
+    header.stored_ms = entry->stored_ms;
+    header.max_age_ms = entry->max_age_ms;
+  }
+  memcpy(header.digest, digest.data(), digest.size());
+  memcpy(record.data(), &header, sizeof(header));
+  return Append(record.data(), record.size());
+}
+
+bool ResponseCache::Compact() {
+  if (view_size_ < end_ && !Map()) {
+    return false;
+  }
+  std::wstring temporary_path = path_ + kTemporarySuffix;
+  HANDLE file = CreateFile(temporary_path.c_str(), GENERIC_WRITE, 0, nullptr,
+                           CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  // The records are copied as they are, with the latest touch folded into
+  // their header, until the most recently used fill the compacted size.
+  SegmentHeader segment{kSegmentMagic, kSegmentVersion};
+  bool written = WriteAt(file, 0, &segment, sizeof(segment));
+  uint64_t end = sizeof(segment);
+  std::vector<std::pair<Digest, uint64_t>> kept;
+  for (const Digest& digest : recency_) {
+    if (!written) {
+      break;
+    }
+    const Entry& entry = entries_[digest];
+    if (end + entry.size > kCompactedBytes) {
+      break;
+    }
+    RecordHeader header;
+    memcpy(&header, view_ + entry.offset, sizeof(header));
+    header.stored_ms = entry.stored_ms;
+    header.max_age_ms = entry.max_age_ms;
+    written = WriteAt(file, end, &header, sizeof(header)) &&
+              WriteAt(file, end + sizeof(header),
+                      view_ + entry.offset + sizeof(header),
+                      entry.size - sizeof(header));
+    kept.emplace_back(digest, end);
+    end += entry.size;
+  }
+  CloseHandle(file);
+
+  Unmap();
+  CloseHandle(file_);
+  file_ = INVALID_HANDLE_VALUE;
+  if (written) {
+    written = MoveFileEx(temporary_path.c_str(), path_.c_str(),
+                         MOVEFILE_REPLACE_EXISTING) != FALSE;
+  }
+  if (!written) {
+    DeleteFile(temporary_path.c_str());
+  }
+  file_ = CreateFile(path_.c_str(), GENERIC_READ | GENERIC_WRITE,
+                     FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                     FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (!written || file_ == INVALID_HANDLE_VALUE) {
+    // The old segment, if it is still there, is read again on next launch.
+    entries_.clear();
+    recency_.clear();
+    return false;
+  }
+
+  std::map<Digest, Entry> entries;
+  std::list<Digest> recency;
+  for (const auto& digest_offset : kept) {
+    Entry& entry = entries_[digest_offset.first];
+    recency.push_back(digest_offset.first);
+    entry.offset = digest_offset.second;
+    entry.recency = std::prev(recency.end());
+    entries.emplace(digest_offset.first, std::move(entry));
+  }
+  entries_ = std::move(entries);
+  recency_ = std::move(recency);
+  end_ = end;
+  return Map();
+}
+
+void ResponseCache::Forget(std::map<Digest, Entry>::iterator it) {
+  recency_.erase(it->second.recency);
+  entries_.erase(it);
+}
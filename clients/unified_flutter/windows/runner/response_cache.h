@@ -0,0 +1,124 @@
+#ifndef RUNNER_RESPONSE_CACHE_H_
+#define RUNNER_RESPONSE_CACHE_H_
+
+#include <windows.h>
+#include <bcrypt.h>
+
+#include <array>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <optional>
+#include <string>
+
+// The runner's on-disk cache of gateway responses, shared by every window
+// and kept across launches.
+//
+// Responses are appended as records to one segment file under
+// %LOCALAPPDATA%, which is read through a mapping of it, so a hit costs a
+// lookup and a copy out of the file cache. The index of the newest record
+// per key is rebuilt from the file when it is opened, and kept in least
+// recently used order; once the file reaches its limit it is rewritten with
+// the most recently used entries only.
+//
+// Responses hold the user's business data, so bodies are encrypted with
+// AES-GCM under a key that is itself protected with DPAPI, and records are
+// found by an HMAC of their key rather than the key itself.
+//
+// Not thread-safe, and the methods block on the disk, so call them from one
+// thread off the platform thread.
+class ResponseCache {
+ public:
+  struct Hit {
+    std::string body;
+    std::string etag;
+    // Whether the response is still within the max-age it was stored with;
+    // stale ones should be revalidated.
+    bool fresh;
+    int64_t age_ms;
+  };
+
+  // Opens the cache, creating it if needed. Returns nullptr if the folder,
+  // the key or the segment can't be used, e.g. because another process has
+  // the segment open.
+  static std::unique_ptr<ResponseCache> Open();
+
+  ~ResponseCache();
+
+  // Prevent copying.
+  ResponseCache(ResponseCache const&) = delete;
+  ResponseCache& operator=(ResponseCache const&) = delete;
+
+  // Returns the response stored under |key|, unless it has been stale for
+  // too long to be worth showing.
+  std::optional<Hit> Get(const std::string& key);
+
+  // Stores |body| under |key|, fresh for |max_age_ms|. A response with the
+  // ETag of the one already stored only renews its freshness.
+  bool Put(const std::string& key,
+           const std::string& body,
+           const std::string& etag,
+           int64_t max_age_ms);
+
+  // Renews the freshness of the response under |key|, for a 304.
+  bool Touch(const std::string& key, int64_t max_age_ms);
+
+  // Forgets the response under |key|, if any.
+  bool Remove(const std::string& key);
+
+  // Forgets every response.
+  bool Clear();
+
+ private:
+  using Digest = std::array<uint8_t, 32>;
+
+  struct Entry {
+    // Of the record holding the body.
+    uint64_t offset;
+    uint32_t size;
+    std::string etag;
+    int64_t stored_ms;
+    int64_t max_age_ms;
+    std::list<Digest>::iterator recency;
+  };
+
+  ResponseCache() = default;
+
+  // Reads the index from the segment, dropping a torn record at its end.
+  bool Load();
+
+  // Maps |end_| bytes of the segment for reading.
+  bool Map();
+  void Unmap();
+
+  Digest KeyDigest(const std::string& key) const;
+
+  // Appends |size| bytes of |record| to the segment.
+  bool Append(const void* record, size_t size);
+
+  // Appends a record with no body, of |kind|, for |digest|.
+  bool AppendMarker(uint8_t kind, const Digest& digest, const Entry* entry);
+
+  // Rewrites the segment with the most recently used entries only.
+  bool Compact();
+
+  void Forget(std::map<Digest, Entry>::iterator it);
+
+  std::wstring path_;
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  HANDLE mapping_ = nullptr;
+  const uint8_t* view_ = nullptr;
+  uint64_t view_size_ = 0;
+  // Where the next record goes.
+  uint64_t end_ = 0;
+
+  BCRYPT_KEY_HANDLE key_ = nullptr;
+  std::array<uint8_t, 32> hmac_key_{};
+
+  std::map<Digest, Entry> entries_;
+  // Most recently used first.
+  std::list<Digest> recency_;
+};
+
+#endif  // RUNNER_RESPONSE_CACHE_H_
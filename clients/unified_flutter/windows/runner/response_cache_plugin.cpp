@@ -0,0 +1,180 @@
+#include "response_cache_plugin.h"
+
+#include <flutter/standard_method_codec.h>
+
+#include <algorithm>
+#include <cctype>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "json_decoder.h"
+
+namespace {
+
+constexpr char kMethodChannelName[] = "com.tamshai.ai/response_cache";
+
+constexpr char kUnavailable[] = "The response cache could not be used";
+
+// How long a response without a max-age is fresh.
+constexpr int64_t kDefaultMaxAgeMs = 5 * 60 * 1000;
+
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+const EncodableValue* Lookup(const EncodableMap& map, const char* key) {
+  auto it = map.find(EncodableValue(key));
+  return it == map.end() ? nullptr : &it->second;
+}
+
+const std::string* LookupString(const EncodableMap& map, const char* key) {
+  const EncodableValue* value = Lookup(map, key);
+  return value ? std::get_if<std::string>(value) : nullptr;
+}
+
+// How long a response with |cache_control| is fresh, or nothing if it must
+// not be stored.
+std::optional<int64_t> FreshnessFor(const std::string* cache_control) {
+  if (!cache_control) {
+    return kDefaultMaxAgeMs;
+  }
+  std::string directives = *cache_control;
+  std::transform(directives.begin(), directives.end(), directives.begin(),
+                 [](char c) { return static_cast<char>(tolower(c)); });
+  if (directives.find("no-store") != std::string::npos) {
+    return std::nullopt;
+  }
+  if (directives.find("no-cache") != std::string::npos) {
+    return 0;
+  }
+  size_t max_age = directives.find("max-age=");
+  if (max_age == std::string::npos) {
+    return kDefaultMaxAgeMs;
+  }
+  int64_t seconds = 0;
+  for (size_t i = max_age + 8; i < directives.size() && seconds < 1 << 30;
+       ++i) {
+    if (!isdigit(static_cast<unsigned char>(directives[i]))) {
+      break;
+    }
+    seconds = seconds * 10 + (directives[i] - '0');
+  }
+  return seconds * 1000;
+}
+
+EncodableValue HitToValue(const ResponseCache::Hit& hit) {
+  std::optional<EncodableValue> value = DecodeJson(hit.body);
+  if (!value) {
+    return EncodableValue();
+  }
+  return EncodableValue(EncodableMap{
+      {EncodableValue("value"), std::move(*value)},
+      {EncodableValue("etag"), EncodableValue(hit.etag)},
+      {EncodableValue("fresh"), EncodableValue(hit.fresh)},
+      {EncodableValue("ageMs"), EncodableValue(hit.age_ms)},
+  });
+}
+
+}  // namespace
+
+ResponseCachePlugin::ResponseCachePlugin(flutter::BinaryMessenger* messenger,
+                                         PlatformTaskQueue* task_queue)
+    : messenger_(messenger),
+      pending_results_(task_queue, kUnavailable) {
+  messenger_->SetMessageHandler(
+      kMethodChannelName, [this](const uint8_t* message, size_t message_size,
+                                 flutter::BinaryReply reply) {
+        int64_t id = pending_results_.AddReply(std::move(reply));
+        // The engine frees |message| on return, so its bytes are copied
+        // once; everything else happens on the sequence.
+        cache_sequence_.Post(
+            [this, id,
+             call = std::vector<uint8_t>(message, message + message_size)]() {
+              pending_results_.Send(id, HandleMessage(call));
+            });
+      });
+}
+
+ResponseCachePlugin::~ResponseCachePlugin() {
+  messenger_->SetMessageHandler(kMethodChannelName, nullptr);
+}
+
+ResponseCachePlugin::Envelope ResponseCachePlugin::HandleMessage(
+    const std::vector<uint8_t>& message) {
+  std::unique_ptr<flutter::MethodCall<EncodableValue>> call =
+      flutter::StandardMethodCodec::GetInstance().DecodeMethodCall(message);
+  if (!call) {
+    return nullptr;
+  }
+  if (!cache_opened_) {
+    cache_ = ResponseCache::Open();
+    cache_opened_ = true;
+  }
+  return HandleMethodCall(*call, cache_.get());
+}
+
+ResponseCachePlugin::Envelope ResponseCachePlugin::HandleMethodCall(
+    const flutter::MethodCall<EncodableValue>& call,
+    ResponseCache* cache) {
+  const flutter::StandardMethodCodec& codec =
+      flutter::StandardMethodCodec::GetInstance();
+  const EncodableValue none;
+
+  if (call.method_name() == "clear") {
+    if (cache && !cache->Clear()) {
+      return codec.EncodeErrorEnvelope("unavailable", kUnavailable);
+    }
+    return codec.EncodeSuccessEnvelope(&none);
+  }
+
+  const auto* arguments = std::get_if<EncodableMap>(call.arguments());
+  const std::string* key = arguments ? LookupString(*arguments, "key")
+                                     : nullptr;
+  if (!key) {
+    return codec.EncodeErrorEnvelope("bad_arguments", "key is required");
+  }
+  const std::string* cache_control =
+      LookupString(*arguments, "cacheControl");
+  std::optional<int64_t> max_age_ms = FreshnessFor(cache_control);
+
+  if (call.method_name() == "get") {
+    std::optional<ResponseCache::Hit> hit =
+        cache ? cache->Get(*key) : std::nullopt;
+    EncodableValue value = hit ? HitToValue(*hit) : EncodableValue();
+    return codec.EncodeSuccessEnvelope(&value);
+  }
+  if (call.method_name() == "put") {
+    const EncodableValue* body_value = Lookup(*arguments, "body");
+    const auto* body =
+        body_value ? std::get_if<std::vector<uint8_t>>(body_value) : nullptr;
+    if (!body) {
+      return codec.EncodeErrorEnvelope("bad_arguments", "body must be bytes");
+    }
+    std::string_view json(reinterpret_cast<const char*>(body->data()),
+                          body->size());
+    const std::string* etag = LookupString(*arguments, "etag");
+    std::optional<EncodableValue> value = DecodeJson(json);
+    if (cache) {
+      // Only JSON is served back, so anything else isn't kept.
+      if (value && max_age_ms) {
+        cache->Put(*key, std::string(json), etag ? *etag : std::string(),
+                   *max_age_ms);
+      } else {
+        cache->Remove(*key);
+      }
+    }
+    return codec.EncodeSuccessEnvelope(value ? &*value : &none);
+  }
+  if (call.method_name() == "touch") {
+    if (cache) {
+      if (max_age_ms) {
+        cache->Touch(*key, *max_age_ms);
+      } else {
+        cache->Remove(*key);
+      }
+    }
+    return codec.EncodeSuccessEnvelope(&none);
+  }
+  return nullptr;
+}
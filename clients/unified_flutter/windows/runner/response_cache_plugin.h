@@ -0,0 +1,73 @@
+#ifndef RUNNER_RESPONSE_CACHE_PLUGIN_H_
+#define RUNNER_RESPONSE_CACHE_PLUGIN_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/method_call.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "pending_results.h"
+#include "platform_task_queue.h"
+#include "response_cache.h"
+#include "worker_pool.h"
+
+// Gives Dart the ResponseCache, for stale-while-revalidate loading of
+// generative components.
+//
+// Calls run in order on the worker pool, where the cached JSON is also
+// decoded, so a hit reaches Dart as a ready map. They are taken by a raw
+// message handler, and the worker also decodes them and encodes their
+// replies, so bodies of several megabytes cost the platform thread no more
+// than handing over their bytes.
+//
+// Method channel "com.tamshai.ai/response_cache":
+//   get({key})  - the cached {value, etag, fresh, ageMs}, or null.
+//   put({key, body, etag, cacheControl}) - stores the UTF-8 JSON |body| as
+//                 the response's Cache-Control allows, and returns it
+//                 decoded, or null if it isn't JSON. The response is fresh
+//                 for its max-age, or five minutes without one; no-cache
+//                 stores it stale and no-store not at all. A body with the
+//                 stored ETag only renews the stored one.
+//   touch({key, cacheControl}) - renews the response after a 304.
+//   clear()     - forgets every response.
+class ResponseCachePlugin {
+ public:
+  ResponseCachePlugin(flutter::BinaryMessenger* messenger,
+                      PlatformTaskQueue* task_queue);
+  ~ResponseCachePlugin();
+
+  // Prevent copying.
+  ResponseCachePlugin(ResponseCachePlugin const&) = delete;
+  ResponseCachePlugin& operator=(ResponseCachePlugin const&) = delete;
+
+ private:
+  using Envelope = std::unique_ptr<std::vector<uint8_t>>;
+
+  // Handles the method call encoded in |message| and returns the encoded
+  // reply, or null for an unknown method. |cache_sequence_| only.
+  Envelope HandleMessage(const std::vector<uint8_t>& message);
+
+  // Runs |call| against |cache|, which is null if it could not be opened.
+  Envelope HandleMethodCall(
+      const flutter::MethodCall<flutter::EncodableValue>& call,
+      ResponseCache* cache);
+
+  flutter::BinaryMessenger* messenger_;
+
+  // Calls waiting for their reply.
+  PendingResults pending_results_;
+
+  // Opened by the first job. |cache_sequence_| only.
+  std::unique_ptr<ResponseCache> cache_;
+  bool cache_opened_ = false;
+
+  // Declared last, so that it goes first: it finishes the job in progress
+  // and drops queued ones. A record cut short by the process exiting is
+  // dropped when the segment is next read.
+  WorkerPool::Sequence cache_sequence_{WorkerPool::Priority::kInteractive};
+};
+
+#endif  // RUNNER_RESPONSE_CACHE_PLUGIN_H_
@@ -0,0 +1,168 @@
+#include "run_loop.h"
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+#include "hang_watchdog.h"
+
+namespace {
+
+// MsgWaitForMultipleObjectsEx needs one slot for the message queue.
+constexpr size_t kMaxWaitableHandles = MAXIMUM_WAIT_OBJECTS - 1;
+
+// How many messages may be dispatched per pass, and for how long, before
+// the handles are checked again: a quarter of a frame at 60 Hz.
+constexpr int kMaxMessagesPerPass = 64;
+constexpr std::chrono::microseconds kMessageTimeSlice(4000);
+
+// How long idle callbacks may run per pass: half a frame at 60 Hz.
+constexpr std::chrono::microseconds kIdleTimeSlice(8000);
+
+// Whether input is waiting in the thread's message queue.
+bool InputPending() {
+  return HIWORD(GetQueueStatus(QS_INPUT)) != 0;
+}
+
+// Brackets one dispatch or callback for the watchdog, if there is one.
+class ScopedDispatch {
+ public:
+  ScopedDispatch(HangWatchdog* watchdog, UINT message, HWND window = nullptr)
+      : watchdog_(watchdog) {
+    if (watchdog_) {
+      watchdog_->BeginDispatch(message, window);
+    }
+  }
+
+  ~ScopedDispatch() {
+    if (watchdog_) {
+      watchdog_->EndDispatch();
+    }
+  }
+
+  // Prevent copying.
+  ScopedDispatch(ScopedDispatch const&) = delete;
+  ScopedDispatch& operator=(ScopedDispatch const&) = delete;
+
+ private:
+  HangWatchdog* watchdog_;
+};
+
+}  // namespace
+
+RunLoop::RunLoop() = default;
+
+RunLoop::~RunLoop() = default;
+
+void RunLoop::Run() {
+  std::vector<HANDLE> handles;
+  for (;;) {
+    bool messages_left = false;
+    if (!DispatchMessages(&messages_left)) {
+      return;
+    }
+    // Idle work waits for the messages, which come back after the handles.
+    bool more_idle_work = !messages_left && RunIdleCallbacks();
+
+    handles.clear();
+    for (const Waitable& waitable : waitables_) {
+      handles.push_back(waitable.handle);
+    }
+    // MWMO_INPUTAVAILABLE also wakes for messages that were already queued
+    // but not yet looked at, such as those posted by idle callbacks.
+    DWORD result = MsgWaitForMultipleObjectsEx(
+        static_cast<DWORD>(handles.size()), handles.data(),
+        (messages_left || more_idle_work) ? 0 : INFINITE, QS_ALLINPUT,
+        MWMO_INPUTAVAILABLE);
+    if (result >= WAIT_OBJECT_0 && result < WAIT_OBJECT_0 + handles.size()) {
+      RunWaitCallback(result - WAIT_OBJECT_0);
+    }
+  }
+}
+
+RunLoop::Id RunLoop::AddWaitableHandle(HANDLE handle, WaitCallback callback) {
+  if (waitables_.size() >= kMaxWaitableHandles) {
+    return 0;
+  }
+  Id id = next_id_++;
+  waitables_.push_back({id, handle, std::move(callback)});
+  return id;
+}
+
+void RunLoop::RemoveWaitableHandle(Id id) {
+  waitables_.erase(std::remove_if(waitables_.begin(), waitables_.end(),
+                                  [id](const Waitable& waitable) {
+                                    return waitable.id == id;
+                                  }),
+                   waitables_.end());
+}
+
+RunLoop::Id RunLoop::AddIdleCallback(IdleCallback callback) {
+  Id id = next_id_++;
+  idle_callbacks_.push_back({id, std::move(callback)});
+  return id;
+}
+
+void RunLoop::RemoveIdleCallback(Id id) {
+  idle_callbacks_.erase(
+      std::remove_if(idle_callbacks_.begin(), idle_callbacks_.end(),
+                     [id](const Idle& idle) { return idle.id == id; }),
+      idle_callbacks_.end());
+}
+
+bool RunLoop::DispatchMessages(bool* messages_left) {
+  auto deadline = std::chrono::steady_clock::now() + kMessageTimeSlice;
+  MSG message;
+  for (int dispatched = 1; PeekMessage(&message, nullptr, 0, 0, PM_REMOVE);
+       ++dispatched) {
+    if (message.message == WM_QUIT) {
+      return false;
+    }
+    {
+      ScopedDispatch dispatch(watchdog_, message.message, message.hwnd);
+      TranslateMessage(&message);
+      DispatchMessage(&message);
+    }
+    if (dispatched >= kMaxMessagesPerPass ||
+        std::chrono::steady_clock::now() >= deadline) {
+      *messages_left = true;
+      return true;
+    }
+  }
+  return true;
+}
+
+void RunLoop::RunWaitCallback(size_t index) {
+  // The callback may remove its own registration, so run a copy.
+  WaitCallback callback = waitables_[index].callback;
+  std::rotate(waitables_.begin() + index, waitables_.begin() + index + 1,
+              waitables_.end());
+  ScopedDispatch dispatch(watchdog_, HangWatchdog::kWaitCallback);
+  callback();
+}
+
+bool RunLoop::RunIdleCallbacks() {
+  if (idle_callbacks_.empty()) {
+    return false;
+  }
+  auto deadline = std::chrono::steady_clock::now() + kIdleTimeSlice;
+  bool more_work = false;
+  // Each callback runs at most once per pass. Callbacks may add or remove
+  // callbacks, so positions are rechecked on every step.
+  for (size_t ran = 0; ran < idle_callbacks_.size(); ++ran) {
+    if (InputPending() || std::chrono::steady_clock::now() >= deadline) {
+      // Come back as soon as the input has been handled.
+      return true;
+    }
+    if (next_idle_ >= idle_callbacks_.size()) {
+      next_idle_ = 0;
+    }
+    IdleCallback callback = idle_callbacks_[next_idle_].callback;
+    ++next_idle_;
+    ScopedDispatch dispatch(watchdog_, HangWatchdog::kIdleCallback);
+    if (callback()) {
+      more_work = true;
+    }
+  }
+  return more_work;
+}
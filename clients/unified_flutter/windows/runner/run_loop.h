@@ -0,0 +1,106 @@
+#ifndef RUNNER_RUN_LOOP_H_
+#define RUNNER_RUN_LOOP_H_
+
+#include <windows.h>
+
+#include <functional>
+#include <vector>
+
+class HangWatchdog;
+
+// The platform thread's message loop.
+//
+// Besides dispatching window messages, which carry input as well as the
+// engine's own platform tasks, it waits on handles registered by runner
+// components and runs their callbacks when they are signalled. It also runs
+// idle callbacks when nothing else is pending, so native work can live on
+// the platform thread without a thread or window of its own.
+//
+// Messages go first, up to a budget per pass, after which a signalled
+// handle gets its turn even if more messages are queued. At most one handle
+// callback runs between checks of the message queue, and idle callbacks
+// stop as soon as input arrives or their time slice is used up, so neither
+// can starve input or the engine.
+//
+// Windows runs its own loop during modal operations such as moving or
+// resizing the window, and this one is suspended meanwhile. Work that must
+// keep flowing then belongs on PlatformTaskQueue.
+class RunLoop {
+ public:
+  // Identifies a registered handle or idle callback.
+  using Id = int;
+
+  using WaitCallback = std::function<void()>;
+
+  // Returns true if it has more work to do, in which case it is called again
+  // without waiting for a message or handle.
+  using IdleCallback = std::function<bool()>;
+
+  // Creates the loop. Must be called on the platform thread.
+  RunLoop();
+  ~RunLoop();
+
+  // Prevent copying.
+  RunLoop(RunLoop const&) = delete;
+  RunLoop& operator=(RunLoop const&) = delete;
+
+  // Runs until WM_QUIT is received.
+  void Run();
+
+  // Calls |callback| each time |handle| is signalled. A manual-reset event
+  // must be reset by the callback. Returns 0 if the loop already waits on
+  // the most handles it can.
+  Id AddWaitableHandle(HANDLE handle, WaitCallback callback);
+
+  // Stops waiting on a handle. Safe to call from its own callback.
+  void RemoveWaitableHandle(Id id);
+
+  // Runs |callback| whenever the loop is idle, until removed.
+  Id AddIdleCallback(IdleCallback callback);
+
+  // Removes an idle callback. Safe to call from any callback.
+  void RemoveIdleCallback(Id id);
+
+  // Times every message and callback with |watchdog|, which must outlive
+  // Run.
+  void SetWatchdog(HangWatchdog* watchdog) { watchdog_ = watchdog; }
+
+ private:
+  struct Waitable {
+    Id id;
+    HANDLE handle;
+    WaitCallback callback;
+  };
+
+  struct Idle {
+    Id id;
+    IdleCallback callback;
+  };
+
+  // Dispatches queued messages until none are left or the pass's budget is
+  // used up, in which case |messages_left| is set. Returns false once
+  // WM_QUIT is received.
+  bool DispatchMessages(bool* messages_left);
+
+  // Runs the callback of the handle at |index|, then moves the handle to the
+  // back so that busy handles cannot starve the ones after them.
+  void RunWaitCallback(size_t index);
+
+  // Runs idle callbacks until input arrives or the time slice is used up.
+  // Returns true if any has more work.
+  bool RunIdleCallbacks();
+
+  Id next_id_ = 1;
+
+  // In wait order.
+  std::vector<Waitable> waitables_;
+
+  std::vector<Idle> idle_callbacks_;
+
+  // Where the next idle pass starts, so every callback gets its turn.
+  size_t next_idle_ = 0;
+
+  HangWatchdog* watchdog_ = nullptr;
+};
+
+#endif  // RUNNER_RUN_LOOP_H_
@@ -0,0 +1,213 @@
+#include "runner_engine.h"
+
+#include <map>
+#include <utility>
+
+namespace {
+
+// A flutter::BinaryMessenger over the engine's C messenger, equivalent to the
+// one flutter::FlutterEngine keeps internally.
+class RunnerMessenger : public flutter::BinaryMessenger {
+ public:
+  explicit RunnerMessenger(FlutterDesktopMessengerRef messenger)
+      : messenger_(messenger) {}
+
+  // Prevent copying.
+  RunnerMessenger(RunnerMessenger const&) = delete;
+  RunnerMessenger& operator=(RunnerMessenger const&) = delete;
+
+  // flutter::BinaryMessenger:
+  void Send(const std::string& channel,
+            const uint8_t* message,
+            size_t message_size,
+            flutter::BinaryReply reply) const override {
+    if (!reply) {
+      FlutterDesktopMessengerSend(messenger_, channel.c_str(), message,
+                                  message_size);
+      return;
+    }
+    auto* captured_reply = new flutter::BinaryReply(std::move(reply));
+    if (!FlutterDesktopMessengerSendWithReply(messenger_, channel.c_str(),
+                                              message, message_size,
+                                              ForwardReply, captured_reply)) {
+      delete captured_reply;
+    }
+  }
+
+  void SetMessageHandler(const std::string& channel,
+                         flutter::BinaryMessageHandler handler) override {
+    if (!handler) {
+      handlers_.erase(channel);
+      FlutterDesktopMessengerSetCallback(messenger_, channel.c_str(), nullptr,
+                                         nullptr);
+      return;
+    }
+    // Map nodes are stable, so the engine can hold a pointer to the handler.
+    flutter::BinaryMessageHandler& stored = handlers_[channel];
+    stored = std::move(handler);
+    FlutterDesktopMessengerSetCallback(messenger_, channel.c_str(),
+                                       ForwardToHandler, &stored);
+  }
+
+ private:
+  static void ForwardReply(const uint8_t* data,
+                           size_t data_size,
+                           void* user_data) {
+    auto* reply = static_cast<flutter::BinaryReply*>(user_data);
+    (*reply)(data, data_size);
+    delete reply;
+  }
+
+  static void ForwardToHandler(FlutterDesktopMessengerRef messenger,
+                               const FlutterDesktopMessage* message,
+                               void* user_data) {
+    const FlutterDesktopMessageResponseHandle* response_handle =
+        message->response_handle;
+    flutter::BinaryReply reply = [messenger, response_handle](
+                                     const uint8_t* reply_data,
+                                     size_t reply_size) mutable {
+      if (!response_handle) {
+        return;
+      }
+      FlutterDesktopMessengerSendResponse(messenger, response_handle,
+                                          reply_data, reply_size);
+      // A response handle can only be used once.
+      response_handle = nullptr;
+    };
+    auto& handler = *static_cast<flutter::BinaryMessageHandler*>(user_data);
+    handler(message->message, message->message_size, std::move(reply));
+  }
+
+  FlutterDesktopMessengerRef messenger_;
+
+  std::map<std::string, flutter::BinaryMessageHandler> handlers_;
+};
+
+}  // namespace
+
+// static
+std::unique_ptr<RunnerEngine> RunnerEngine::Start(
+    const std::wstring& data_directory,
+    const std::vector<std::string>& dart_entrypoint_arguments) {
+  // The same layout flutter::DartProject assumes.
+  std::wstring assets_path = data_directory + L"\\flutter_assets";
+  std::wstring icu_data_path = data_directory + L"\\icudtl.dat";
+  std::wstring aot_library_path = data_directory + L"\\app.so";
+
+  std::vector<const char*> argv;
+  for (const std::string& argument : dart_entrypoint_arguments) {
+    argv.push_back(argument.c_str());
+  }
+
+  FlutterDesktopEngineProperties properties{};
+  properties.assets_path = assets_path.c_str();
+  properties.icu_data_path = icu_data_path.c_str();
+  properties.aot_library_path = aot_library_path.c_str();
+  properties.dart_entrypoint_argc = static_cast<int>(argv.size());
+  properties.dart_entrypoint_argv = argv.empty() ? nullptr : argv.data();
+
+  // The engine copies the properties, so the strings above need not outlive
+  // this call.
+  FlutterDesktopEngineRef engine = FlutterDesktopEngineCreate(&properties);
+  if (!engine) {
+    return nullptr;
+  }
+  // If this fails, the view controller retries when it is created.
+  FlutterDesktopEngineRun(engine, nullptr);
+  return std::unique_ptr<RunnerEngine>(new RunnerEngine(engine));
+}
+
+RunnerEngine::RunnerEngine(FlutterDesktopEngineRef engine)
+    : engine_(engine),
+      messenger_(std::make_unique<RunnerMessenger>(
+          FlutterDesktopEngineGetMessenger(engine))) {}
+
+RunnerEngine::~RunnerEngine() {
+  FlutterDesktopEngineDestroy(engine_);
+}
+
+void RunnerEngine::ReloadSystemFonts() {
+  FlutterDesktopEngineReloadSystemFonts(engine_);
+}
+
+void RunnerEngine::AddNextFrameCallback(std::function<void()> callback) {
+  next_frame_callbacks_.push_back(std::move(callback));
+  // The engine keeps a single callback, so one runs all that were added.
+  FlutterDesktopEngineSetNextFrameCallback(
+      engine_,
+      [](void* user_data) {
+        auto* self = static_cast<RunnerEngine*>(user_data);
+        // Moved out first, as the callbacks may add new ones.
+        std::vector<std::function<void()>> pending =
+            std::move(self->next_frame_callbacks_);
+        self->next_frame_callbacks_.clear();
+        for (const std::function<void()>& callback : pending) {
+          callback();
+        }
+      },
+      this);
+}
+
+std::optional<LRESULT> RunnerEngine::ProcessExternalWindowMessage(
+    HWND hwnd,
+    UINT message,
+    WPARAM wparam,
+    LPARAM lparam) {
+  LRESULT result;
+  if (FlutterDesktopEngineProcessExternalWindowMessage(
+          engine_, hwnd, message, wparam, lparam, &result)) {
+    return result;
+  }
+  return std::nullopt;
+}
+
+FlutterDesktopPluginRegistrarRef RunnerEngine::GetRegistrarForPlugin(
+    const std::string& plugin_name) {
+  return FlutterDesktopEngineGetPluginRegistrar(engine_, plugin_name.c_str());
+}
+
+RunnerViewController::RunnerViewController(int width,
+                                           int height,
+                                           RunnerEngine* engine)
+    : engine_(engine) {
+  FlutterDesktopViewControllerProperties properties{};
+  properties.width = width;
+  properties.height = height;
+  // Unlike FlutterDesktopViewControllerCreate, this leaves the engine owned
+  // by RunnerEngine, so other views can share it.
+  controller_ =
+      FlutterDesktopEngineCreateViewController(engine_->engine_, &properties);
+}
+
+RunnerViewController::~RunnerViewController() {
+  // Removes the view from the engine, which keeps running.
+  if (controller_) {
+    FlutterDesktopViewControllerDestroy(controller_);
+  }
+}
+
+FlutterDesktopViewId RunnerViewController::view_id() {
+  return FlutterDesktopViewControllerGetViewId(controller_);
+}
+
+HWND RunnerViewController::GetNativeWindow() {
+  return FlutterDesktopViewGetHWND(
+      FlutterDesktopViewControllerGetView(controller_));
+}
+
+void RunnerViewController::ForceRedraw() {
+  FlutterDesktopViewControllerForceRedraw(controller_);
+}
+
+std::optional<LRESULT> RunnerViewController::HandleTopLevelWindowProc(
+    HWND hwnd,
+    UINT message,
+    WPARAM wparam,
+    LPARAM lparam) {
+  LRESULT result;
+  if (FlutterDesktopViewControllerHandleTopLevelWindowProc(
+          controller_, hwnd, message, wparam, lparam, &result)) {
+    return result;
+  }
+  return std::nullopt;
+}
@@ -0,0 +1,111 @@
+#ifndef RUNNER_RUNNER_ENGINE_H_
+#define RUNNER_RUNNER_ENGINE_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/plugin_registry.h>
+#include <flutter_windows.h>
+#include <windows.h>
+
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+// A Flutter engine that runs before it has a view, and can host several.
+//
+// flutter::FlutterViewController only creates its engine together with the
+// view. Starting the engine from wWinMain instead lets the AOT snapshot, ICU
+// data and root isolate load on the engine's threads while the platform
+// thread registers the window class and creates the window. Views then
+// attach to the running engine through RunnerViewController: the first is
+// the implicit view that runApp renders into, and every further one shares
+// the engine's isolate, snapshot and GPU context, adding only its surface.
+class RunnerEngine : public flutter::PluginRegistry {
+ public:
+  // Creates an engine for the app bundled in |data_directory| (relative to
+  // the executable, as for flutter::DartProject) and starts running its Dart
+  // entrypoint with |dart_entrypoint_arguments|. Returns null if the engine
+  // could not be created.
+  static std::unique_ptr<RunnerEngine> Start(
+      const std::wstring& data_directory,
+      const std::vector<std::string>& dart_entrypoint_arguments);
+
+  ~RunnerEngine() override;
+
+  // Prevent copying.
+  RunnerEngine(RunnerEngine const&) = delete;
+  RunnerEngine& operator=(RunnerEngine const&) = delete;
+
+  // The messenger for communicating with the engine.
+  flutter::BinaryMessenger* messenger() { return messenger_.get(); }
+
+  // Tells the engine to reload the system fonts.
+  void ReloadSystemFonts();
+
+  // Adds a callback to run on the platform thread once the next frame has
+  // been drawn, in any view. Callbacks added before then all run.
+  void AddNextFrameCallback(std::function<void()> callback);
+
+  // Gives the engine, including plugins, a chance to handle a message sent
+  // to a top-level window other than the one hosting a view. Its lifecycle
+  // handling also takes messages made up for a window hosting a view, such
+  // as WM_SHOWWINDOW for one that it can't otherwise tell is out of sight.
+  std::optional<LRESULT> ProcessExternalWindowMessage(HWND hwnd,
+                                                      UINT message,
+                                                      WPARAM wparam,
+                                                      LPARAM lparam);
+
+  // flutter::PluginRegistry:
+  FlutterDesktopPluginRegistrarRef GetRegistrarForPlugin(
+      const std::string& plugin_name) override;
+
+ private:
+  friend class RunnerViewController;
+
+  explicit RunnerEngine(FlutterDesktopEngineRef engine);
+
+  FlutterDesktopEngineRef engine_ = nullptr;
+
+  std::unique_ptr<flutter::BinaryMessenger> messenger_;
+
+  std::vector<std::function<void()>> next_frame_callbacks_;
+};
+
+// A view hosting a RunnerEngine, in place of flutter::FlutterViewController.
+class RunnerViewController {
+ public:
+  // Creates a |width| x |height| view for |engine|, starting the engine if
+  // it is not already running. |engine| must outlive the view.
+  RunnerViewController(int width, int height, RunnerEngine* engine);
+  ~RunnerViewController();
+
+  // Prevent copying.
+  RunnerViewController(RunnerViewController const&) = delete;
+  RunnerViewController& operator=(RunnerViewController const&) = delete;
+
+  // Returns null if the view could not be created.
+  RunnerEngine* engine() { return controller_ ? engine_ : nullptr; }
+
+  // The id Dart knows the view by, as in FlutterView.viewId.
+  FlutterDesktopViewId view_id();
+
+  // The HWND of the view.
+  HWND GetNativeWindow();
+
+  // Requests a new frame from the engine and repaints the view.
+  void ForceRedraw();
+
+  // Lets the view and plugins handle a message sent to the top-level window
+  // hosting the view.
+  std::optional<LRESULT> HandleTopLevelWindowProc(HWND hwnd,
+                                                  UINT message,
+                                                  WPARAM wparam,
+                                                  LPARAM lparam);
+
+ private:
+  RunnerEngine* engine_;
+  FlutterDesktopViewControllerRef controller_ = nullptr;
+};
+
+#endif  // RUNNER_RUNNER_ENGINE_H_
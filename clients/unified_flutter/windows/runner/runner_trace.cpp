@@ -0,0 +1,40 @@
+#include "runner_trace.h"
+
+#include <utility>
+
+// {5c178415-3d7c-5bf7-a235-72d85d4c6aa6}, hashed from "TamshaiAI.Runner".
+TRACELOGGING_DEFINE_PROVIDER(g_runner_trace_provider,
+                             "TamshaiAI.Runner",
+                             (0x5c178415, 0x3d7c, 0x5bf7, 0xa2, 0x35, 0x72,
+                              0xd8, 0x5d, 0x4c, 0x6a, 0xa6));
+
+void RegisterRunnerTraceProvider() {
+  TraceLoggingRegister(g_runner_trace_provider);
+}
+
+void UnregisterRunnerTraceProvider() {
+  TraceLoggingUnregister(g_runner_trace_provider);
+}
+
+TraceSpan::TraceSpan(std::string name) : name_(std::move(name)) {
+  EventActivityIdControl(EVENT_ACTIVITY_CTRL_CREATE_ID, &activity_id_);
+  TraceLoggingWriteActivity(g_runner_trace_provider, "Span", &activity_id_,
+                            nullptr,
+                            TraceLoggingOpcode(WINEVENT_OPCODE_START),
+                            TraceLoggingString(name_.c_str(), "Name"));
+}
+
+TraceSpan::~TraceSpan() {
+  End();
+}
+
+void TraceSpan::End() {
+  if (ended_) {
+    return;
+  }
+  ended_ = true;
+  TraceLoggingWriteActivity(g_runner_trace_provider, "Span", &activity_id_,
+                            nullptr,
+                            TraceLoggingOpcode(WINEVENT_OPCODE_STOP),
+                            TraceLoggingString(name_.c_str(), "Name"));
+}
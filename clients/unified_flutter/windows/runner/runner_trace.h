@@ -0,0 +1,45 @@
+#ifndef RUNNER_RUNNER_TRACE_H_
+#define RUNNER_RUNNER_TRACE_H_
+
+#include <windows.h>
+
+#include <TraceLoggingProvider.h>
+
+#include <string>
+
+// TraceLogging provider for the runner, "TamshaiAI.Runner".
+//
+// Its GUID is derived from the name the same way EventSource does, so WPR
+// profiles and `tracelog`/`xperf` can enable it as "*TamshaiAI.Runner"
+// without knowing the GUID.
+TRACELOGGING_DECLARE_PROVIDER(g_runner_trace_provider);
+
+// Registers and unregisters the provider. Events written while it is not
+// registered are dropped.
+void RegisterRunnerTraceProvider();
+void UnregisterRunnerTraceProvider();
+
+// A timed region, written as a pair of "Span" start/stop events that share an
+// activity ID, which WPA pairs into a region.
+class TraceSpan {
+ public:
+  // Starts a span called |name|.
+  explicit TraceSpan(std::string name);
+
+  // Ends the span if End has not been called.
+  ~TraceSpan();
+
+  // Prevent copying.
+  TraceSpan(TraceSpan const&) = delete;
+  TraceSpan& operator=(TraceSpan const&) = delete;
+
+  // Ends the span before it goes out of scope.
+  void End();
+
+ private:
+  std::string name_;
+  GUID activity_id_{};
+  bool ended_ = false;
+};
+
+#endif  // RUNNER_RUNNER_TRACE_H_
@@ -0,0 +1,300 @@
+#include "single_instance.h"
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+// "Local\" scopes the mutex to the current login session, so each user on a
+// shared host gets their own primary instance.
+constexpr const wchar_t kMutexName[] = L"Local\\TamshaiAI.SingleInstance";
+constexpr const wchar_t kPipeNamePrefix[] =
+    L"\\\\.\\pipe\\TamshaiAI.Activation.";
+
+// Forwarded command lines are small; anything larger is rejected.
+constexpr DWORD kMaxMessageSize = 64 * 1024;
+
+// Byte the primary writes back once it has queued the arguments.
+constexpr char kAck = 1;
+
+// How long a second launch keeps trying to reach a primary that holds the
+// mutex but has not created its pipe yet.
+constexpr int kConnectAttempts = 20;
+constexpr DWORD kConnectRetryDelayMs = 50;
+constexpr DWORD kPipeBusyTimeoutMs = 500;
+
+// How long the listener waits on a connected client before dropping it.
+constexpr DWORD kClientTimeoutMs = 2000;
+
+// Whether |process_id| runs this process's executable. The pipe name is
+// predictable, so another program could serve it first; it must not be
+// handed the arguments, which may carry an OAuth code.
+bool RunsThisExecutable(ULONG process_id) {
+  wchar_t own_path[MAX_PATH];
+  DWORD own_length = GetModuleFileName(nullptr, own_path, MAX_PATH);
+  if (own_length == 0 || own_length == MAX_PATH) {
+    return false;
+  }
+  HANDLE process =
+      OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, process_id);
+  if (!process) {
+    return false;
+  }
+  wchar_t server_path[MAX_PATH];
+  DWORD server_length = MAX_PATH;
+  BOOL queried =
+      QueryFullProcessImageName(process, 0, server_path, &server_length);
+  CloseHandle(process);
+  return queried &&
+         CompareStringOrdinal(own_path, static_cast<int>(own_length),
+                              server_path, static_cast<int>(server_length),
+                              TRUE) == CSTR_EQUAL;
+}
+
+// Serializes |arguments| as a sequence of length-prefixed UTF-8 strings.
+std::string EncodeArguments(const std::vector<std::string>& arguments) {
+  std::string message;
+  for (const std::string& argument : arguments) {
+    uint32_t length = static_cast<uint32_t>(argument.size());
+    message.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    message.append(argument);
+  }
+  return message;
+}
+
+// Inverse of EncodeArguments. Returns false if |message| is malformed.
+bool DecodeArguments(const std::string& message,
+                     std::vector<std::string>& arguments) {
+  size_t position = 0;
+  while (position < message.size()) {
+    uint32_t length;
+    if (message.size() - position < sizeof(length)) {
+      return false;
+    }
+    memcpy(&length, message.data() + position, sizeof(length));
+    position += sizeof(length);
+    if (message.size() - position < length) {
+      return false;
+    }
+    arguments.emplace_back(message.data() + position, length);
+    position += length;
+  }
+  return true;
+}
+
+// Waits for the overlapped operation that |started| describes. Returns false
+// if it fails, times out (in which case it is cancelled) or |stop_event| is
+// signalled first. A message read that filled the buffer before the end of
+// the message succeeds with |more_data| set, if provided.
+bool CompleteIo(HANDLE pipe,
+                OVERLAPPED& overlapped,
+                BOOL started,
+                HANDLE stop_event,
+                DWORD timeout_ms,
+                DWORD* bytes_transferred,
+                bool* more_data = nullptr) {
+  if (more_data) {
+    *more_data = false;
+  }
+  DWORD error = started ? ERROR_SUCCESS : GetLastError();
+  if (!started && error != ERROR_IO_PENDING && error != ERROR_MORE_DATA) {
+    return false;
+  }
+  if (error == ERROR_IO_PENDING) {
+    HANDLE handles[] = {overlapped.hEvent, stop_event};
+    DWORD wait = WaitForMultipleObjects(2, handles, FALSE, timeout_ms);
+    if (wait != WAIT_OBJECT_0) {
+      CancelIo(pipe);
+      GetOverlappedResult(pipe, &overlapped, bytes_transferred, TRUE);
+      return false;
+    }
+  }
+  if (!GetOverlappedResult(pipe, &overlapped, bytes_transferred, FALSE)) {
+    if (GetLastError() != ERROR_MORE_DATA) {
+      return false;
+    }
+    if (more_data) {
+      *more_data = true;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+SingleInstance* SingleInstance::instance_ = nullptr;
+
+SingleInstance::~SingleInstance() {
+  StopListening();
+  if (mutex_) {
+    ReleaseMutex(mutex_);
+    CloseHandle(mutex_);
+  }
+}
+
+// static
+SingleInstance* SingleInstance::GetInstance() {
+  if (!instance_) {
+    instance_ = new SingleInstance();
+  }
+  return instance_;
+}
+
+bool SingleInstance::AcquirePrimary() {
+  DWORD session_id = 0;
+  ProcessIdToSessionId(GetCurrentProcessId(), &session_id);
+  pipe_name_ = kPipeNamePrefix + std::to_wstring(session_id);
+
+  mutex_ = CreateMutex(nullptr, TRUE, kMutexName);
+  if (mutex_ && GetLastError() == ERROR_ALREADY_EXISTS) {
+    CloseHandle(mutex_);
+    mutex_ = nullptr;
+    return false;
+  }
+  // If the mutex could not be created at all, run as a standalone instance
+  // rather than refusing to start.
+  return true;
+}
+
+bool SingleInstance::ForwardToPrimary(
+    const std::vector<std::string>& arguments) {
+  HANDLE pipe = INVALID_HANDLE_VALUE;
+  for (int attempt = 0; attempt < kConnectAttempts; ++attempt) {
+    pipe = CreateFile(pipe_name_.c_str(), GENERIC_READ | GENERIC_WRITE, 0,
+                      nullptr, OPEN_EXISTING, 0, nullptr);
+    if (pipe != INVALID_HANDLE_VALUE) {
+      break;
+    }
+    if (GetLastError() == ERROR_PIPE_BUSY) {
+      WaitNamedPipe(pipe_name_.c_str(), kPipeBusyTimeoutMs);
+    } else {
+      Sleep(kConnectRetryDelayMs);
+    }
+  }
+  if (pipe == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  DWORD mode = PIPE_READMODE_MESSAGE;
+  SetNamedPipeHandleState(pipe, &mode, nullptr, nullptr);
+
+  ULONG server_process_id = 0;
+  if (!GetNamedPipeServerProcessId(pipe, &server_process_id) ||
+      !RunsThisExecutable(server_process_id)) {
+    CloseHandle(pipe);
+    return false;
+  }
+  // This process was launched by the user and may take the foreground; pass
+  // that right on so the primary can raise its window.
+  AllowSetForegroundWindow(server_process_id);
+
+  std::string message = EncodeArguments(arguments);
+  DWORD bytes_written = 0;
+  char ack = 0;
+  DWORD bytes_read = 0;
+  bool delivered =
+      WriteFile(pipe, message.data(), static_cast<DWORD>(message.size()),
+                &bytes_written, nullptr) &&
+      ReadFile(pipe, &ack, sizeof(ack), &bytes_read, nullptr) &&
+      bytes_read == sizeof(ack) && ack == kAck;
+  CloseHandle(pipe);
+  return delivered;
+}
+
+void SingleInstance::StartListening() {
+  if (listener_.joinable() || pipe_name_.empty()) {
+    return;
+  }
+  stop_event_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+  listener_ = std::thread(&SingleInstance::Listen, this);
+}
+
+void SingleInstance::StopListening() {
+  if (!listener_.joinable()) {
+    return;
+  }
+  stopping_ = true;
+  SetEvent(stop_event_);
+  listener_.join();
+  CloseHandle(stop_event_);
+  stop_event_ = nullptr;
+}
+
+void SingleInstance::SetActivationHandler(ActivationHandler handler) {
+  std::lock_guard<std::mutex> lock(handler_mutex_);
+  handler_ = std::move(handler);
+  if (handler_) {
+    for (auto& arguments : pending_) {
+      handler_(std::move(arguments));
+    }
+    pending_.clear();
+  }
+}
+
+void SingleInstance::Listen() {
+  OVERLAPPED overlapped{};
+  overlapped.hEvent = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+
+  while (!stopping_) {
+    // FILE_FLAG_FIRST_PIPE_INSTANCE makes creation fail if another process
+    // has squatted on the name.
+    HANDLE pipe = CreateNamedPipe(
+        pipe_name_.c_str(),
+        PIPE_ACCESS_DUPLEX | FILE_FLAG_OVERLAPPED |
+            FILE_FLAG_FIRST_PIPE_INSTANCE,
+        PIPE_TYPE_MESSAGE | PIPE_READMODE_MESSAGE | PIPE_WAIT |
+            PIPE_REJECT_REMOTE_CLIENTS,
+        1, sizeof(kAck), kMaxMessageSize, 0, nullptr);
+    if (pipe == INVALID_HANDLE_VALUE) {
+      break;
+    }
+
+    DWORD bytes = 0;
+    ResetEvent(overlapped.hEvent);
+    BOOL started = ConnectNamedPipe(pipe, &overlapped);
+    bool connected = (!started && GetLastError() == ERROR_PIPE_CONNECTED) ||
+                     CompleteIo(pipe, overlapped, started, stop_event_,
+                                INFINITE, &bytes);
+
+    std::string message;
+    bool complete = false;
+    while (connected && !complete && message.size() < kMaxMessageSize) {
+      char buffer[4096];
+      ResetEvent(overlapped.hEvent);
+      started = ReadFile(pipe, buffer, sizeof(buffer), nullptr, &overlapped);
+      bool more_data = false;
+      if (!CompleteIo(pipe, overlapped, started, stop_event_,
+                      kClientTimeoutMs, &bytes, &more_data)) {
+        break;
+      }
+      message.append(buffer, bytes);
+      complete = !more_data;
+    }
+
+    std::vector<std::string> arguments;
+    if (complete && DecodeArguments(message, arguments)) {
+      Dispatch(std::move(arguments));
+      ResetEvent(overlapped.hEvent);
+      started = WriteFile(pipe, &kAck, sizeof(kAck), nullptr, &overlapped);
+      CompleteIo(pipe, overlapped, started, stop_event_, kClientTimeoutMs,
+                 &bytes);
+    }
+
+    DisconnectNamedPipe(pipe);
+    CloseHandle(pipe);
+  }
+
+  CloseHandle(overlapped.hEvent);
+}
+
+void SingleInstance::Dispatch(std::vector<std::string> arguments) {
+  // The handler runs under the lock so that once SetActivationHandler(nullptr)
+  // returns, the previous handler is guaranteed not to be running.
+  std::lock_guard<std::mutex> lock(handler_mutex_);
+  if (handler_) {
+    handler_(std::move(arguments));
+  } else {
+    pending_.push_back(std::move(arguments));
+  }
+}
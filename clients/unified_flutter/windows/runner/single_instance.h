@@ -0,0 +1,79 @@
+#ifndef RUNNER_SINGLE_INSTANCE_H_
+#define RUNNER_SINGLE_INSTANCE_H_
+
+#include <windows.h>
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Keeps the runner to one process per user session.
+//
+// The first process to start owns a named mutex and serves a named pipe.
+// Later launches (OAuth redirects, "open in Tamshai" shortcuts) find the
+// mutex taken, send their command line arguments down the pipe and exit
+// without creating an engine.
+class SingleInstance {
+ public:
+  using ActivationHandler =
+      std::function<void(std::vector<std::string> arguments)>;
+
+  ~SingleInstance();
+
+  // Returns the process-wide instance.
+  static SingleInstance* GetInstance();
+
+  // Tries to become the primary instance. Returns false if another process
+  // already is. Must be called before any other method.
+  bool AcquirePrimary();
+
+  // Sends |arguments| to the primary instance and lets it take the
+  // foreground. Returns true once the primary has acknowledged them; false if
+  // it could not be reached, or the pipe is served by another executable, in
+  // which case this process should start normally.
+  bool ForwardToPrimary(const std::vector<std::string>& arguments);
+
+  // Starts serving the activation pipe on a background thread. Only valid on
+  // the primary instance.
+  void StartListening();
+
+  // Stops the listener thread started by StartListening, if any.
+  void StopListening();
+
+  // Sets the handler for arguments forwarded by later launches, or clears it
+  // if |handler| is null. The handler runs on the listener thread and must not
+  // call back into SingleInstance. Arguments received while no handler is set
+  // are kept and passed to the next one.
+  void SetActivationHandler(ActivationHandler handler);
+
+ private:
+  SingleInstance() = default;
+
+  // Body of the listener thread.
+  void Listen();
+
+  // Hands |arguments| to the handler, or queues them if there is none.
+  void Dispatch(std::vector<std::string> arguments);
+
+  static SingleInstance* instance_;
+
+  HANDLE mutex_ = nullptr;
+  std::wstring pipe_name_;
+
+  std::thread listener_;
+  std::atomic<bool> stopping_{false};
+
+  // Signalled to wake the listener for shutdown.
+  HANDLE stop_event_ = nullptr;
+
+  std::mutex handler_mutex_;
+
+  // Guarded by |handler_mutex_|.
+  ActivationHandler handler_;
+  std::vector<std::vector<std::string>> pending_;
+};
+
+#endif  // RUNNER_SINGLE_INSTANCE_H_
@@ -0,0 +1,98 @@
+#include "sse_event_parser.h"
+
+#include <cstring>
+#include <utility>
+
+SseEventParser::SseEventParser(EventCallback on_event)
+    : on_event_(std::move(on_event)) {}
+
+void SseEventParser::Append(const char* data, size_t size) {
+  size_t position = 0;
+  if (skip_next_line_feed_ && size > 0) {
+    skip_next_line_feed_ = false;
+    if (data[0] == '\n') {
+      position = 1;
+    }
+  }
+
+  while (position < size) {
+    // Find the next line terminator; lines may end in CR, LF or CRLF.
+    size_t end = position;
+    while (end < size && data[end] != '\n' && data[end] != '\r') {
+      ++end;
+    }
+    if (end == size) {
+      partial_line_.append(data + position, size - position);
+      return;
+    }
+
+    if (partial_line_.empty()) {
+      ProcessLine(data + position, end - position);
+    } else {
+      partial_line_.append(data + position, end - position);
+      ProcessLine(partial_line_.data(), partial_line_.size());
+      partial_line_.clear();
+    }
+
+    if (data[end] == '\r') {
+      if (end + 1 == size) {
+        skip_next_line_feed_ = true;
+      } else if (data[end + 1] == '\n') {
+        ++end;
+      }
+    }
+    position = end + 1;
+  }
+}
+
+void SseEventParser::Finish() {
+  if (!partial_line_.empty()) {
+    ProcessLine(partial_line_.data(), partial_line_.size());
+    partial_line_.clear();
+  }
+  DispatchEvent();
+}
+
+void SseEventParser::ProcessLine(const char* line, size_t length) {
+  if (length == 0) {
+    DispatchEvent();
+    return;
+  }
+  // Lines starting with a colon are comments (used as keep-alives).
+  if (line[0] == ':') {
+    return;
+  }
+
+  const char* colon = static_cast<const char*>(memchr(line, ':', length));
+  size_t name_length = colon ? static_cast<size_t>(colon - line) : length;
+  const char* value = line + length;
+  size_t value_length = 0;
+  if (colon) {
+    value = colon + 1;
+    value_length = length - name_length - 1;
+    if (value_length > 0 && value[0] == ' ') {
+      ++value;
+      --value_length;
+    }
+  }
+
+  if (name_length == 4 && memcmp(line, "data", 4) == 0) {
+    if (has_data_) {
+      pending_.data.push_back('\n');
+    }
+    pending_.data.append(value, value_length);
+    has_data_ = true;
+  } else if (name_length == 5 && memcmp(line, "event", 5) == 0) {
+    pending_.event.assign(value, value_length);
+  }
+  // "id" and "retry" are not used by the gateway and are ignored.
+}
+
+void SseEventParser::DispatchEvent() {
+  if (has_data_) {
+    on_event_(pending_);
+  }
+  pending_.event.clear();
+  pending_.data.clear();
+  has_data_ = false;
+}
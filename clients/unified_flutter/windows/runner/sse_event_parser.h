@@ -0,0 +1,58 @@
+#ifndef RUNNER_SSE_EVENT_PARSER_H_
+#define RUNNER_SSE_EVENT_PARSER_H_
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// A single dispatched server-sent event.
+struct SseEvent {
+  // Value of the last "event:" field, or empty for the default event type.
+  std::string event;
+
+  // Concatenated "data:" fields, joined with '\n'.
+  std::string data;
+};
+
+// Incremental parser for a text/event-stream body.
+//
+// Bytes can be fed in arbitrary chunks as they arrive from the network; the
+// parser keeps only the current partial line and the event being built, so
+// the work per chunk is proportional to the chunk size rather than to the
+// amount of data buffered so far.
+class SseEventParser {
+ public:
+  using EventCallback = std::function<void(const SseEvent& event)>;
+
+  explicit SseEventParser(EventCallback on_event);
+
+  // Feeds |size| bytes of the stream. |on_event| is called synchronously for
+  // each event completed by these bytes.
+  void Append(const char* data, size_t size);
+
+  // Dispatches a trailing event that was not terminated by a blank line.
+  // Called when the connection closes.
+  void Finish();
+
+ private:
+  // Processes one complete line, without its terminator.
+  void ProcessLine(const char* line, size_t length);
+
+  // Calls |on_event_| if the pending event has any data, then resets it.
+  void DispatchEvent();
+
+  EventCallback on_event_;
+
+  // Bytes of a line whose terminator has not arrived yet.
+  std::string partial_line_;
+
+  // The event being assembled from field lines.
+  SseEvent pending_;
+  bool has_data_ = false;
+
+  // True if the previous chunk ended in '\r', so a leading '\n' in the next
+  // chunk belongs to the same CRLF terminator.
+  bool skip_next_line_feed_ = false;
+};
+
+#endif  // RUNNER_SSE_EVENT_PARSER_H_
@@ -0,0 +1,728 @@
+#include "sse_stream_plugin.h"
+
+#include <flutter/event_stream_handler_functions.h>
+#include <flutter/standard_method_codec.h>
+
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "certificate_pinner.h"
+#include "connection_prewarmer.h"
+#include "json_decoder.h"
+#include "sse_event_parser.h"
+#include "text_transcoder.h"
+#include "utils.h"
+
+namespace {
+
+constexpr char kMethodChannelName[] = "com.tamshai.ai/sse";
+constexpr char kEventChannelName[] = "com.tamshai.ai/sse/events";
+
+// Size of the buffer each worker reads the response body into.
+constexpr DWORD kReadBufferSize = 16 * 1024;
+
+// How much of a document is escaped at a time while it is written out.
+constexpr size_t kDocumentWriteSize = 64 * 1024;
+
+// Upper bound on how much of an error response body is read for its message.
+constexpr size_t kMaxErrorBodySize = 64 * 1024;
+
+// Timeouts matching the Dio client used on the other platforms.
+constexpr int kConnectTimeoutMs = 30 * 1000;
+constexpr int kReceiveTimeoutMs = 60 * 1000;
+
+using flutter::EncodableList;
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+// Returns the value stored under |key| in |map|, or nullptr.
+const EncodableValue* Lookup(const EncodableMap& map, const char* key) {
+  auto it = map.find(EncodableValue(key));
+  return it == map.end() ? nullptr : &it->second;
+}
+
+// Returns the string stored under |key| in |map|, or nullptr if it is missing
+// or not a string.
+const std::string* LookupString(const EncodableMap& map, const char* key) {
+  const EncodableValue* value = Lookup(map, key);
+  return value ? std::get_if<std::string>(value) : nullptr;
+}
+
+// Returns |value| if it is an integer, or std::nullopt.
+std::optional<int64_t> IntValue(const EncodableValue& value) {
+  if (const auto* value32 = std::get_if<int32_t>(&value)) {
+    return *value32;
+  }
+  if (const auto* value64 = std::get_if<int64_t>(&value)) {
+    return *value64;
+  }
+  return std::nullopt;
+}
+
+// Whether |name| and |value| make a header line on their own: a line break
+// in either would start another header, and a colon in the name would move
+// where the value begins.
+bool IsValidHeader(const std::string& name, const std::string& value) {
+  return !name.empty() && name.find_first_of("\r\n:") == std::string::npos &&
+         value.find_first_of("\r\n") == std::string::npos;
+}
+
+// Returns the map stored under |key| in |map|, or nullptr if it is missing or
+// not a map.
+const EncodableMap* LookupMap(const EncodableMap& map, const char* key) {
+  const EncodableValue* value = Lookup(map, key);
+  return value ? std::get_if<EncodableMap>(value) : nullptr;
+}
+
+// Returns the list stored under |key| in |map|, or nullptr if it is missing
+// or not a list.
+const EncodableList* LookupList(const EncodableMap& map, const char* key) {
+  const EncodableValue* value = Lookup(map, key);
+  return value ? std::get_if<EncodableList>(value) : nullptr;
+}
+
+// The request body is {"query": "..."}, with any documents appended to the
+// query string; these are the parts around its escaped text.
+constexpr char kQueryStart[] = "{\"query\":\"";
+constexpr char kQueryEnd[] = "\"}";
+constexpr size_t kQueryEndSize = sizeof(kQueryEnd) - 1;
+
+// The line introducing |document| in the query, escaped for JSON.
+std::string DocumentHeading(const DocumentIngestPlugin::Document& document) {
+  std::string heading = "\n\n--- Attached document: " + document.name +
+                        " ---\n";
+  std::string escaped;
+  AppendJsonEscaped(heading.data(), heading.size(), &escaped);
+  return escaped;
+}
+
+// Writes all of |data| to the body of |request|.
+bool WriteAll(HINTERNET request, const char* data, size_t size) {
+  while (size > 0) {
+    DWORD written = 0;
+    if (!WinHttpWriteData(request, data, static_cast<DWORD>(size),
+                          &written)) {
+      return false;
+    }
+    data += written;
+    size -= written;
+  }
+  return true;
+}
+
+EncodableMap MakeEvent(const char* type) {
+  return EncodableMap{{EncodableValue("type"), EncodableValue(type)}};
+}
+
+EncodableMap MakeErrorEvent(const char* kind, const std::string& message) {
+  EncodableMap event = MakeEvent("error");
+  event[EncodableValue("errorKind")] = EncodableValue(kind);
+  event[EncodableValue("error")] = EncodableValue(message);
+  return event;
+}
+
+// Copies |key| from |source| into |event| under |target_key| if present.
+void CopyField(const EncodableMap& source,
+               const char* key,
+               EncodableMap& event,
+               const char* target_key) {
+  if (const EncodableValue* value = Lookup(source, key)) {
+    event[EncodableValue(target_key)] = *value;
+  }
+}
+
+// Translates one SSE event from the gateway into the event map delivered to
+// Dart, mirroring the Anthropic and MCP Gateway formats understood by
+// ChatService. Returns std::nullopt for events Dart does not need.
+std::optional<EncodableMap> TranslateEvent(const SseEvent& sse_event) {
+  if (sse_event.data == "[DONE]") {
+    return MakeEvent("done");
+  }
+
+  std::optional<EncodableValue> json = DecodeJson(sse_event.data);
+  const EncodableMap* object =
+      json ? std::get_if<EncodableMap>(&*json) : nullptr;
+  if (!object) {
+    return MakeErrorEvent("parse", "Failed to parse response");
+  }
+
+  const std::string* type = LookupString(*object, "type");
+  std::string type_name = type ? *type : std::string();
+
+  if (type_name == "content_block_delta" || type_name == "text") {
+    EncodableMap event = MakeEvent("contentBlockDelta");
+    const EncodableMap* delta =
+        type_name == "text" ? object : LookupMap(*object, "delta");
+    if (delta) {
+      CopyField(*delta, "text", event, "text");
+    }
+    return event;
+  }
+  if (type_name == "message_start") {
+    EncodableMap event = MakeEvent("messageStart");
+    CopyField(*object, "message", event, "metadata");
+    return event;
+  }
+  if (type_name == "content_block_start") {
+    EncodableMap event = MakeEvent("contentBlockStart");
+    CopyField(*object, "content_block", event, "metadata");
+    return event;
+  }
+  if (type_name == "content_block_stop") {
+    return MakeEvent("contentBlockStop");
+  }
+  if (type_name == "message_stop") {
+    return MakeEvent("messageStop");
+  }
+  if (type_name == "message_delta") {
+    EncodableMap event = MakeEvent("messageStop");
+    CopyField(*object, "delta", event, "metadata");
+    return event;
+  }
+  if (type_name == "error") {
+    const EncodableMap* error = LookupMap(*object, "error");
+    const std::string* message =
+        error ? LookupString(*error, "message") : nullptr;
+    return MakeErrorEvent("server", message ? *message : "Unknown error");
+  }
+  if (type_name == "pagination") {
+    EncodableMap event = MakeEvent("pagination");
+    event[EncodableValue("metadata")] = *json;
+    return event;
+  }
+
+  // Custom MCP Gateway events keyed on 'status'.
+  const std::string* status = LookupString(*object, "status");
+  if (status && *status == "pending_confirmation") {
+    EncodableMap metadata;
+    CopyField(*object, "confirmationId", metadata, "confirmationId");
+    CopyField(*object, "message", metadata, "message");
+    metadata[EncodableValue("action")] = EncodableValue("unknown");
+    CopyField(*object, "action", metadata, "action");
+    CopyField(*object, "confirmationData", metadata, "confirmationData");
+    EncodableMap event = MakeEvent("pendingConfirmation");
+    event[EncodableValue("metadata")] = EncodableValue(std::move(metadata));
+    return event;
+  }
+
+  const EncodableValue* truncated = Lookup(*object, "truncated");
+  if (truncated && *truncated == EncodableValue(true)) {
+    EncodableMap event = MakeEvent("contentBlockDelta");
+    CopyField(*object, "warning", event, "text");
+    event[EncodableValue("metadata")] = EncodableValue(
+        EncodableMap{{EncodableValue("truncated"), EncodableValue(true)}});
+    return event;
+  }
+
+  // Legacy nested pending_confirmation.
+  if (Lookup(*object, "pending_confirmation")) {
+    EncodableMap event = MakeEvent("pendingConfirmation");
+    CopyField(*object, "pending_confirmation", event, "metadata");
+    return event;
+  }
+
+  return std::nullopt;
+}
+
+// Maps a WinHTTP failure to the error kinds ChatService formats for users.
+const char* ErrorKindForWinHttpError(DWORD error) {
+  switch (error) {
+    case ERROR_WINHTTP_TIMEOUT:
+      return "timeout";
+    case ERROR_WINHTTP_CANNOT_CONNECT:
+    case ERROR_WINHTTP_NAME_NOT_RESOLVED:
+    case ERROR_WINHTTP_CONNECTION_ERROR:
+      return "connection";
+    default:
+      return "network";
+  }
+}
+
+// True if |event| is a content delta carrying only text, which can be merged
+// with an adjacent one from the same stream.
+bool IsPlainDelta(const EncodableMap& event) {
+  const std::string* type = LookupString(event, "type");
+  return type && *type == "contentBlockDelta" &&
+         LookupString(event, "text") && !Lookup(event, "metadata");
+}
+
+}  // namespace
+
+// One in-flight request and the worker thread that services it.
+class SseStreamPlugin::Stream {
+ public:
+  struct Request {
+    std::wstring url;
+    std::wstring headers;
+    std::string query;
+
+    // Their text is appended to |query|, each under a heading.
+    std::vector<std::shared_ptr<const DocumentIngestPlugin::Document>>
+        documents;
+  };
+
+  Stream(int64_t id, Request request, SseStreamPlugin* owner)
+      : id_(id), request_(std::move(request)), owner_(owner) {}
+
+  ~Stream() { Join(); }
+
+  void Start() { thread_ = std::thread(&Stream::Run, this); }
+
+  // Aborts the request. Safe to call from any thread; closing the request
+  // handle makes any WinHTTP call blocked on the worker return immediately.
+  void Cancel() {
+    cancelled_ = true;
+    CloseRequestHandle();
+  }
+
+  void Join() {
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+ private:
+  void Run() {
+    Execute();
+    CloseHandles();
+    if (!cancelled_) {
+      Emit(MakeEvent("streamEnd"));
+    }
+    std::weak_ptr<bool> alive = owner_->alive_;
+    SseStreamPlugin* owner = owner_;
+    int64_t id = id_;
+    owner_->task_queue_->PostTask([alive, owner, id]() {
+      if (alive.lock()) {
+        owner->ReleaseStream(id);
+      }
+    });
+  }
+
+  void Execute() {
+    URL_COMPONENTS parts{};
+    parts.dwStructSize = sizeof(parts);
+    parts.dwHostNameLength = static_cast<DWORD>(-1);
+    parts.dwUrlPathLength = static_cast<DWORD>(-1);
+    parts.dwExtraInfoLength = static_cast<DWORD>(-1);
+    if (!WinHttpCrackUrl(request_.url.c_str(), 0, 0, &parts)) {
+      Emit(MakeErrorEvent("network", "Invalid gateway URL"));
+      return;
+    }
+    host_.assign(parts.lpszHostName, parts.dwHostNameLength);
+    std::wstring path(parts.lpszUrlPath, parts.dwUrlPathLength);
+    path.append(parts.lpszExtraInfo, parts.dwExtraInfoLength);
+
+    connect_handle_ =
+        WinHttpConnect(owner_->session_, host_.c_str(), parts.nPort, 0);
+    if (!connect_handle_) {
+      EmitWinHttpError();
+      return;
+    }
+    HINTERNET request = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(handle_mutex_);
+      if (cancelled_) {
+        return;
+      }
+      request_handle_ = WinHttpOpenRequest(
+          connect_handle_, L"POST", path.c_str(), nullptr, WINHTTP_NO_REFERER,
+          WINHTTP_DEFAULT_ACCEPT_TYPES,
+          parts.nScheme == INTERNET_SCHEME_HTTPS ? WINHTTP_FLAG_SECURE : 0);
+      request = request_handle_;
+    }
+    if (!request) {
+      EmitWinHttpError();
+      return;
+    }
+    WinHttpSetTimeouts(request, 0, kConnectTimeoutMs, kConnectTimeoutMs,
+                       kReceiveTimeoutMs);
+    if (parts.nScheme == INTERNET_SCHEME_HTTPS && !WatchCertificate(request)) {
+      EmitWinHttpError();
+      return;
+    }
+
+    if (!SendBody(request) || !WinHttpReceiveResponse(request, nullptr)) {
+      EmitWinHttpError();
+      return;
+    }
+
+    DWORD status_code = 0;
+    DWORD status_code_size = sizeof(status_code);
+    WinHttpQueryHeaders(request,
+                        WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                        WINHTTP_HEADER_NAME_BY_INDEX, &status_code,
+                        &status_code_size, WINHTTP_NO_HEADER_INDEX);
+    if (status_code >= 400) {
+      EmitHttpError(request, status_code);
+      return;
+    }
+
+    bool finished = false;
+    SseEventParser parser([this, &finished](const SseEvent& sse_event) {
+      if (finished) {
+        return;
+      }
+      std::optional<EncodableMap> event = TranslateEvent(sse_event);
+      if (!event) {
+        return;
+      }
+      const std::string* type = LookupString(*event, "type");
+      finished = type && *type == "done";
+      Emit(std::move(*event));
+    });
+
+    std::vector<char> buffer(kReadBufferSize);
+    while (!finished && !cancelled_) {
+      DWORD bytes_read = 0;
+      if (!WinHttpReadData(request, buffer.data(), kReadBufferSize,
+                           &bytes_read)) {
+        EmitWinHttpError();
+        return;
+      }
+      if (bytes_read == 0) {
+        break;
+      }
+      parser.Append(buffer.data(), bytes_read);
+    }
+    if (!finished && !cancelled_) {
+      parser.Finish();
+    }
+  }
+
+  // Has the server's certificate checked against the pins once the
+  // connection is up, before the headers with the token are sent.
+  bool WatchCertificate(HINTERNET request) {
+    DWORD_PTR context = reinterpret_cast<DWORD_PTR>(this);
+    return WinHttpSetOption(request, WINHTTP_OPTION_CONTEXT_VALUE, &context,
+                            sizeof(context)) &&
+           WinHttpSetStatusCallback(request, &Stream::OnRequestStatus,
+                                    WINHTTP_CALLBACK_FLAG_SEND_REQUEST,
+                                    0) != WINHTTP_INVALID_STATUS_CALLBACK;
+  }
+
+  static void CALLBACK OnRequestStatus(HINTERNET request,
+                                       DWORD_PTR context,
+                                       DWORD status,
+                                       void* information,
+                                       DWORD information_size) {
+    if (status != WINHTTP_CALLBACK_STATUS_SENDING_REQUEST) {
+      return;
+    }
+    auto* stream = reinterpret_cast<Stream*>(context);
+    if (!CertificatePinner::GetInstance()->Verify(request, stream->host_)) {
+      // Makes the blocked WinHttpSendRequest fail without sending anything.
+      stream->unpinned_ = true;
+      stream->CloseRequestHandle();
+    }
+  }
+
+  // Sends the request with its JSON body, writing any documents into the
+  // query as they are escaped rather than building the whole body first.
+  bool SendBody(HINTERNET request) {
+    const wchar_t* headers = request_.headers.empty()
+                                 ? WINHTTP_NO_ADDITIONAL_HEADERS
+                                 : request_.headers.c_str();
+    std::string body = kQueryStart;
+    AppendJsonEscaped(request_.query.data(), request_.query.size(), &body);
+    if (request_.documents.empty()) {
+      body += kQueryEnd;
+      const DWORD body_size = static_cast<DWORD>(body.size());
+      return WinHttpSendRequest(request, headers, static_cast<DWORD>(-1L),
+                                body.data(), body_size, body_size, 0);
+    }
+
+    std::vector<std::string> headings;
+    uint64_t total_size = body.size() + kQueryEndSize;
+    for (const auto& document : request_.documents) {
+      headings.push_back(DocumentHeading(*document));
+      total_size += headings.back().size() + document->escaped_size;
+    }
+    if (total_size > MAXDWORD) {
+      SetLastError(ERROR_INVALID_PARAMETER);
+      return false;
+    }
+    if (!WinHttpSendRequest(request, headers, static_cast<DWORD>(-1L),
+                            WINHTTP_NO_REQUEST_DATA, 0,
+                            static_cast<DWORD>(total_size), 0) ||
+        !WriteAll(request, body.data(), body.size())) {
+      return false;
+    }
+    std::string escaped;
+    for (size_t i = 0; i < request_.documents.size(); ++i) {
+      const DocumentIngestPlugin::Document& document = *request_.documents[i];
+      if (!WriteAll(request, headings[i].data(), headings[i].size())) {
+        return false;
+      }
+      for (size_t offset = 0; offset < document.text_size;
+           offset += kDocumentWriteSize) {
+        escaped.clear();
+        AppendJsonEscaped(
+            document.text + offset,
+            std::min(kDocumentWriteSize, document.text_size - offset),
+            &escaped);
+        if (!WriteAll(request, escaped.data(), escaped.size())) {
+          return false;
+        }
+      }
+    }
+    return WriteAll(request, kQueryEnd, kQueryEndSize);
+  }
+
+  // Reads the body of a failed response and reports it with its status code.
+  void EmitHttpError(HINTERNET request, DWORD status_code) {
+    std::string body;
+    std::vector<char> buffer(kReadBufferSize);
+    DWORD bytes_read = 0;
+    while (body.size() < kMaxErrorBodySize &&
+           WinHttpReadData(request, buffer.data(), kReadBufferSize,
+                           &bytes_read) &&
+           bytes_read > 0) {
+      body.append(buffer.data(), bytes_read);
+    }
+
+    std::string message = "HTTP " + std::to_string(status_code);
+    std::optional<EncodableValue> json = DecodeJson(body);
+    if (const EncodableMap* object =
+            json ? std::get_if<EncodableMap>(&*json) : nullptr) {
+      if (const std::string* error = LookupString(*object, "error")) {
+        message = *error;
+      }
+    }
+    EncodableMap event = MakeErrorEvent("http", message);
+    event[EncodableValue("statusCode")] =
+        EncodableValue(static_cast<int32_t>(status_code));
+    Emit(std::move(event));
+  }
+
+  void EmitWinHttpError() {
+    DWORD error = GetLastError();
+    if (unpinned_) {
+      Emit(MakeErrorEvent("certificate",
+                          "The gateway's certificate is not pinned"));
+      return;
+    }
+    if (cancelled_) {
+      return;
+    }
+    Emit(MakeErrorEvent(ErrorKindForWinHttpError(error),
+                        "WinHTTP error " + std::to_string(error)));
+  }
+
+  void Emit(EncodableMap event) {
+    event[EncodableValue("streamId")] = EncodableValue(id_);
+    owner_->QueueEvent(std::move(event));
+  }
+
+  // Closes the request handle exactly once, whichever of Cancel and the
+  // worker gets there first. The worker keeps using its own copy of the
+  // handle, on which WinHTTP calls simply fail once it is closed.
+  void CloseRequestHandle() {
+    std::lock_guard<std::mutex> lock(handle_mutex_);
+    if (request_handle_) {
+      WinHttpCloseHandle(request_handle_);
+      request_handle_ = nullptr;
+    }
+  }
+
+  void CloseHandles() {
+    CloseRequestHandle();
+    if (connect_handle_) {
+      WinHttpCloseHandle(connect_handle_);
+      connect_handle_ = nullptr;
+    }
+  }
+
+  int64_t id_;
+  Request request_;
+  SseStreamPlugin* owner_;
+  std::thread thread_;
+  std::atomic<bool> cancelled_{false};
+
+  // Only touched by the worker.
+  HINTERNET connect_handle_ = nullptr;
+  std::wstring host_;
+  bool unpinned_ = false;
+
+  // Guards |request_handle_|, which Cancel may close from the platform
+  // thread.
+  std::mutex handle_mutex_;
+  HINTERNET request_handle_ = nullptr;
+};
+
+SseStreamPlugin::SseStreamPlugin(flutter::BinaryMessenger* messenger,
+                                 PlatformTaskQueue* task_queue,
+                                 DocumentIngestPlugin* documents)
+    : task_queue_(task_queue), documents_(documents) {
+  session_ = ConnectionPrewarmer::GetInstance()->session();
+
+  method_channel_ =
+      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+          messenger, kMethodChannelName,
+          &flutter::StandardMethodCodec::GetInstance());
+  method_channel_->SetMethodCallHandler(
+      [this](const auto& call, auto result) {
+        HandleMethodCall(call, std::move(result));
+      });
+
+  event_channel_ =
+      std::make_unique<flutter::EventChannel<flutter::EncodableValue>>(
+          messenger, kEventChannelName,
+          &flutter::StandardMethodCodec::GetInstance());
+  event_channel_->SetStreamHandler(
+      std::make_unique<
+          flutter::StreamHandlerFunctions<flutter::EncodableValue>>(
+          [this](const flutter::EncodableValue* arguments,
+                 std::unique_ptr<flutter::EventSink<flutter::EncodableValue>>&&
+                     events)
+              -> std::unique_ptr<
+                  flutter::StreamHandlerError<flutter::EncodableValue>> {
+            event_sink_ = std::move(events);
+            return nullptr;
+          },
+          [this](const flutter::EncodableValue* arguments)
+              -> std::unique_ptr<
+                  flutter::StreamHandlerError<flutter::EncodableValue>> {
+            event_sink_ = nullptr;
+            return nullptr;
+          }));
+}
+
+SseStreamPlugin::~SseStreamPlugin() {
+  method_channel_->SetMethodCallHandler(nullptr);
+  event_channel_->SetStreamHandler(nullptr);
+  for (auto& entry : streams_) {
+    entry.second->Cancel();
+  }
+  // Joins every worker, after which nothing else can post tasks.
+  streams_.clear();
+  alive_.reset();
+}
+
+void SseStreamPlugin::HandleMethodCall(
+    const flutter::MethodCall<flutter::EncodableValue>& call,
+    std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result) {
+  const auto* arguments = std::get_if<EncodableMap>(call.arguments());
+  const EncodableValue* stream_id_value =
+      arguments ? Lookup(*arguments, "streamId") : nullptr;
+  std::optional<int64_t> stream_id_int =
+      stream_id_value ? IntValue(*stream_id_value) : std::nullopt;
+  if (!stream_id_int) {
+    result->Error("bad_arguments", "streamId must be an integer");
+    return;
+  }
+  int64_t stream_id = *stream_id_int;
+
+  if (call.method_name() == "start") {
+    if (streams_.count(stream_id)) {
+      result->Error("bad_arguments", "streamId is already in use");
+      return;
+    }
+    const std::string* url = LookupString(*arguments, "url");
+    const std::string* query = LookupString(*arguments, "query");
+    if (!url || !query) {
+      result->Error("bad_arguments", "url and query are required");
+      return;
+    }
+    if (!session_) {
+      result->Error("unavailable", "The WinHTTP session could not be opened");
+      return;
+    }
+    Stream::Request request;
+    request.url = Utf16FromUtf8(*url);
+    request.query = *query;
+    if (const EncodableList* documents = LookupList(*arguments, "documents")) {
+      for (const EncodableValue& handle_value : *documents) {
+        std::optional<int64_t> handle = IntValue(handle_value);
+        if (!handle) {
+          result->Error("bad_arguments", "documents must be handles");
+          return;
+        }
+        auto document = documents_ ? documents_->Find(*handle) : nullptr;
+        if (!document) {
+          result->Error("bad_arguments", "A document is not ready");
+          return;
+        }
+        request.documents.push_back(std::move(document));
+      }
+    }
+    if (const EncodableMap* headers = LookupMap(*arguments, "headers")) {
+      for (const auto& header : *headers) {
+        const auto* name = std::get_if<std::string>(&header.first);
+        const auto* value = std::get_if<std::string>(&header.second);
+        if (!name || !value || !IsValidHeader(*name, *value)) {
+          result->Error("bad_arguments",
+                        "headers must map names to values without line "
+                        "breaks");
+          return;
+        }
+        request.headers += Utf16FromUtf8(*name + ": " + *value + "\r\n");
+      }
+    }
+    auto stream =
+        std::make_unique<Stream>(stream_id, std::move(request), this);
+    stream->Start();
+    streams_[stream_id] = std::move(stream);
+    result->Success();
+  } else if (call.method_name() == "cancel") {
+    auto it = streams_.find(stream_id);
+    if (it != streams_.end()) {
+      it->second->Cancel();
+    }
+    result->Success();
+  } else {
+    result->NotImplemented();
+  }
+}
+
+void SseStreamPlugin::QueueEvent(flutter::EncodableMap event) {
+  bool was_empty;
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    was_empty = pending_events_.empty();
+
+    // Merge runs of text deltas so a fast stream costs one event per flush
+    // instead of one per token.
+    if (!was_empty && IsPlainDelta(event)) {
+      auto* last = std::get_if<EncodableMap>(&pending_events_.back());
+      if (last && IsPlainDelta(*last) &&
+          *Lookup(*last, "streamId") == *Lookup(event, "streamId")) {
+        auto& text = std::get<std::string>((*last)[EncodableValue("text")]);
+        text += *LookupString(event, "text");
+        return;
+      }
+    }
+    pending_events_.push_back(EncodableValue(std::move(event)));
+  }
+  if (was_empty) {
+    std::weak_ptr<bool> alive = alive_;
+    task_queue_->PostTask([this, alive]() {
+      if (alive.lock()) {
+        FlushEvents();
+      }
+    });
+  }
+}
+
+void SseStreamPlugin::FlushEvents() {
+  EncodableList events;
+  {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    events.swap(pending_events_);
+  }
+  if (event_sink_ && !events.empty()) {
+    event_sink_->Success(EncodableValue(std::move(events)));
+  }
+}
+
+void SseStreamPlugin::ReleaseStream(int64_t stream_id) {
+  auto it = streams_.find(stream_id);
+  if (it != streams_.end()) {
+    it->second->Join();
+    streams_.erase(it);
+  }
+}
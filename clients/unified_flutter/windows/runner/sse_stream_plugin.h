@@ -0,0 +1,91 @@
+#ifndef RUNNER_SSE_STREAM_PLUGIN_H_
+#define RUNNER_SSE_STREAM_PLUGIN_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/event_channel.h>
+#include <flutter/method_channel.h>
+#include <windows.h>
+#include <winhttp.h>
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "document_ingest_plugin.h"
+#include "platform_task_queue.h"
+
+// Streams text/event-stream responses from the MCP Gateway natively.
+//
+// Each request runs on its own worker thread, which performs the HTTP
+// exchange with WinHTTP, frames SSE events incrementally and decodes their
+// JSON payloads. Only the resulting typed events reach Dart, batched so that a
+// burst of token deltas costs a single channel message.
+//
+// Method channel "com.tamshai.ai/sse":
+//   start({streamId, url, headers, query, documents}) - opens a POST stream
+//     with the JSON body {"query": ...}. |documents| lists
+//     DocumentIngestPlugin handles whose text is appended to the query.
+//     Header names and values with line breaks, and names with a colon,
+//     are rejected.
+//   cancel({streamId}) - aborts a stream.
+// Event channel "com.tamshai.ai/sse/events" delivers lists of event maps,
+// each carrying the "streamId" it belongs to and a "type" named after the
+// Dart SSEEventType values, plus "streamEnd" when a stream has closed.
+class SseStreamPlugin {
+ public:
+  // |documents| may be null, in which case no documents can be attached.
+  SseStreamPlugin(flutter::BinaryMessenger* messenger,
+                  PlatformTaskQueue* task_queue,
+                  DocumentIngestPlugin* documents);
+  ~SseStreamPlugin();
+
+  // Prevent copying.
+  SseStreamPlugin(SseStreamPlugin const&) = delete;
+  SseStreamPlugin& operator=(SseStreamPlugin const&) = delete;
+
+ private:
+  class Stream;
+
+  void HandleMethodCall(
+      const flutter::MethodCall<flutter::EncodableValue>& call,
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>> result);
+
+  // Queues |event| for delivery to Dart. Called on worker threads.
+  void QueueEvent(flutter::EncodableMap event);
+
+  // Sends all queued events to Dart. Runs on the platform thread.
+  void FlushEvents();
+
+  // Joins and releases a stream whose worker has exited. Runs on the platform
+  // thread.
+  void ReleaseStream(int64_t stream_id);
+
+  PlatformTaskQueue* task_queue_;
+  DocumentIngestPlugin* documents_;
+
+  // ConnectionPrewarmer's WinHTTP session, so that connections to the
+  // gateway, including those it warmed up, are pooled across requests.
+  HINTERNET session_ = nullptr;
+
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>>
+      method_channel_;
+  std::unique_ptr<flutter::EventChannel<flutter::EncodableValue>>
+      event_channel_;
+  std::unique_ptr<flutter::EventSink<flutter::EncodableValue>> event_sink_;
+
+  // Active streams keyed by their Dart-assigned id.
+  std::map<int64_t, std::unique_ptr<Stream>> streams_;
+
+  std::mutex pending_mutex_;
+
+  // Events produced by workers and not yet sent; guarded by |pending_mutex_|.
+  flutter::EncodableList pending_events_;
+
+  // Tasks posted from workers hold a weak reference to this token so they
+  // become no-ops once the plugin has been destroyed.
+  std::shared_ptr<bool> alive_ = std::make_shared<bool>(true);
+};
+
+#endif  // RUNNER_SSE_STREAM_PLUGIN_H_
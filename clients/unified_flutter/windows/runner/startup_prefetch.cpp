@@ -0,0 +1,379 @@
+#include "startup_prefetch.h"
+
+#include <psapi.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cwctype>
+#include <map>
+#include <string>
+#include <utility>
+
+#include "runner_trace.h"
+#include "utils.h"
+
+namespace {
+
+constexpr wchar_t kManifestName[] = L"prefetch.manifest";
+constexpr wchar_t kRecordVariable[] = L"TAMSHAI_PREFETCH_RECORD";
+
+// The engine reads app.so rather than mapping it, so a recorded manifest
+// always lists all of it.
+constexpr wchar_t kAotLibrary[] = L"app.so";
+
+// Files prefetched whole when there is no manifest.
+constexpr const wchar_t* kDefaultFiles[] = {
+    L"app.so",
+    L"icudtl.dat",
+    L"flutter_assets\\AssetManifest.bin",
+    L"flutter_assets\\FontManifest.json",
+};
+constexpr wchar_t kDefaultFontFolder[] = L"flutter_assets\\fonts";
+
+// Recorded ranges closer than this are merged, as one larger read costs less
+// than two seeks.
+constexpr uint64_t kMergeGap = 64 * 1024;
+
+// A part of a file to prefetch. A length of zero means the rest of the file.
+struct HotRange {
+  uint64_t offset;
+  uint64_t length;
+};
+
+// Hot ranges by path relative to the data directory.
+using HotRanges = std::map<std::wstring, std::vector<HotRange>>;
+
+std::wstring ExecutableDirectory() {
+  wchar_t path[MAX_PATH];
+  DWORD length = GetModuleFileName(nullptr, path, MAX_PATH);
+  if (length == 0 || length == MAX_PATH) {
+    return std::wstring();
+  }
+  std::wstring directory(path, length);
+  return directory.substr(0, directory.find_last_of(L'\\'));
+}
+
+std::wstring Lowercase(std::wstring text) {
+  std::transform(text.begin(), text.end(), text.begin(),
+                 [](wchar_t c) { return static_cast<wchar_t>(towlower(c)); });
+  return text;
+}
+
+// Parses the manifest at |path|. Returns false if there is none.
+bool ReadManifest(const std::wstring& path, HotRanges* ranges) {
+  HANDLE file = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                           nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN,
+                           nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  std::string contents;
+  char buffer[4096];
+  DWORD bytes_read = 0;
+  while (ReadFile(file, buffer, sizeof(buffer), &bytes_read, nullptr) &&
+         bytes_read > 0) {
+    contents.append(buffer, bytes_read);
+  }
+  CloseHandle(file);
+
+  size_t line_start = 0;
+  while (line_start < contents.size()) {
+    size_t line_end = contents.find('\n', line_start);
+    if (line_end == std::string::npos) {
+      line_end = contents.size();
+    }
+    std::string line = contents.substr(line_start, line_end - line_start);
+    line_start = line_end + 1;
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    // "<offset> <length> <path>"; the path is last, so it may hold spaces.
+    char* end = nullptr;
+    uint64_t offset = std::strtoull(line.c_str(), &end, 10);
+    if (*end != ' ') {
+      continue;
+    }
+    uint64_t length = std::strtoull(end + 1, &end, 10);
+    if (*end != ' ' || *(end + 1) == '\0') {
+      continue;
+    }
+    (*ranges)[Utf16FromUtf8(end + 1)].push_back({offset, length});
+  }
+  return true;
+}
+
+HotRanges DefaultRanges(const std::wstring& data_directory) {
+  HotRanges ranges;
+  for (const wchar_t* file : kDefaultFiles) {
+    ranges[file].push_back({0, 0});
+  }
+  WIN32_FIND_DATA find_data;
+  std::wstring pattern =
+      data_directory + L"\\" + kDefaultFontFolder + L"\\*";
+  HANDLE find = FindFirstFile(pattern.c_str(), &find_data);
+  if (find != INVALID_HANDLE_VALUE) {
+    do {
+      if (!(find_data.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+        ranges[std::wstring(kDefaultFontFolder) + L"\\" + find_data.cFileName]
+            .push_back({0, 0});
+      }
+    } while (FindNextFile(find, &find_data));
+    FindClose(find);
+  }
+  return ranges;
+}
+
+// Sorts |ranges| and merges those that overlap or nearly touch.
+void MergeRanges(std::vector<HotRange>& ranges) {
+  std::sort(ranges.begin(), ranges.end(),
+            [](const HotRange& a, const HotRange& b) {
+              return a.offset < b.offset;
+            });
+  std::vector<HotRange> merged;
+  for (const HotRange& range : ranges) {
+    if (!merged.empty() &&
+        range.offset <= merged.back().offset + merged.back().length +
+                            kMergeGap) {
+      HotRange& last = merged.back();
+      last.length =
+          std::max(last.offset + last.length, range.offset + range.length) -
+          last.offset;
+    } else {
+      merged.push_back(range);
+    }
+  }
+  ranges = std::move(merged);
+}
+
+}  // namespace
+
+StartupPrefetch::~StartupPrefetch() {
+  if (thread_.joinable()) {
+    SetEvent(finished_);
+    thread_.join();
+  }
+  Unmap();
+  if (finished_) {
+    CloseHandle(finished_);
+  }
+}
+
+// static
+StartupPrefetch* StartupPrefetch::GetInstance() {
+  static StartupPrefetch* instance = new StartupPrefetch();
+  return instance;
+}
+
+void StartupPrefetch::Start(const std::wstring& data_directory) {
+  data_directory_ = data_directory;
+  if (data_directory_.find(L':') == std::wstring::npos &&
+      data_directory_.compare(0, 2, L"\\\\") != 0) {
+    data_directory_ = ExecutableDirectory() + L"\\" + data_directory_;
+  }
+
+  wchar_t record_path[MAX_PATH];
+  DWORD length =
+      GetEnvironmentVariable(kRecordVariable, record_path, MAX_PATH);
+  if (length > 0 && length < MAX_PATH) {
+    record_path_.assign(record_path, length);
+    return;
+  }
+  finished_ = CreateEvent(nullptr, TRUE, FALSE, nullptr);
+  if (!finished_) {
+    return;
+  }
+  thread_ = std::thread(&StartupPrefetch::Prefetch, this);
+}
+
+void StartupPrefetch::Finish() {
+  if (thread_.joinable()) {
+    // The thread unmaps the files itself once it sees the event, so the
+    // platform thread never waits on the disk.
+    SetEvent(finished_);
+    thread_.detach();
+  }
+  if (recording()) {
+    Record();
+  }
+}
+
+void StartupPrefetch::Prefetch() {
+  TraceSpan span("StartupPrefetch");
+  HotRanges ranges;
+  if (!ReadManifest(data_directory_ + L"\\" + kManifestName, &ranges)) {
+    ranges = DefaultRanges(data_directory_);
+  }
+
+  std::vector<WIN32_MEMORY_RANGE_ENTRY> entries;
+  for (const auto& file_ranges : ranges) {
+    // Too late to help the engine by now.
+    if (finished()) {
+      break;
+    }
+    std::wstring path = data_directory_ + L"\\" + file_ranges.first;
+    HANDLE file = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                             nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                             nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+      continue;
+    }
+    LARGE_INTEGER size;
+    MappedFile mapped;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0 &&
+        static_cast<uint64_t>(size.QuadPart) <= SIZE_MAX) {
+      mapped.size = static_cast<uint64_t>(size.QuadPart);
+      mapped.mapping =
+          CreateFileMapping(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    // The mapping keeps the file open.
+    CloseHandle(file);
+    if (!mapped.mapping) {
+      continue;
+    }
+    mapped.view = static_cast<const uint8_t*>(
+        MapViewOfFile(mapped.mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!mapped.view) {
+      CloseHandle(mapped.mapping);
+      continue;
+    }
+    for (const HotRange& range : file_ranges.second) {
+      if (range.offset >= mapped.size) {
+        continue;
+      }
+      uint64_t available = mapped.size - range.offset;
+      uint64_t length = range.length == 0
+                            ? available
+                            : std::min(range.length, available);
+      WIN32_MEMORY_RANGE_ENTRY entry;
+      entry.VirtualAddress = const_cast<uint8_t*>(
+          mapped.view + static_cast<size_t>(range.offset));
+      entry.NumberOfBytes = static_cast<SIZE_T>(length);
+      entries.push_back(entry);
+    }
+    files_.push_back(mapped);
+  }
+
+  // One call for everything, so the memory manager can order and batch the
+  // reads across files. The pages land in the file cache, where the engine's
+  // own mappings and reads find them.
+  if (!entries.empty() && !finished()) {
+    PrefetchVirtualMemory(GetCurrentProcess(), entries.size(),
+                          entries.data(), 0);
+  }
+  span.End();
+
+  // Kept mapped until the first frame is up, so the pages stay resident
+  // while the engine starts.
+  WaitForSingleObject(finished_, INFINITE);
+  Unmap();
+}
+
+void StartupPrefetch::Record() {
+  // The engine's views are named by device path, so they are matched on the
+  // tail of the data directory's path, e.g. "\release\data\".
+  size_t last_separator = data_directory_.find_last_of(L'\\');
+  size_t parent_separator =
+      last_separator == 0 || last_separator == std::wstring::npos
+          ? std::wstring::npos
+          : data_directory_.find_last_of(L'\\', last_separator - 1);
+  if (parent_separator == std::wstring::npos) {
+    return;
+  }
+  std::wstring marker =
+      Lowercase(data_directory_.substr(parent_separator)) + L"\\";
+
+  SYSTEM_INFO system_info;
+  GetSystemInfo(&system_info);
+  const size_t page_size = system_info.dwPageSize;
+
+  HotRanges touched;
+  std::wstring relative_path;
+  const void* named_allocation = nullptr;
+  MEMORY_BASIC_INFORMATION info;
+  for (const uint8_t* address = nullptr;
+       VirtualQuery(address, &info, sizeof(info)) == sizeof(info);
+       address = static_cast<const uint8_t*>(info.BaseAddress) +
+                 info.RegionSize) {
+    if (info.State != MEM_COMMIT || info.Type != MEM_MAPPED) {
+      continue;
+    }
+    // The engine maps each asset and icudtl.dat whole, so a view's offset
+    // from its allocation is its offset in the file.
+    if (info.AllocationBase != named_allocation) {
+      named_allocation = info.AllocationBase;
+      wchar_t name[MAX_PATH];
+      DWORD length = GetMappedFileName(GetCurrentProcess(),
+                                       info.AllocationBase, name, MAX_PATH);
+      std::wstring mapped_name(name, length);
+      size_t found = Lowercase(mapped_name).find(marker);
+      relative_path = found == std::wstring::npos
+                          ? std::wstring()
+                          : mapped_name.substr(found + marker.size());
+    }
+    if (relative_path.empty()) {
+      continue;
+    }
+
+    const auto* base = static_cast<const uint8_t*>(info.BaseAddress);
+    std::vector<PSAPI_WORKING_SET_EX_INFORMATION> pages(info.RegionSize /
+                                                        page_size);
+    for (size_t i = 0; i < pages.size(); ++i) {
+      pages[i].VirtualAddress = const_cast<uint8_t*>(base + i * page_size);
+    }
+    if (!QueryWorkingSetEx(
+            GetCurrentProcess(), pages.data(),
+            static_cast<DWORD>(pages.size() * sizeof(pages[0])))) {
+      continue;
+    }
+    const auto* allocation = static_cast<const uint8_t*>(info.AllocationBase);
+    for (const auto& page : pages) {
+      if (page.VirtualAttributes.Valid) {
+        const auto* page_address =
+            static_cast<const uint8_t*>(page.VirtualAddress);
+        touched[relative_path].push_back(
+            {static_cast<uint64_t>(page_address - allocation), page_size});
+      }
+    }
+  }
+
+  WIN32_FILE_ATTRIBUTE_DATA aot_attributes;
+  std::wstring aot_path = data_directory_ + L"\\" + kAotLibrary;
+  if (GetFileAttributesEx(aot_path.c_str(), GetFileExInfoStandard,
+                          &aot_attributes)) {
+    touched[kAotLibrary] = {
+        {0, (static_cast<uint64_t>(aot_attributes.nFileSizeHigh) << 32) |
+                aot_attributes.nFileSizeLow}};
+  }
+
+  std::string manifest =
+      "# Startup prefetch manifest: <offset> <length> <path>\n";
+  for (auto& file_ranges : touched) {
+    MergeRanges(file_ranges.second);
+    std::string path = Utf8FromUtf16(file_ranges.first.c_str());
+    for (const HotRange& range : file_ranges.second) {
+      manifest += std::to_string(range.offset) + " " +
+                  std::to_string(range.length) + " " + path + "\n";
+    }
+  }
+
+  HANDLE file = CreateFile(record_path_.c_str(), GENERIC_WRITE, 0, nullptr,
+                           CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return;
+  }
+  DWORD bytes_written = 0;
+  WriteFile(file, manifest.data(), static_cast<DWORD>(manifest.size()),
+            &bytes_written, nullptr);
+  CloseHandle(file);
+}
+
+void StartupPrefetch::Unmap() {
+  for (const MappedFile& file : files_) {
+    UnmapViewOfFile(file.view);
+    CloseHandle(file.mapping);
+  }
+  files_.clear();
+}
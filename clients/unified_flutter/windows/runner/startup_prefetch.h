@@ -0,0 +1,83 @@
+#ifndef RUNNER_STARTUP_PREFETCH_H_
+#define RUNNER_STARTUP_PREFETCH_H_
+
+#include <windows.h>
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Reads the engine's startup files into the file cache ahead of the engine.
+//
+// On a cold boot, and on VDI machines with slow roaming disks in particular,
+// page faults on app.so, icudtl.dat and flutter_assets dominate startup. Start
+// maps those files on a background thread and hands all of their hot ranges
+// to PrefetchVirtualMemory at once, so the disk sees a few large reads rather
+// than one small read per fault.
+//
+// The hot ranges come from data\prefetch.manifest when it exists; each line
+// is "<offset> <length> <path relative to data>". Without one, the whole of
+// a default set of files is prefetched.
+//
+// Setting TAMSHAI_PREFETCH_RECORD to a file path records a manifest instead:
+// nothing is prefetched, and Finish writes the pages the engine's own
+// mappings of the data files have touched by then.
+class StartupPrefetch {
+ public:
+  ~StartupPrefetch();
+
+  // Returns the process-wide instance.
+  static StartupPrefetch* GetInstance();
+
+  // Starts prefetching the files in |data_directory|, which is relative to
+  // the executable unless absolute. Returns immediately.
+  void Start(const std::wstring& data_directory);
+
+  // Called once the first frame is up. Tells the prefetch thread to stop
+  // and release the mappings, without waiting for it; when recording, writes
+  // the manifest, which is all such a launch is for.
+  void Finish();
+
+  // Whether this launch records a manifest rather than using one.
+  bool recording() const { return !record_path_.empty(); }
+
+  // Prevent copying.
+  StartupPrefetch(StartupPrefetch const&) = delete;
+  StartupPrefetch& operator=(StartupPrefetch const&) = delete;
+
+ private:
+  // A read-only view of a whole file.
+  struct MappedFile {
+    HANDLE mapping = nullptr;
+    const uint8_t* view = nullptr;
+    uint64_t size = 0;
+  };
+
+  StartupPrefetch() = default;
+
+  // Body of the prefetch thread.
+  void Prefetch();
+
+  // Whether Finish has been called.
+  bool finished() const {
+    return WaitForSingleObject(finished_, 0) == WAIT_OBJECT_0;
+  }
+
+  // Writes the manifest to |record_path_|.
+  void Record();
+
+  // Unmaps everything in |files_|.
+  void Unmap();
+
+  std::wstring data_directory_;
+  std::wstring record_path_;
+  std::thread thread_;
+  // Set by Finish; manual-reset.
+  HANDLE finished_ = nullptr;
+
+  // Prefetch thread only, until it has exited.
+  std::vector<MappedFile> files_;
+};
+
+#endif  // RUNNER_STARTUP_PREFETCH_H_
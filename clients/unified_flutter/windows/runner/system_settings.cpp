@@ -0,0 +1,222 @@
+#include "system_settings.h"
+
+#include <algorithm>
+#include <cwchar>
+#include <utility>
+
+namespace {
+
+/// Registry key for app theme preference.
+///
+/// A value of 0 indicates apps should use dark mode. A non-zero or missing
+/// value indicates apps should use light mode.
+constexpr const wchar_t kGetPreferredBrightnessRegKey[] =
+    L"Software\\Microsoft\\Windows\\CurrentVersion\\Themes\\Personalize";
+constexpr const wchar_t kGetPreferredBrightnessRegValue[] =
+    L"AppsUseLightTheme";
+
+// How long changes are collected before they are delivered: a frame at
+// 60 Hz, in the 100 ns units of a relative waitable timer.
+constexpr LONGLONG kFlushDelay = -16 * 10000LL;
+
+}  // namespace
+
+SystemSettings::SystemSettings() {
+  // User32 is loaded by every process with windows, so its exports can be
+  // resolved once without loading it again.
+  HMODULE user32_module = GetModuleHandle(L"user32.dll");
+  if (user32_module) {
+    enable_non_client_dpi_scaling_ =
+        reinterpret_cast<EnableNonClientDpiScalingFunction*>(
+            GetProcAddress(user32_module, "EnableNonClientDpiScaling"));
+  }
+  ReadDarkMode();
+}
+
+SystemSettings::~SystemSettings() {
+  StopWatching();
+}
+
+// static
+SystemSettings* SystemSettings::GetInstance() {
+  static SystemSettings* instance = new SystemSettings();
+  return instance;
+}
+
+void SystemSettings::Watch(RunLoop* run_loop) {
+  if (run_loop_) {
+    return;
+  }
+  run_loop_ = run_loop;
+
+  flush_timer_ = CreateWaitableTimerEx(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+  if (flush_timer_) {
+    flush_wait_ = run_loop_->AddWaitableHandle(flush_timer_, [this]() {
+      Flush();
+    });
+  }
+
+  if (RegOpenKeyEx(HKEY_CURRENT_USER, kGetPreferredBrightnessRegKey, 0,
+                   KEY_NOTIFY | KEY_QUERY_VALUE,
+                   &personalize_key_) != ERROR_SUCCESS) {
+    personalize_key_ = nullptr;
+    return;
+  }
+  registry_event_ = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+  if (!registry_event_) {
+    return;
+  }
+  registry_wait_ = run_loop_->AddWaitableHandle(registry_event_, [this]() {
+    // A notification fires once, so ask for the next one first.
+    ArmRegistryWatch();
+    NotifyChanged(kThemeChange);
+  });
+  ArmRegistryWatch();
+}
+
+void SystemSettings::StopWatching() {
+  if (!run_loop_) {
+    return;
+  }
+  if (registry_wait_) {
+    run_loop_->RemoveWaitableHandle(registry_wait_);
+    registry_wait_ = 0;
+  }
+  if (flush_wait_) {
+    run_loop_->RemoveWaitableHandle(flush_wait_);
+    flush_wait_ = 0;
+  }
+  // Closing the key also cancels its pending notification.
+  if (personalize_key_) {
+    RegCloseKey(personalize_key_);
+    personalize_key_ = nullptr;
+  }
+  if (registry_event_) {
+    CloseHandle(registry_event_);
+    registry_event_ = nullptr;
+  }
+  if (flush_timer_) {
+    CancelWaitableTimer(flush_timer_);
+    CloseHandle(flush_timer_);
+    flush_timer_ = nullptr;
+  }
+  run_loop_ = nullptr;
+  // Nothing will deliver what is still pending later.
+  Flush();
+}
+
+bool SystemSettings::UsesDarkMode() {
+  return dark_mode_;
+}
+
+void SystemSettings::EnableNonClientDpiScaling(HWND window) {
+  if (enable_non_client_dpi_scaling_ != nullptr) {
+    enable_non_client_dpi_scaling_(window);
+  }
+}
+
+void SystemSettings::NotifyChanged(unsigned int changes) {
+  if (changes == 0) {
+    return;
+  }
+  bool idle = pending_changes_ == 0;
+  pending_changes_ |= changes;
+  if (!flush_wait_) {
+    Flush();
+    return;
+  }
+  // Later changes ride along with the first, rather than pushing delivery
+  // back, so that a long burst still updates once a frame.
+  if (idle) {
+    LARGE_INTEGER due_time;
+    due_time.QuadPart = kFlushDelay;
+    SetWaitableTimer(flush_timer_, &due_time, 0, nullptr, nullptr, FALSE);
+  }
+}
+
+// static
+unsigned int SystemSettings::ChangesFromSettingChange(WPARAM wparam,
+                                                      LPARAM lparam) {
+  switch (wparam) {
+    case SPI_SETNONCLIENTMETRICS:
+    case SPI_SETFONTSMOOTHING:
+    case SPI_SETFONTSMOOTHINGTYPE:
+    case SPI_SETFONTSMOOTHINGCONTRAST:
+      return kFontChange;
+  }
+  auto area = reinterpret_cast<const wchar_t*>(lparam);
+  if (area && wcscmp(area, L"ImmersiveColorSet") == 0) {
+    return kThemeChange;
+  }
+  return 0;
+}
+
+SystemSettings::ObserverId SystemSettings::AddObserver(Observer observer) {
+  ObserverId id = next_observer_id_++;
+  observers_.push_back({id, std::move(observer)});
+  return id;
+}
+
+void SystemSettings::RemoveObserver(ObserverId id) {
+  observers_.erase(std::remove_if(observers_.begin(), observers_.end(),
+                                  [id](const ObserverEntry& entry) {
+                                    return entry.id == id;
+                                  }),
+                   observers_.end());
+}
+
+bool SystemSettings::ReadDarkMode() {
+  DWORD light_mode;
+  DWORD light_mode_size = sizeof(light_mode);
+  LSTATUS result = RegGetValue(HKEY_CURRENT_USER, kGetPreferredBrightnessRegKey,
+                               kGetPreferredBrightnessRegValue,
+                               RRF_RT_REG_DWORD, nullptr, &light_mode,
+                               &light_mode_size);
+  bool dark_mode = result == ERROR_SUCCESS && light_mode == 0;
+  bool changed = dark_mode != dark_mode_;
+  dark_mode_ = dark_mode;
+  return changed;
+}
+
+void SystemSettings::ArmRegistryWatch() {
+  if (RegNotifyChangeKeyValue(personalize_key_, FALSE,
+                              REG_NOTIFY_CHANGE_LAST_SET, registry_event_,
+                              TRUE) != ERROR_SUCCESS) {
+    // Theme changes are then only seen through window messages.
+    run_loop_->RemoveWaitableHandle(registry_wait_);
+    registry_wait_ = 0;
+  }
+}
+
+void SystemSettings::Flush() {
+  unsigned int changes = pending_changes_;
+  pending_changes_ = 0;
+  // Every window reports a theme switch, and so does the registry, but the
+  // theme is reread only once and only a real change is passed on.
+  if ((changes & kThemeChange) && !ReadDarkMode()) {
+    changes &= ~kThemeChange;
+  }
+  if (changes == 0) {
+    return;
+  }
+  // Observers may add or remove observers, so each one is looked up again
+  // before it is called: one removed by an earlier observer, say along with
+  // the window it belongs to, is skipped. Those added meanwhile wait for the
+  // next change.
+  std::vector<ObserverId> ids;
+  ids.reserve(observers_.size());
+  for (const ObserverEntry& entry : observers_) {
+    ids.push_back(entry.id);
+  }
+  for (ObserverId id : ids) {
+    auto it = std::find_if(
+        observers_.begin(), observers_.end(),
+        [id](const ObserverEntry& entry) { return entry.id == id; });
+    if (it == observers_.end()) {
+      continue;
+    }
+    // Copied, as the observer may remove itself while it runs.
+    Observer observer = it->observer;
+    observer(changes);
+  }
+}
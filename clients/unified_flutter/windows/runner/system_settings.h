@@ -0,0 +1,105 @@
+#ifndef RUNNER_SYSTEM_SETTINGS_H_
+#define RUNNER_SYSTEM_SETTINGS_H_
+
+#include <windows.h>
+
+#include <functional>
+#include <vector>
+
+#include "run_loop.h"
+
+// Caches the system settings the runner reacts to, and coalesces the window
+// messages that report changes to them.
+//
+// Theme and font changes tend to arrive in bursts: a font installer sends
+// WM_FONTCHANGE for every font, and a theme switch sends several
+// WM_SETTINGCHANGE and WM_DWMCOLORIZATIONCOLORCHANGED messages to every
+// window. Windows report them with |NotifyChanged|, and observers hear about
+// each kind of change at most once per frame, with the cache reread once.
+//
+// Platform thread only.
+class SystemSettings {
+ public:
+  // Kinds of change, combined as a bit mask.
+  enum Change : unsigned int {
+    kThemeChange = 1 << 0,
+    kFontChange = 1 << 1,
+  };
+
+  // Called with the changes seen since the last call.
+  using Observer = std::function<void(unsigned int changes)>;
+
+  // Identifies an observer.
+  using ObserverId = int;
+
+  ~SystemSettings();
+
+  // Returns the process-wide instance.
+  static SystemSettings* GetInstance();
+
+  // Watches the theme in the registry and delivers coalesced changes on
+  // |run_loop|, until |StopWatching| is called. Until then, changes are
+  // delivered as soon as they are reported.
+  void Watch(RunLoop* run_loop);
+
+  // Stops what |Watch| started. Must be called before the run loop goes.
+  void StopWatching();
+
+  // Returns true if apps should use dark mode.
+  bool UsesDarkMode();
+
+  // Lets the non-client area of |window| scale with its DPI. Only needed in
+  // PerMonitor V1 awareness mode; a no-op where the API is not available.
+  void EnableNonClientDpiScaling(HWND window);
+
+  // Records changes reported by a window message. Messages may report the
+  // same change more than once.
+  void NotifyChanged(unsigned int changes);
+
+  // Translates a WM_SETTINGCHANGE into the changes it reports, if any.
+  static unsigned int ChangesFromSettingChange(WPARAM wparam, LPARAM lparam);
+
+  ObserverId AddObserver(Observer observer);
+  void RemoveObserver(ObserverId id);
+
+ private:
+  struct ObserverEntry {
+    ObserverId id;
+    Observer observer;
+  };
+
+  SystemSettings();
+
+  // Reads the theme from the registry into |dark_mode_|. Returns true if it
+  // changed.
+  bool ReadDarkMode();
+
+  // Asks for |registry_event_| to be signalled on the next theme change.
+  void ArmRegistryWatch();
+
+  // Delivers the pending changes.
+  void Flush();
+
+  bool dark_mode_ = false;
+
+  using EnableNonClientDpiScalingFunction = BOOL __stdcall(HWND window);
+  EnableNonClientDpiScalingFunction* enable_non_client_dpi_scaling_ = nullptr;
+
+  RunLoop* run_loop_ = nullptr;
+
+  // The key holding the theme, and the event signalled when it changes.
+  HKEY personalize_key_ = nullptr;
+  HANDLE registry_event_ = nullptr;
+  RunLoop::Id registry_wait_ = 0;
+
+  // Delays delivery by a frame, so that a burst is delivered once.
+  HANDLE flush_timer_ = nullptr;
+  RunLoop::Id flush_wait_ = 0;
+
+  unsigned int pending_changes_ = 0;
+
+  ObserverId next_observer_id_ = 1;
+  std::vector<ObserverEntry> observers_;
+};
+
+#endif  // RUNNER_SYSTEM_SETTINGS_H_
@@ -0,0 +1,332 @@
+#include "text_transcoder.h"
+
+#include <cstdint>
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Returns the number of ASCII bytes at the start of |input|.
+size_t AsciiPrefix(const char* input, size_t length) {
+  size_t i = 0;
+#if defined(_M_X64) || defined(_M_IX86)
+  for (; i + 16 <= length; i += 16) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+    if (_mm_movemask_epi8(chunk) != 0) {
+      break;
+    }
+  }
+#endif
+  while (i < length && static_cast<unsigned char>(input[i]) < 0x80) {
+    ++i;
+  }
+  return i;
+}
+
+// Returns the number of ASCII code units at the start of |input|.
+size_t AsciiPrefix(const wchar_t* input, size_t length) {
+  size_t i = 0;
+#if defined(_M_X64) || defined(_M_IX86)
+  const __m128i non_ascii = _mm_set1_epi16(static_cast<short>(0xFF80));
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 8 <= length; i += 8) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+    __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(chunk, non_ascii), zero);
+    if (_mm_movemask_epi8(ascii) != 0xFFFF) {
+      break;
+    }
+  }
+#endif
+  while (i < length && input[i] < 0x80) {
+    ++i;
+  }
+  return i;
+}
+
+// Copies |length| ASCII code units to |output| as bytes.
+void NarrowAscii(const wchar_t* input, size_t length, char* output) {
+  size_t i = 0;
+#if defined(_M_X64) || defined(_M_IX86)
+  for (; i + 8 <= length; i += 8) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(output + i),
+                     _mm_packus_epi16(chunk, chunk));
+  }
+#endif
+  for (; i < length; ++i) {
+    output[i] = static_cast<char>(input[i]);
+  }
+}
+
+// Copies |length| ASCII bytes to |output| as code units.
+void WidenAscii(const char* input, size_t length, wchar_t* output) {
+  size_t i = 0;
+#if defined(_M_X64) || defined(_M_IX86)
+  const __m128i zero = _mm_setzero_si128();
+  for (; i + 16 <= length; i += 16) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i),
+                     _mm_unpacklo_epi8(chunk, zero));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i + 8),
+                     _mm_unpackhi_epi8(chunk, zero));
+  }
+#endif
+  for (; i < length; ++i) {
+    output[i] = static_cast<wchar_t>(input[i]);
+  }
+}
+
+// Decodes the non-ASCII sequence at the start of |input| into |code_point|.
+// Returns its length, or 0 if it is not valid or is cut short.
+size_t DecodeUtf8(const unsigned char* input,
+                  size_t length,
+                  uint32_t* code_point) {
+  unsigned char lead = input[0];
+  size_t size;
+  // The range of the second byte excludes overlong forms, surrogates and
+  // code points beyond U+10FFFF.
+  unsigned char low = 0x80;
+  unsigned char high = 0xBF;
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    size = 2;
+    *code_point = lead & 0x1F;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    size = 3;
+    *code_point = lead & 0x0F;
+    if (lead == 0xE0) {
+      low = 0xA0;
+    } else if (lead == 0xED) {
+      high = 0x9F;
+    }
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    size = 4;
+    *code_point = lead & 0x07;
+    if (lead == 0xF0) {
+      low = 0x90;
+    } else if (lead == 0xF4) {
+      high = 0x8F;
+    }
+  } else {
+    return 0;
+  }
+  if (length < size || input[1] < low || input[1] > high) {
+    return 0;
+  }
+  for (size_t i = 1; i < size; ++i) {
+    if ((input[i] & 0xC0) != 0x80) {
+      return 0;
+    }
+    *code_point = (*code_point << 6) | (input[i] & 0x3F);
+  }
+  return size;
+}
+
+// Whether |c| has to be escaped in a JSON string.
+bool NeedsEscape(unsigned char c) {
+  return c < 0x20 || c == '"' || c == '\\';
+}
+
+// Returns the number of bytes at the start of |input| that a JSON string
+// holds as they are.
+size_t PlainPrefix(const char* input, size_t length) {
+  size_t i = 0;
+#if defined(_M_X64) || defined(_M_IX86)
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i last_control = _mm_set1_epi8(0x1F);
+  for (; i + 16 <= length; i += 16) {
+    __m128i chunk =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+    // Unsigned c <= 0x1F exactly when min(c, 0x1F) == c.
+    __m128i control =
+        _mm_cmpeq_epi8(_mm_min_epu8(chunk, last_control), chunk);
+    __m128i special =
+        _mm_or_si128(control, _mm_or_si128(_mm_cmpeq_epi8(chunk, quote),
+                                           _mm_cmpeq_epi8(chunk, backslash)));
+    if (_mm_movemask_epi8(special) != 0) {
+      break;
+    }
+  }
+#endif
+  while (i < length && !NeedsEscape(static_cast<unsigned char>(input[i]))) {
+    ++i;
+  }
+  return i;
+}
+
+// Returns the short escape for |c|, or 0 if it takes the \u form.
+char ShortEscape(unsigned char c) {
+  switch (c) {
+    case '"':
+      return '"';
+    case '\\':
+      return '\\';
+    case '\b':
+      return 'b';
+    case '\f':
+      return 'f';
+    case '\n':
+      return 'n';
+    case '\r':
+      return 'r';
+    case '\t':
+      return 't';
+  }
+  return 0;
+}
+
+}  // namespace
+
+bool AppendUtf8FromUtf16(const wchar_t* input,
+                         size_t length,
+                         std::string* output) {
+  const size_t original_size = output->size();
+  // Sized as if the rest were ASCII, and grown when it is not.
+  size_t out = original_size;
+  output->resize(out + length);
+  size_t i = 0;
+  for (;;) {
+    size_t ascii = AsciiPrefix(input + i, length - i);
+    NarrowAscii(input + i, ascii, &(*output)[out]);
+    i += ascii;
+    out += ascii;
+    if (i == length) {
+      break;
+    }
+
+    uint32_t code_point = input[i];
+    size_t units = 1;
+    if (code_point >= 0xD800 && code_point <= 0xDFFF) {
+      if (code_point >= 0xDC00 || i + 1 == length || input[i + 1] < 0xDC00 ||
+          input[i + 1] > 0xDFFF) {
+        output->resize(original_size);
+        return false;
+      }
+      code_point =
+          0x10000 + ((code_point - 0xD800) << 10) + (input[i + 1] - 0xDC00);
+      units = 2;
+    }
+    i += units;
+    size_t needed = out + 4 + (length - i);
+    if (output->size() < needed) {
+      output->resize(needed + needed / 4);
+    }
+    char* bytes = &(*output)[out];
+    if (code_point < 0x800) {
+      bytes[0] = static_cast<char>(0xC0 | (code_point >> 6));
+      bytes[1] = static_cast<char>(0x80 | (code_point & 0x3F));
+      out += 2;
+    } else if (code_point < 0x10000) {
+      bytes[0] = static_cast<char>(0xE0 | (code_point >> 12));
+      bytes[1] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      bytes[2] = static_cast<char>(0x80 | (code_point & 0x3F));
+      out += 3;
+    } else {
+      bytes[0] = static_cast<char>(0xF0 | (code_point >> 18));
+      bytes[1] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+      bytes[2] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+      bytes[3] = static_cast<char>(0x80 | (code_point & 0x3F));
+      out += 4;
+    }
+  }
+  output->resize(out);
+  return true;
+}
+
+bool AppendUtf16FromUtf8(const char* input,
+                         size_t length,
+                         std::wstring* output) {
+  const size_t original_size = output->size();
+  // No sequence takes more code units than it has bytes.
+  size_t out = original_size;
+  output->resize(out + length);
+  size_t i = 0;
+  for (;;) {
+    size_t ascii = AsciiPrefix(input + i, length - i);
+    WidenAscii(input + i, ascii, &(*output)[out]);
+    i += ascii;
+    out += ascii;
+    if (i == length) {
+      break;
+    }
+
+    uint32_t code_point = 0;
+    size_t size = DecodeUtf8(reinterpret_cast<const unsigned char*>(input) + i,
+                             length - i, &code_point);
+    if (size == 0) {
+      output->resize(original_size);
+      return false;
+    }
+    i += size;
+    if (code_point < 0x10000) {
+      (*output)[out++] = static_cast<wchar_t>(code_point);
+    } else {
+      code_point -= 0x10000;
+      (*output)[out++] = static_cast<wchar_t>(0xD800 + (code_point >> 10));
+      (*output)[out++] = static_cast<wchar_t>(0xDC00 + (code_point & 0x3FF));
+    }
+  }
+  output->resize(out);
+  return true;
+}
+
+size_t ValidUtf8Prefix(const char* input, size_t length) {
+  size_t i = 0;
+  for (;;) {
+    i += AsciiPrefix(input + i, length - i);
+    if (i == length) {
+      return i;
+    }
+    uint32_t code_point = 0;
+    size_t size = DecodeUtf8(reinterpret_cast<const unsigned char*>(input) + i,
+                             length - i, &code_point);
+    if (size == 0) {
+      return i;
+    }
+    i += size;
+  }
+}
+
+size_t JsonEscapedSize(const char* input, size_t length) {
+  size_t size = 0;
+  size_t i = 0;
+  for (;;) {
+    size_t plain = PlainPrefix(input + i, length - i);
+    size += plain;
+    i += plain;
+    if (i == length) {
+      return size;
+    }
+    size += ShortEscape(static_cast<unsigned char>(input[i])) ? 2 : 6;
+    ++i;
+  }
+}
+
+void AppendJsonEscaped(const char* input, size_t length, std::string* output) {
+  static constexpr char kHexDigits[] = "0123456789abcdef";
+  size_t i = 0;
+  for (;;) {
+    size_t plain = PlainPrefix(input + i, length - i);
+    output->append(input + i, plain);
+    i += plain;
+    if (i == length) {
+      return;
+    }
+    auto c = static_cast<unsigned char>(input[i]);
+    if (char escape = ShortEscape(c)) {
+      output->push_back('\\');
+      output->push_back(escape);
+    } else {
+      output->append("\\u00");
+      output->push_back(kHexDigits[c >> 4]);
+      output->push_back(kHexDigits[c & 0xF]);
+    }
+    ++i;
+  }
+}
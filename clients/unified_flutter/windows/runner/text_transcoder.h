@@ -0,0 +1,39 @@
+#ifndef RUNNER_TEXT_TRANSCODER_H_
+#define RUNNER_TEXT_TRANSCODER_H_
+
+#include <cstddef>
+#include <string>
+
+// Conversions between UTF-16 and UTF-8, and escaping for JSON strings, fast
+// enough for documents of several megabytes.
+//
+// Most text is mostly ASCII, so runs of it are checked and copied 16 bytes at
+// a time with SSE2, and only the rest is handled a code point at a time.
+// Output is appended to the caller's string, which is grown at most a few
+// times per call rather than once per code point, and can be reused across
+// calls.
+
+// Appends |input| as UTF-8 to |output|. Returns false, leaving |output| as it
+// was, if |input| has an unpaired surrogate.
+bool AppendUtf8FromUtf16(const wchar_t* input,
+                         size_t length,
+                         std::string* output);
+
+// Appends |input| as UTF-16 to |output|. Returns false, leaving |output| as
+// it was, if |input| is not valid UTF-8.
+bool AppendUtf16FromUtf8(const char* input,
+                         size_t length,
+                         std::wstring* output);
+
+// Returns how many bytes at the start of |input| are whole, valid UTF-8
+// sequences. Text read in pieces can be checked piece by piece, carrying
+// over a sequence that a piece cut short.
+size_t ValidUtf8Prefix(const char* input, size_t length);
+
+// Returns the size of |input| once escaped for a JSON string.
+size_t JsonEscapedSize(const char* input, size_t length);
+
+// Appends |input| to |output|, escaped for a JSON string.
+void AppendJsonEscaped(const char* input, size_t length, std::string* output);
+
+#endif  // RUNNER_TEXT_TRANSCODER_H_
@@ -0,0 +1,281 @@
+#include "token_vault.h"
+
+#include <flutter/encodable_value.h>
+#include <flutter/standard_message_codec.h>
+#include <shlobj.h>
+#include <wincrypt.h>
+
+#include <memory>
+#include <vector>
+
+#include "runner_trace.h"
+#include "worker_pool.h"
+
+namespace {
+
+// Folder under %LOCALAPPDATA% for the bundle, and its file name.
+constexpr const wchar_t kVaultFolder[] = L"\\Tamshai Corp\\Tamshai AI";
+constexpr const wchar_t kVaultFile[] = L"\\tokens.bin";
+constexpr const wchar_t kTemporarySuffix[] = L".tmp";
+
+// Mixed into the encryption. It is compiled into the binary, so it does not
+// keep out other code running as the user; it only keeps this blob apart
+// from the user's other DPAPI blobs.
+constexpr char kEntropy[] = "TamshaiAI.TokenVault.v1";
+
+// A token bundle is a few kilobytes; anything much larger is not one.
+constexpr LONGLONG kMaxBundleSize = 1024 * 1024;
+
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+DATA_BLOB EntropyBlob() {
+  DATA_BLOB entropy;
+  entropy.pbData = reinterpret_cast<BYTE*>(const_cast<char*>(kEntropy));
+  entropy.cbData = sizeof(kEntropy) - 1;
+  return entropy;
+}
+
+// Overwrites |bytes| before they are freed, as they held plaintext.
+void Scrub(std::vector<uint8_t>& bytes) {
+  if (!bytes.empty()) {
+    SecureZeroMemory(bytes.data(), bytes.size());
+  }
+}
+
+void Scrub(TokenVault::Entries& entries) {
+  for (auto& entry : entries) {
+    if (!entry.second.empty()) {
+      SecureZeroMemory(&entry.second[0], entry.second.size());
+    }
+  }
+  entries.clear();
+}
+
+// Reads the whole file at |path|. Sets |missing| if it does not exist.
+bool ReadFileContents(const std::wstring& path,
+                      std::vector<uint8_t>* contents,
+                      bool* missing) {
+  *missing = false;
+  HANDLE file = CreateFile(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                           nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+                           nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    DWORD error = GetLastError();
+    *missing = error == ERROR_FILE_NOT_FOUND || error == ERROR_PATH_NOT_FOUND;
+    return false;
+  }
+  LARGE_INTEGER size;
+  bool read = GetFileSizeEx(file, &size) && size.QuadPart <= kMaxBundleSize;
+  if (read) {
+    contents->resize(static_cast<size_t>(size.QuadPart));
+    DWORD bytes_read = 0;
+    read = contents->empty() ||
+           (ReadFile(file, contents->data(),
+                     static_cast<DWORD>(contents->size()), &bytes_read,
+                     nullptr) &&
+            bytes_read == contents->size());
+  }
+  CloseHandle(file);
+  return read;
+}
+
+// Writes |contents| to a temporary file next to |path|, then moves it over
+// |path|, so that readers see either the old bundle or the new one.
+bool ReplaceFileContents(const std::wstring& path, const DATA_BLOB& contents) {
+  std::wstring temporary_path = path + kTemporarySuffix;
+  HANDLE file = CreateFile(temporary_path.c_str(), GENERIC_WRITE, 0, nullptr,
+                           CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL | FILE_FLAG_WRITE_THROUGH,
+                           nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  DWORD bytes_written = 0;
+  bool written = WriteFile(file, contents.pbData, contents.cbData,
+                           &bytes_written, nullptr) &&
+                 bytes_written == contents.cbData && FlushFileBuffers(file);
+  CloseHandle(file);
+  if (!written ||
+      !MoveFileEx(temporary_path.c_str(), path.c_str(),
+                  MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+    DeleteFile(temporary_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+TokenVault::~TokenVault() {
+  if (entries_) {
+    Scrub(*entries_);
+  }
+}
+
+// static
+TokenVault* TokenVault::GetInstance() {
+  static TokenVault* instance = new TokenVault();
+  return instance;
+}
+
+void TokenVault::Prefetch() {
+  // Posted on its own, as the vault is never destroyed. Dart's first read
+  // waits on it, hence the priority.
+  WorkerPool::GetInstance()->Post(
+      WorkerPool::Priority::kInteractive, [this]() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        TraceSpan span("TokenVaultPrefetch");
+        EnsureLoaded();
+      });
+}
+
+std::optional<TokenVault::Entries> TokenVault::GetAll() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!EnsureLoaded()) {
+    return std::nullopt;
+  }
+  return entries_;
+}
+
+bool TokenVault::Update(const Changes& changes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!EnsureLoaded()) {
+    return false;
+  }
+  Entries updated = *entries_;
+  for (const auto& change : changes) {
+    if (change.second) {
+      updated[change.first] = *change.second;
+    } else {
+      updated.erase(change.first);
+    }
+  }
+  if (!Write(updated)) {
+    Scrub(updated);
+    return false;
+  }
+  Scrub(*entries_);
+  entries_ = std::move(updated);
+  return true;
+}
+
+bool TokenVault::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (path().empty() ||
+      (!DeleteFile(path().c_str()) && GetLastError() != ERROR_FILE_NOT_FOUND)) {
+    return false;
+  }
+  if (entries_) {
+    Scrub(*entries_);
+  }
+  entries_ = Entries();
+  return true;
+}
+
+bool TokenVault::EnsureLoaded() {
+  if (entries_) {
+    return true;
+  }
+  if (path().empty()) {
+    return false;
+  }
+
+  std::vector<uint8_t> encrypted;
+  bool missing = false;
+  if (!ReadFileContents(path(), &encrypted, &missing)) {
+    if (missing) {
+      entries_ = Entries();
+      return true;
+    }
+    return false;
+  }
+
+  DATA_BLOB input;
+  input.pbData = encrypted.data();
+  input.cbData = static_cast<DWORD>(encrypted.size());
+  DATA_BLOB entropy = EntropyBlob();
+  DATA_BLOB output{};
+  // Only the environment can make the file unreadable for a while; a bundle
+  // that cannot be decrypted, e.g. because the profile was copied to another
+  // machine, never will be, so it is dropped.
+  entries_ = Entries();
+  if (!CryptUnprotectData(&input, nullptr, &entropy, nullptr, nullptr,
+                          CRYPTPROTECT_UI_FORBIDDEN, &output)) {
+    return true;
+  }
+  std::vector<uint8_t> plaintext(output.pbData, output.pbData + output.cbData);
+  SecureZeroMemory(output.pbData, output.cbData);
+  LocalFree(output.pbData);
+
+  std::unique_ptr<EncodableValue> decoded =
+      flutter::StandardMessageCodec::GetInstance().DecodeMessage(plaintext);
+  Scrub(plaintext);
+  const auto* map = decoded ? std::get_if<EncodableMap>(decoded.get())
+                            : nullptr;
+  if (!map) {
+    return true;
+  }
+  Entries entries;
+  for (const auto& entry : *map) {
+    const auto* key = std::get_if<std::string>(&entry.first);
+    const auto* value = std::get_if<std::string>(&entry.second);
+    if (key && value) {
+      entries[*key] = *value;
+    }
+  }
+  entries_ = std::move(entries);
+  return true;
+}
+
+bool TokenVault::Write(const Entries& entries) {
+  if (path().empty()) {
+    return false;
+  }
+  EncodableValue bundle{EncodableMap()};
+  auto& map = std::get<EncodableMap>(bundle);
+  for (const auto& entry : entries) {
+    map[EncodableValue(entry.first)] = EncodableValue(entry.second);
+  }
+  std::unique_ptr<std::vector<uint8_t>> plaintext =
+      flutter::StandardMessageCodec::GetInstance().EncodeMessage(bundle);
+  for (auto& entry : map) {
+    auto* value = std::get_if<std::string>(&entry.second);
+    if (value && !value->empty()) {
+      SecureZeroMemory(&(*value)[0], value->size());
+    }
+  }
+
+  DATA_BLOB input;
+  input.pbData = plaintext->data();
+  input.cbData = static_cast<DWORD>(plaintext->size());
+  DATA_BLOB entropy = EntropyBlob();
+  DATA_BLOB output{};
+  bool encrypted =
+      CryptProtectData(&input, L"Tamshai AI tokens", &entropy, nullptr,
+                       nullptr, CRYPTPROTECT_UI_FORBIDDEN, &output) != FALSE;
+  Scrub(*plaintext);
+  if (!encrypted) {
+    return false;
+  }
+  bool written = ReplaceFileContents(path(), output);
+  LocalFree(output.pbData);
+  return written;
+}
+
+const std::wstring& TokenVault::path() {
+  if (path_.empty()) {
+    PWSTR local_app_data = nullptr;
+    if (SUCCEEDED(SHGetKnownFolderPath(FOLDERID_LocalAppData, 0, nullptr,
+                                       &local_app_data))) {
+      std::wstring folder = std::wstring(local_app_data) + kVaultFolder;
+      int result = SHCreateDirectoryEx(nullptr, folder.c_str(), nullptr);
+      if (result == ERROR_SUCCESS || result == ERROR_ALREADY_EXISTS ||
+          result == ERROR_FILE_EXISTS) {
+        path_ = folder + kVaultFile;
+      }
+    }
+    CoTaskMemFree(local_app_data);
+  }
+  return path_;
+}
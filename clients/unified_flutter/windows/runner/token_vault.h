@@ -0,0 +1,70 @@
+#ifndef RUNNER_TOKEN_VAULT_H_
+#define RUNNER_TOKEN_VAULT_H_
+
+#include <windows.h>
+
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+
+// The runner's encrypted store for the auth token bundle.
+//
+// All entries live in one file under %LOCALAPPDATA%, encrypted as a whole
+// with a single DPAPI call for the current user, so storing a refreshed set
+// of tokens costs one encryption and one write rather than one Credential
+// Manager round trip per key. Writes go to a temporary file that then
+// replaces the old one, so a crash mid-write leaves the previous bundle.
+//
+// The decrypted entries are cached after the first read. Thread-safe; the
+// methods block on DPAPI and the disk, so call them off the platform thread.
+class TokenVault {
+ public:
+  using Entries = std::map<std::string, std::string>;
+
+  // New values by key; a missing value removes the entry.
+  using Changes = std::map<std::string, std::optional<std::string>>;
+
+  ~TokenVault();
+
+  // Returns the process-wide instance.
+  static TokenVault* GetInstance();
+
+  // Starts reading and decrypting the bundle on the worker pool, so that
+  // it is usually in the cache by the time Dart first asks for it. Calls
+  // made while it is still loading wait for it. Returns immediately.
+  void Prefetch();
+
+  // Returns the stored entries, which are empty if nothing has been stored
+  // or the bundle can no longer be decrypted. Returns nothing if the bundle
+  // could not be read.
+  std::optional<Entries> GetAll();
+
+  // Applies |changes| to the stored entries. Returns false if the bundle
+  // could not be read or written, in which case nothing is changed.
+  bool Update(const Changes& changes);
+
+  // Removes every entry.
+  bool Clear();
+
+ private:
+  TokenVault() = default;
+
+  // Loads the bundle into |entries_| unless it already is. Must be called
+  // with |mutex_| held.
+  bool EnsureLoaded();
+
+  // Encrypts |entries| and replaces the stored bundle with them.
+  bool Write(const Entries& entries);
+
+  // The bundle's path, or empty if the folder could not be found or made.
+  const std::wstring& path();
+
+  std::mutex mutex_;
+
+  // Everything below is guarded by |mutex_|.
+  std::wstring path_;
+  std::optional<Entries> entries_;
+};
+
+#endif  // RUNNER_TOKEN_VAULT_H_
@@ -0,0 +1,116 @@
+#include "token_vault_plugin.h"
+
+#include <flutter/standard_method_codec.h>
+
+#include <string>
+#include <utility>
+
+#include "token_vault.h"
+
+namespace {
+
+constexpr char kMethodChannelName[] = "com.tamshai.ai/token_vault";
+
+using flutter::EncodableMap;
+using flutter::EncodableValue;
+
+// Converts the putAll values to vault changes. Returns nothing if any key or
+// value has the wrong type.
+std::optional<TokenVault::Changes> ParseChanges(const EncodableMap& values) {
+  TokenVault::Changes changes;
+  for (const auto& entry : values) {
+    const auto* key = std::get_if<std::string>(&entry.first);
+    if (!key) {
+      return std::nullopt;
+    }
+    if (entry.second.IsNull()) {
+      changes[*key] = std::nullopt;
+    } else if (const auto* value = std::get_if<std::string>(&entry.second)) {
+      changes[*key] = *value;
+    } else {
+      return std::nullopt;
+    }
+  }
+  return changes;
+}
+
+}  // namespace
+
+TokenVaultPlugin::TokenVaultPlugin(flutter::BinaryMessenger* messenger,
+                                   PlatformTaskQueue* task_queue)
+    : pending_results_(task_queue, "The token vault could not be used") {
+  method_channel_ =
+      std::make_unique<flutter::MethodChannel<flutter::EncodableValue>>(
+          messenger, kMethodChannelName,
+          &flutter::StandardMethodCodec::GetInstance());
+  method_channel_->SetMethodCallHandler(
+      [this](const auto& call, auto result) {
+        HandleMethodCall(call, std::move(result));
+      });
+}
+
+TokenVaultPlugin::~TokenVaultPlugin() {
+  method_channel_->SetMethodCallHandler(nullptr);
+}
+
+void TokenVaultPlugin::HandleMethodCall(
+    const flutter::MethodCall<flutter::EncodableValue>& call,
+    Result result) {
+  if (call.method_name() == "getAll") {
+    Enqueue(
+        []() -> std::optional<EncodableValue> {
+          std::optional<TokenVault::Entries> entries =
+              TokenVault::GetInstance()->GetAll();
+          if (!entries) {
+            return std::nullopt;
+          }
+          EncodableMap map;
+          for (const auto& entry : *entries) {
+            map[EncodableValue(entry.first)] = EncodableValue(entry.second);
+          }
+          return EncodableValue(std::move(map));
+        },
+        std::move(result));
+  } else if (call.method_name() == "putAll") {
+    const auto* arguments = std::get_if<EncodableMap>(call.arguments());
+    const EncodableMap* values_map = nullptr;
+    if (arguments) {
+      auto values = arguments->find(EncodableValue("values"));
+      if (values != arguments->end()) {
+        values_map = std::get_if<EncodableMap>(&values->second);
+      }
+    }
+    std::optional<TokenVault::Changes> changes =
+        values_map ? ParseChanges(*values_map) : std::nullopt;
+    if (!changes) {
+      result->Error("bad_arguments", "values must map strings to strings");
+      return;
+    }
+    Enqueue(
+        [update = std::move(*changes)]() -> std::optional<EncodableValue> {
+          if (!TokenVault::GetInstance()->Update(update)) {
+            return std::nullopt;
+          }
+          return EncodableValue();
+        },
+        std::move(result));
+  } else if (call.method_name() == "clear") {
+    Enqueue(
+        []() -> std::optional<EncodableValue> {
+          if (!TokenVault::GetInstance()->Clear()) {
+            return std::nullopt;
+          }
+          return EncodableValue();
+        },
+        std::move(result));
+  } else {
+    result->NotImplemented();
+  }
+}
+
+void TokenVaultPlugin::Enqueue(Job job, Result result) {
+  int64_t id = pending_results_.Add(std::move(result));
+  vault_sequence_.Post([this, id, work = std::move(job)]() {
+    pending_results_.Complete(id, work());
+  });
+}
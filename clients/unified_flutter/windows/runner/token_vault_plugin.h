@@ -0,0 +1,63 @@
+#ifndef RUNNER_TOKEN_VAULT_PLUGIN_H_
+#define RUNNER_TOKEN_VAULT_PLUGIN_H_
+
+#include <flutter/binary_messenger.h>
+#include <flutter/encodable_value.h>
+#include <flutter/method_channel.h>
+
+#include <functional>
+#include <memory>
+#include <optional>
+
+#include "pending_results.h"
+#include "platform_task_queue.h"
+#include "worker_pool.h"
+
+// Gives Dart batched access to the TokenVault.
+//
+// Vault calls run in order on the worker pool, so DPAPI and disk work stays
+// off the platform thread, and each call moves the whole bundle:
+//
+// Method channel "com.tamshai.ai/token_vault":
+//   getAll()         - every stored entry as a map of strings.
+//   putAll({values}) - sets the given entries in one write; entries whose
+//                      value is null are removed.
+//   clear()          - removes every entry.
+class TokenVaultPlugin {
+ public:
+  TokenVaultPlugin(flutter::BinaryMessenger* messenger,
+                   PlatformTaskQueue* task_queue);
+  ~TokenVaultPlugin();
+
+  // Prevent copying.
+  TokenVaultPlugin(TokenVaultPlugin const&) = delete;
+  TokenVaultPlugin& operator=(TokenVaultPlugin const&) = delete;
+
+ private:
+  using Result =
+      std::unique_ptr<flutter::MethodResult<flutter::EncodableValue>>;
+
+  // Vault work run on |vault_sequence_|. Returns the value to complete the call
+  // with, or nothing if the vault could not be read or written.
+  using Job = std::function<std::optional<flutter::EncodableValue>()>;
+
+  void HandleMethodCall(
+      const flutter::MethodCall<flutter::EncodableValue>& call,
+      Result result);
+
+  // Runs |job| in order after the jobs before it, then completes |result|
+  // with its outcome on the platform thread.
+  void Enqueue(Job job, Result result);
+
+  // Calls waiting for their job.
+  PendingResults pending_results_;
+
+  std::unique_ptr<flutter::MethodChannel<flutter::EncodableValue>>
+      method_channel_;
+
+  // Declared last, so that it goes first: it finishes the job in progress,
+  // so that a write is never cut short, and drops queued ones.
+  WorkerPool::Sequence vault_sequence_{WorkerPool::Priority::kInteractive};
+};
+
+#endif  // RUNNER_TOKEN_VAULT_PLUGIN_H_
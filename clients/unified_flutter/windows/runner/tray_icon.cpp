@@ -0,0 +1,142 @@
+#include "tray_icon.h"
+
+#include <shellapi.h>
+#include <windowsx.h>
+
+#include <utility>
+
+#include "resource.h"
+
+namespace {
+
+// Sent to the window for the icon's clicks and menu key. After
+// PlatformTaskQueue's WM_APP + 1, which it is never sent to.
+constexpr UINT kTrayMessage = WM_APP + 2;
+
+// The app has one icon.
+constexpr UINT kIconId = 1;
+
+constexpr int kHotKeyId = 0x7A01;
+constexpr UINT kHotKeyModifiers = MOD_CONTROL | MOD_ALT | MOD_NOREPEAT;
+constexpr UINT kHotKey = 'T';
+
+constexpr wchar_t kTooltip[] = L"Tamshai AI";
+
+enum MenuCommand : UINT {
+  kOpenCommand = 1,
+  kQuitCommand,
+};
+
+NOTIFYICONDATA IconData(HWND window) {
+  NOTIFYICONDATA data{};
+  data.cbSize = sizeof(data);
+  data.hWnd = window;
+  data.uID = kIconId;
+  return data;
+}
+
+}  // namespace
+
+TrayIcon::TrayIcon(HWND window,
+                   OpenHandler on_open,
+                   std::function<void()> on_quit)
+    : window_(window),
+      on_open_(std::move(on_open)),
+      on_quit_(std::move(on_quit)) {
+  // Sized for the window's monitor; the shell scales it for the others.
+  UINT dpi = GetDpiForWindow(window_);
+  icon_ = static_cast<HICON>(
+      LoadImage(GetModuleHandle(nullptr), MAKEINTRESOURCE(IDI_APP_ICON),
+                IMAGE_ICON, GetSystemMetricsForDpi(SM_CXSMICON, dpi),
+                GetSystemMetricsForDpi(SM_CYSMICON, dpi), LR_DEFAULTCOLOR));
+
+  taskbar_created_message_ = RegisterWindowMessage(L"TaskbarCreated");
+  // An elevated runner would otherwise not hear of Explorer restarting.
+  ChangeWindowMessageFilterEx(window_, taskbar_created_message_,
+                              MSGFLT_ALLOW, nullptr);
+  Add();
+
+  hotkey_registered_ =
+      RegisterHotKey(window_, kHotKeyId, kHotKeyModifiers, kHotKey) != FALSE;
+}
+
+TrayIcon::~TrayIcon() {
+  if (hotkey_registered_) {
+    UnregisterHotKey(window_, kHotKeyId);
+  }
+  NOTIFYICONDATA data = IconData(window_);
+  Shell_NotifyIcon(NIM_DELETE, &data);
+  if (icon_) {
+    DestroyIcon(icon_);
+  }
+}
+
+bool TrayIcon::HandleMessage(UINT const message,
+                             WPARAM const wparam,
+                             LPARAM const lparam) {
+  if (message == kTrayMessage) {
+    // With NOTIFYICON_VERSION_4 the event is in the low word, and the
+    // anchor for a menu in |wparam|.
+    switch (LOWORD(lparam)) {
+      case NIN_SELECT:
+      case NIN_KEYSELECT:
+        on_open_("icon");
+        break;
+      case WM_CONTEXTMENU:
+        ShowMenu({GET_X_LPARAM(wparam), GET_Y_LPARAM(wparam)});
+        break;
+    }
+    return true;
+  }
+  if (message == WM_HOTKEY && static_cast<int>(wparam) == kHotKeyId) {
+    on_open_("hotkey");
+    return true;
+  }
+  if (taskbar_created_message_ && message == taskbar_created_message_) {
+    Add();
+    return true;
+  }
+  return false;
+}
+
+void TrayIcon::Add() {
+  NOTIFYICONDATA data = IconData(window_);
+  data.uFlags = NIF_MESSAGE | NIF_ICON | NIF_TIP | NIF_SHOWTIP;
+  data.uCallbackMessage = kTrayMessage;
+  data.hIcon = icon_;
+  wcscpy_s(data.szTip, kTooltip);
+  if (!Shell_NotifyIcon(NIM_ADD, &data)) {
+    // Explorer isn't up yet; TaskbarCreated follows once it is.
+    return;
+  }
+  data.uVersion = NOTIFYICON_VERSION_4;
+  Shell_NotifyIcon(NIM_SETVERSION, &data);
+}
+
+void TrayIcon::ShowMenu(POINT anchor) {
+  HMENU menu = CreatePopupMenu();
+  if (!menu) {
+    return;
+  }
+  AppendMenu(menu, MF_STRING, kOpenCommand, L"Open Tamshai AI");
+  AppendMenu(menu, MF_SEPARATOR, 0, nullptr);
+  AppendMenu(menu, MF_STRING, kQuitCommand, L"Quit");
+  SetMenuDefaultItem(menu, kOpenCommand, FALSE);
+
+  // Without the foreground the menu would not close when the user clicks
+  // elsewhere; the WM_NULL after it is the documented companion to that.
+  SetForegroundWindow(window_);
+  UINT flags = TPM_RETURNCMD | TPM_NONOTIFY | TPM_RIGHTBUTTON |
+               (GetSystemMetrics(SM_MENUDROPALIGNMENT) ? TPM_RIGHTALIGN
+                                                       : TPM_LEFTALIGN);
+  UINT command = static_cast<UINT>(
+      TrackPopupMenuEx(menu, flags, anchor.x, anchor.y, window_, nullptr));
+  PostMessage(window_, WM_NULL, 0, 0);
+  DestroyMenu(menu);
+
+  if (command == kOpenCommand) {
+    on_open_("menu");
+  } else if (command == kQuitCommand) {
+    on_quit_();
+  }
+}
@@ -0,0 +1,53 @@
+#ifndef RUNNER_TRAY_ICON_H_
+#define RUNNER_TRAY_ICON_H_
+
+#include <windows.h>
+
+#include <functional>
+
+// The notification area icon and global hotkey of the tray-resident app.
+//
+// Clicking the icon, choosing "Open" from its menu or pressing Ctrl+Alt+T
+// anywhere calls the open handler; choosing "Quit" calls the quit handler.
+// The icon is added back if Explorer restarts. The hotkey is left alone if
+// another app already holds it.
+class TrayIcon {
+ public:
+  // Called with how the user asked for the window: "icon", "menu" or
+  // "hotkey".
+  using OpenHandler = std::function<void(const char* source)>;
+
+  // Adds the icon for |window|, which must pass its messages to
+  // |HandleMessage| and outlive the icon.
+  TrayIcon(HWND window, OpenHandler on_open, std::function<void()> on_quit);
+  ~TrayIcon();
+
+  // Prevent copying.
+  TrayIcon(TrayIcon const&) = delete;
+  TrayIcon& operator=(TrayIcon const&) = delete;
+
+  // Handles a message sent to the window. Returns true if it was meant only
+  // for the icon.
+  bool HandleMessage(UINT const message,
+                     WPARAM const wparam,
+                     LPARAM const lparam);
+
+ private:
+  // Adds the icon to the notification area.
+  void Add();
+
+  // Shows the icon's menu at |anchor| and acts on the choice.
+  void ShowMenu(POINT anchor);
+
+  HWND window_;
+  OpenHandler on_open_;
+  std::function<void()> on_quit_;
+
+  // Sent to every top-level window when Explorer's taskbar is (re)created.
+  UINT taskbar_created_message_ = 0;
+
+  HICON icon_ = nullptr;
+  bool hotkey_registered_ = false;
+};
+
+#endif  // RUNNER_TRAY_ICON_H_
@@ -7,6 +7,8 @@
 
 #include <iostream>
 
+#include "text_transcoder.h"
+
 void CreateAndAttachConsole() {
   if (::AllocConsole()) {
     FILE *unused;
@@ -42,24 +44,20 @@ std::vector<std::string> GetCommandLineArguments() {
 }
 
 std::string Utf8FromUtf16(const wchar_t* utf16_string) {
-  if (utf16_string == nullptr) {
-    return std::string();
-  }
-  unsigned int target_length = ::WideCharToMultiByte(
-      CP_UTF8, WC_ERR_INVALID_CHARS, utf16_string,
-      -1, nullptr, 0, nullptr, nullptr)
-    -1; // remove the trailing null character
-  int input_length = (int)wcslen(utf16_string);
   std::string utf8_string;
-  if (target_length == 0 || target_length > utf8_string.max_size()) {
-    return utf8_string;
-  }
-  utf8_string.resize(target_length);
-  int converted_length = ::WideCharToMultiByte(
-      CP_UTF8, WC_ERR_INVALID_CHARS, utf16_string,
-      input_length, utf8_string.data(), target_length, nullptr, nullptr);
-  if (converted_length == 0) {
+  if (utf16_string == nullptr ||
+      !AppendUtf8FromUtf16(utf16_string, wcslen(utf16_string),
+                           &utf8_string)) {
     return std::string();
   }
   return utf8_string;
 }
+
+std::wstring Utf16FromUtf8(const std::string& utf8_string) {
+  std::wstring utf16_string;
+  if (!AppendUtf16FromUtf8(utf8_string.data(), utf8_string.size(),
+                           &utf16_string)) {
+    return std::wstring();
+  }
+  return utf16_string;
+}
@@ -3,7 +3,13 @@
 #include <dwmapi.h>
 #include <flutter_windows.h>
 
+#include <utility>
+
+#include "memory_telemetry.h"
 #include "resource.h"
+#include "runner_trace.h"
+#include "system_settings.h"
+#include "window_placement.h"
 
 namespace {
 
@@ -18,39 +24,32 @@ namespace {
 
 constexpr const wchar_t kWindowClassName[] = L"FLUTTER_RUNNER_WIN32_WINDOW";
 
-/// Registry key for app theme preference.
-///
-/// A value of 0 indicates apps should use dark mode. A non-zero or missing
-/// value indicates apps should use light mode.
-constexpr const wchar_t kGetPreferredBrightnessRegKey[] =
-  L"Software\\Microsoft\\Windows\\CurrentVersion\\Themes\\Personalize";
-constexpr const wchar_t kGetPreferredBrightnessRegValue[] = L"AppsUseLightTheme";
+// Timer that applies the latest size to the child content during a live
+// resize.
+constexpr UINT_PTR kLiveResizeTimerId = 0x7A02;
 
 // The number of Win32Window objects that currently exist.
 static int g_active_window_count = 0;
 
-using EnableNonClientDpiScaling = BOOL __stdcall(HWND hwnd);
-
 // Scale helper to convert logical scaler values to physical using passed in
 // scale factor
 int Scale(int source, double scale_factor) {
   return static_cast<int>(source * scale_factor);
 }
 
-// Dynamically loads the |EnableNonClientDpiScaling| from the User32 module.
-// This API is only needed for PerMonitor V1 awareness mode.
-void EnableFullDpiSupportIfAvailable(HWND hwnd) {
-  HMODULE user32_module = LoadLibraryA("User32.dll");
-  if (!user32_module) {
-    return;
+// Returns the display refresh interval in milliseconds, so that a live resize
+// updates the content at most once per vsync.
+UINT GetRefreshIntervalMs() {
+  DWM_TIMING_INFO timing_info{};
+  timing_info.cbSize = sizeof(timing_info);
+  if (SUCCEEDED(DwmGetCompositionTimingInfo(nullptr, &timing_info)) &&
+      timing_info.rateRefresh.uiNumerator != 0) {
+    UINT interval = (1000 * timing_info.rateRefresh.uiDenominator +
+                     timing_info.rateRefresh.uiNumerator - 1) /
+                    timing_info.rateRefresh.uiNumerator;
+    return interval > USER_TIMER_MINIMUM ? interval : USER_TIMER_MINIMUM;
   }
-  auto enable_non_client_dpi_scaling =
-      reinterpret_cast<EnableNonClientDpiScaling*>(
-          GetProcAddress(user32_module, "EnableNonClientDpiScaling"));
-  if (enable_non_client_dpi_scaling != nullptr) {
-    enable_non_client_dpi_scaling(hwnd);
-  }
-  FreeLibrary(user32_module);
+  return 16;
 }
 
 }  // namespace
@@ -91,7 +90,10 @@ const wchar_t* WindowClassRegistrar::GetWindowClass() {
     WNDCLASS window_class{};
     window_class.hCursor = LoadCursor(nullptr, IDC_ARROW);
     window_class.lpszClassName = kWindowClassName;
-    window_class.style = CS_HREDRAW | CS_VREDRAW;
+    // No CS_HREDRAW | CS_VREDRAW: the Flutter content repaints itself when
+    // resized, and invalidating the whole window on every size change only
+    // adds a second full repaint.
+    window_class.style = 0;
     window_class.cbClsExtra = 0;
     window_class.cbWndExtra = 0;
     window_class.hInstance = GetModuleHandle(nullptr);
@@ -123,36 +125,92 @@ Win32Window::~Win32Window() {
 bool Win32Window::Create(const std::wstring& title,
                          const Point& origin,
                          const Size& size) {
+  TraceSpan span("Win32Window::Create");
   Destroy();
 
+  TraceSpan class_span("WindowClassRegistrar::GetWindowClass");
   const wchar_t* window_class =
       WindowClassRegistrar::GetInstance()->GetWindowClass();
+  class_span.End();
 
-  const POINT target_point = {static_cast<LONG>(origin.x),
-                              static_cast<LONG>(origin.y)};
-  HMONITOR monitor = MonitorFromPoint(target_point, MONITOR_DEFAULTTONEAREST);
-  UINT dpi = FlutterDesktopGetDpiForMonitor(monitor);
-  double scale_factor = dpi / 96.0;
+  std::optional<WINDOWPLACEMENT> placement;
+  if (!placement_name_.empty()) {
+    placement = LoadWindowPlacement(placement_name_);
+  }
 
-  HWND window = CreateWindow(
-      window_class, title.c_str(), WS_OVERLAPPEDWINDOW,
-      Scale(origin.x, scale_factor), Scale(origin.y, scale_factor),
-      Scale(size.width, scale_factor), Scale(size.height, scale_factor),
-      nullptr, nullptr, GetModuleHandle(nullptr), this);
+  int x, y, width, height;
+  if (placement) {
+    // Already in physical pixels for the monitor it is restored to, but in
+    // workspace coordinates, which are offset from screen coordinates by
+    // that monitor's taskbar and app bars. RestorePlacement applies the
+    // placement itself; this only creates the window on the right monitor.
+    const RECT& rect = placement->rcNormalPosition;
+    x = rect.left;
+    y = rect.top;
+    width = rect.right - rect.left;
+    height = rect.bottom - rect.top;
+    MONITORINFO monitor_info{};
+    monitor_info.cbSize = sizeof(monitor_info);
+    if (GetMonitorInfo(MonitorFromRect(&rect, MONITOR_DEFAULTTONEAREST),
+                       &monitor_info)) {
+      x += monitor_info.rcWork.left - monitor_info.rcMonitor.left;
+      y += monitor_info.rcWork.top - monitor_info.rcMonitor.top;
+    }
+  } else {
+    const POINT target_point = {static_cast<LONG>(origin.x),
+                                static_cast<LONG>(origin.y)};
+    HMONITOR monitor =
+        MonitorFromPoint(target_point, MONITOR_DEFAULTTONEAREST);
+    TraceSpan dpi_span("FlutterDesktopGetDpiForMonitor");
+    UINT dpi = FlutterDesktopGetDpiForMonitor(monitor);
+    dpi_span.End();
+    double scale_factor = dpi / 96.0;
+    x = Scale(origin.x, scale_factor);
+    y = Scale(origin.y, scale_factor);
+    width = Scale(size.width, scale_factor);
+    height = Scale(size.height, scale_factor);
+  }
+
+  HWND window = CreateWindow(window_class, title.c_str(), WS_OVERLAPPEDWINDOW,
+                             x, y, width, height, nullptr, nullptr,
+                             GetModuleHandle(nullptr), this);
 
   if (!window) {
     return false;
   }
 
+  // Before OnCreate, so that the content is created at the size the window
+  // will be shown at.
+  if (placement) {
+    RestorePlacement(*placement);
+  }
+
   UpdateTheme(window);
+  settings_observer_ = SystemSettings::GetInstance()->AddObserver(
+      [this](unsigned int changes) { OnSystemSettingsChanged(changes); });
 
   return OnCreate();
 }
 
 bool Win32Window::Show() {
+  if (pending_placement_) {
+    WINDOWPLACEMENT placement = *pending_placement_;
+    pending_placement_.reset();
+    return SetWindowPlacement(window_handle_, &placement);
+  }
   return ShowWindow(window_handle_, SW_SHOWNORMAL);
 }
 
+void Win32Window::BringToFront() {
+  if (!window_handle_) {
+    return;
+  }
+  if (IsIconic(window_handle_)) {
+    ShowWindow(window_handle_, SW_RESTORE);
+  }
+  SetForegroundWindow(window_handle_);
+}
+
 // static
 LRESULT CALLBACK Win32Window::WndProc(HWND const window,
                                       UINT const message,
@@ -164,7 +222,7 @@ LRESULT CALLBACK Win32Window::WndProc(HWND const window,
                      reinterpret_cast<LONG_PTR>(window_struct->lpCreateParams));
 
     auto that = static_cast<Win32Window*>(window_struct->lpCreateParams);
-    EnableFullDpiSupportIfAvailable(window);
+    SystemSettings::GetInstance()->EnableNonClientDpiScaling(window);
     that->window_handle_ = window;
   } else if (Win32Window* that = GetThisFromHandle(window)) {
     return that->MessageHandler(window, message, wparam, lparam);
@@ -180,11 +238,18 @@ Win32Window::MessageHandler(HWND hwnd,
                             LPARAM const lparam) noexcept {
   switch (message) {
     case WM_DESTROY:
+      // A placement that was never shown is still the one to restore.
+      if (!placement_name_.empty() && !pending_placement_) {
+        SaveWindowPlacement(placement_name_, hwnd);
+      }
       window_handle_ = nullptr;
       Destroy();
       if (quit_on_close_) {
         PostQuitMessage(0);
       }
+      if (on_destroyed_) {
+        on_destroyed_();
+      }
       return 0;
 
     case WM_DPICHANGED: {
@@ -194,34 +259,83 @@ Win32Window::MessageHandler(HWND hwnd,
 
       SetWindowPos(hwnd, nullptr, newRectSize->left, newRectSize->top, newWidth,
                    newHeight, SWP_NOZORDER | SWP_NOACTIVATE);
+      RECT client = GetClientArea();
+      MemoryTelemetry::GetInstance()->MarkSurface(
+          "dpi", hwnd, client.right - client.left, client.bottom - client.top);
 
       return 0;
     }
     case WM_SIZE: {
-      RECT rect = GetClientArea();
-      if (child_content_ != nullptr) {
-        // Size and position the child window.
-        MoveWindow(child_content_, rect.left, rect.top, rect.right - rect.left,
-                   rect.bottom - rect.top, TRUE);
+      if (in_size_move_) {
+        // Resizing the content makes the engine reallocate its surface and
+        // render a frame at the new size, so during a drag only the latest
+        // size is applied, once per vsync.
+        if (!live_resize_pending_) {
+          live_resize_pending_ = true;
+          SetTimer(hwnd, kLiveResizeTimerId, GetRefreshIntervalMs(), nullptr);
+        }
+      } else {
+        ResizeChildContent();
       }
       return 0;
     }
 
+    case WM_ENTERSIZEMOVE:
+      in_size_move_ = true;
+      return 0;
+
+    case WM_EXITSIZEMOVE:
+      in_size_move_ = false;
+      KillTimer(hwnd, kLiveResizeTimerId);
+      live_resize_pending_ = false;
+      ResizeChildContent();
+      return 0;
+
+    case WM_TIMER:
+      if (wparam == kLiveResizeTimerId) {
+        KillTimer(hwnd, kLiveResizeTimerId);
+        live_resize_pending_ = false;
+        ResizeChildContent();
+        return 0;
+      }
+      break;
+
     case WM_ACTIVATE:
       if (child_content_ != nullptr) {
         SetFocus(child_content_);
       }
       return 0;
 
+    // Bursts of these are coalesced, and OnSystemSettingsChanged applies
+    // them.
     case WM_DWMCOLORIZATIONCOLORCHANGED:
-      UpdateTheme(hwnd);
+      SystemSettings::GetInstance()->NotifyChanged(
+          SystemSettings::kThemeChange);
       return 0;
+
+    case WM_SETTINGCHANGE:
+      SystemSettings::GetInstance()->NotifyChanged(
+          SystemSettings::ChangesFromSettingChange(wparam, lparam));
+      break;
+
+    case WM_FONTCHANGE:
+      SystemSettings::GetInstance()->NotifyChanged(
+          SystemSettings::kFontChange);
+      break;
   }
 
   return DefWindowProc(window_handle_, message, wparam, lparam);
 }
 
 void Win32Window::Destroy() {
+  if (settings_observer_) {
+    SystemSettings::GetInstance()->RemoveObserver(settings_observer_);
+    settings_observer_ = 0;
+  }
+  if (drop_target_) {
+    drop_target_->Revoke();
+    drop_target_ = nullptr;
+  }
   OnDestroy();
 
   if (window_handle_) {
@@ -249,6 +363,28 @@ void Win32Window::SetChildContent(HWND content) {
   SetFocus(child_content_);
 }
 
+void Win32Window::ResizeChildContent() {
+  if (child_content_ == nullptr) {
+    return;
+  }
+  RECT rect = GetClientArea();
+  RECT current;
+  GetWindowRect(child_content_, &current);
+  if (current.right - current.left == rect.right - rect.left &&
+      current.bottom - current.top == rect.bottom - rect.top) {
+    return;
+  }
+  // The content paints itself at its new size; forcing a repaint here would
+  // only draw it twice.
+  MoveWindow(child_content_, rect.left, rect.top, rect.right - rect.left,
+             rect.bottom - rect.top, FALSE);
+  // Marked here rather than on every WM_SIZE, as this is when the engine
+  // reallocates the surface.
+  MemoryTelemetry::GetInstance()->MarkSurface(
+      "resize", window_handle_, rect.right - rect.left,
+      rect.bottom - rect.top);
+}
+
 RECT Win32Window::GetClientArea() {
   RECT frame;
   GetClientRect(window_handle_, &frame);
@@ -263,6 +399,18 @@ void Win32Window::SetQuitOnClose(bool quit_on_close) {
   quit_on_close_ = quit_on_close;
 }
 
+void Win32Window::SetOnDestroyed(std::function<void()> callback) {
+  on_destroyed_ = std::move(callback);
+}
+
+void Win32Window::SetPlacementName(const std::wstring& name) {
+  placement_name_ = name;
+}
+
+void Win32Window::SetFileDropHandler(FileDropTarget::Callback handler) {
+  drop_target_ = FileDropTarget::Register(window_handle_, std::move(handler));
+}
+
 bool Win32Window::OnCreate() {
   // No-op; provided for subclasses.
   return true;
@@ -272,17 +420,47 @@ void Win32Window::OnDestroy() {
   // No-op; provided for subclasses.
 }
 
-void Win32Window::UpdateTheme(HWND const window) {
-  DWORD light_mode;
-  DWORD light_mode_size = sizeof(light_mode);
-  LSTATUS result = RegGetValue(HKEY_CURRENT_USER, kGetPreferredBrightnessRegKey,
-                               kGetPreferredBrightnessRegValue,
-                               RRF_RT_REG_DWORD, nullptr, &light_mode,
-                               &light_mode_size);
-
-  if (result == ERROR_SUCCESS) {
-    BOOL enable_dark_mode = light_mode == 0;
-    DwmSetWindowAttribute(window, DWMWA_USE_IMMERSIVE_DARK_MODE,
-                          &enable_dark_mode, sizeof(enable_dark_mode));
+void Win32Window::OnSystemSettingsChanged(unsigned int changes) {
+  if (changes & SystemSettings::kThemeChange) {
+    UpdateTheme(window_handle_);
+  }
+}
+
+void Win32Window::RestorePlacement(const WINDOWPLACEMENT& placement) {
+  // Moves the window to its normal position without showing it.
+  WINDOWPLACEMENT hidden = placement;
+  hidden.showCmd = SW_HIDE;
+  SetWindowPlacement(window_handle_, &hidden);
+
+  if (placement.showCmd == SW_SHOWMAXIMIZED) {
+    // A hidden window can't be maximized, but it can be given the bounds it
+    // will have once it is: the work area plus the resize borders, which a
+    // maximized window pushes off screen.
+    HMONITOR monitor =
+        MonitorFromWindow(window_handle_, MONITOR_DEFAULTTONEAREST);
+    MONITORINFO monitor_info{};
+    monitor_info.cbSize = sizeof(monitor_info);
+    if (GetMonitorInfo(monitor, &monitor_info)) {
+      UINT dpi = FlutterDesktopGetDpiForMonitor(monitor);
+      int padding = GetSystemMetricsForDpi(SM_CXPADDEDBORDER, dpi);
+      int border_x = GetSystemMetricsForDpi(SM_CXSIZEFRAME, dpi) + padding;
+      int border_y = GetSystemMetricsForDpi(SM_CYSIZEFRAME, dpi) + padding;
+      const RECT& work = monitor_info.rcWork;
+      SetWindowPos(window_handle_, nullptr, work.left - border_x,
+                   work.top - border_y,
+                   work.right - work.left + 2 * border_x,
+                   work.bottom - work.top + 2 * border_y,
+                   SWP_NOZORDER | SWP_NOACTIVATE);
+    }
   }
+
+  // Show applies the placement again, which restores the normal position
+  // that the above overwrote, and shows the window in its saved state.
+  pending_placement_ = placement;
+}
+
+void Win32Window::UpdateTheme(HWND const window) {
+  BOOL enable_dark_mode = SystemSettings::GetInstance()->UsesDarkMode();
+  DwmSetWindowAttribute(window, DWMWA_USE_IMMERSIVE_DARK_MODE,
+                        &enable_dark_mode, sizeof(enable_dark_mode));
 }
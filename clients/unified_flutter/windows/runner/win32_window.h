@@ -5,8 +5,12 @@
 
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 
+#include "file_drop_target.h"
+#include "system_settings.h"
+
 // A class abstraction for a high DPI-aware Win32 Window. Intended to be
 // inherited from by classes that wish to specialize with custom
 // rendering and input handling
@@ -32,13 +36,18 @@ class Win32Window {
   // |origin| and |size|. New windows are created on the default monitor. Window
   // sizes are specified to the OS in physical pixels, hence to ensure a
   // consistent size this function will scale the inputted width and height as
-  // as appropriate for the default monitor. The window is invisible until
+  // as appropriate for the default monitor. If a placement was saved under
+  // the name given to |SetPlacementName|, the window is instead restored to
+  // it, and |origin| and |size| are ignored. The window is invisible until
   // |Show| is called. Returns true if the window was created successfully.
   bool Create(const std::wstring& title, const Point& origin, const Size& size);
 
   // Show the current window. Returns true if the window was successfully shown.
   bool Show();
 
+  // Restores the window if it is minimized and makes it the foreground window.
+  void BringToFront();
+
   // Release OS resources associated with window.
   void Destroy();
 
@@ -52,6 +61,20 @@ class Win32Window {
   // If true, closing this window will quit the application.
   void SetQuitOnClose(bool quit_on_close);
 
+  // Runs |callback| once the window has been destroyed, whether the user
+  // closed it or |Destroy| was called. The callback must not delete the
+  // window.
+  void SetOnDestroyed(std::function<void()> callback);
+
+  // Saves the window's placement under |name| when it is destroyed, and
+  // restores it the next time the window is created. Must be called before
+  // |Create|.
+  void SetPlacementName(const std::wstring& name);
+
+  // Calls |handler| with the files dropped onto the window. Must be called
+  // after |Create|, at most once.
+  void SetFileDropHandler(FileDropTarget::Callback handler);
+
   // Return a RECT representing the bounds of the current client area.
   RECT GetClientArea();
 
@@ -71,6 +94,10 @@ class Win32Window {
   // Called when Destroy is called.
   virtual void OnDestroy();
 
+  // Called with the SystemSettings changes reported since the last call, at
+  // most once a frame. Applies theme changes to the window frame.
+  virtual void OnSystemSettingsChanged(unsigned int changes);
+
  private:
   friend class WindowClassRegistrar;
 
@@ -87,16 +114,44 @@ class Win32Window {
   // Retrieves a class instance pointer for |window|
   static Win32Window* GetThisFromHandle(HWND const window) noexcept;
 
-  // Update the window frame's theme to match the system theme.
+  // Update the window frame's theme to match the cached system theme.
   static void UpdateTheme(HWND const window);
 
+  // Moves the still hidden window to |placement|, to be shown in its state
+  // by |Show|.
+  void RestorePlacement(const WINDOWPLACEMENT& placement);
+
+  // Sizes the child content to the client area if it does not match yet.
+  void ResizeChildContent();
+
   bool quit_on_close_ = false;
 
+  std::function<void()> on_destroyed_;
+
   // window handle for top level window.
   HWND window_handle_ = nullptr;
 
   // window handle for hosted content.
   HWND child_content_ = nullptr;
+
+  // Whether the user is moving or resizing the window, between
+  // WM_ENTERSIZEMOVE and WM_EXITSIZEMOVE.
+  bool in_size_move_ = false;
+
+  // Whether a live resize of the child content is waiting for its timer.
+  bool live_resize_pending_ = false;
+
+  // Registration for OnSystemSettingsChanged, or 0.
+  SystemSettings::ObserverId settings_observer_ = 0;
+
+  // Registered by SetFileDropHandler, or nullptr.
+  FileDropTarget* drop_target_ = nullptr;
+
+  // Empty if the placement is not persisted.
+  std::wstring placement_name_;
+
+  // A restored placement that |Show| has yet to apply.
+  std::optional<WINDOWPLACEMENT> pending_placement_;
 };
 
 #endif  // RUNNER_WIN32_WINDOW_H_
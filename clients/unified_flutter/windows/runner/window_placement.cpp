@@ -0,0 +1,78 @@
+#include "window_placement.h"
+
+#include <flutter_windows.h>
+
+namespace {
+
+// Registry key the placements are stored under, one binary value per name.
+constexpr const wchar_t kPlacementRegKey[] =
+    L"Software\\Tamshai Corp\\Tamshai AI\\WindowPlacement";
+
+// Bumped whenever the layout of StoredPlacement changes, so that values
+// written by another version are ignored rather than misread.
+constexpr DWORD kStoredPlacementVersion = 1;
+
+struct StoredPlacement {
+  DWORD version;
+  WINDOWPLACEMENT placement;
+  UINT dpi;
+};
+
+UINT GetDpiForRect(const RECT& rect, DWORD flags) {
+  HMONITOR monitor = MonitorFromRect(&rect, flags);
+  return monitor ? FlutterDesktopGetDpiForMonitor(monitor) : 0;
+}
+
+}  // namespace
+
+std::optional<WINDOWPLACEMENT> LoadWindowPlacement(const std::wstring& name) {
+  StoredPlacement stored;
+  DWORD stored_size = sizeof(stored);
+  if (RegGetValue(HKEY_CURRENT_USER, kPlacementRegKey, name.c_str(),
+                  RRF_RT_REG_BINARY, nullptr, &stored,
+                  &stored_size) != ERROR_SUCCESS ||
+      stored_size != sizeof(stored) ||
+      stored.version != kStoredPlacementVersion ||
+      stored.placement.length != sizeof(WINDOWPLACEMENT) || stored.dpi == 0) {
+    return std::nullopt;
+  }
+
+  WINDOWPLACEMENT placement = stored.placement;
+  RECT& rect = placement.rcNormalPosition;
+  if (rect.right <= rect.left || rect.bottom <= rect.top) {
+    return std::nullopt;
+  }
+  UINT dpi = GetDpiForRect(rect, MONITOR_DEFAULTTONULL);
+  if (dpi == 0) {
+    return std::nullopt;
+  }
+  if (dpi != stored.dpi) {
+    rect.right = rect.left + MulDiv(rect.right - rect.left, dpi, stored.dpi);
+    rect.bottom = rect.top + MulDiv(rect.bottom - rect.top, dpi, stored.dpi);
+  }
+  if (placement.showCmd != SW_SHOWMAXIMIZED) {
+    placement.showCmd = SW_SHOWNORMAL;
+  }
+  return placement;
+}
+
+void SaveWindowPlacement(const std::wstring& name, HWND window) {
+  StoredPlacement stored{};
+  stored.version = kStoredPlacementVersion;
+  stored.placement.length = sizeof(WINDOWPLACEMENT);
+  if (!GetWindowPlacement(window, &stored.placement)) {
+    return;
+  }
+  WINDOWPLACEMENT& placement = stored.placement;
+  if (placement.showCmd == SW_SHOWMINIMIZED) {
+    placement.showCmd = (placement.flags & WPF_RESTORETOMAXIMIZED)
+                            ? SW_SHOWMAXIMIZED
+                            : SW_SHOWNORMAL;
+  }
+  // Taken from the monitor of the normal position, as the load is checked
+  // against, even if the window is maximized on another.
+  stored.dpi = GetDpiForRect(placement.rcNormalPosition,
+                             MONITOR_DEFAULTTONEAREST);
+  RegSetKeyValue(HKEY_CURRENT_USER, kPlacementRegKey, name.c_str(),
+                 REG_BINARY, &stored, sizeof(stored));
+}
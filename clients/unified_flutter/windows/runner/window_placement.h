@@ -0,0 +1,20 @@
+#ifndef RUNNER_WINDOW_PLACEMENT_H_
+#define RUNNER_WINDOW_PLACEMENT_H_
+
+#include <windows.h>
+
+#include <optional>
+#include <string>
+
+// Loads the placement last saved under |name|. Returns nothing if there is
+// none or the monitor it was on is no longer attached. If that monitor's DPI
+// has changed since, the normal position is rescaled to keep its size.
+//
+// A minimized window is saved in the state it restores to, so the show
+// command is always SW_SHOWNORMAL or SW_SHOWMAXIMIZED.
+std::optional<WINDOWPLACEMENT> LoadWindowPlacement(const std::wstring& name);
+
+// Saves the placement of |window|, and the DPI of its monitor, under |name|.
+void SaveWindowPlacement(const std::wstring& name, HWND window);
+
+#endif  // RUNNER_WINDOW_PLACEMENT_H_
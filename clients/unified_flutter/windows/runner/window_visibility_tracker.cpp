@@ -0,0 +1,267 @@
+#include "window_visibility_tracker.h"
+
+#include <dwmapi.h>
+#include <wtsapi32.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "memory_telemetry.h"
+#include "memory_trimmer.h"
+
+namespace {
+
+// Timer that coalesces window events into one occlusion check.
+constexpr UINT_PTR kOcclusionTimerId = 0x7A01;
+constexpr UINT kOcclusionCheckDelayMs = 250;
+
+// Window events after which another window may cover or uncover ours.
+struct WinEventRange {
+  DWORD first;
+  DWORD last;
+  // Whether only this process's windows are of interest.
+  bool own_process;
+};
+constexpr WinEventRange kWinEventRanges[] = {
+    {EVENT_SYSTEM_FOREGROUND, EVENT_SYSTEM_FOREGROUND, false},
+    {EVENT_SYSTEM_MOVESIZEEND, EVENT_SYSTEM_MOVESIZEEND, false},
+    {EVENT_SYSTEM_MINIMIZESTART, EVENT_SYSTEM_MINIMIZEEND, false},
+    {EVENT_OBJECT_SHOW, EVENT_OBJECT_HIDE, false},
+    // Fired for every move of every window on the desktop, including each
+    // step of animations, so only this process's are hooked. Other windows
+    // being dragged are caught by EVENT_SYSTEM_MOVESIZEEND.
+    {EVENT_OBJECT_LOCATIONCHANGE, EVENT_OBJECT_LOCATIONCHANGE, true},
+    {EVENT_OBJECT_CLOAKED, EVENT_OBJECT_UNCLOAKED, false},
+};
+
+// Every live tracker, and the event hooks they share. Platform thread only.
+std::vector<WindowVisibilityTracker*> g_trackers;
+std::vector<HWINEVENTHOOK> g_hooks;
+
+bool IsCloaked(HWND window) {
+  DWORD cloaked = 0;
+  return SUCCEEDED(DwmGetWindowAttribute(window, DWMWA_CLOAKED, &cloaked,
+                                         sizeof(cloaked))) &&
+         cloaked != 0;
+}
+
+// Returns the bounds the window visibly occupies, without the invisible
+// resize borders that GetWindowRect includes.
+bool GetVisibleBounds(HWND window, RECT* bounds) {
+  return SUCCEEDED(DwmGetWindowAttribute(window, DWMWA_EXTENDED_FRAME_BOUNDS,
+                                         bounds, sizeof(*bounds))) ||
+         GetWindowRect(window, bounds);
+}
+
+// Whether the windows above |window| in z-order cover all of it that is on
+// screen. Windows that may be see-through are assumed not to cover anything.
+bool IsCovered(HWND window) {
+  RECT bounds;
+  if (!GetVisibleBounds(window, &bounds)) {
+    return false;
+  }
+  RECT screen = {GetSystemMetrics(SM_XVIRTUALSCREEN),
+                 GetSystemMetrics(SM_YVIRTUALSCREEN),
+                 GetSystemMetrics(SM_XVIRTUALSCREEN) +
+                     GetSystemMetrics(SM_CXVIRTUALSCREEN),
+                 GetSystemMetrics(SM_YVIRTUALSCREEN) +
+                     GetSystemMetrics(SM_CYVIRTUALSCREEN)};
+  if (!IntersectRect(&bounds, &bounds, &screen)) {
+    return true;
+  }
+
+  HRGN visible = CreateRectRgnIndirect(&bounds);
+  bool covered = false;
+  for (HWND above = GetWindow(window, GW_HWNDPREV); above && !covered;
+       above = GetWindow(above, GW_HWNDPREV)) {
+    LONG ex_style = GetWindowLong(above, GWL_EXSTYLE);
+    RECT above_bounds;
+    if (!IsWindowVisible(above) || IsIconic(above) || IsCloaked(above) ||
+        (ex_style & (WS_EX_LAYERED | WS_EX_TRANSPARENT)) ||
+        !GetVisibleBounds(above, &above_bounds)) {
+      continue;
+    }
+    HRGN cover = CreateRectRgnIndirect(&above_bounds);
+    covered = CombineRgn(visible, visible, cover, RGN_DIFF) == NULLREGION;
+    DeleteObject(cover);
+  }
+  DeleteObject(visible);
+  return covered;
+}
+
+void SetEcoQos(bool enabled) {
+  PROCESS_POWER_THROTTLING_STATE state{};
+  state.Version = PROCESS_POWER_THROTTLING_CURRENT_VERSION;
+  // Clearing the control mask hands the decision back to the system.
+  state.ControlMask = enabled ? PROCESS_POWER_THROTTLING_EXECUTION_SPEED : 0;
+  state.StateMask = enabled ? PROCESS_POWER_THROTTLING_EXECUTION_SPEED : 0;
+  SetProcessInformation(GetCurrentProcess(), ProcessPowerThrottling, &state,
+                        sizeof(state));
+}
+
+}  // namespace
+
+WindowVisibilityTracker::WindowVisibilityTracker(HWND window,
+                                                 RunnerEngine* engine)
+    : window_(window), engine_(engine) {
+  WTSRegisterSessionNotification(window_, NOTIFY_FOR_THIS_SESSION);
+  if (g_trackers.empty()) {
+    for (const WinEventRange& range : kWinEventRanges) {
+      // Events from this process are wanted too: cloaking the window, as
+      // when switching virtual desktops, is reported for it.
+      DWORD process = range.own_process ? GetCurrentProcessId() : 0;
+      HWINEVENTHOOK hook = SetWinEventHook(range.first, range.last, nullptr,
+                                           HandleWinEvent, process, 0,
+                                           WINEVENT_OUTOFCONTEXT);
+      if (hook) {
+        g_hooks.push_back(hook);
+      }
+    }
+  }
+  g_trackers.push_back(this);
+  minimized_ = IsIconic(window_) != FALSE;
+}
+
+WindowVisibilityTracker::~WindowVisibilityTracker() {
+  KillTimer(window_, kOcclusionTimerId);
+  WTSUnRegisterSessionNotification(window_);
+  g_trackers.erase(std::remove(g_trackers.begin(), g_trackers.end(), this),
+                   g_trackers.end());
+  if (g_trackers.empty()) {
+    for (HWINEVENTHOOK hook : g_hooks) {
+      UnhookWinEvent(hook);
+    }
+    g_hooks.clear();
+  }
+  UpdateAppState();
+}
+
+bool WindowVisibilityTracker::HandleMessage(UINT const message,
+                                            WPARAM const wparam,
+                                            LPARAM const lparam) {
+  switch (message) {
+    case WM_SIZE:
+      if (wparam == SIZE_MINIMIZED) {
+        minimized_ = true;
+      } else if (wparam == SIZE_RESTORED || wparam == SIZE_MAXIMIZED) {
+        // A restored window is normally brought to the front; the check
+        // corrects that if it is not.
+        minimized_ = false;
+        occluded_ = false;
+        ScheduleOcclusionCheck();
+      }
+      Update();
+      return false;
+    case WM_SHOWWINDOW:
+      // Only ShowWindow calls, not an owner being minimized or restored.
+      if (lparam != 0) {
+        return false;
+      }
+      withdrawn_ = !wparam;
+      if (!withdrawn_) {
+        occluded_ = false;
+        ScheduleOcclusionCheck();
+      }
+      Update();
+      return false;
+    case WM_WTSSESSION_CHANGE:
+      if (wparam == WTS_SESSION_LOCK) {
+        locked_ = true;
+      } else if (wparam == WTS_SESSION_UNLOCK) {
+        locked_ = false;
+        occluded_ = false;
+        ScheduleOcclusionCheck();
+      }
+      Update();
+      return false;
+    case WM_TIMER:
+      if (wparam != kOcclusionTimerId) {
+        return false;
+      }
+      KillTimer(window_, kOcclusionTimerId);
+      check_pending_ = false;
+      CheckOcclusion();
+      return true;
+  }
+  return false;
+}
+
+// static
+void CALLBACK WindowVisibilityTracker::HandleWinEvent(HWINEVENTHOOK hook,
+                                                      DWORD event,
+                                                      HWND hwnd,
+                                                      LONG object_id,
+                                                      LONG child_id,
+                                                      DWORD event_thread,
+                                                      DWORD event_time) {
+  // Only top-level window changes matter, not carets, cursors or controls.
+  if (object_id != OBJID_WINDOW || child_id != CHILDID_SELF || !hwnd ||
+      GetAncestor(hwnd, GA_ROOT) != hwnd) {
+    return;
+  }
+  for (WindowVisibilityTracker* tracker : g_trackers) {
+    tracker->ScheduleOcclusionCheck();
+  }
+}
+
+// static
+void WindowVisibilityTracker::UpdateAppState() {
+  bool all_hidden =
+      !g_trackers.empty() &&
+      std::all_of(g_trackers.begin(), g_trackers.end(),
+                  [](WindowVisibilityTracker* tracker) {
+                    return tracker->hidden_;
+                  });
+  static bool eco_qos = false;
+  if (eco_qos != all_hidden) {
+    eco_qos = all_hidden;
+    SetEcoQos(eco_qos);
+  }
+
+  static bool app_hidden = false;
+  if (g_trackers.empty() || app_hidden == all_hidden) {
+    return;
+  }
+  app_hidden = all_hidden;
+  MemoryTrimmer::GetInstance()->SetAppHidden(app_hidden);
+  MemoryTelemetry::GetInstance()->Mark(app_hidden ? "hidden" : "shown");
+}
+
+void WindowVisibilityTracker::ScheduleOcclusionCheck() {
+  // Pointless while the window is known to be out of sight anyway.
+  if (minimized_ || withdrawn_ || locked_) {
+    return;
+  }
+  // A burst of events results in a single check once the timer fires. It is
+  // not re-armed, which would restart it, so that a steady stream of events
+  // can't hold the check off.
+  if (check_pending_) {
+    return;
+  }
+  check_pending_ =
+      SetTimer(window_, kOcclusionTimerId, kOcclusionCheckDelayMs, nullptr) !=
+      0;
+}
+
+void WindowVisibilityTracker::CheckOcclusion() {
+  occluded_ = IsCloaked(window_) || IsCovered(window_);
+  Update();
+}
+
+void WindowVisibilityTracker::Update() {
+  bool hidden =
+      minimized_ || withdrawn_ || locked_ ||
+      (IsWindowVisible(window_) && occluded_);
+  if (hidden == hidden_) {
+    return;
+  }
+  hidden_ = hidden;
+  // The lifecycle state belongs to the engine, which works it out from all
+  // of its windows, so it is told about this one as if it had been hidden
+  // or shown; the app counts as hidden once none of them can be seen. The
+  // engine sees minimizing and hiding for itself, and taking them again is
+  // harmless.
+  engine_->ProcessExternalWindowMessage(window_, WM_SHOWWINDOW,
+                                        hidden_ ? FALSE : TRUE, 0);
+  UpdateAppState();
+}
@@ -0,0 +1,76 @@
+#ifndef RUNNER_WINDOW_VISIBILITY_TRACKER_H_
+#define RUNNER_WINDOW_VISIBILITY_TRACKER_H_
+
+#include <windows.h>
+
+#include "runner_engine.h"
+
+// Tracks whether a Flutter window can be seen at all.
+//
+// The window counts as hidden while it is minimized or hidden (e.g. closed to
+// the tray), the session is locked, DWM has cloaked it (e.g. it is on another
+// virtual desktop) or other windows cover it entirely. The engine only sees
+// the first two itself, so the others are reported to its lifecycle handling
+// as the window being hidden; once none of its windows is visible, the engine
+// tells the framework the app is hidden, which stops it scheduling frames.
+// The process also runs at EcoQoS while no tracked window is visible. Both
+// are undone as soon as any window shows again.
+class WindowVisibilityTracker {
+ public:
+  // Tracks |window|, which hosts a view of |engine|. Both must outlive the
+  // tracker.
+  WindowVisibilityTracker(HWND window, RunnerEngine* engine);
+  ~WindowVisibilityTracker();
+
+  // Prevent copying.
+  WindowVisibilityTracker(WindowVisibilityTracker const&) = delete;
+  WindowVisibilityTracker& operator=(WindowVisibilityTracker const&) = delete;
+
+  // Updates the state from a message sent to the window. Returns true if the
+  // message was meant only for the tracker.
+  bool HandleMessage(UINT const message,
+                     WPARAM const wparam,
+                     LPARAM const lparam);
+
+ private:
+  // Receives window events, installed while any tracker exists.
+  static void CALLBACK HandleWinEvent(HWINEVENTHOOK hook,
+                                      DWORD event,
+                                      HWND hwnd,
+                                      LONG object_id,
+                                      LONG child_id,
+                                      DWORD event_thread,
+                                      DWORD event_time);
+
+  // Sets EcoQoS for the process, and lets memory be trimmed, if no tracked
+  // window is visible; undoes both otherwise.
+  static void UpdateAppState();
+
+  // Rechecks occlusion shortly, coalescing bursts of window events.
+  void ScheduleOcclusionCheck();
+
+  // Recomputes whether the window is cloaked or covered.
+  void CheckOcclusion();
+
+  // Applies the current state if it changed.
+  void Update();
+
+  HWND window_;
+  RunnerEngine* engine_;
+
+  bool minimized_ = false;
+  // Hidden with ShowWindow since it was last shown. A window that has yet to
+  // be shown for the first time doesn't count, so that its first frame is
+  // still drawn.
+  bool withdrawn_ = false;
+  bool locked_ = false;
+  bool occluded_ = false;
+
+  // Whether the occlusion timer is running.
+  bool check_pending_ = false;
+
+  // Whether this window is hidden.
+  bool hidden_ = false;
+};
+
+#endif  // RUNNER_WINDOW_VISIBILITY_TRACKER_H_
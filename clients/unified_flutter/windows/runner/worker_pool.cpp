@@ -0,0 +1,235 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+
+namespace {
+
+// A thread per processor, within reason: the work is short, and mostly
+// waits on DPAPI or the disk rather than the processor.
+constexpr unsigned int kMinThreads = 2;
+constexpr unsigned int kMaxThreads = 8;
+
+// How long work the pool could not take waits before it is offered again.
+constexpr int64_t kRetryDelayMs = 10;
+
+}  // namespace
+
+struct WorkerPool::Work {
+  Task task;
+  CancellationToken token;
+  Priority priority;
+};
+
+WorkerPool::Sequence::Sequence(Priority priority) : priority_(priority) {}
+
+WorkerPool::Sequence::~Sequence() {
+  token_.Cancel();
+  std::unique_lock<std::mutex> lock(mutex_);
+  tasks_.clear();
+  idle_.wait(lock, [this]() { return !scheduled_; });
+}
+
+void WorkerPool::Sequence::Post(Task task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks_.push_back(std::move(task));
+    if (scheduled_) {
+      return;
+    }
+    scheduled_ = true;
+  }
+  // Without a token: RunNext must run to tell the destructor it is done.
+  GetInstance()->Post(priority_, [this]() { RunNext(); });
+}
+
+void WorkerPool::Sequence::RunNext() {
+  Task task;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tasks_.empty()) {
+      scheduled_ = false;
+      idle_.notify_all();
+      return;
+    }
+    task = std::move(tasks_.front());
+    tasks_.pop_front();
+  }
+  task();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (tasks_.empty()) {
+      scheduled_ = false;
+      idle_.notify_all();
+      return;
+    }
+  }
+  // One task per callback, so that a busy sequence takes its turn with the
+  // other work at its priority rather than holding on to a thread.
+  GetInstance()->Post(priority_, [this]() { RunNext(); });
+}
+
+WorkerPool::TaskGroup::TaskGroup(Priority priority) : priority_(priority) {}
+
+WorkerPool::TaskGroup::~TaskGroup() {
+  token_.Cancel();
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this]() { return outstanding_ == 0; });
+}
+
+void WorkerPool::TaskGroup::Post(Task task) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++outstanding_;
+  }
+  GetInstance()->Post(priority_, [this, work = std::move(task)]() {
+    if (!token_.IsCanceled()) {
+      work();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--outstanding_ == 0) {
+      idle_.notify_all();
+    }
+  });
+}
+
+// static
+WorkerPool* WorkerPool::GetInstance() {
+  static WorkerPool* instance = new WorkerPool();
+  return instance;
+}
+
+void WorkerPool::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (pool_) {
+    return;
+  }
+  PTP_POOL pool = CreateThreadpool(nullptr);
+  if (!pool) {
+    return;
+  }
+  PTP_CLEANUP_GROUP cleanup_group = CreateThreadpoolCleanupGroup();
+  if (!cleanup_group) {
+    CloseThreadpool(pool);
+    return;
+  }
+  SetThreadpoolThreadMaximum(
+      pool, std::clamp(std::thread::hardware_concurrency(), kMinThreads,
+                       kMaxThreads));
+  // Keeps a thread around, so that a call after a quiet spell doesn't wait
+  // for one to be created.
+  SetThreadpoolThreadMinimum(pool, 1);
+
+  for (Priority priority : {Priority::kInteractive, Priority::kBackground}) {
+    TP_CALLBACK_ENVIRON& environment =
+        environments_[static_cast<int>(priority)];
+    InitializeThreadpoolEnvironment(&environment);
+    SetThreadpoolCallbackPool(&environment, pool);
+    SetThreadpoolCallbackCleanupGroup(&environment, cleanup_group,
+                                      &WorkerPool::DropWork);
+    SetThreadpoolCallbackPriority(&environment,
+                                  priority == Priority::kInteractive
+                                      ? TP_CALLBACK_PRIORITY_HIGH
+                                      : TP_CALLBACK_PRIORITY_LOW);
+  }
+  pool_ = pool;
+  cleanup_group_ = cleanup_group;
+  // Created now, so that retrying needs nothing the pool may be out of. On
+  // the default pool, as it only submits.
+  retry_timer_ = CreateThreadpoolTimer(&WorkerPool::OnRetryTimer, this,
+                                       nullptr);
+}
+
+void WorkerPool::Stop() {
+  PTP_POOL pool;
+  PTP_CLEANUP_GROUP cleanup_group;
+  PTP_TIMER retry_timer;
+  std::deque<std::unique_ptr<Work>> retries;
+  {
+    // Let go before waiting, as the running tasks may still post.
+    std::lock_guard<std::mutex> lock(mutex_);
+    pool = pool_;
+    cleanup_group = cleanup_group_;
+    retry_timer = retry_timer_;
+    pool_ = nullptr;
+    cleanup_group_ = nullptr;
+    retry_timer_ = nullptr;
+    // Dropped, like the work the cleanup group has not started.
+    retries.swap(retries_);
+  }
+  if (!pool) {
+    return;
+  }
+  if (retry_timer) {
+    SetThreadpoolTimer(retry_timer, nullptr, 0, 0);
+    WaitForThreadpoolTimerCallbacks(retry_timer, TRUE);
+    CloseThreadpoolTimer(retry_timer);
+  }
+  CloseThreadpoolCleanupGroupMembers(cleanup_group, TRUE, nullptr);
+  CloseThreadpoolCleanupGroup(cleanup_group);
+  for (TP_CALLBACK_ENVIRON& environment : environments_) {
+    DestroyThreadpoolEnvironment(&environment);
+  }
+  CloseThreadpool(pool);
+}
+
+void WorkerPool::Post(Priority priority,
+                      Task task,
+                      CancellationToken token) {
+  auto work = std::make_unique<Work>(
+      Work{std::move(task), std::move(token), priority});
+  std::lock_guard<std::mutex> lock(mutex_);
+  // Behind any work waiting to be retried, so that tasks still start in the
+  // order they were posted.
+  retries_.push_back(std::move(work));
+  SubmitRetries();
+}
+
+void WorkerPool::SubmitRetries() {
+  while (!retries_.empty()) {
+    Work* work = retries_.front().get();
+    PTP_CALLBACK_ENVIRON environment =
+        pool_ ? &environments_[static_cast<int>(work->priority)] : nullptr;
+    if (!TrySubmitThreadpoolCallback(&WorkerPool::RunWork, work,
+                                     environment)) {
+      // Out of resources. Kept rather than lost, which would leave a
+      // Sequence or TaskGroup waiting on it forever, and rather than run on
+      // the caller, which is often the platform thread. Without the timer,
+      // before Start, the next Post tries again.
+      if (retry_timer_) {
+        ULARGE_INTEGER due;
+        due.QuadPart = static_cast<ULONGLONG>(-kRetryDelayMs * 10000);
+        FILETIME due_time{due.LowPart, due.HighPart};
+        SetThreadpoolTimer(retry_timer_, &due_time, 0, 0);
+      }
+      return;
+    }
+    retries_.front().release();
+    retries_.pop_front();
+  }
+}
+
+// static
+void CALLBACK WorkerPool::OnRetryTimer(PTP_CALLBACK_INSTANCE instance,
+                                       void* context,
+                                       PTP_TIMER timer) {
+  auto* pool = static_cast<WorkerPool*>(context);
+  std::lock_guard<std::mutex> lock(pool->mutex_);
+  pool->SubmitRetries();
+}
+
+// static
+void CALLBACK WorkerPool::RunWork(PTP_CALLBACK_INSTANCE instance,
+                                  void* context) {
+  std::unique_ptr<Work> work(static_cast<Work*>(context));
+  if (!work->token.IsCanceled()) {
+    work->task();
+  }
+}
+
+// static
+void CALLBACK WorkerPool::DropWork(void* object_context,
+                                   void* cleanup_context) {
+  delete static_cast<Work*>(object_context);
+}
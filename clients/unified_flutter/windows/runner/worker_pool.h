@@ -0,0 +1,167 @@
+#ifndef RUNNER_WORKER_POOL_H_
+#define RUNNER_WORKER_POOL_H_
+
+#include <windows.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+// The runner's worker threads, shared by every component that works off the
+// platform thread.
+//
+// Built on a private Windows thread pool, which keeps the number of threads
+// to the processors there are, however many components post work, and takes
+// interactive work before background work. Results go back to the platform
+// thread through PlatformTaskQueue, which drains everything posted since its
+// last wake-up in one message.
+//
+// Components post through a Sequence, whose tasks run one at a time in
+// order, or a TaskGroup, whose tasks run in parallel; both drop their tasks
+// that have not started, and wait for those that have, when destroyed, so a
+// task may use its owner. Tasks should not block for long: loops that wait
+// on the network or a device keep threads of their own.
+class WorkerPool {
+ public:
+  enum class Priority {
+    // Something waits on the result, e.g. a Dart call.
+    kInteractive,
+    // Nothing does yet, e.g. reading an attachment ahead of the query.
+    kBackground,
+  };
+
+  using Task = std::function<void()>;
+
+  // Shared by copies; cancelling one cancels them all.
+  class CancellationToken {
+   public:
+    CancellationToken()
+        : canceled_(std::make_shared<std::atomic<bool>>(false)) {}
+
+    void Cancel() const { canceled_->store(true); }
+    bool IsCanceled() const { return canceled_->load(); }
+
+   private:
+    std::shared_ptr<std::atomic<bool>> canceled_;
+  };
+
+  // Runs tasks one at a time, in the order they were posted, each on
+  // whichever pool thread is free.
+  class Sequence {
+   public:
+    explicit Sequence(Priority priority);
+    // Drops the tasks that have not started, and waits for the one that
+    // has.
+    ~Sequence();
+
+    // Prevent copying.
+    Sequence(Sequence const&) = delete;
+    Sequence& operator=(Sequence const&) = delete;
+
+    // Safe to call from any thread, tasks included.
+    void Post(Task task);
+
+    // Cancelled when the sequence is destroyed, for tasks that run long
+    // enough to stop early.
+    const CancellationToken& token() const { return token_; }
+
+   private:
+    // Runs the next task, then schedules the one after it, if any.
+    void RunNext();
+
+    Priority priority_;
+    CancellationToken token_;
+
+    std::mutex mutex_;
+    std::condition_variable idle_;
+
+    // Guarded by |mutex_|.
+    std::deque<Task> tasks_;
+    // Whether RunNext is posted or running.
+    bool scheduled_ = false;
+  };
+
+  // Runs tasks in parallel.
+  class TaskGroup {
+   public:
+    explicit TaskGroup(Priority priority);
+    // Drops the tasks that have not started, and waits for those that have.
+    ~TaskGroup();
+
+    // Prevent copying.
+    TaskGroup(TaskGroup const&) = delete;
+    TaskGroup& operator=(TaskGroup const&) = delete;
+
+    // Safe to call from any thread, tasks included.
+    void Post(Task task);
+
+    // Cancelled when the group is destroyed, for tasks that run long enough
+    // to stop early.
+    const CancellationToken& token() const { return token_; }
+
+   private:
+    Priority priority_;
+    CancellationToken token_;
+
+    std::mutex mutex_;
+    std::condition_variable idle_;
+
+    // Tasks posted and not yet finished or dropped. Guarded by |mutex_|.
+    int outstanding_ = 0;
+  };
+
+  // Returns the process-wide instance.
+  static WorkerPool* GetInstance();
+
+  // Prevent copying.
+  WorkerPool(WorkerPool const&) = delete;
+  WorkerPool& operator=(WorkerPool const&) = delete;
+
+  // Creates the threads' pool. Until then, and after Stop, tasks run on the
+  // process's default pool.
+  void Start();
+
+  // Drops the tasks that have not started and waits for those that have.
+  // Every Sequence and TaskGroup must be gone by then.
+  void Stop();
+
+  // Runs |task| at |priority|, unless |token| is cancelled before it starts.
+  // Safe to call from any thread.
+  void Post(Priority priority,
+            Task task,
+            CancellationToken token = CancellationToken());
+
+ private:
+  struct Work;
+
+  WorkerPool() = default;
+
+  static void CALLBACK RunWork(PTP_CALLBACK_INSTANCE instance, void* context);
+
+  // Submits |retries_| in order, until the pool takes no more; then arms
+  // |retry_timer_| to try again. |mutex_| must be held.
+  void SubmitRetries();
+
+  static void CALLBACK OnRetryTimer(PTP_CALLBACK_INSTANCE instance,
+                                    void* context,
+                                    PTP_TIMER timer);
+
+  // Frees the work the cleanup group dropped in Stop.
+  static void CALLBACK DropWork(void* object_context, void* cleanup_context);
+
+  // Guards the pool's handles against Post from other threads during Start
+  // and Stop.
+  std::mutex mutex_;
+  PTP_POOL pool_ = nullptr;
+  PTP_CLEANUP_GROUP cleanup_group_ = nullptr;
+  // By Priority.
+  TP_CALLBACK_ENVIRON environments_[2];
+  // Work the pool could not take yet, oldest first.
+  std::deque<std::unique_ptr<Work>> retries_;
+  PTP_TIMER retry_timer_ = nullptr;
+};
+
+#endif  // RUNNER_WORKER_POOL_H_